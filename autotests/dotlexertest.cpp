@@ -0,0 +1,124 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+
+#include "dotlexer.h"
+
+#include <QTest>
+
+#include <cstring>
+
+using namespace KGraphViewer;
+
+Q_DECLARE_METATYPE(KGraphViewer::DotToken::Type)
+
+class DotLexerTest : public QObject
+{
+  Q_OBJECT
+
+private Q_SLOTS:
+  void numerals_data();
+  void numerals();
+  void endOfBuffer_data();
+  void endOfBuffer();
+};
+
+namespace
+{
+
+DotToken firstToken(const char* input, bool atEnd = true)
+{
+  DotLexer lexer(input, input + strlen(input), atEnd);
+  return lexer.next();
+}
+
+}
+
+void DotLexerTest::numerals_data()
+{
+  QTest::addColumn<QByteArray>("input");
+  QTest::addColumn<DotToken::Type>("type");
+  QTest::addColumn<QByteArray>("text");
+
+  QTest::newRow("integer") << QByteArray("-12 ") << DotToken::Id << QByteArray("-12");
+  QTest::newRow("real") << QByteArray("-1.5;") << DotToken::Id << QByteArray("-1.5");
+  QTest::newRow("no integer part") << QByteArray("-.5]") << DotToken::Id << QByteArray("-.5");
+  QTest::newRow("no decimals") << QByteArray("-1.,") << DotToken::Id << QByteArray("-1.");
+  QTest::newRow("at end") << QByteArray("-7") << DotToken::Id << QByteArray("-7");
+  QTest::newRow("edge op") << QByteArray("->b") << DotToken::EdgeOp << QByteArray("->");
+  QTest::newRow("undirected edge op") << QByteArray("--b") << DotToken::EdgeOp << QByteArray("--");
+  QTest::newRow("letters") << QByteArray("-abc") << DotToken::Error << QByteArray("-");
+  QTest::newRow("letters and dot") << QByteArray("-a.b") << DotToken::Error << QByteArray("-");
+  QTest::newRow("dot only") << QByteArray("-. ") << DotToken::Error << QByteArray("-.");
+  QTest::newRow("trailing letters") << QByteArray("-1a") << DotToken::Error << QByteArray("-1a");
+  QTest::newRow("two dots") << QByteArray("-1.2.3") << DotToken::Error << QByteArray("-1.2.3");
+  QTest::newRow("alone") << QByteArray("- 1") << DotToken::Error << QByteArray("-");
+}
+
+void DotLexerTest::numerals()
+{
+  QFETCH(QByteArray, input);
+  QFETCH(DotToken::Type, type);
+  QFETCH(QByteArray, text);
+
+  const DotToken token = firstToken(input.constData());
+  QCOMPARE(token.type, type);
+  QCOMPARE(QByteArray(token.text.first, int(token.text.size())), text);
+}
+
+void DotLexerTest::endOfBuffer_data()
+{
+  QTest::addColumn<QByteArray>("input");
+  QTest::addColumn<DotToken::Type>("atEndType");
+
+  // tokens which could go on after the end of the buffer
+  QTest::newRow("id") << QByteArray("  node") << DotToken::Id;
+  QTest::newRow("numeral") << QByteArray(" -1.5") << DotToken::Id;
+  QTest::newRow("minus") << QByteArray(" -") << DotToken::Error;
+  QTest::newRow("quoted string") << QByteArray(" \"a b") << DotToken::Error;
+  QTest::newRow("escaped quote") << QByteArray(" \"a \\\"") << DotToken::Error;
+  QTest::newRow("html string") << QByteArray(" <<b>a</b>") << DotToken::Error;
+  QTest::newRow("comment start") << QByteArray(" /") << DotToken::Error;
+  QTest::newRow("comment") << QByteArray(" /* a *") << DotToken::End;
+  QTest::newRow("line comment") << QByteArray(" // a") << DotToken::End;
+  QTest::newRow("preprocessor line") << QByteArray(" # 1 \"a.dot\"") << DotToken::End;
+  QTest::newRow("nothing") << QByteArray("  ") << DotToken::End;
+}
+
+void DotLexerTest::endOfBuffer()
+{
+  QFETCH(QByteArray, input);
+  QFETCH(DotToken::Type, atEndType);
+
+  const char* first = input.constData();
+  const char* last = first + input.size();
+  DotLexer lexer(first, last, false);
+  const DotToken token = lexer.next();
+  QCOMPARE(token.type, DotToken::Incomplete);
+  // the lexing restarts after the spaces, at the token or comment start
+  QVERIFY(lexer.position() > first);
+  QVERIFY(lexer.position() < last || input.trimmed().isEmpty());
+  QCOMPARE(*(lexer.position() - 1), ' ');
+
+  DotLexer finalLexer(first, last, true);
+  QCOMPARE(finalLexer.next().type, atEndType);
+}
+
+QTEST_GUILESS_MAIN(DotLexerTest)
+
+#include "dotlexertest.moc"
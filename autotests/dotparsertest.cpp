@@ -0,0 +1,273 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+
+#include "dotparser.h"
+#include "dotgraph.h"
+#include "graphedge.h"
+#include "graphnode.h"
+#include "graphsubgraph.h"
+#include "DotGraphParsingHelper.h"
+
+#include <QBuffer>
+#include <QTest>
+#include <QThreadPool>
+
+using namespace KGraphViewer;
+
+class DotParserTest : public QObject
+{
+  Q_OBJECT
+
+private Q_SLOTS:
+  void parse();
+  void invalidNumeral();
+  void defaultAttributes();
+  void streamSplitAnywhere();
+  void streamByteByByte();
+  void streamIncompleteGraph();
+  void parallelChunks();
+};
+
+namespace
+{
+
+const char smallGraph[] =
+  "/* a comment */ digraph G {\n"
+  "  graph [label=\"the graph\"];\n"
+  "  node [shape=box, label=\"a\\nb\"];\n"
+  "  a -> b -> c [color=red];\n"
+  "  // a line comment\n"
+  "  d [label=<<b>bold</b>>, width=-1.5];\n"
+  "  subgraph cluster_0 { e; f -> g; }\n"
+  "  \"h i\" -> { j k } [label=\"multi\\\n"
+  "line\"];\n"
+  "}\n";
+
+/** A graph being built by a parser */
+struct ParsedGraph
+{
+  ParsedGraph()
+  {
+    helper.graph = &graph;
+    helper.z = 1;
+    helper.maxZ = 1;
+    helper.uniq = 0;
+  }
+
+  DotGraph graph;
+  DotGraphParsingHelper helper;
+};
+
+QString attributesString(const GraphElement& element)
+{
+  QStringList attributes;
+  const QMap<QString, QString> map = element.attributes().toMap();
+  for (auto it = map.constBegin(); it != map.constEnd(); ++it)
+  {
+    attributes << it.key() + QLatin1Char('=') + it.value();
+  }
+  return attributes.join(QLatin1Char(','));
+}
+
+/** The elements of graph and their attributes, to compare graphs */
+QStringList describe(const DotGraph& graph)
+{
+  QStringList description;
+  description << QStringLiteral("graph ") + attributesString(graph);
+  for (const GraphNode* node : graph.nodes())
+  {
+    description << QStringLiteral("node ") + node->id() + QLatin1Char(' ') + attributesString(*node);
+  }
+  for (const GraphEdge* edge : graph.edges())
+  {
+    description << QStringLiteral("edge ") + edge->fromNode()->id() + QLatin1String("->")
+                 + edge->toNode()->id() + QLatin1Char(' ') + attributesString(*edge);
+  }
+  for (const GraphSubgraph* subgraph : graph.subgraphs())
+  {
+    description << QStringLiteral("subgraph ") + subgraph->id() + QLatin1Char(' ') + attributesString(*subgraph);
+  }
+  description.sort();
+  return description;
+}
+
+QStringList parseWhole(const QByteArray& input)
+{
+  ParsedGraph parsed;
+  DotParser parser(parsed.helper);
+  if (!parser.parse(input.constData(), input.constData() + input.size()) || !parser.isFinished())
+  {
+    return QStringList();
+  }
+  return describe(parsed.graph);
+}
+
+/** Gives data to the stream parser as a device would, in a buffer of its own */
+bool feed(DotStreamParser& parser, const QByteArray& data)
+{
+  QByteArray copy(data);
+  QBuffer device(&copy);
+  device.open(QIODevice::ReadOnly);
+  return parser.readFrom(&device);
+}
+
+}
+
+void DotParserTest::parse()
+{
+  const QStringList description = parseWhole(QByteArray(smallGraph));
+  QVERIFY(!description.isEmpty());
+  QCOMPARE(description.filter(QStringLiteral("node d ")).size(), 1);
+  QVERIFY(description.filter(QStringLiteral("node d ")).first().contains(QStringLiteral("width=-1.5")));
+  QCOMPARE(description.filter(QStringLiteral("shape=box")).size(), 10);
+  QCOMPARE(description.filter(QStringLiteral("edge h i->j")).size(), 1);
+  QCOMPARE(description.filter(QStringLiteral("label=multiline")).size(), 2);
+  QCOMPARE(description.filter(QStringLiteral("edge ")).size(), 5);
+}
+
+void DotParserTest::invalidNumeral()
+{
+  QVERIFY(parseWhole(QByteArray("digraph { a [width=-1] }")).size() > 0);
+  QVERIFY(parseWhole(QByteArray("digraph { a [width=-abc] }")).isEmpty());
+  QVERIFY(parseWhole(QByteArray("digraph { a [width=-a.b] }")).isEmpty());
+  QVERIFY(parseWhole(QByteArray("digraph { a -> -b }")).isEmpty());
+}
+
+void DotParserTest::defaultAttributes()
+{
+  const QByteArray input("digraph {\n"
+                         "  node [label=\"x\\ny\", color=red];\n"
+                         "  a;\n"
+                         "  subgraph s { node [label=\"\\N\", shape=box]; b; edge [color=blue]; b -> c; }\n"
+                         "  d; d -> a;\n"
+                         "}\n");
+  ParsedGraph parsed;
+  DotParser parser(parsed.helper);
+  QVERIFY(parser.parse(input.constData(), input.constData() + input.size()));
+  QVERIFY(parser.isFinished());
+
+  const DotGraph& graph = parsed.graph;
+  // the escaped line breaks of the default labels are replaced, as the
+  // ones of the labels set on the elements
+  QCOMPARE(graph.elementNamed(QStringLiteral("a"))->attributes().value(QStringLiteral("label")), QStringLiteral("x\ny"));
+  QCOMPARE(graph.elementNamed(QStringLiteral("d"))->attributes().value(QStringLiteral("label")), QStringLiteral("x\ny"));
+  QCOMPARE(graph.elementNamed(QStringLiteral("a"))->attributes().value(QStringLiteral("shape")), QString());
+
+  // the defaults of the subgraph are added to the inherited ones, "\N"
+  // giving back the default label
+  const GraphElement* b = graph.elementNamed(QStringLiteral("b"));
+  QVERIFY(!b->attributes().contains(QStringLiteral("label")));
+  QCOMPARE(b->attributes().value(QStringLiteral("color")), QStringLiteral("red"));
+  QCOMPARE(b->attributes().value(QStringLiteral("shape")), QStringLiteral("box"));
+  QCOMPARE(graph.elementNamed(QStringLiteral("c"))->attributes().value(QStringLiteral("shape")), QStringLiteral("box"));
+
+  QCOMPARE(graph.edges().size(), 2);
+  foreach (const GraphEdge* edge, graph.edges())
+  {
+    const QString color = edge->fromNode()->id() == QStringLiteral("b") ? QStringLiteral("blue") : QString();
+    QCOMPARE(edge->attributes().value(QStringLiteral("color")), color);
+  }
+}
+
+void DotParserTest::streamSplitAnywhere()
+{
+  // the first part of the input ends inside each token and comment in turn
+  const QByteArray input(smallGraph);
+  const QStringList expected = parseWhole(input);
+  for (int split = 0; split <= input.size(); split++)
+  {
+    ParsedGraph parsed;
+    DotStreamParser parser(parsed.helper);
+    QVERIFY2(feed(parser, input.left(split)), qPrintable(QString::number(split)));
+    QVERIFY2(feed(parser, input.mid(split)), qPrintable(QString::number(split)));
+    QVERIFY2(parser.finish(), qPrintable(QString::number(split)));
+    QCOMPARE(describe(parsed.graph), expected);
+  }
+}
+
+void DotParserTest::streamByteByByte()
+{
+  // the references kept by the parser survive the discarding of the buffer
+  // beginning and its reallocations
+  const QByteArray input(smallGraph);
+  ParsedGraph parsed;
+  DotStreamParser parser(parsed.helper);
+  for (int i = 0; i < input.size(); i++)
+  {
+    QVERIFY(feed(parser, input.mid(i, 1)));
+  }
+  QVERIFY(parser.finish());
+  QCOMPARE(describe(parsed.graph), parseWhole(input));
+}
+
+void DotParserTest::streamIncompleteGraph()
+{
+  const QByteArray input(smallGraph);
+  {
+    // the input stops before the closing brace
+    ParsedGraph parsed;
+    DotStreamParser parser(parsed.helper);
+    QVERIFY(feed(parser, input.left(input.lastIndexOf('}'))));
+    QVERIFY(!parser.finish());
+  }
+  {
+    // the input stops inside a quoted string
+    ParsedGraph parsed;
+    DotStreamParser parser(parsed.helper);
+    QVERIFY(feed(parser, input.left(input.indexOf("multi"))));
+    QVERIFY(!parser.finish());
+  }
+}
+
+void DotParserTest::parallelChunks()
+{
+  // A graph big enough to be tokenized in several chunks, with quoted and
+  // HTML strings and comments spanning lines, so that the chunks start
+  // inside them and their tokens have to be replayed from the previous one.
+  QByteArray input("digraph G {\n");
+  int i = 0;
+  while (input.size() < 6 * (1 << 20))
+  {
+    const QByteArray n = QByteArray::number(i++);
+    input += "n" + n + " [label=\"first line\n second line -> n" + n + " ;\n } \"];\n";
+    input += "/* a comment\n n" + n + " -> m" + n + "\n with an edge in it */\n";
+    input += "m" + n + " [label=<<table>\n<tr><td>\"" + n + "</td></tr>\n</table>>];\n";
+    input += "n" + n + " -> m" + n + " [weight=-" + n + ".5];\n";
+  }
+  input += "}\n";
+
+  const QStringList expected = parseWhole(input);
+  QVERIFY(!expected.isEmpty());
+  QCOMPARE(expected.filter(QStringLiteral("edge ")).size(), i);
+
+  QThreadPool* pool = QThreadPool::globalInstance();
+  const int maxThreadCount = pool->maxThreadCount();
+  pool->setMaxThreadCount(4);
+  ParsedGraph parsed;
+  DotParser parser(parsed.helper);
+  const bool result = parser.parseInParallel(input.constData(), input.constData() + input.size());
+  pool->setMaxThreadCount(maxThreadCount);
+  QVERIFY(result);
+  QVERIFY(parser.isFinished());
+  QCOMPARE(describe(parsed.graph), expected);
+}
+
+QTEST_MAIN(DotParserTest)
+
+#include "dotparsertest.moc"
@@ -0,0 +1,116 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+
+#include "graphedge.h"
+#include "dotgraph.h"
+#include "dotparser.h"
+#include "DotGraphParsingHelper.h"
+
+#include <QTest>
+
+using namespace KGraphViewer;
+
+class GraphEdgeTest : public QObject
+{
+  Q_OBJECT
+
+private Q_SLOTS:
+  void plainIds();
+  void distinctIds_data();
+  void distinctIds();
+  void distinctParsedEdges();
+};
+
+void GraphEdgeTest::plainIds()
+{
+  QCOMPARE(GraphEdge::edgeId(QStringLiteral("a"), QStringLiteral("b"), true, QString(), 0), QStringLiteral("a->b"));
+  QCOMPARE(GraphEdge::edgeId(QStringLiteral("a"), QStringLiteral("b"), false, QString(), 0), QStringLiteral("a--b"));
+  QCOMPARE(GraphEdge::edgeId(QStringLiteral("a"), QStringLiteral("b"), true, QString(), 2), QStringLiteral("a->b#2"));
+  QCOMPARE(GraphEdge::edgeId(QStringLiteral("a"), QStringLiteral("b"), true, QStringLiteral("k"), 0), QStringLiteral("a->b:k"));
+  QCOMPARE(GraphEdge::edgeId(QStringLiteral("a b"), QStringLiteral("c.d"), true, QString(), 0), QStringLiteral("a b->c.d"));
+}
+
+void GraphEdgeTest::distinctIds_data()
+{
+  QTest::addColumn<QString>("tail1");
+  QTest::addColumn<QString>("head1");
+  QTest::addColumn<QString>("key1");
+  QTest::addColumn<int>("ordinal1");
+  QTest::addColumn<QString>("tail2");
+  QTest::addColumn<QString>("head2");
+  QTest::addColumn<QString>("key2");
+  QTest::addColumn<int>("ordinal2");
+
+  QTest::newRow("ordinal in name") << "a" << "b" << QString() << 1 << "a" << "b#1" << QString() << 0;
+  QTest::newRow("key in name") << "a" << "b" << "x" << 0 << "a" << "b:x" << QString() << 0;
+  QTest::newRow("key and ordinal") << "a" << "b" << "1" << 0 << "a" << "b" << QString() << 1;
+  QTest::newRow("key with separator") << "a" << "b" << "x#1" << 0 << "a" << "b:x" << QString() << 1;
+  QTest::newRow("edge op in tail") << "a->b" << "c" << QString() << 0 << "a" << "b->c" << QString() << 0;
+  QTest::newRow("undirected op") << "a--b" << "c" << QString() << 0 << "a" << "b--c" << QString() << 0;
+  QTest::newRow("dash around op") << "a-" << "b" << QString() << 0 << "a" << "-b" << QString() << 0;
+  QTest::newRow("trailing backslash") << "a" << "b\\" << QString() << 1 << "a" << "b\\#1" << QString() << 0;
+  QTest::newRow("escaped dash") << "a\\" << "b" << QString() << 0 << "a" << "\\-b" << QString() << 0;
+}
+
+void GraphEdgeTest::distinctIds()
+{
+  QFETCH(QString, tail1);
+  QFETCH(QString, head1);
+  QFETCH(QString, key1);
+  QFETCH(int, ordinal1);
+  QFETCH(QString, tail2);
+  QFETCH(QString, head2);
+  QFETCH(QString, key2);
+  QFETCH(int, ordinal2);
+
+  for (bool directed : {true, false})
+  {
+    const QString id1 = GraphEdge::edgeId(tail1, head1, directed, key1, ordinal1);
+    const QString id2 = GraphEdge::edgeId(tail2, head2, directed, key2, ordinal2);
+    QVERIFY2(id1 != id2, qPrintable(id1));
+  }
+}
+
+void GraphEdgeTest::distinctParsedEdges()
+{
+  const QByteArray input("digraph {\n"
+                         "  a -> b; a -> b; a -> \"b#1\";\n"
+                         "  a -> b [key=x]; a -> \"b:x\";\n"
+                         "  \"a->b\" -> c; a -> \"b->c\";\n"
+                         "}\n");
+  DotGraph graph;
+  DotGraphParsingHelper helper;
+  helper.graph = &graph;
+  helper.z = 1;
+  helper.maxZ = 1;
+  helper.uniq = 0;
+  DotParser parser(helper);
+  QVERIFY(parser.parse(input.constData(), input.constData() + input.size()));
+  QVERIFY(parser.isFinished());
+
+  QCOMPARE(graph.edges().size(), 7);
+  foreach (GraphEdge* edge, graph.edges())
+  {
+    QCOMPARE(graph.edgeNamed(edge->id()), edge);
+  }
+}
+
+QTEST_MAIN(GraphEdgeTest)
+
+#include "graphedgetest.moc"
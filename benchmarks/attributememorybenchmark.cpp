@@ -0,0 +1,174 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+
+/*
+ * Measure of the memory used by the attributes of the nodes of a big graph,
+ * stored as DotAttributes and as the QMap<QString,QString> used before
+ */
+
+#include "dotattributes.h"
+#include "dotgraph.h"
+#include "dotparser.h"
+#include "graphnode.h"
+#include "DotGraphParsingHelper.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QMap>
+#include <QVector>
+
+#include <cstdio>
+
+using namespace KGraphViewer;
+
+namespace
+{
+
+/**
+ * A laid out graph of nodes nodes with the attributes dot gives them, and
+ * an edge between successive nodes
+ */
+QByteArray laidOutGraph(int nodes)
+{
+  QByteArray dot("digraph G {\n  graph [bb=\"0,0,1000,1000\"];\n  node [label=\"\\N\"];\n");
+  for (int n = 0; n < nodes; n++)
+  {
+    const QByteArray id = QByteArray::number(n);
+    const QByteArray x = QByteArray::number(27 + (n % 1000) * 81);
+    const QByteArray y = QByteArray::number(18 + (n / 1000) * 72);
+    dot += "  n" + id + " [label=\"node " + id + "\", shape=ellipse, color=black, fontname=\"Times-Roman\", fontsize=14,"
+           " height=0.5, width=0.75, pos=\"" + x + ',' + y + "\","
+           " _draw_=\"c 7 -#000000 e " + x + ' ' + y + " 27 18 \","
+           " _ldraw_=\"F 14 11 -Times-Roman c 7 -#000000 T " + x + ' ' + y + " 0 30 " + QByteArray::number(id.size() + 5) + " -node " + id + " \"];\n";
+    if (n > 0)
+    {
+      dot += "  n" + QByteArray::number(n - 1) + " -> n" + id + " [pos=\"e," + x + ',' + y + ' ' + x + ',' + y + "\"];\n";
+    }
+  }
+  dot += "}\n";
+  return dot;
+}
+
+/** The resident set size of the process, in kB, read from /proc */
+qint64 residentSize()
+{
+  QFile status(QStringLiteral("/proc/self/status"));
+  if (!status.open(QIODevice::ReadOnly))
+  {
+    return -1;
+  }
+  for (;;)
+  {
+    const QByteArray line = status.readLine();
+    if (line.isEmpty())
+    {
+      return -1;
+    }
+    if (line.startsWith("VmRSS:"))
+    {
+      return line.mid(6).trimmed().split(' ').first().toLongLong();
+    }
+  }
+}
+
+/** A deep copy of str, as the parser gives a new string to each value */
+inline QString copied(const QString& str)
+{
+  return QString(str.constData(), str.size());
+}
+
+}
+
+// Loads a laid out graph of nodes nodes (default 200000), then stores a copy
+// of the attributes of all the nodes as DotAttributes, built as the parser
+// builds them, and another one as QMap<QString,QString>, built as the
+// parser of kgraphviewer 2.4.2 built them. The growth of the resident set
+// size during each step is given per node.
+int main(int argc, char** argv)
+{
+  QCoreApplication app(argc, argv);
+  int nodes = 200000;
+  if (app.arguments().size() > 1)
+  {
+    nodes = app.arguments().at(1).toInt();
+  }
+
+  DotGraph graph;
+  {
+    const QByteArray dot = laidOutGraph(nodes);
+    const qint64 before = residentSize();
+    DotGraphParsingHelper helper;
+    helper.graph = &graph;
+    helper.z = 1;
+    helper.maxZ = 1;
+    helper.uniq = 0;
+    DotParser parser(helper);
+    if (!parser.parse(dot.constData(), dot.constData() + dot.size()) || !parser.isFinished())
+    {
+      fprintf(stderr, "cannot parse the graph\n");
+      return 1;
+    }
+    const qint64 after = residentSize();
+    printf("model          %8.1f bytes/node (%lld kB for %d nodes)\n",
+           (after - before) * 1024.0 / nodes, after - before, nodes);
+  }
+
+  // the copies are made from a list of the attributes, built beforehand
+  QVector< QVector< QPair<QString, QString> > > source;
+  source.reserve(nodes);
+  foreach (const GraphNode* node, graph.nodes())
+  {
+    QVector< QPair<QString, QString> > attributes;
+    for (auto it = node->attributes().constBegin(); it != node->attributes().constEnd(); ++it)
+    {
+      attributes.append(qMakePair(DotAttributeSymbols::name(it.symbol()), it.value()));
+    }
+    source.append(attributes);
+  }
+
+  qint64 before = residentSize();
+  QVector<DotAttributes> compact(source.size());
+  DotAttributeValues values;
+  for (int i = 0; i < source.size(); i++)
+  {
+    for (const auto& attribute : source.at(i))
+    {
+      compact[i][DotAttributeSymbols::symbol(attribute.first)] = values.intern(copied(attribute.second));
+    }
+  }
+  qint64 after = residentSize();
+  const double compactSize = (after - before) * 1024.0 / source.size();
+  printf("DotAttributes  %8.1f bytes/node\n", compactSize);
+
+  before = residentSize();
+  QVector< QMap<QString, QString> > maps(source.size());
+  for (int i = 0; i < source.size(); i++)
+  {
+    for (const auto& attribute : source.at(i))
+    {
+      maps[i][copied(attribute.first)] = copied(attribute.second);
+    }
+  }
+  after = residentSize();
+  const double mapSize = (after - before) * 1024.0 / source.size();
+  printf("QMap           %8.1f bytes/node\n", mapSize);
+  printf("ratio          %8.2f\n", compactSize / mapSize);
+
+  return 0;
+}
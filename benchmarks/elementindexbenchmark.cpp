@@ -0,0 +1,203 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+
+/*
+ * Benchmark of the loading of a big clustered graph and of the lookups of
+ * its elements by id
+ */
+
+#include "dotgraph.h"
+#include "dotparser.h"
+#include "graphnode.h"
+#include "graphsubgraph.h"
+#include "DotGraphParsingHelper.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QStringList>
+
+#include <cstdio>
+
+using namespace KGraphViewer;
+
+namespace
+{
+
+/**
+ * A graph of nodes nodes in clusters of 1000 nodes, each one made of 10
+ * nested clusters of 100 nodes. Each node has an edge to the next node of
+ * its cluster and every tenth node one to a node of another cluster.
+ */
+QByteArray clusteredGraph(int nodes)
+{
+  QByteArray dot("digraph G {\n  node [shape=box];\n");
+  const int clusters = (nodes + 999) / 1000;
+  for (int c = 0; c < clusters; c++)
+  {
+    dot += "  subgraph cluster_" + QByteArray::number(c) + " {\n    label=\"cluster " + QByteArray::number(c) + "\";\n";
+    for (int s = 0; s < 10; s++)
+    {
+      const int first = c * 1000 + s * 100;
+      if (first >= nodes)
+      {
+        break;
+      }
+      dot += "    subgraph cluster_" + QByteArray::number(c) + '_' + QByteArray::number(s) + " {\n";
+      for (int n = first; n < qMin(first + 100, nodes); n++)
+      {
+        dot += "      n" + QByteArray::number(n) + " [label=\"node " + QByteArray::number(n) + "\"];\n";
+        if (n + 1 < qMin(first + 100, nodes))
+        {
+          dot += "      n" + QByteArray::number(n) + " -> n" + QByteArray::number(n + 1) + ";\n";
+        }
+      }
+      dot += "    }\n";
+    }
+    dot += "  }\n";
+  }
+  for (int n = 0; n < nodes; n += 10)
+  {
+    dot += "  n" + QByteArray::number(n) + " -> n" + QByteArray::number((n * 7919 + 1000) % nodes) + ";\n";
+  }
+  dot += "}\n";
+  return dot;
+}
+
+GraphElement* scanSubgraph(GraphSubgraph* subgraph, const QString& id);
+
+/**
+ * The lookup of kgraphviewer 2.4.2, kept here as the reference: the maps of
+ * the graph, then a recursive scan of the content of the subgraphs.
+ */
+GraphElement* scanElementNamed(const DotGraph& graph, const QString& id)
+{
+  GraphElement* ret = nullptr;
+  if ((ret = graph.nodes().value(id, nullptr)))
+  {
+    return ret;
+  }
+  if ((ret = graph.edges().value(id, nullptr)))
+  {
+    return ret;
+  }
+  foreach (GraphSubgraph* subgraph, graph.subgraphs())
+  {
+    if ((ret = scanSubgraph(subgraph, id)))
+    {
+      return ret;
+    }
+  }
+  return nullptr;
+}
+
+GraphElement* scanSubgraph(GraphSubgraph* subgraph, const QString& id)
+{
+  if (subgraph->id() == id)
+  {
+    return subgraph;
+  }
+  foreach (GraphElement* element, subgraph->content())
+  {
+    if (element->id() == id)
+    {
+      return element;
+    }
+    GraphSubgraph* nested = dynamic_cast<GraphSubgraph*>(element);
+    if (nested != nullptr)
+    {
+      GraphElement* found = scanSubgraph(nested, id);
+      if (found != nullptr)
+      {
+        return found;
+      }
+    }
+  }
+  return nullptr;
+}
+
+}
+
+// Loads a clustered graph of nodes nodes (default 100000), then looks all
+// its nodes up by id with the index, and a sample of them with a scan of
+// the subgraphs as before the index
+int main(int argc, char** argv)
+{
+  QCoreApplication app(argc, argv);
+  int nodes = 100000;
+  if (app.arguments().size() > 1)
+  {
+    nodes = app.arguments().at(1).toInt();
+  }
+  const QByteArray dot = clusteredGraph(nodes);
+
+  QElapsedTimer timer;
+  timer.start();
+  DotGraph graph;
+  DotGraphParsingHelper helper;
+  helper.graph = &graph;
+  helper.z = 1;
+  helper.maxZ = 1;
+  helper.uniq = 0;
+  DotParser parser(helper);
+  if (!parser.parse(dot.constData(), dot.constData() + dot.size()) || !parser.isFinished())
+  {
+    fprintf(stderr, "cannot parse the graph\n");
+    return 1;
+  }
+  const qint64 loading = timer.nsecsElapsed();
+  printf("load     %8.1f ms  %d bytes, %d elements\n", loading / 1e6, dot.size(), graph.elementCount());
+
+  QStringList ids;
+  for (int n = 0; n < nodes; n++)
+  {
+    ids << QStringLiteral("n") + QString::number(n);
+  }
+
+  timer.restart();
+  for (const QString& id : ids)
+  {
+    if (graph.elementNamed(id) == nullptr)
+    {
+      fprintf(stderr, "node %s not found\n", qPrintable(id));
+      return 1;
+    }
+  }
+  const qint64 indexed = timer.nsecsElapsed();
+  printf("index    %8.1f ns/lookup\n", double(indexed) / ids.size());
+
+  // the scan is linear: only one node in a hundred is looked up
+  int sampled = 0;
+  timer.restart();
+  for (int n = 0; n < ids.size(); n += 100, sampled++)
+  {
+    if (scanElementNamed(graph, ids.at(n)) != graph.elementNamed(ids.at(n)))
+    {
+      fprintf(stderr, "scan and index differ for %s\n", qPrintable(ids.at(n)));
+      return 1;
+    }
+  }
+  const qint64 scanned = timer.nsecsElapsed();
+  printf("scan     %8.1f ns/lookup\n", double(scanned) / qMax(sampled, 1));
+  // loading looked the bounds of each edge up, and each node once
+  const int lookups = nodes + 2 * graph.edges().size();
+  printf("loading with the scan would add about %.1f s of lookups\n",
+         double(scanned) / qMax(sampled, 1) * lookups / 1e9);
+
+  return 0;
+}
@@ -0,0 +1,212 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+
+/*
+ * Benchmark of the reading of the layout output in the JSON format against
+ * the xdot format
+ */
+
+#include "dotgraph.h"
+#include "dotjsonparser.h"
+#include "dotparser.h"
+#include "graphedge.h"
+#include "graphnode.h"
+#include "graphsubgraph.h"
+#include "DotGraphParsingHelper.h"
+
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QProcess>
+#include <QStringList>
+
+#include <cstdio>
+
+using namespace KGraphViewer;
+
+namespace
+{
+
+/** A graph of nodes nodes with about two edges per node */
+QByteArray generatedGraph(int nodes)
+{
+  QByteArray dot("digraph G {\n  node [shape=box];\n");
+  for (int n = 0; n < nodes; n++)
+  {
+    dot += "  n" + QByteArray::number(n) + " [label=\"node " + QByteArray::number(n) + "\"];\n";
+  }
+  for (int n = 1; n < nodes; n++)
+  {
+    dot += "  n" + QByteArray::number((n - 1) / 2) + " -> n" + QByteArray::number(n) + ";\n";
+    if (n % 3 == 0)
+    {
+      dot += "  n" + QByteArray::number(n) + " -> n" + QByteArray::number((n * 7919) % nodes) + " [label=\"e" + QByteArray::number(n) + "\"];\n";
+    }
+  }
+  dot += "}\n";
+  return dot;
+}
+
+/** Runs engine on dot with the given output format */
+QByteArray layOut(const QString& engine, const QByteArray& dot, const char* format, qint64& nsecs)
+{
+  QElapsedTimer timer;
+  timer.start();
+  QProcess process;
+  process.start(engine, QStringList() << QStringLiteral("-T") + QLatin1String(format));
+  process.write(dot);
+  process.closeWriteChannel();
+  if (!process.waitForFinished(-1) || process.exitCode() != 0)
+  {
+    fprintf(stderr, "%s -T%s failed\n", qPrintable(engine), format);
+    return QByteArray();
+  }
+  nsecs = timer.nsecsElapsed();
+  return process.readAllStandardOutput();
+}
+
+/** Decodes the drawing operations of all the elements, as drawing them does */
+int decodeAll(const DotGraph& graph)
+{
+  int ops = graph.renderOperations().size();
+  foreach (const GraphNode* node, graph.nodes())
+  {
+    ops += node->renderOperations().size();
+  }
+  foreach (const GraphEdge* edge, graph.edges())
+  {
+    ops += edge->renderOperations().size() + edge->arrowheads().size();
+  }
+  foreach (const GraphSubgraph* subgraph, graph.subgraphs())
+  {
+    ops += subgraph->renderOperations().size();
+    foreach (const GraphElement* element, subgraph->content())
+    {
+      if (dynamic_cast<const GraphNode*>(element) != nullptr)
+      {
+        ops += element->renderOperations().size();
+      }
+    }
+  }
+  return ops;
+}
+
+bool readXdot(const QByteArray& output, int& elements, int& ops)
+{
+  DotGraph graph;
+  DotGraphParsingHelper helper;
+  helper.graph = &graph;
+  helper.z = 1;
+  helper.maxZ = 1;
+  helper.uniq = 0;
+  DotParser parser(helper);
+  if (!parser.parseInParallel(output.constData(), output.constData() + output.size()) || !parser.isFinished())
+  {
+    return false;
+  }
+  elements = graph.elementCount();
+  ops = decodeAll(graph);
+  return true;
+}
+
+bool readJson(const QByteArray& output, int& elements, int& ops)
+{
+  DotGraph graph;
+  DotJsonParser parser(&graph);
+  QByteArray data(output);
+  QBuffer device(&data);
+  device.open(QIODevice::ReadOnly);
+  if (!parser.readFrom(&device) || !parser.finish())
+  {
+    return false;
+  }
+  elements = graph.elementCount();
+  ops = decodeAll(graph);
+  return true;
+}
+
+}
+
+// Lays a graph out once with -Txdot and once with -Tjson, then reads each
+// output into the model, decoding all the drawing operations, and prints
+// the time taken by each step. The graph is the given DOT file or a
+// generated graph of the given number of nodes (default 5000).
+int main(int argc, char** argv)
+{
+  QCoreApplication app(argc, argv);
+  const QStringList arguments = app.arguments();
+  QByteArray dot;
+  if (arguments.size() > 1 && QFile::exists(arguments.at(1)))
+  {
+    QFile file(arguments.at(1));
+    if (!file.open(QIODevice::ReadOnly))
+    {
+      fprintf(stderr, "cannot read %s\n", qPrintable(arguments.at(1)));
+      return 1;
+    }
+    dot = file.readAll();
+  }
+  else
+  {
+    dot = generatedGraph(arguments.size() > 1 ? arguments.at(1).toInt() : 5000);
+  }
+  const QString engine = arguments.size() > 2 ? arguments.at(2) : QStringLiteral("dot");
+  const int runs = 5;
+
+  qint64 xdotLayout = 0;
+  qint64 jsonLayout = 0;
+  const QByteArray xdot = layOut(engine, dot, "xdot", xdotLayout);
+  const QByteArray json = layOut(engine, dot, "json", jsonLayout);
+  if (xdot.isEmpty() || json.isEmpty())
+  {
+    return 1;
+  }
+
+  QElapsedTimer timer;
+  int xdotElements = 0, xdotOps = 0;
+  timer.start();
+  for (int i = 0; i < runs; i++)
+  {
+    if (!readXdot(xdot, xdotElements, xdotOps))
+    {
+      fprintf(stderr, "cannot read the xdot output\n");
+      return 1;
+    }
+  }
+  const qint64 xdotRead = timer.nsecsElapsed() / runs;
+
+  int jsonElements = 0, jsonOps = 0;
+  timer.restart();
+  for (int i = 0; i < runs; i++)
+  {
+    if (!readJson(json, jsonElements, jsonOps))
+    {
+      fprintf(stderr, "cannot read the json output\n");
+      return 1;
+    }
+  }
+  const qint64 jsonRead = timer.nsecsElapsed() / runs;
+
+  printf("format   output     layout       read   elements        ops\n");
+  printf("xdot   %8d %8.1f ms %8.1f ms %10d %10d\n", xdot.size(), xdotLayout / 1e6, xdotRead / 1e6, xdotElements, xdotOps);
+  printf("json   %8d %8.1f ms %8.1f ms %10d %10d\n", json.size(), jsonLayout / 1e6, jsonRead / 1e6, jsonElements, jsonOps);
+
+  return 0;
+}
@@ -0,0 +1,178 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+
+
+/*
+ * Measure of the latency and of the memory growth of the relayouts made in
+ * process when a graph is edited, with a Graphviz context created for each
+ * relayout as kgraphviewer 2.4.2 did and with the DotContextPool
+ */
+
+#include "dotcontextpool.h"
+#include "layoutagraphthread.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+
+#include <graphviz/gvc.h>
+
+#include <cstdio>
+
+using namespace KGraphViewer;
+
+namespace
+{
+
+/** A graph of nodes nodes, each linked to the next and to the one ten further */
+QByteArray editedGraph(int nodes)
+{
+  QByteArray dot("digraph G {\n");
+  for (int n = 0; n < nodes; n++)
+  {
+    const QByteArray id = QByteArray::number(n);
+    dot += "  n" + id + " [label=\"node " + id + "\"];\n";
+    if (n > 0)
+    {
+      dot += "  n" + QByteArray::number(n - 1) + " -> n" + id + ";\n";
+    }
+    if (n >= 10)
+    {
+      dot += "  n" + QByteArray::number(n - 10) + " -> n" + id + ";\n";
+    }
+  }
+  dot += "}\n";
+  return dot;
+}
+
+/** The resident set size of the process, in kB, read from /proc */
+qint64 residentSize()
+{
+  QFile status(QStringLiteral("/proc/self/status"));
+  if (!status.open(QIODevice::ReadOnly))
+  {
+    return -1;
+  }
+  for (;;)
+  {
+    const QByteArray line = status.readLine();
+    if (line.isEmpty())
+    {
+      return -1;
+    }
+    if (line.startsWith("VmRSS:"))
+    {
+      return line.mid(6).trimmed().split(' ').first().toLongLong();
+    }
+  }
+}
+
+/**
+ * One relayout as DotGraph::update() makes it in library mode, with a
+ * context of type Context, and its latency in microseconds
+ */
+template <typename Context>
+qint64 relayout(const QByteArray& dot, const char* engine)
+{
+  QElapsedTimer timer;
+  timer.start();
+  graph_t* graph = agmemread(dot.constData());
+  if (graph == nullptr)
+  {
+    return -1;
+  }
+  Context gvc;
+  threadsafe_wrap_gvLayout(gvc, graph, engine);
+  threadsafe_wrap_gvRender(gvc, graph, "xdot", nullptr);
+  gvFreeLayout(gvc, graph);
+  agclose(graph);
+  return timer.nsecsElapsed() / 1000;
+}
+
+/** The context of kgraphviewer 2.4.2: a new one, never freed */
+class NewContext
+{
+public:
+  NewContext() : m_gvc(gvContext()) {}
+  inline operator GVC_t*() const {return m_gvc;}
+
+private:
+  GVC_t* m_gvc;
+};
+
+/**
+ * Makes relayouts layouts of dot and prints the latency of the first one,
+ * the mean latency of the others and the growth of the resident set size
+ * per relayout
+ */
+template <typename Context>
+bool measure(const char* name, const QByteArray& dot, const char* engine, int relayouts)
+{
+  const qint64 before = residentSize();
+  const qint64 first = relayout<Context>(dot, engine);
+  if (first < 0)
+  {
+    fprintf(stderr, "cannot read the graph\n");
+    return false;
+  }
+  qint64 total = 0;
+  for (int i = 1; i < relayouts; i++)
+  {
+    total += relayout<Context>(dot, engine);
+  }
+  const qint64 after = residentSize();
+  printf("%-12s first %8.1f ms, then %8.1f ms/relayout, %8.1f kB/relayout\n",
+         name, first / 1000.0, relayouts > 1 ? total / 1000.0 / (relayouts - 1) : 0.0,
+         double(after - before) / relayouts);
+  return true;
+}
+
+}
+
+// Relayouts in process relayouts times (default 50) a graph of nodes nodes
+// (default 500) with engine (default dot), first with a new context for
+// each relayout, then with the contexts of the pool. Each context loads the
+// Graphviz configuration and plugins on its first layout.
+int main(int argc, char** argv)
+{
+  QCoreApplication app(argc, argv);
+  int nodes = 500;
+  int relayouts = 50;
+  QByteArray engine("dot");
+  if (app.arguments().size() > 1)
+  {
+    nodes = app.arguments().at(1).toInt();
+  }
+  if (app.arguments().size() > 2)
+  {
+    relayouts = app.arguments().at(2).toInt();
+  }
+  if (app.arguments().size() > 3)
+  {
+    engine = app.arguments().at(3).toUtf8();
+  }
+
+  const QByteArray dot = editedGraph(nodes);
+  if (!measure<NewContext>("new context", dot, engine.constData(), relayouts)
+      || !measure<DotContext>("pool", dot, engine.constData(), relayouts))
+  {
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,210 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+
+/*
+ * Benchmark of the xdot drawing operations decoder against the boost Spirit
+ * grammar it replaced
+ */
+
+#include "dotgrammar.h"
+#include "dotrenderop.h"
+
+#include <boost/spirit/include/classic_actor.hpp>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+// The Spirit grammar of kgraphviewer 2.4.2, kept here as the reference.
+// boost::throw_exception is defined by the library.
+namespace spirit
+{
+
+using namespace boost::spirit::classic;
+
+struct RenderOp
+{
+  QString renderop;
+  QList< int > integers;
+  QString str;
+};
+
+typedef QList< RenderOp > RenderOpVec;
+
+std::string therenderop;
+std::string thestr;
+RenderOp renderop;
+RenderOpVec* renderopvec = nullptr;
+
+void init_op()
+{
+  renderop = RenderOp();
+}
+
+void valid_op(char const* /*first*/, char const* /*last*/)
+{
+  renderop.renderop = QString::fromUtf8(therenderop.c_str());
+  renderop.str = QString::fromUtf8(thestr.c_str());
+  renderopvec->push_back(renderop);
+  renderop.renderop = QString();
+  renderop.integers = QList<int>();
+  renderop.str = QString();
+}
+
+bool parse_renderop(const std::string& str, RenderOpVec& arenderopvec)
+{
+  if (str.empty())
+  {
+    return false;
+  }
+  init_op();
+  renderopvec = &arenderopvec;
+  int c;
+  return parse(str.c_str(),
+              (
+                +(
+                   (
+                     (ch_p('E')|ch_p('e'))[assign_a(therenderop)] >> +space_p >>
+                     repeat_p(4)[int_p[push_back_a(renderop.integers)] >> !((ch_p(',')|ch_p('.')) >> int_p) >> +space_p]
+                   )[&valid_op]
+                   | (
+                       (ch_p('P')|ch_p('p')|ch_p('L')|ch_p('B')|ch_p('b'))[assign_a(therenderop)] >> +space_p >>
+                       int_p[assign_a(c)][push_back_a(renderop.integers)] >> +space_p >>
+                       repeat_p(boost::ref(c))[
+                                                int_p[push_back_a(renderop.integers)] >> !((ch_p(',')|ch_p('.')) >> int_p) >> +space_p >>
+                                                int_p[push_back_a(renderop.integers)] >> !((ch_p(',')|ch_p('.')) >> int_p) >> +space_p
+                                              ]
+                     )[&valid_op]
+                   | (
+                       (ch_p('T')|ch_p('I'))[assign_a(therenderop)] >> +space_p >>
+                       repeat_p(4)[int_p[push_back_a(renderop.integers)] >> !((ch_p(',')|ch_p('.')) >> int_p) >> +space_p] >>
+                       int_p[assign_a(c)] >> +space_p >> '-' >>
+                       (repeat_p(boost::ref(c))[anychar_p])[assign_a(thestr)] >> +space_p
+                     )[&valid_op]
+                     | (
+                       (ch_p('C')|ch_p('c')|ch_p('S'))[assign_a(therenderop)] >> +space_p >>
+                       int_p[assign_a(c)] >> +space_p >> '-' >>
+                       (repeat_p(boost::ref(c))[anychar_p])[assign_a(thestr)] >> +space_p
+                     )[&valid_op]
+                     | (
+                       (ch_p('t'))[assign_a(therenderop)] >> +space_p >>
+                       int_p[assign_a(c)] >> +space_p
+                     )[&valid_op]
+                    | (
+                       ch_p('F')[assign_a(therenderop)] >> +space_p >>
+                       int_p[push_back_a(renderop.integers)] >> !((ch_p(',')|ch_p('.')) >> int_p) >> +space_p >>
+                       int_p[assign_a(c)] >> +space_p >> '-' >>
+                       (repeat_p(boost::ref(c))[anychar_p])[assign_a(thestr)] >> +space_p
+                     )[&valid_op]
+                 )
+                 ) >> !end_p
+             ).full;
+}
+
+}
+
+// The drawing attributes written by dot -Txdot for a node and an edge
+const char* const drawings[] = {
+  "c 7 -#000000 e 27 18 27 18 ",
+  "F 14 11 -Times-Roman c 7 -#000000 T 27 14.3 0 7.77 1 -a ",
+  "c 7 -#000000 B 4 27 71.7 27 63.98 27 54.71 27 46.11 ",
+  "S 5 -solid c 7 -#000000 C 7 -#000000 P 3 30.5 46.1 27 36.1 23.5 46.1 ",
+  "c 9 -#ff0000ff p 4 54 108 0 108 0 72 54 72 ",
+  "F 14 11 -Times-Roman c 7 -#000000 T 69.5 57.8 0 21 3 -e12 "
+};
+const int drawingsCount = sizeof(drawings) / sizeof(drawings[0]);
+
+void report(const char* name, qint64 nsecs, int strings, qint64 bytes, int ops)
+{
+  printf("%-8s %8.1f ms %8.1f ns/string %8.1f MB/s %10d ops\n",
+         name, nsecs / 1e6, double(nsecs) / strings,
+         bytes * 1e3 / nsecs, ops);
+}
+
+}
+
+// Decodes the drawings of a graph of elements elements (default 200000) with
+// both decoders and prints the time taken by each one
+int main(int argc, char** argv)
+{
+  QCoreApplication app(argc, argv);
+  int elements = 200000;
+  if (app.arguments().size() > 1)
+  {
+    elements = app.arguments().at(1).toInt();
+  }
+
+  std::vector<std::string> strings;
+  qint64 bytes = 0;
+  for (int i = 0; i < drawingsCount; i++)
+  {
+    strings.push_back(drawings[i]);
+    bytes += strings.back().size();
+  }
+  bytes *= elements;
+  const int count = elements * drawingsCount;
+
+  QElapsedTimer timer;
+  int spiritOps = 0;
+  timer.start();
+  for (int i = 0; i < elements; i++)
+  {
+    for (const std::string& str : strings)
+    {
+      spirit::RenderOpVec ops;
+      if (!spirit::parse_renderop(str, ops))
+      {
+        fprintf(stderr, "spirit: cannot decode %s\n", str.c_str());
+        return 1;
+      }
+      spiritOps += ops.size();
+    }
+  }
+  report("spirit", timer.nsecsElapsed(), count, bytes, spiritOps);
+
+  // as when loading a graph, all the elements share one arena
+  QSharedPointer<DotRenderOpArena> arena(new DotRenderOpArena);
+  int decoderOps = 0;
+  timer.restart();
+  for (int i = 0; i < elements; i++)
+  {
+    for (const std::string& str : strings)
+    {
+      DotRenderOpVec ops(arena);
+      if (!parse_renderop(str.data(), str.data() + str.size(), ops))
+      {
+        fprintf(stderr, "decoder: cannot decode %s\n", str.c_str());
+        return 1;
+      }
+      decoderOps += ops.size();
+    }
+  }
+  report("decoder", timer.nsecsElapsed(), count, bytes, decoderOps);
+
+  return spiritOps == decoderOps ? 0 : 1;
+}
@@ -29,6 +29,7 @@
 
 #include <kshortcutsdialog.h>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <kconfig.h>
 #include <QUrl>
 #include <QTabWidget>
@@ -166,17 +167,24 @@ void KGraphViewerWindow::openUrl(const QUrl& url)
     {
       QString fileName = url.url();
       QWidget *w = part->widget();
+      // the standard input and pipes cannot be opened again
+      const QFileInfo fileInfo(url.toLocalFile());
+      const bool stream = url.isLocalFile()
+          && (url.toLocalFile() == QLatin1String("-") || (fileInfo.exists() && !fileInfo.isFile()));
 
       part->openUrl( url );
       
-      if (m_rfa)
+      if (m_rfa && !stream)
       {
         m_rfa->addUrl(url);
         KSharedConfig::Ptr config = KSharedConfig::openConfig();
         m_rfa->saveEntries(KConfigGroup(config, "kgraphviewer recent files"));
       }
 
-      m_openedFiles.push_back(fileName);
+      if (!stream)
+      {
+        m_openedFiles.push_back(fileName);
+      }
       m_tabsPartsMap[w] = part;
       m_tabsFilesMap[w] = fileName;
       connect(this,SIGNAL(hide(KParts::Part*)),part,SLOT(slotHide(KParts::Part*)));
@@ -187,7 +195,7 @@ void KGraphViewerWindow::openUrl(const QUrl& url)
               this, SLOT(slotHoverLeave(QString)));
 
       m_manager->addPart( part, true );
-      const QString label = fileName.section('/', -1, -1);
+      const QString label = (url.toLocalFile() == QLatin1String("-")) ? i18n("Standard input") : fileName.section('/', -1, -1);
       m_widget->addTab(w, QIcon::fromTheme("kgraphviewer"), label);
       m_widget->setCurrentWidget(w);
       m_closeAction->setEnabled(true);
@@ -201,7 +209,7 @@ void KGraphViewerWindow::fileOpen()
   // the Open shortcut is pressed (usually CTRL+O) or the Open toolbar
   // button is clicked
   QFileDialog fileDialog(this);
-  fileDialog.setMimeTypeFilters(QStringList(QStringLiteral("text/vnd.graphviz")));
+  fileDialog.setMimeTypeFilters(QStringList() << QStringLiteral("text/vnd.graphviz") << QStringLiteral("application/gzip"));
   fileDialog.setAcceptMode(QFileDialog::AcceptOpen);
   fileDialog.setFileMode(QFileDialog::ExistingFiles);
   if (fileDialog.exec() != QFileDialog::Accepted) {
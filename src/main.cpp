@@ -68,7 +68,7 @@ int main(int argc, char **argv)
   QCommandLineParser options;
   options.addHelpOption();
   options.addVersionOption();
-  options.addPositionalArgument(QStringLiteral("url"), i18n("Path or URL to scan"), i18n("[url]"));
+  options.addPositionalArgument(QStringLiteral("url"), i18n("Path or URL to scan, - for the standard input"), i18n("[url]"));
   about.setupCommandLine(&options);
   options.process(app);
   about.processCommandLine(&options);
@@ -99,7 +99,8 @@ int main(int argc, char **argv)
   
         for (int i = 0; i < args.count(); i++ )
         {
-          if (instanceExists 
+          // the standard input, given as -, can only be read by this process
+          if (instanceExists && args[i] != QLatin1String("-")
               && (QMessageBox::question(nullptr,
                                         i18n("Opening in new window confirmation"),
                                         i18n("A KGraphViewer window is already open, where do you want to open this file in the existing window?"))
@@ -135,7 +136,7 @@ int main(int argc, char **argv)
             new KgraphviewerAdaptor(widget);
             QDBusConnection::sessionBus().registerObject("/KGraphViewer", widget);
             widget->show();
-            widget->openUrl( QUrl::fromUserInput(args[i]));
+            widget->openUrl((args[i] == QLatin1String("-")) ? QUrl::fromLocalFile(args[i]) : QUrl::fromUserInput(args[i]));
           }
         }
       }
@@ -26,42 +26,145 @@
 #include "graphedge.h"
 #include "kgraphviewerlib_debug.h"
 
-#include <boost/throw_exception.hpp>
-#include <boost/spirit/include/classic_core.hpp>
-#include <boost/spirit/include/classic_distinct.hpp>
-#include <boost/spirit/include/classic_loops.hpp>
-#include <boost/spirit/include/classic_confix.hpp>
-
-
 #include <iostream>
 
 #include <QDebug>
     
 #include <QFile>
-#include<QUuid>
 
 using namespace std;
 
-extern KGraphViewer::DotGraphParsingHelper* phelper;
-
 namespace KGraphViewer
 {
 #define KGV_MAX_ITEMS_TO_LOAD std::numeric_limits<int>::max()
 
+namespace
+{
+// Accessors allowing to handle in the same way the attributes stored in the
+// helper and the ones referencing the parsed buffer
+
+inline QString attributeString(const std::string& str)
+{
+  return QString::fromStdString(str);
+}
+
+inline QString attributeString(const DotStringRef& str)
+{
+  return str.toString();
+}
+
+inline int attributeSymbol(const std::string& str)
+{
+  return DotAttributeSymbols::symbol(str.data(), str.data() + str.size());
+}
+
+inline int attributeSymbol(const DotStringRef& str)
+{
+  // looked up without conversion, unless the name has to be unescaped
+  return str.hasLineBreaks() ? DotAttributeSymbols::symbol(str.toString()) : DotAttributeSymbols::symbol(str.first, str.last);
+}
+
+inline bool attributeIs(const std::string& str, const char* name)
+{
+  return str == name;
+}
+
+inline bool attributeIs(const DotStringRef& str, const char* name)
+{
+  return str == name;
+}
+
+/** Stores the xdot string in ops, to be decoded when the operations are first used */
+inline void storeRenderOps(const std::string& str, DotRenderOpVec& ops)
+{
+  ops.appendXdot(str.data(), str.data() + str.size());
+}
+
+inline void storeRenderOps(const DotStringRef& str, DotRenderOpVec& ops)
+{
+  if (str.hasLineBreaks())
+  {
+    // the text lengths of the operations do not count the line continuations
+    storeRenderOps(str.toStdString(), ops);
+  }
+  else
+  {
+    ops.appendXdot(str.first, str.last);
+  }
+}
+
+const std::string* findAttribute(const DotGraphParsingHelper::AttributesMap& attributes, const char* name)
+{
+  DotGraphParsingHelper::AttributesMap::const_iterator it = attributes.find(name);
+  return it == attributes.end() ? nullptr : &(*it).second;
+}
+
+const DotStringRef* findAttribute(const DotGraphParsingHelper::StatementAttributes& attributes, const char* name)
+{
+  // the last value given to an attribute is the one to use
+  DotGraphParsingHelper::StatementAttributes::const_reverse_iterator it, it_end;
+  it = attributes.rbegin(); it_end = attributes.rend();
+  for (; it != it_end; it++)
+  {
+    if ((*it).first == name)
+    {
+      return &(*it).second;
+    }
+  }
+  return nullptr;
+}
+
+template <typename Attributes>
+void setElementAttributes(GraphElement* ge, const Attributes& attributes, const QSharedPointer<DotRenderOpArena>& arena,
+                          DotAttributeValues& values)
+{
+  typename Attributes::const_iterator it, it_end;
+  it = attributes.begin(); it_end = attributes.end();
+  for (; it != it_end; it++)
+  {
+//     qCDebug(KGRAPHVIEWERLIB_LOG) << "    " << attributeString((*it).first) << "\t=\t'" << attributeString((*it).second) <<"'";
+    if (attributeIs((*it).first, "label"))
+    {
+      QString label = attributeString((*it).second);
+      label.replace("\\n","\n");
+      (*ge).attributes()[DotAttributeSymbols::Label] = label;
+    }
+    else
+    {
+      (*ge).attributes()[attributeSymbol((*it).first)] = values.intern(attributeString((*it).second));
+    }
+  }
+  
+  // the operations of all the elements of the graph share the same arena
+  DotRenderOpVec ops = ge->renderOperations();
+  if (ops.isEmpty())
+  {
+    ops = DotRenderOpVec(arena);
+  }
+  static const char* const drawAttributes[] = {"_draw_", "_ldraw_", "_hldraw_", "_tldraw_", "_tdraw_", "_hdraw_"};
+  for (const char* drawAttribute : drawAttributes)
+  {
+    if (auto value = findAttribute(attributes, drawAttribute))
+    {
+      storeRenderOps(*value, ops);
+//     qCDebug(KGRAPHVIEWERLIB_LOG) << "element renderOperations size is now " << ops.size();
+    }
+  }
+  ge->setRenderOperations(ops);
+}
+
+}
+
 DotGraphParsingHelper::DotGraphParsingHelper():
-  attrid(),
-  valid(),
   attributed(),
   subgraphid(),
   uniq(0),
   attributes(),
-  graphAttributes(),
-  nodesAttributes(),
-  edgesAttributes(),
-  graphAttributesStack(),
-  nodesAttributesStack(),
-  edgesAttributesStack(),
+  scopes(1),
   edgebounds(),
+  parallelEdges(),
+  renderOpArena(QSharedPointer<DotRenderOpArena>::create()),
+  attributeValues(),
   z(0),
   maxZ(0),
   graph(nullptr),
@@ -73,52 +176,63 @@ DotGraphParsingHelper::DotGraphParsingHelper():
 
 void DotGraphParsingHelper::setgraphelementattributes(GraphElement* ge, const AttributesMap& attributes)
 {
-  AttributesMap::const_iterator it, it_end;
+  setElementAttributes(ge, attributes, renderOpArena, attributeValues);
+}
+
+void DotGraphParsingHelper::setgraphelementattributes(GraphElement* ge, const StatementAttributes& attributes)
+{
+  setElementAttributes(ge, attributes, renderOpArena, attributeValues);
+}
+
+void DotGraphParsingHelper::setdefaultattributes(GraphElement* ge, DefaultAttributes AttributesScope::*defaults)
+{
+  const DefaultAttributes& attributes = scopes.back().*defaults;
+  DefaultAttributes::const_iterator it, it_end;
   it = attributes.begin(); it_end = attributes.end();
   for (; it != it_end; it++)
   {
-//     qCDebug(KGRAPHVIEWERLIB_LOG) << "    " << QString::fromStdString((*it).first) << "\t=\t'" << QString::fromStdString((*it).second) <<"'";
-    if ((*it).first=="label")
-    {
-      QString label = QString::fromUtf8((*it).second.c_str());
-      label.replace("\\n","\n");
-      (*ge).attributes()["label"] = label;
-    }
-    else
-    {
-      (*ge).attributes()[QString::fromStdString((*it).first)] =
-      QString::fromStdString((*it).second);
-    }
+    ge->attributes()[(*it).first] = (*it).second;
   }
-  
-  DotRenderOpVec ops = ge->renderOperations();
-  if (attributes.find("_draw_") != attributes.end())
+}
+
+void DotGraphParsingHelper::setdefaultattribute(DefaultAttributes& defaults, const DotStringRef& name, const DotStringRef& value)
+{
+  const int symbol = attributeSymbol(name);
+  DefaultAttributes::iterator it, it_end;
+  it = defaults.begin(); it_end = defaults.end();
+  while (it != it_end && (*it).first != symbol)
+  {
+    it++;
+  }
+  if (symbol == DotAttributeSymbols::Label && value == "\\N")
   {
-    parse_renderop((attributes.find("_draw_"))->second, ops);
-//     qCDebug(KGRAPHVIEWERLIB_LOG) << "element renderOperations size is now " << ge->renderOperations().size();
+    // the default label is the element name: an inherited label is dropped
+    if (it != it_end)
+    {
+      defaults.erase(it);
+    }
+    return;
   }
-  if (attributes.find("_ldraw_") != attributes.end())
+  QString str = value.toString();
+  if (symbol == DotAttributeSymbols::Label)
   {
-    parse_renderop(attributes.find("_ldraw_")->second, ops);
-//     qCDebug(KGRAPHVIEWERLIB_LOG) << "element renderOperations size is now " << ge->renderOperations().size();
+    str.replace("\\n","\n");
   }
-  if (attributes.find("_hldraw_") != attributes.end())
+  str = attributeValues.intern(str);
+  if (it != it_end)
   {
-    parse_renderop(attributes.find("_hldraw_")->second, ops);
-//     qCDebug(KGRAPHVIEWERLIB_LOG) << "element renderOperations size is now " << ge->renderOperations().size();
+    (*it).second = str;
   }
-  if (attributes.find("_tldraw_") != attributes.end())
+  else
   {
-    parse_renderop(attributes.find("_tldraw_")->second, ops);
-//     qCDebug(KGRAPHVIEWERLIB_LOG) << "element renderOperations size is now " << ge->renderOperations().size();
+    defaults.push_back(std::make_pair(symbol, str));
   }
-  ge->setRenderOperations(ops);
 }
 
 void DotGraphParsingHelper::setgraphattributes()
 {
 //   qCDebug(KGRAPHVIEWERLIB_LOG) << "Attributes for graph are : ";
-  setgraphelementattributes(graph, graphAttributes);
+  setgraphelementattributes(graph, scopes.back().graphAttributes);
 }
 
 void DotGraphParsingHelper::setsubgraphattributes()
@@ -126,7 +240,7 @@ void DotGraphParsingHelper::setsubgraphattributes()
 //   qCDebug(KGRAPHVIEWERLIB_LOG) << "Attributes for subgraph are : ";
   gs->setZ(z);
 //   qCDebug(KGRAPHVIEWERLIB_LOG) << "z="<<gs->z();
-  setgraphelementattributes(gs, graphAttributes);
+  setgraphelementattributes(gs, scopes.back().graphAttributes);
 }
 
 void DotGraphParsingHelper::setnodeattributes()
@@ -141,7 +255,7 @@ void DotGraphParsingHelper::setnodeattributes()
 //   qCDebug(KGRAPHVIEWERLIB_LOG) << "Attributes for node " << gn->id() << " are : ";
   gn->setZ(z+1);
 //   qCDebug(KGRAPHVIEWERLIB_LOG) << "z="<<gn->z();
-  setgraphelementattributes(gn, nodesAttributes);
+  setgraphelementattributes(gn, attributes);
 }
 
 void DotGraphParsingHelper::setedgeattributes()
@@ -151,39 +265,36 @@ void DotGraphParsingHelper::setedgeattributes()
 //   qCDebug(KGRAPHVIEWERLIB_LOG) << "Attributes for edge " << ge->fromNode()->id() << "->" << ge->toNode()->id() << " are : ";
   ge->setZ(z+1);
 //   qCDebug(KGRAPHVIEWERLIB_LOG) << "z="<<ge->z();
-  setgraphelementattributes(ge, edgesAttributes);
+  // the arrowheads are also part of the edge operations
+  setgraphelementattributes(ge, attributes);
   
-  DotRenderOpVec ops = ge->renderOperations();
-  if (edgesAttributes.find("_tdraw_") != edgesAttributes.end())
+  // the edge is new: it has no arrowheads yet
+  DotRenderOpVec arrowheads(renderOpArena);
+  static const char* const arrowAttributes[] = {"_tdraw_", "_hdraw_"};
+  for (const char* arrowAttribute : arrowAttributes)
   {
-    parse_renderop(edgesAttributes["_tdraw_"], ops);
-//     qCDebug(KGRAPHVIEWERLIB_LOG) << "edge renderOperations size is now " << ge->renderOperations().size();
-    DotRenderOpVec::const_iterator it, it_end;
-    it = ops.constBegin(); it_end = ops.constEnd();
-    for (; it != it_end; it++)
-      ge->arrowheads().push_back(*it);
+    if (const DotStringRef* value = findAttribute(attributes, arrowAttribute))
+    {
+      storeRenderOps(*value, arrowheads);
+    }
   }
-  if (edgesAttributes.find("_hdraw_") != edgesAttributes.end())
+  if (arrowheads.hasPending())
   {
-    parse_renderop(edgesAttributes["_hdraw_"], ops);
-//     qCDebug(KGRAPHVIEWERLIB_LOG) << "edge renderOperations size is now " << ge->renderOperations().size();
-    DotRenderOpVec::const_iterator it, it_end;
-    it = ops.constBegin(); it_end = ops.constEnd();
-    for (; it != it_end; it++)
-      ge->arrowheads().push_back(*it);
+    ge->arrowheads() = arrowheads;
   }
-  ge->setRenderOperations(ops);
 }
 
 void DotGraphParsingHelper::setattributedlist()
 {
 // //   qCDebug(KGRAPHVIEWERLIB_LOG) << "Setting attributes list for " << QString::fromStdString(attributed);
+  AttributesMap* attributedMap = nullptr;
+  DefaultAttributes* defaults = nullptr;
   if (attributed == "graph")
   {
-    if (attributes.find("bb") != attributes.end())
+    if (const DotStringRef* bb = findAttribute(attributes, "bb"))
     {
       std::vector< double > v;
-      parse_reals(attributes["bb"].c_str(), v);
+      parse_reals(bb->toStdString().c_str(), v);
       if (v.size()>=4)
       {
 //         qCDebug(KGRAPHVIEWERLIB_LOG) << "setting width and height to " << v[2] << v[3];
@@ -191,40 +302,37 @@ void DotGraphParsingHelper::setattributedlist()
         graph->height(v[3]);
       }
     }
-    AttributesMap::const_iterator it, it_end;
-    it = attributes.begin(); it_end = attributes.end();
-    for (; it != it_end; it++)
-    {
-//       qCDebug(KGRAPHVIEWERLIB_LOG) << "    " << QString::fromStdString((*it).first) << " = " <<  QString::fromStdString((*it).second);
-      graphAttributes[(*it).first] = (*it).second;
-    }
+    attributedMap = &scopes.back().graphAttributes;
   }
   else if (attributed == "node")
   {
-    AttributesMap::const_iterator it, it_end;
-    it = attributes.begin(); it_end = attributes.end();
-    for (; it != it_end; it++)
-    {
-//       qCDebug(KGRAPHVIEWERLIB_LOG) << "    " << QString::fromStdString((*it).first) << " = " <<  QString::fromStdString((*it).second);
-      nodesAttributes[(*it).first] = (*it).second;
-    }
+    defaults = &scopes.back().nodesAttributes;
   }
   else if (attributed == "edge")
   {
-    AttributesMap::const_iterator it, it_end;
-    it = attributes.begin(); it_end = attributes.end();
-    for (; it != it_end; it++)
+    defaults = &scopes.back().edgesAttributes;
+  }
+  // these attributes are kept after the end of the statement: copy them
+  StatementAttributes::const_iterator it, it_end;
+  it = attributes.begin(); it_end = attributes.end();
+  for (; it != it_end; it++)
+  {
+//     qCDebug(KGRAPHVIEWERLIB_LOG) << "    " << (*it).first.toString() << " = " <<  (*it).second.toString();
+    if (attributedMap)
+    {
+      (*attributedMap)[(*it).first.toStdString()] = (*it).second.toStdString();
+    }
+    else if (defaults)
     {
-//       qCDebug(KGRAPHVIEWERLIB_LOG) << "    " << QString::fromStdString((*it).first) << " = " <<  QString::fromStdString((*it).second);
-      edgesAttributes[(*it).first] = (*it).second;
+      setdefaultattribute(*defaults, (*it).first, (*it).second);
     }
   }
   attributes.clear();
 }
 
-void DotGraphParsingHelper::createnode(const std::string& nodeid)
+void DotGraphParsingHelper::createnode(const DotStringRef& nodeid)
 {
-  QString id = QString::fromStdString(nodeid); 
+  QString id = nodeid.toString(); 
 //   qCDebug(KGRAPHVIEWERLIB_LOG) << id;
   gn = dynamic_cast<GraphNode*>(graph->elementNamed(id));
   if (gn==nullptr && graph->nodes().size() < KGV_MAX_ITEMS_TO_LOAD)
@@ -232,16 +340,17 @@ void DotGraphParsingHelper::createnode(const std::string& nodeid)
 //     qCDebug(KGRAPHVIEWERLIB_LOG) << "Creating a new node" << z << (void*)gs;
     gn = new GraphNode();
     gn->setId(id);
+    setdefaultattributes(gn, &AttributesScope::nodesAttributes);
 //     gn->label(QString::fromStdString(nodeid));
     if (z>0 && gs)
     {
 //       qCDebug(KGRAPHVIEWERLIB_LOG) << "Adding node" << id << "in subgraph" << gs->id();
-      gs->content().push_back(gn);
+      graph->insertInSubgraph(gs, gn);
     }
     else
     {
 //       qCDebug(KGRAPHVIEWERLIB_LOG) << "Adding node" << id;
-      graph->nodes()[id] = gn;
+      graph->insertNode(id, gn);
     }
   }
   edgebounds.clear();
@@ -250,66 +359,99 @@ void DotGraphParsingHelper::createnode(const std::string& nodeid)
 void DotGraphParsingHelper::createsubgraph()
 {
 //   qCDebug(KGRAPHVIEWERLIB_LOG) ;
-  if (phelper)
+  QString str = subgraphid.toString();
+  if (str.isEmpty())
   {
-    std::string str = phelper->subgraphid;
-    if (str.empty())
-    {
-      std::ostringstream oss;
-      oss << "kgv_id_" << phelper->uniq++;
-      str = oss.str();
-    }
-//     qCDebug(KGRAPHVIEWERLIB_LOG) << QString::fromStdString(str);
-    if (graph->subgraphs().find(QString::fromStdString(str)) == graph->subgraphs().end())
-    {
-//       qCDebug(KGRAPHVIEWERLIB_LOG) << "Creating a new subgraph";
-      gs = new GraphSubgraph();
-      gs->setId(QString::fromStdString(str));
-//       gs->label(QString::fromStdString(str)); 
-      graph->subgraphs().insert(QString::fromStdString(str), gs);
-//       qCDebug(KGRAPHVIEWERLIB_LOG) << "there is now"<<graph->subgraphs().size()<<"subgraphs in" << graph;
-    }
-    else
-    {
-//       qCDebug(KGRAPHVIEWERLIB_LOG) << "Found existing subgraph";
-      gs = *(graph->subgraphs().find(QString::fromStdString(str)));
-    }
-    phelper->subgraphid = "";
+    str = QString("kgv_id_") + QString::number(uniq++);
+  }
+//   qCDebug(KGRAPHVIEWERLIB_LOG) << str;
+  gs = graph->subgraphs().value(str, nullptr);
+  if (gs == nullptr)
+  {
+//     qCDebug(KGRAPHVIEWERLIB_LOG) << "Creating a new subgraph";
+    gs = new GraphSubgraph();
+    gs->setId(str);
+//     gs->label(str); 
+    graph->insertSubgraph(str, gs);
+//     qCDebug(KGRAPHVIEWERLIB_LOG) << "there is now"<<graph->subgraphs().size()<<"subgraphs in" << graph;
   }
+  subgraphid = DotStringRef();
+}
+
+void DotGraphParsingHelper::incrz()
+{
+  z++;
+  if (z > maxZ)
+  {
+    maxZ = z;
+  }
+}
+
+void DotGraphParsingHelper::decrz()
+{
+  z--;
+  gs = nullptr;
+}
+
+void DotGraphParsingHelper::pushAttrList()
+{
+//   qCDebug(KGRAPHVIEWERLIB_LOG) << "Pushing attributes";
+  // the values are shared, not copied
+  AttributesScope scope;
+  scope.nodesAttributes = scopes.back().nodesAttributes;
+  scope.edgesAttributes = scopes.back().edgesAttributes;
+  scopes.push_back(scope);
+}
+
+void DotGraphParsingHelper::popAttrList()
+{
+//   qCDebug(KGRAPHVIEWERLIB_LOG) << "Poping attributes";
+  if (scopes.size() > 1)
+  {
+    scopes.pop_back();
+  }
+//   qCDebug(KGRAPHVIEWERLIB_LOG) << "Poped";
 }
 
 void DotGraphParsingHelper::createedges()
 {
 //   qCDebug(KGRAPHVIEWERLIB_LOG);
-  std::string node1Name, node2Name;
-  node1Name = edgebounds.front();
-  edgebounds.pop_front();
-  while (!edgebounds.empty())
+  if (edgebounds.empty())
+  {
+    return;
+  }
+  QString node1Name, node2Name;
+  node1Name = edgebounds.front().toString();
+  for (std::size_t i = 1; i < edgebounds.size(); i++)
   {
-    node2Name = edgebounds.front();
-    edgebounds.pop_front();
+    node2Name = edgebounds[i].toString();
 
     if (graph->nodes().size() >= KGV_MAX_ITEMS_TO_LOAD || graph->edges().size() >= KGV_MAX_ITEMS_TO_LOAD)
     {
-      return;
+      break;
     }
-//     qCDebug(KGRAPHVIEWERLIB_LOG) << QString::fromStdString(node1Name) << ", " << QString::fromStdString(node2Name);
+//     qCDebug(KGRAPHVIEWERLIB_LOG) << node1Name << ", " << node2Name;
     ge = new GraphEdge();
-    GraphElement* gn1 = graph->elementNamed(QString::fromStdString(node1Name));
+    setdefaultattributes(ge, &AttributesScope::edgesAttributes);
+    GraphElement* gn1 = graph->elementNamed(node1Name);
     if (gn1 == nullptr)
     {
 //       qCDebug(KGRAPHVIEWERLIB_LOG) << "new node 1";
-      gn1 = new GraphNode();
-      gn1->setId(QString::fromStdString(node1Name));
-      graph->nodes()[QString::fromStdString(node1Name)] = dynamic_cast<GraphNode*>(gn1);
+      GraphNode* newgn = new GraphNode();
+      newgn->setId(node1Name);
+      setdefaultattributes(newgn, &AttributesScope::nodesAttributes);
+      graph->insertNode(node1Name, newgn);
+      gn1 = newgn;
     }
-    GraphElement* gn2 = graph->elementNamed(QString::fromStdString(node2Name));
+    GraphElement* gn2 = graph->elementNamed(node2Name);
     if (gn2 == nullptr)
     {
 //       qCDebug(KGRAPHVIEWERLIB_LOG) << "new node 2";
-      gn2 = new GraphNode();
-      gn2->setId(QString::fromStdString(node2Name));
-      graph->nodes()[QString::fromStdString(node2Name)] = dynamic_cast<GraphNode*>(gn2);
+      GraphNode* newgn = new GraphNode();
+      newgn->setId(node2Name);
+      setdefaultattributes(newgn, &AttributesScope::nodesAttributes);
+      graph->insertNode(node2Name, newgn);
+      gn2 = newgn;
     }
 //     qCDebug(KGRAPHVIEWERLIB_LOG) << "Found gn1="<<gn1<<" and gn2=" << gn2;
     if (gn1 == nullptr || gn2 == nullptr)
@@ -323,11 +465,13 @@ void DotGraphParsingHelper::createedges()
 //     qCDebug(KGRAPHVIEWERLIB_LOG) << ge->id();
     if (ge->id().isEmpty())
     {
-      ge->setId(QString::fromStdString(node1Name)+QString::fromStdString(node2Name)+QUuid::createUuid().toString().remove('{').remove('}').remove('-'));
+      const QString key = ge->attributes().value("key");
+      const int ordinal = key.isEmpty() ? parallelEdges[qMakePair(gn1, gn2)]++ : 0;
+      ge->setId(GraphEdge::edgeId(node1Name, node2Name, graph->directed(), key, ordinal));
     }
 //     qCDebug(KGRAPHVIEWERLIB_LOG) << ge->id();
 //     qCDebug(KGRAPHVIEWERLIB_LOG) << "num before=" << graph->edges().size();
-    graph->edges().insert(ge->id(), ge);
+    graph->insertEdge(ge->id(), ge);
 //     qCDebug(KGRAPHVIEWERLIB_LOG) << "num after=" << graph->edges().size();
 
 
@@ -19,9 +19,16 @@
 #ifndef DOT_GRAPHPARSINGHELPER_H
 #define DOT_GRAPHPARSINGHELPER_H
 
+#include "dotattributes.h"
+#include "dotlexer.h"
+#include "dotrenderop.h"
+
+#include <QHash>
+#include <QPair>
+
 #include <map>
-#include <list>
 #include <string>
+#include <vector>
 
 namespace KGraphViewer
 {
@@ -34,37 +41,72 @@ class GraphElement;
 struct DotGraphParsingHelper
 {
   typedef std::map< std::string, std::string > AttributesMap;
+  /** The attributes of the statement being parsed. They reference the parsed buffer. */
+  typedef std::vector< std::pair< DotStringRef, DotStringRef > > StatementAttributes;
+
+  /**
+   * Node or edge default attributes, converted and interned once when their
+   * statement is parsed, to be set as they are to each new element
+   */
+  typedef std::vector< std::pair< int, QString > > DefaultAttributes;
+
+  /**
+   * The default attributes set by the graph, node and edge statements of a
+   * block. The graph attributes are only the ones set in the block itself,
+   * while the node and edge defaults include the ones inherited from the
+   * enclosing blocks.
+   */
+  struct AttributesScope
+  {
+    AttributesMap graphAttributes;
+    DefaultAttributes nodesAttributes;
+    DefaultAttributes edgesAttributes;
+  };
 
   DotGraphParsingHelper();
 
-  void createnode(const std::string& nodeid);
+  void createnode(const DotStringRef& nodeid);
   void createsubgraph();
   void setgraphattributes();
   void setsubgraphattributes();
-      void setnodeattributes();
+  void setnodeattributes();
   void setedgeattributes();
   void setattributedlist();
   void createedges();
-  void edgebound(const std::string& bound) {edgebounds.push_back(bound);}
+  void edgebound(const DotStringRef& bound) {edgebounds.push_back(bound);}
+  void incrz();
+  void decrz();
+  void pushAttrList();
+  void popAttrList();
   void finalactions();
   void setgraphelementattributes(GraphElement* ge, const AttributesMap& attributes);
+  void setgraphelementattributes(GraphElement* ge, const StatementAttributes& attributes);
+  /** Sets to ge the node or edge defaults of the current block, inherited ones included */
+  void setdefaultattributes(GraphElement* ge, DefaultAttributes AttributesScope::*defaults);
+  /** Sets in defaults the attribute of a node or edge statement */
+  void setdefaultattribute(DefaultAttributes& defaults, const DotStringRef& name, const DotStringRef& value);
 
-  std::string attrid;
-  std::string valid;
   std::string attributed;
-  std::string subgraphid;
+  DotStringRef subgraphid;
   
   unsigned int uniq;
   
-  AttributesMap attributes;
-  AttributesMap graphAttributes;
-  AttributesMap nodesAttributes;
-  AttributesMap edgesAttributes;
-  std::list< AttributesMap > graphAttributesStack;
-  std::list< AttributesMap > nodesAttributesStack;
-  std::list< AttributesMap > edgesAttributesStack;
+  StatementAttributes attributes;
+  /**
+   * The scopes of the enclosing blocks, the current one last. Entering a
+   * block adds a scope starting with the node and edge defaults of the
+   * enclosing one.
+   */
+  std::vector< AttributesScope > scopes;
   
-  std::list< std::string > edgebounds;
+  std::vector< DotStringRef > edgebounds;
+  /** The number of edges without id nor key already created between two bounds */
+  QHash< QPair< GraphElement*, GraphElement* >, int > parallelEdges;
+
+  /** The storage of the drawing operations of the graph */
+  QSharedPointer< DotRenderOpArena > renderOpArena;
+  /** Shares the attribute values repeated on the elements of the graph */
+  DotAttributeValues attributeValues;
   
   unsigned int z;
   unsigned int maxZ;
@@ -117,9 +117,9 @@ QPainterPath CanvasEdge::shape () const
     return m_shape;
   }
 
-  foreach (const DotRenderOp& dro, edge()->renderOperations())
+  for (const DotRenderOp& dro : edge()->renderOperations())
   {
-    if ( dro.renderop == "B" )
+    if (dro.code == DotRenderOp::BSpline)
     {
       for (int splineNum = 0; splineNum < edge()->colors().count() || (splineNum==0 && edge()->colors().count()==0); splineNum++)
       {
@@ -132,13 +132,15 @@ QPainterPath CanvasEdge::shape () const
 
 QPainterPath CanvasEdge::pathForSpline(int splineNum, const DotRenderOp& dro) const
 {
-  QPolygonF points(dro.integers[0]);
-  for (int i = 0; i < dro.integers[0]; i++)
+  const float* coordinates = edge()->renderOperations().coordinates(dro);
+  const int count = dro.count;
+  QPolygonF points(count);
+  for (int i = 0; i < count; i++)
   {
     // computing of diffX and diffY to draw parallel edges
     // when asked through the corresponding Graphviz feature
-    qreal nom = (dro.integers[2*dro.integers[0]]-dro.integers[2]);
-    qreal denom = (dro.integers[2*dro.integers[0]-1]-dro.integers[1]);
+    qreal nom = (coordinates[2*count-1]-coordinates[1]);
+    qreal denom = (coordinates[2*count-2]-coordinates[0]);
     qreal diffX, diffY;
     if (nom == 0)
     {
@@ -165,8 +167,8 @@ QPainterPath CanvasEdge::pathForSpline(int splineNum, const DotRenderOp& dro) co
     }
     }
     QPointF p(
-        (dro.integers[2*i+1]/*%m_wdhcf*/*m_scaleX) +m_xMargin + diffX,
-        (m_gh-dro.integers[2*i+2]/*%m_hdvcf*/)*m_scaleY + m_yMargin + diffY
+        (coordinates[2*i]/*%m_wdhcf*/*m_scaleX) +m_xMargin + diffX,
+        (m_gh-coordinates[2*i+1]/*%m_hdvcf*/)*m_scaleY + m_yMargin + diffY
     );
     points[i] = p;
 //     qCDebug(KGRAPHVIEWERLIB_LOG) << edge()->fromNode()->id() << "->" << edge()->toNode()->id()  << p;
@@ -224,34 +226,31 @@ Q_UNUSED(widget)
   const QPen oldPen = p->pen();
   const QBrush oldBrush = p->brush();
 
-  foreach (const DotRenderOp& dro, edge()->renderOperations())
+  const DotRenderOpVec& ops = edge()->renderOperations();
+  for (const DotRenderOp& dro : ops)
   {
-    //     qCDebug(KGRAPHVIEWERLIB_LOG) << edge()->fromNode()->id() << "->" << edge()->toNode()->id() << "renderop" << dro.renderop << "; selected:" << edge()->isSelected();
-    if (dro.renderop == "c")
+    //     qCDebug(KGRAPHVIEWERLIB_LOG) << edge()->fromNode()->id() << "->" << edge()->toNode()->id() << "renderop" << dro.name() << "; selected:" << edge()->isSelected();
+    const float* coordinates = ops.coordinates(dro);
+    if (dro.code == DotRenderOp::PenColor)
     {
-      QColor c(dro.str.mid(0,7));
-      bool ok;
-      c.setAlpha(255-dro.str.mid(8).toInt(&ok,16));
-      lineColor = c;
-//       qCDebug(KGRAPHVIEWERLIB_LOG) << "c" << dro.str.mid(0,7) << lineColor;
+      lineColor = ops.color(dro);
+//       qCDebug(KGRAPHVIEWERLIB_LOG) << "c" << ops.text(dro) << lineColor;
     }
-    else if (dro.renderop == "C")
+    else if (dro.code == DotRenderOp::FillColor)
     {
-      QColor c(dro.str.mid(0,7));
-      bool ok;
-      c.setAlpha(255-dro.str.mid(8).toInt(&ok,16));
+      QColor c = ops.color(dro);
 /*      if (m_hovered && m_view->highlighting())
       {
         c = c.lighter();
       }*/
       backColor = c;
-//       qCDebug(KGRAPHVIEWERLIB_LOG) << "C" << dro.str.mid(0,7) << backColor;
+//       qCDebug(KGRAPHVIEWERLIB_LOG) << "C" << ops.text(dro) << backColor;
     }
-    else if ( dro.renderop == "T" )
+    else if (dro.code == DotRenderOp::Text)
     {
-      const QString& str = dro.str;
+      const QString& str = ops.text(dro);
     
-      qreal stringWidthGoal = dro.integers[3] * m_scaleX;
+      qreal stringWidthGoal = coordinates[3] * m_scaleX;
       int fontSize = edge()->fontSize();
       m_font->setPointSize(fontSize);
       QFontMetrics fm(*m_font);
@@ -268,13 +267,13 @@ Q_UNUSED(widget)
 
       qreal x = (m_scaleX *
                        (
-                         (dro.integers[0])
-                         + (((-dro.integers[2])*(fm.width(dro.str)))/2)
-                         - ( (fm.width(dro.str))/2 )
+                         (coordinates[0])
+                         + (((-coordinates[2])*(fm.width(str)))/2)
+                         - ( (fm.width(str))/2 )
                        )
                       )
                       + m_xMargin;
-      qreal y = ((m_gh - (dro.integers[1]))*m_scaleY)+ m_yMargin;
+      qreal y = ((m_gh - (coordinates[1]))*m_scaleY)+ m_yMargin;
       QPointF point(x,y);
 //       qCDebug(KGRAPHVIEWERLIB_LOG) << edge()->fromNode()->id() << "->" << edge()->toNode()->id() << "drawText" << edge()->fontColor() << point;
 
@@ -283,20 +282,20 @@ Q_UNUSED(widget)
       p->setFont(oldFont);
       p->setPen(oldPen);
     }      
-    else if (( dro.renderop == "p" ) || (dro.renderop == "P" ))
+    else if (dro.isPolygon())
     {
-      QPolygonF polygon(dro.integers[0]);
-      for (int i = 0; i < dro.integers[0]; i++)
+      QPolygonF polygon(dro.count);
+      for (int i = 0; i < int(dro.count); i++)
       {
         QPointF point(
-            (int(dro.integers[2*i+1])/*%m_wdhcf*/)*m_scaleX +m_xMargin,
-            (int(m_gh-dro.integers[2*i+2])/*%m_hdvcf*/)*m_scaleY + m_yMargin
+            (coordinates[2*i]/*%m_wdhcf*/)*m_scaleX +m_xMargin,
+            (m_gh-coordinates[2*i+1]/*%m_hdvcf*/)*m_scaleY + m_yMargin
                 );
         polygon[i] = point;
 //         qCDebug(KGRAPHVIEWERLIB_LOG) << edge()->fromNode()->id() << "->" << edge()->toNode()->id()  << point;
         allPoints.append(point);
       }
-      if (dro.renderop == "P" )
+      if (dro.code == DotRenderOp::FilledPolygon)
       {
         p->setBrush(lineColor);
         p->drawPolygon(polygon);
@@ -324,13 +323,13 @@ Q_UNUSED(widget)
       p->setPen(oldPen);
       p->setBrush(oldBrush);
     }
-    else if (( dro.renderop == "e" ) || (dro.renderop == "E" ))
+    else if (dro.isEllipse())
     {
-      qreal w = m_scaleX * dro.integers[2] * 2;
-      qreal h = m_scaleY *  dro.integers[3] * 2;
-      qreal x = (m_xMargin + (dro.integers[0]/*%m_wdhcf*/)*m_scaleX) - w/2;
-      qreal y = ((m_gh -  dro.integers[1]/*%m_hdvcf*/)*m_scaleY + m_yMargin) - h/2;
-      if (dro.renderop == "E" )
+      qreal w = m_scaleX * coordinates[2] * 2;
+      qreal h = m_scaleY *  coordinates[3] * 2;
+      qreal x = (m_xMargin + (coordinates[0]/*%m_wdhcf*/)*m_scaleX) - w/2;
+      qreal y = ((m_gh -  coordinates[1]/*%m_hdvcf*/)*m_scaleY + m_yMargin) - h/2;
+      if (dro.code == DotRenderOp::FilledEllipse)
       {
         p->setBrush(lineColor);
       }
@@ -356,7 +355,7 @@ Q_UNUSED(widget)
       p->setPen(oldPen);
       p->setBrush(oldBrush);
     }
-    else if ( dro.renderop == "B" )
+    else if (dro.code == DotRenderOp::BSpline)
     {
       uint lineWidth = 1;
       QPen pen;
@@ -375,16 +374,16 @@ Q_UNUSED(widget)
         lineWidth = edge()->style().mid(12, edge()->style().length()-1-12).toInt(&ok);
         pen.setWidth(int(lineWidth * widthScaleFactor));
       }
-      if (edge()->attributes().contains("penwidth"))
+      if (edge()->attributes().contains(DotAttributeSymbols::PenWidth))
       {
         bool ok;
-        lineWidth = edge()->attributes()["penwidth"].toInt(&ok);
+        lineWidth = edge()->attributes().value(DotAttributeSymbols::PenWidth).toInt(&ok);
         pen.setWidth(int(lineWidth * widthScaleFactor));
       }
-      if (edge()->attributes().contains("color"))
+      if (edge()->attributes().contains(DotAttributeSymbols::Color))
       {
-        qCDebug(KGRAPHVIEWERLIB_LOG) << "set edge color to " << QColor(edge()->attributes()["color"]).name();
-        lineColor = QColor(edge()->attributes()["color"]);
+        lineColor = QColor(edge()->attributes().value(DotAttributeSymbols::Color));
+        qCDebug(KGRAPHVIEWERLIB_LOG) << "set edge color to " << lineColor.name();
       }
       for (int splineNum = 0; splineNum < edge()->colors().count() || (splineNum==0 && edge()->colors().count()==0); splineNum++)
       {
@@ -443,7 +442,11 @@ void CanvasEdge::computeBoundingRect()
 //   qCDebug(KGRAPHVIEWERLIB_LOG);
   //invalidate bounding region cache
   m_shape = QPainterPath();
-  if (edge()->renderOperations().isEmpty())
+  if (edge()->hasPendingRenderOperations() && computeBoundingRectFromPos())
+  {
+    // the operations will be decoded when first painted
+  }
+  else if (edge()->renderOperations().isEmpty())
   {
     if ((edge()->fromNode()->canvasElement() == nullptr)
       || (edge()->toNode()->canvasElement() == nullptr)
@@ -463,17 +466,19 @@ void CanvasEdge::computeBoundingRect()
   else
   {
     QPolygonF points;
-    foreach (const DotRenderOp& dro, edge()->renderOperations())
+    const DotRenderOpVec& ops = edge()->renderOperations();
+    for (const DotRenderOp& dro : ops)
     {
-//       qCDebug(KGRAPHVIEWERLIB_LOG) << dro.renderop  << ", ";
-      if ( (dro.renderop != "B") && (dro.renderop != "p") &&  (dro.renderop != "P") ) continue;
+//       qCDebug(KGRAPHVIEWERLIB_LOG) << dro.name()  << ", ";
+      if ((dro.code != DotRenderOp::BSpline) && !dro.isPolygon()) continue;
+      const float* coordinates = ops.coordinates(dro);
       uint previousSize = points.size();
-      points.resize(previousSize+dro.integers[0]);
-      for (int i = 0; i < dro.integers[0]; i++)
+      points.resize(previousSize+dro.count);
+      for (int i = 0; i < int(dro.count); i++)
       {
         QPointF p(
-            ((dro.integers[2*i+1]/*%m_wdhcf*/)*m_scaleX) +m_xMargin,
-            ((m_gh-dro.integers[2*i+2]/*%m_hdvcf*/)*m_scaleY) + m_yMargin
+            ((coordinates[2*i]/*%m_wdhcf*/)*m_scaleX) +m_xMargin,
+            ((m_gh-coordinates[2*i+1]/*%m_hdvcf*/)*m_scaleY) + m_yMargin
                 );
         points[previousSize+i] = p;
       }
@@ -497,6 +502,53 @@ void CanvasEdge::computeBoundingRect()
   qCDebug(KGRAPHVIEWERLIB_LOG) << edge()->fromNode()->id() << "->" << edge()->toNode()->id() << "New bounding rect is:" << m_boundingRect;
 }
 
+bool CanvasEdge::computeBoundingRectFromPos()
+{
+  // pos is "[e,x,y] [s,x,y] x1,y1 x2,y2 ..." with possibly several splines
+  // separated by semicolons
+  QString pos = edge()->attributes().value(DotAttributeSymbols::Pos);
+  if (pos.isEmpty())
+  {
+    return false;
+  }
+  pos.replace(QLatin1Char(';'), QLatin1Char(' '));
+  qreal left = 0, top = 0, right = 0, bottom = 0;
+  bool first = true;
+  for (const QStringRef& point : pos.splitRef(QLatin1Char(' '), QString::SkipEmptyParts))
+  {
+    const QVector<QStringRef> coordinates = point.split(',');
+    if (coordinates.size() < 2)
+    {
+      return false;
+    }
+    // skip the e or s marker of the end points
+    const int offset = coordinates.size() - 2;
+    bool okX, okY;
+    const qreal x = coordinates[offset].toDouble(&okX)*m_scaleX + m_xMargin;
+    const qreal y = (m_gh - coordinates[offset+1].toDouble(&okY))*m_scaleY + m_yMargin;
+    if (!okX || !okY)
+    {
+      return false;
+    }
+    if (first)
+    {
+      left = right = x;
+      top = bottom = y;
+      first = false;
+    }
+    left = qMin(left, x); right = qMax(right, x);
+    top = qMin(top, y); bottom = qMax(bottom, y);
+  }
+  if (first)
+  {
+    return false;
+  }
+  // room for the arrowheads drawn around the end points
+  const qreal adjust = 5 * qMax(m_scaleX, m_scaleY);
+  m_boundingRect = QRectF(QPointF(left, top), QPointF(right, bottom)).adjusted(-adjust, -adjust, adjust, adjust);
+  return true;
+}
+
 void CanvasEdge::mousePressEvent(QGraphicsSceneMouseEvent * event)
 {
   qCDebug(KGRAPHVIEWERLIB_LOG) << event;
@@ -98,6 +98,12 @@ protected:
   
 private:
   QPainterPath pathForSpline(int splineNum, const DotRenderOp& dro) const;
+  /**
+   * Computes the bounding rectangle from the control points of the pos
+   * attribute, without decoding the drawing operations.
+   * @return false if the attribute is missing or invalid
+   */
+  bool computeBoundingRectFromPos();
   qreal distance(const QPointF& point1, const QPointF& point2);
   
   qreal m_scaleX, m_scaleY;
@@ -162,7 +162,11 @@ void CanvasElement::computeBoundingRect()
   
   qreal adjust = 0.5;
   QRectF rect;
-  if (element()->renderOperations().isEmpty())
+  if (element()->hasPendingRenderOperations() && computeBoundingRectFromAttributes())
+  {
+    // the operations will be decoded when first painted
+  }
+  else if (element()->renderOperations().isEmpty())
   {
     qCDebug(KGRAPHVIEWERLIB_LOG) << "no render operation";
     rect = QRectF(0,0,(m_view->defaultNewElementPixmap().size().width())*m_scaleX,(m_view->defaultNewElementPixmap().size().height())*m_scaleY);
@@ -170,40 +174,32 @@ void CanvasElement::computeBoundingRect()
   }
   else
   {
-    DotRenderOpVec::const_iterator it, it_end;
-    it = element()->renderOperations().constBegin(); it_end = element()->renderOperations().constEnd();
-    for (; it != it_end; it++)
+    const DotRenderOpVec& ops = element()->renderOperations();
+    for (const DotRenderOp& op : ops)
     {
 #if RENDER_DEBUG
-      QString msg;
-      QTextStream dd(&msg);
-      dd << element()->id() << " an op: " << (*it).renderop << " ";
-      foreach (int i, (*it).integers)
-      {
-        dd << i << " ";
-      }
-      dd << (*it).str;
-      qCDebug(KGRAPHVIEWERLIB_LOG) << msg;
+      qCDebug(KGRAPHVIEWERLIB_LOG) << element()->id() << " an op: " << op.name();
 #endif
 
-      if ((*it).renderop == "e" || (*it).renderop == "E")
+      const float* coordinates = ops.coordinates(op);
+      if (op.isEllipse())
       {
-//         qCDebug(KGRAPHVIEWERLIB_LOG) << "integers[0]=" << (*it).integers[0] << ";
-        qreal w = m_scaleX * (*it).integers[2] * 2;
-        qreal h = m_scaleY * (*it).integers[3] * 2;
-        qreal x = m_xMargin + (((*it).integers[0])*m_scaleX) - w/2;
-        qreal y = ((m_gh - (*it).integers[1])*m_scaleY) + m_yMargin - h/2;
+//         qCDebug(KGRAPHVIEWERLIB_LOG) << "coordinates[0]=" << coordinates[0] << ";
+        qreal w = m_scaleX * coordinates[2] * 2;
+        qreal h = m_scaleY * coordinates[3] * 2;
+        qreal x = m_xMargin + ((coordinates[0])*m_scaleX) - w/2;
+        qreal y = ((m_gh - coordinates[1])*m_scaleY) + m_yMargin - h/2;
         m_boundingRect = QRectF(x - adjust,y - adjust, w + adjust, h + adjust);
 //         qCDebug(KGRAPHVIEWERLIB_LOG) << "'" << element()->id() << "' set rect for ellipse to " << rect;
       }
-      else if  ((*it).renderop == "p" || (*it).renderop == "P")
+      else if (op.isPolygon())
       {
-        QPolygonF polygon((*it).integers[0]);
-        for (int i = 0; i < (*it).integers[0]; i++)
+        QPolygonF polygon(op.count);
+        for (int i = 0; i < int(op.count); i++)
         {
           qreal x,y;
-          x = (*it).integers[2*i+1];
-          y = (*it).integers[2*i+2];
+          x = coordinates[2*i];
+          y = coordinates[2*i+1];
           {
 
           }
@@ -221,6 +217,60 @@ void CanvasElement::computeBoundingRect()
   setPos(0,0);
 }
 
+bool CanvasElement::computeBoundingRectFromAttributes()
+{
+  const DotAttributes& attributes = element()->attributes();
+  bool ok = true;
+  if (attributes.contains("bb"))
+  {
+    const QVector<QStringRef> bb = attributes["bb"].splitRef(',');
+    if (bb.size() != 4)
+    {
+      return false;
+    }
+    bool okCoordinates[4];
+    const qreal llx = bb[0].toDouble(&okCoordinates[0]);
+    const qreal lly = bb[1].toDouble(&okCoordinates[1]);
+    const qreal urx = bb[2].toDouble(&okCoordinates[2]);
+    const qreal ury = bb[3].toDouble(&okCoordinates[3]);
+    for (bool okCoordinate : okCoordinates)
+    {
+      ok = ok && okCoordinate;
+    }
+    if (!ok)
+    {
+      return false;
+    }
+    m_boundingRect = QRectF(llx*m_scaleX + m_xMargin, (m_gh - ury)*m_scaleY + m_yMargin,
+                            (urx - llx)*m_scaleX, (ury - lly)*m_scaleY);
+    return true;
+  }
+
+  if (!attributes.contains("pos") || !attributes.contains("width") || !attributes.contains("height"))
+  {
+    return false;
+  }
+  const QVector<QStringRef> pos = attributes["pos"].splitRef(',');
+  if (pos.size() < 2)
+  {
+    return false;
+  }
+  bool okX, okY, okW, okH;
+  const qreal x = pos[0].toDouble(&okX);
+  const qreal y = pos[1].toDouble(&okY);
+  // width and height are in inches, the coordinates in points
+  const qreal w = attributes["width"].toDouble(&okW) * 72 * m_scaleX;
+  const qreal h = attributes["height"].toDouble(&okH) * 72 * m_scaleY;
+  if (!okX || !okY || !okW || !okH)
+  {
+    return false;
+  }
+  const qreal adjust = 0.5;
+  m_boundingRect = QRectF(m_xMargin + x*m_scaleX - w/2 - adjust, (m_gh - y)*m_scaleY + m_yMargin - h/2 - adjust,
+                          w + adjust, h + adjust);
+  return true;
+}
+
 ///TODO: optimize more!
 void CanvasElement::paint(QPainter* p, const QStyleOptionGraphicsItem *option,
 QWidget *widget)
@@ -238,30 +288,21 @@ QWidget *widget)
     widthScaleFactor = 1;
   }
 
+  const DotRenderOpVec& ops = element()->renderOperations();
+
 #if RENDER_DEBUG
-  QString msg;
-  QTextStream dd(&msg);
-  foreach (const DotRenderOp &op, element()->renderOperations())
+  for (const DotRenderOp& op : ops)
   {
-    dd << element()->id() << " an op: " << op.renderop << " ";
-    foreach (int i, op.integers)
-    {
-      dd << i << " ";
-    }
-    dd << op.str << endl;
+    qCDebug(KGRAPHVIEWERLIB_LOG) << element()->id() << " an op: " << op.name();
   }
-  qCDebug(KGRAPHVIEWERLIB_LOG) << msg;
 #endif
 
-  if (element()->renderOperations().isEmpty() && m_view->isReadWrite())
+  if (ops.isEmpty() && m_view->isReadWrite())
   {
     qCWarning(KGRAPHVIEWERLIB_LOG) << element()->id() << ": no render operation. This should not happen.";
     return;
   }
 
-  QListIterator<DotRenderOp> it(element()->renderOperations());
-//   it.toBack();
-
   QColor lineColor = Dot2QtConsts::componentData().qtColor(element()->lineColor());
   QColor backColor = Dot2QtConsts::componentData().qtColor(element()->backColor());
   if (m_hovered && m_view->highlighting())
@@ -273,42 +314,37 @@ QWidget *widget)
   const QBrush oldBrush = p->brush();
   const QFont oldFont = p->font();
 
-  while (it.hasNext())
+  for (const DotRenderOp& dro : ops)
   {
-    const DotRenderOp& dro = it.next();
-    if (dro.renderop == "c")
+    const float* coordinates = ops.coordinates(dro);
+    if (dro.code == DotRenderOp::PenColor)
     {
-      QColor c(dro.str.mid(0,7));
-      bool ok;
-      c.setAlpha(255-dro.str.mid(8).toInt(&ok,16));
-      lineColor = c;
-//       qCDebug(KGRAPHVIEWERLIB_LOG) << "c" << dro.str.mid(0,7) << lineColor;
+      lineColor = ops.color(dro);
+//       qCDebug(KGRAPHVIEWERLIB_LOG) << "c" << ops.text(dro) << lineColor;
     }
-    else if (dro.renderop == "C")
+    else if (dro.code == DotRenderOp::FillColor)
     {
-      QColor c(dro.str.mid(0,7));
-      bool ok;
-      c.setAlpha(255-dro.str.mid(8).toInt(&ok,16));
+      QColor c = ops.color(dro);
       if (m_hovered && m_view->highlighting())
       {
         c = c.lighter();
       }
       backColor = c;
-//       qCDebug(KGRAPHVIEWERLIB_LOG) << "C" << dro.str.mid(0,7) << backColor;
+//       qCDebug(KGRAPHVIEWERLIB_LOG) << "C" << ops.text(dro) << backColor;
     }
-    else if (dro.renderop == "e" || dro.renderop == "E")
+    else if (dro.isEllipse())
     {
       QPen pen = oldPen;
-      qreal w = m_scaleX * dro.integers[2] * 2;
-      qreal h = m_scaleY * dro.integers[3] * 2;
-      qreal x = m_xMargin + (dro.integers[0]*m_scaleX) - w/2;
-      qreal y = ((m_gh - dro.integers[1])*m_scaleY) + m_yMargin - h/2;
+      qreal w = m_scaleX * coordinates[2] * 2;
+      qreal h = m_scaleY * coordinates[3] * 2;
+      qreal x = m_xMargin + (coordinates[0]*m_scaleX) - w/2;
+      qreal y = ((m_gh - coordinates[1])*m_scaleY) + m_yMargin - h/2;
       QRectF rect(x,y,w,h);
       pen.setColor(lineColor);
-      if (element()->attributes().contains("penwidth"))
+      if (element()->attributes().contains(DotAttributeSymbols::PenWidth))
       {
         bool ok;
-        int lineWidth = element()->attributes()["penwidth"].toInt(&ok);
+        int lineWidth = element()->attributes().value(DotAttributeSymbols::PenWidth).toInt(&ok);
         pen.setWidth(int(lineWidth * widthScaleFactor));
       }
 
@@ -319,21 +355,21 @@ QWidget *widget)
 //       rect = QRectF(0,0,100,100);
       p->drawEllipse(rect);
     }
-    else if(dro.renderop == "p" || dro.renderop == "P")
+    else if (dro.isPolygon())
     {
 //       std::cerr << "Drawing polygon for node '"<<element()->id()<<"': ";
-      QPolygonF points(dro.integers[0]);
-      for (int i = 0; i < dro.integers[0]; i++)
+      QPolygonF points(dro.count);
+      for (int i = 0; i < int(dro.count); i++)
       {
         qreal x,y;
-        x = dro.integers[2*i+1];
-        y = dro.integers[2*i+2];
+        x = coordinates[2*i];
+        y = coordinates[2*i+1];
         QPointF p(
                   (x*m_scaleX) + m_xMargin,
                   ((m_gh-y)*m_scaleY) + m_yMargin
                 );
-/*        qCDebug(KGRAPHVIEWERLIB_LOG) << "    point: (" << dro.integers[2*i+1] << ","
-                  << dro.integers[2*i+2] << ") " */
+/*        qCDebug(KGRAPHVIEWERLIB_LOG) << "    point: (" << coordinates[2*i] << ","
+                  << coordinates[2*i+1] << ") " */
         points[i] = p;
       }
 
@@ -344,10 +380,10 @@ QWidget *widget)
         pen.setStyle(Qt::SolidLine);
         pen.setWidth(2);
       }
-      if (element()->attributes().contains("penwidth"))
+      if (element()->attributes().contains(DotAttributeSymbols::PenWidth))
       {
         bool ok;
-        int lineWidth = element()->attributes()["penwidth"].toInt(&ok);
+        int lineWidth = element()->attributes().value(DotAttributeSymbols::PenWidth).toInt(&ok);
         pen.setWidth(int(lineWidth * widthScaleFactor));
       }
       else if (element()->style() != "filled")
@@ -388,39 +424,33 @@ QWidget *widget)
   p->setBrush(oldBrush);
   p->setPen(oldPen);
 
-  it.toFront();
-  while (it.hasNext())
+  for (const DotRenderOp& dro : ops)
   {
-    const DotRenderOp& dro = it.next();
-    if (dro.renderop == "c")
+    if (dro.code == DotRenderOp::PenColor)
     {
-      QColor c(dro.str.mid(0,7));
-      bool ok;
-      c.setAlpha(255-dro.str.mid(8).toInt(&ok,16));
-      lineColor = c;
-//       qCDebug(KGRAPHVIEWERLIB_LOG) << "c" << dro.str.mid(0,7) << lineColor;
+      lineColor = ops.color(dro);
+//       qCDebug(KGRAPHVIEWERLIB_LOG) << "c" << ops.text(dro) << lineColor;
     }
-    else if (dro.renderop == "C")
+    else if (dro.code == DotRenderOp::FillColor)
     {
-      QColor c(dro.str.mid(0,7));
-      bool ok;
-      c.setAlpha(255-dro.str.mid(8).toInt(&ok,16));
+      QColor c = ops.color(dro);
       if (m_hovered && m_view->highlighting())
       {
         c = c.lighter();
       }
       backColor = c;
-//       qCDebug(KGRAPHVIEWERLIB_LOG) << "C" << dro.str.mid(0,7) << backColor;
+//       qCDebug(KGRAPHVIEWERLIB_LOG) << "C" << ops.text(dro) << backColor;
     }
-    else if ( dro.renderop == "L" )
+    else if (dro.code == DotRenderOp::Polyline)
     {
 //       qCDebug(KGRAPHVIEWERLIB_LOG) << "Label";
-      QPolygonF points(dro.integers[0]);
-      for (int i = 0; i < dro.integers[0]; i++)
+      const float* coordinates = ops.coordinates(dro);
+      QPolygonF points(dro.count);
+      for (int i = 0; i < int(dro.count); i++)
       {
         qreal x,y;
-        x = dro.integers[2*i+1];
-        y = dro.integers[2*i+2];
+        x = coordinates[2*i];
+        y = coordinates[2*i+1];
         QPointF p(
                   (x*m_scaleX) +m_xMargin,
                   ((m_gh-y)*m_scaleY) + m_yMargin
@@ -446,31 +476,31 @@ QWidget *widget)
 
 //   qCDebug(KGRAPHVIEWERLIB_LOG) << "Drawing" << element()->id() << "labels";
   QString color = lineColor.name();
-  it.toFront();
   uint num_T = 0;
-  while (it.hasNext())
+  for (const DotRenderOp& dro : ops)
   {
-    const DotRenderOp& dro = it.next();
-    if (dro.renderop == "c" || dro.renderop == "C")
+    const float* coordinates = ops.coordinates(dro);
+    if (dro.isColor())
     {
-      color = dro.str.mid(0,7);
-//       qCDebug(KGRAPHVIEWERLIB_LOG) << dro.renderop << color;
+      color = ops.text(dro);
+//       qCDebug(KGRAPHVIEWERLIB_LOG) << dro.name() << color;
     }
-    else if (dro.renderop == "F")
+    else if (dro.code == DotRenderOp::Font)
     {
-      element()->setFontName(dro.str);
-      element()->setFontSize(dro.integers[0]);
+      element()->setFontName(ops.text(dro));
+      element()->setFontSize(int(coordinates[0]));
 //       qCDebug(KGRAPHVIEWERLIB_LOG) << "F" << element()->fontName() << element()->fontColor() << element()->fontSize();
     }
-    else if ( dro.renderop == "T" )
+    else if (dro.code == DotRenderOp::Text)
     {
+      const QString& str = ops.text(dro);
       ++num_T;
       // we suppose here that the color has been set just before
       element()->setFontColor(color);
       // draw a label
-//       qCDebug(KGRAPHVIEWERLIB_LOG) << "Drawing a label " << dro.integers[0]
-//       << " " << dro.integers[1] << " " << dro.integers[2]
-//       << " " << dro.integers[3] << " " << dro.str
+//       qCDebug(KGRAPHVIEWERLIB_LOG) << "Drawing a label " << coordinates[0]
+//       << " " << coordinates[1] << " " << coordinates[2]
+//       << " " << coordinates[3] << " " << str
 //         << " (" << element()->fontName() << ", " << element()->fontSize()
 //         << ", " << element()->fontColor() << ")";
 
@@ -486,19 +516,19 @@ QWidget *widget)
         }
       }
       if (!cacheValid) {
-        int stringWidthGoal = int(dro.integers[3] * m_scaleX);
+        int stringWidthGoal = int(coordinates[3] * m_scaleX);
         int fontSize = element()->fontSize();
         m_font->setPointSize(fontSize);
 
         QFontMetrics fm(*m_font);
-        fontWidth = fm.width(dro.str);
+        fontWidth = fm.width(str);
         while (fontWidth > stringWidthGoal && fontSize > 1)
         {
             // use floor'ed extrapolated font size
             fontSize = double(stringWidthGoal) / fontWidth * fontSize;
             m_font->setPointSize(fontSize);
             fm = QFontMetrics(*m_font);
-            fontWidth = fm.width(dro.str);
+            fontWidth = fm.width(str);
         }
         m_fontSizeCache[num_T] = qMakePair(fontSize, fontWidth);
       }
@@ -509,16 +539,16 @@ QWidget *widget)
       p->setPen(pen);
       qreal x = (m_scaleX *
                        (
-                         (dro.integers[0])
-                         + (((-dro.integers[2])*(fontWidth))/2)
+                         (coordinates[0])
+                         + (((-coordinates[2])*(fontWidth))/2)
                          - ( (fontWidth)/2 )
                        )
                       )
                       + m_xMargin;
-      qreal y = ((m_gh - (dro.integers[1]))*m_scaleY)+ m_yMargin;
+      qreal y = ((m_gh - (coordinates[1]))*m_scaleY)+ m_yMargin;
       QPointF point(x,y);
 //       qCDebug(KGRAPHVIEWERLIB_LOG) << element()->id() << "drawText" << point << " " << fontSize;
-      p->drawText(point, dro.str);
+      p->drawText(point, str);
     }
   }
 
@@ -70,6 +70,14 @@ protected:
   void hoverEnterEvent(QGraphicsSceneHoverEvent* event) override;
   void hoverLeaveEvent(QGraphicsSceneHoverEvent* event) override;
 
+  /**
+   * Computes the bounding rectangle from the layout attributes, without
+   * decoding the drawing operations: bb for subgraphs and pos, width and
+   * height for nodes.
+   * @return false if the attributes are missing or invalid
+   */
+  bool computeBoundingRectFromAttributes();
+
   qreal m_scaleX, m_scaleY;
   qreal m_xMargin, m_yMargin, m_gh;
   GraphElement* m_element;
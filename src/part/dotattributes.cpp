@@ -0,0 +1,230 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+#include "dotattributes.h"
+
+#include <QAtomicPointer>
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+
+#include <cstring>
+
+namespace KGraphViewer
+{
+
+namespace
+{
+
+/**
+ * A state of the table. It is never modified once published: the lookups
+ * read the current one without locking, an addition publishes a copy.
+ */
+struct Symbols
+{
+  QHash<QString, int> symbols;
+  /** The same symbols, to look up names read from a buffer without converting them */
+  QHash<QByteArray, int> utf8Symbols;
+  QVector<QString> names;
+};
+
+struct SymbolTable
+{
+  SymbolTable()
+  {
+    // in the order of DotAttributeSymbols::WellKnown
+    static const char* const wellKnown[] = {"id", "label", "style", "shape", "shapefile", "color",
+                                            "bgcolor", "URL", "fontsize", "fontname", "fontcolor",
+                                            "fillcolor", "z", "penwidth", "pos"};
+    Symbols* initial = new Symbols;
+    for (const char* name : wellKnown)
+    {
+      const QString symbolName = QString::fromUtf8(name);
+      initial->symbols.insert(symbolName, initial->names.size());
+      initial->utf8Symbols.insert(symbolName.toUtf8(), initial->names.size());
+      initial->names.append(symbolName);
+    }
+    states.append(initial);
+    current.store(initial);
+  }
+
+  ~SymbolTable()
+  {
+    qDeleteAll(states);
+  }
+
+  inline const Symbols* symbols() const {return current.loadAcquire();}
+
+  /** Adds name if it is not in the table yet */
+  int add(const QString& name)
+  {
+    QMutexLocker locker(&mutex);
+    // another thread may have added it meanwhile
+    const Symbols* last = current.load();
+    const QHash<QString, int>::const_iterator it = last->symbols.constFind(name);
+    if (it != last->symbols.constEnd())
+    {
+      return it.value();
+    }
+    // the previous states are kept, as lookups may still be reading them
+    Symbols* next = new Symbols(*last);
+    const int symbol = next->names.size();
+    next->names.append(name);
+    next->symbols.insert(name, symbol);
+    next->utf8Symbols.insert(name.toUtf8(), symbol);
+    states.append(next);
+    current.storeRelease(next);
+    return symbol;
+  }
+
+  QMutex mutex;
+  QAtomicPointer<const Symbols> current;
+  QVector<const Symbols*> states;
+};
+
+SymbolTable& symbolTable()
+{
+  static SymbolTable table;
+  return table;
+}
+
+}
+
+int DotAttributeSymbols::find(const QString& name)
+{
+  return symbolTable().symbols()->symbols.value(name, -1);
+}
+
+int DotAttributeSymbols::symbol(const QString& name)
+{
+  const int found = find(name);
+  return (found >= 0) ? found : symbolTable().add(name);
+}
+
+int DotAttributeSymbols::symbol(const char* first, const char* last)
+{
+  const Symbols* symbols = symbolTable().symbols();
+  const QHash<QByteArray, int>::const_iterator it = symbols->utf8Symbols.constFind(QByteArray::fromRawData(first, int(last - first)));
+  if (it != symbols->utf8Symbols.constEnd())
+  {
+    return it.value();
+  }
+  return symbol(QString::fromUtf8(first, int(last - first)));
+}
+
+int DotAttributeSymbols::symbol(const char* name)
+{
+  return symbol(name, name + strlen(name));
+}
+
+QString DotAttributeSymbols::name(int symbol)
+{
+  return symbolTable().symbols()->names.value(symbol);
+}
+
+DotAttributes& DotAttributes::operator=(const QMap<QString,QString>& map)
+{
+  m_entries.clear();
+  m_entries.reserve(map.size());
+  QMap<QString,QString>::const_iterator it = map.constBegin();
+  for (; it != map.constEnd(); it++)
+  {
+    Entry entry = {DotAttributeSymbols::symbol(it.key()), it.value()};
+    m_entries.append(entry);
+  }
+  return *this;
+}
+
+QMap<QString,QString> DotAttributes::toMap() const
+{
+  QMap<QString,QString> map;
+  for (const Entry& entry : m_entries)
+  {
+    map.insert(DotAttributeSymbols::name(entry.symbol), entry.value);
+  }
+  return map;
+}
+
+int DotAttributes::indexOf(int symbol) const
+{
+  for (int i = 0; i < m_entries.size(); i++)
+  {
+    if (m_entries[i].symbol == symbol)
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+QString DotAttributes::value(int symbol, const QString& defaultValue) const
+{
+  const int i = indexOf(symbol);
+  return (i >= 0) ? m_entries[i].value : defaultValue;
+}
+
+QString& DotAttributes::operator[](int symbol)
+{
+  int i = indexOf(symbol);
+  if (i < 0)
+  {
+    Entry entry = {symbol, QString()};
+    m_entries.append(entry);
+    i = m_entries.size() - 1;
+  }
+  return m_entries[i].value;
+}
+
+int DotAttributes::remove(int symbol)
+{
+  const int i = indexOf(symbol);
+  if (i < 0)
+  {
+    return 0;
+  }
+  m_entries.remove(i);
+  return 1;
+}
+
+QList<QString> DotAttributes::keys() const
+{
+  QList<QString> keys;
+  keys.reserve(m_entries.size());
+  for (const Entry& entry : m_entries)
+  {
+    keys.append(DotAttributeSymbols::name(entry.symbol));
+  }
+  return keys;
+}
+
+QString DotAttributeValues::intern(const QString& value)
+{
+  if (value.size() > MaxInternedSize)
+  {
+    return value;
+  }
+  const QSet<QString>::const_iterator it = m_values.constFind(value);
+  if (it != m_values.constEnd())
+  {
+    return *it;
+  }
+  m_values.insert(value);
+  return value;
+}
+
+}
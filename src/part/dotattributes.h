@@ -0,0 +1,177 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+/*
+ * Compact storage of the attributes of the graph elements
+ */
+
+#ifndef DOT_ATTRIBUTES_H
+#define DOT_ATTRIBUTES_H
+
+#include <QList>
+#include <QMap>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+namespace KGraphViewer
+{
+
+/**
+ * The table of the attribute names, shared by all the graphs. A name is
+ * stored once and designated in the attributes of the elements by a small
+ * integer, its symbol. The attributes the model accesses directly, and the
+ * ones read while painting, have fixed symbols.
+ *
+ * The lookups do not lock: only the addition of a new name does.
+ */
+class DotAttributeSymbols
+{
+public:
+  enum WellKnown
+  {
+    Id,
+    Label,
+    Style,
+    Shape,
+    ShapeFile,
+    Color,
+    BgColor,
+    Url,
+    FontSize,
+    FontName,
+    FontColor,
+    FillColor,
+    Z,
+    PenWidth,
+    Pos
+  };
+
+  /** The symbol of name, added to the table if it is a new name */
+  static int symbol(const QString& name);
+  /** The symbol of the UTF-8 name [first, last) */
+  static int symbol(const char* first, const char* last);
+  /** The symbol of the nul terminated UTF-8 name */
+  static int symbol(const char* name);
+
+  /** @return the symbol of name, or -1 if it has never been used. The table is not modified. */
+  static int find(const QString& name);
+
+  static QString name(int symbol);
+};
+
+/**
+ * The attributes of an element: the pairs of a symbol and a value, in
+ * insertion order. Lookups scan the few attributes of the element, without
+ * string comparisons.
+ *
+ * Its interface follows the one of QMap<QString,QString>, which was used
+ * before.
+ */
+class DotAttributes
+{
+public:
+  struct Entry
+  {
+    int symbol;
+    QString value;
+  };
+
+  class const_iterator
+  {
+  public:
+    inline explicit const_iterator(QVector<Entry>::const_iterator it) : m_it(it) {}
+
+    inline int symbol() const {return m_it->symbol;}
+    inline QString key() const {return DotAttributeSymbols::name(m_it->symbol);}
+    inline const QString& value() const {return m_it->value;}
+    inline const QString& operator*() const {return m_it->value;}
+
+    inline const_iterator& operator++() {++m_it; return *this;}
+    inline const_iterator operator++(int) {const_iterator it = *this; ++m_it; return it;}
+    inline bool operator==(const const_iterator& other) const {return m_it == other.m_it;}
+    inline bool operator!=(const const_iterator& other) const {return m_it != other.m_it;}
+
+  private:
+    QVector<Entry>::const_iterator m_it;
+  };
+
+  DotAttributes() {}
+  DotAttributes& operator=(const QMap<QString,QString>& map);
+
+  QMap<QString,QString> toMap() const;
+
+  inline int size() const {return m_entries.size();}
+  inline bool isEmpty() const {return m_entries.isEmpty();}
+  inline void clear() {m_entries.clear();}
+
+  inline bool contains(int symbol) const {return indexOf(symbol) >= 0;}
+  inline bool contains(const QString& key) const {return indexOf(DotAttributeSymbols::find(key)) >= 0;}
+
+  QString value(int symbol, const QString& defaultValue = QString()) const;
+  inline QString value(const QString& key, const QString& defaultValue = QString()) const {return value(DotAttributeSymbols::find(key), defaultValue);}
+
+  /** The value of the attribute, inserted empty if it is not set */
+  QString& operator[](int symbol);
+  inline QString& operator[](const QString& key) {return (*this)[DotAttributeSymbols::symbol(key)];}
+  inline QString& operator[](const char* key) {return (*this)[DotAttributeSymbols::symbol(key)];}
+  inline QString operator[](int symbol) const {return value(symbol);}
+  inline QString operator[](const QString& key) const {return value(key);}
+  inline QString operator[](const char* key) const {return value(QString::fromUtf8(key));}
+
+  int remove(int symbol);
+  inline int remove(const QString& key) {return remove(DotAttributeSymbols::find(key));}
+
+  QList<QString> keys() const;
+
+  inline const_iterator begin() const {return const_iterator(m_entries.constBegin());}
+  inline const_iterator end() const {return const_iterator(m_entries.constEnd());}
+  inline const_iterator constBegin() const {return begin();}
+  inline const_iterator constEnd() const {return end();}
+
+private:
+  int indexOf(int symbol) const;
+
+  QVector<Entry> m_entries;
+};
+
+/**
+ * Shares the attribute values read while a graph is built. The short
+ * values, colors, font names, shapes or styles, are the same on most of
+ * the elements: the interned ones are stored once, the elements sharing the
+ * data of the same QString. The table itself is only needed while reading.
+ */
+class DotAttributeValues
+{
+public:
+  /** @return value, or an equal value already met, sharing its data */
+  QString intern(const QString& value);
+  inline QString intern(const char* value) {return intern(QString::fromUtf8(value));}
+
+private:
+  /** Longer values, like positions or labels, are seldom repeated */
+  static const int MaxInternedSize = 32;
+
+  QSet<QString> m_values;
+};
+
+}
+
+Q_DECLARE_TYPEINFO(KGraphViewer::DotAttributes::Entry, Q_MOVABLE_TYPE);
+
+#endif
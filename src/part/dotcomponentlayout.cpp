@@ -0,0 +1,677 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+#include "dotcomponentlayout.h"
+#include "dotgraph.h"
+#include "dotlayoutworkerpool.h"
+#include "DotGraphParsingHelper.h"
+#include "dotparser.h"
+#include "kgraphviewer_partsettings.h"
+#include "kgraphviewerlib_debug.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QProcess>
+#include <QSet>
+#include <QSharedPointer>
+#include <QThread>
+#include <QVector>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <cmath>
+
+namespace KGraphViewer
+{
+
+namespace
+{
+
+inline bool isSet(const QAtomicInt* flag)
+{
+  return flag != nullptr && flag->load() != 0;
+}
+
+/** The space left between the packed drawings, in points, as with the default pack value of Graphviz */
+const double packMargin = 8;
+
+/** The graph attributes making the drawing of a part depend on the whole graph */
+const char* const wholeDrawingAttributes[] = {"size", "ratio", "rotate", "landscape", "page"};
+
+/** The attributes holding positions, moved with the drawing operations */
+const char* const positionAttributes[] = {"pos", "bb", "lp", "xlp", "head_lp", "tail_lp"};
+
+/** Some connected components of the graph, laid out together */
+struct Part
+{
+  QVector<node_t*> nodes;
+  /** The number of nodes and edges */
+  int weight = 0;
+  graph_t* graph = nullptr;
+  QByteArray output;
+  bool laidOut = false;
+  DotGraph* model = nullptr;
+  /** The position of the drawing in the packed one */
+  double x = 0;
+  double y = 0;
+};
+
+int findRoot(QVector<int>& parents, int i)
+{
+  while (parents[i] != i)
+  {
+    parents[i] = parents[parents[i]];
+    i = parents[i];
+  }
+  return i;
+}
+
+void unite(QVector<int>& parents, int a, int b)
+{
+  a = findRoot(parents, a);
+  b = findRoot(parents, b);
+  if (a != b)
+  {
+    parents[b] = a;
+  }
+}
+
+/** The connected components of graph, the nodes of a subgraph being considered connected */
+QVector<Part> components(graph_t* graph)
+{
+  QVector<node_t*> nodes;
+  QHash<node_t*, int> indexes;
+  for (node_t* node = agfstnode(graph); node; node = agnxtnode(graph, node))
+  {
+    indexes.insert(node, nodes.size());
+    nodes.append(node);
+  }
+  QVector<int> parents(nodes.size());
+  for (int i = 0; i < parents.size(); i++)
+  {
+    parents[i] = i;
+  }
+  for (node_t* node : nodes)
+  {
+    for (edge_t* edge = agfstout(graph, node); edge; edge = agnxtout(graph, edge))
+    {
+      unite(parents, indexes.value(agtail(edge)), indexes.value(aghead(edge)));
+    }
+  }
+  // the nodes of a nested subgraph are also in its parents
+  for (graph_t* subgraph = agfstsubg(graph); subgraph; subgraph = agnxtsubg(subgraph))
+  {
+    node_t* first = agfstnode(subgraph);
+    for (node_t* node = first; node; node = agnxtnode(subgraph, node))
+    {
+      unite(parents, indexes.value(first), indexes.value(node));
+    }
+  }
+
+  QVector<Part> result;
+  QHash<int, int> componentOfRoot;
+  for (int i = 0; i < nodes.size(); i++)
+  {
+    const int root = findRoot(parents, i);
+    QHash<int, int>::const_iterator it = componentOfRoot.constFind(root);
+    if (it == componentOfRoot.constEnd())
+    {
+      it = componentOfRoot.insert(root, result.size());
+      result.append(Part());
+    }
+    Part& component = result[it.value()];
+    component.nodes.append(nodes[i]);
+    component.weight += 1 + agdegree(graph, nodes[i], 0, 1);
+  }
+  return result;
+}
+
+/** Groups components in count parts of similar weights, the heaviest components first */
+QVector<Part> group(QVector<Part> components, int count)
+{
+  std::sort(components.begin(), components.end(),
+            [](const Part& a, const Part& b) {return a.weight > b.weight;});
+  QVector<Part> parts(qMin(count, components.size()));
+  for (const Part& component : components)
+  {
+    Part* lightest = std::min_element(parts.begin(), parts.end(),
+                                      [](const Part& a, const Part& b) {return a.weight < b.weight;});
+    lightest->nodes += component.nodes;
+    lightest->weight += component.weight;
+  }
+  return parts;
+}
+
+bool concernsWholeDrawing(graph_t* graph)
+{
+  for (const char* attribute : wholeDrawingAttributes)
+  {
+    const char* value = agget(graph, const_cast<char*>(attribute));
+    if (value != nullptr && *value != '\0')
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+/** Copies subgraph, its nodes and edges being given by their copies, in parent */
+void copySubgraph(graph_t* subgraph, graph_t* parent,
+                  const QHash<node_t*, node_t*>& nodes, const QHash<edge_t*, edge_t*>& edges)
+{
+  // the anonymous subgraphs have an internal name, starting with %
+  char* name = agnameof(subgraph);
+  graph_t* copy = agsubg(parent, (name != nullptr && name[0] != '%') ? name : nullptr, 1);
+  agcopyattr(subgraph, copy);
+  for (node_t* node = agfstnode(subgraph); node; node = agnxtnode(subgraph, node))
+  {
+    agsubnode(copy, nodes.value(node), 1);
+    for (edge_t* edge = agfstout(subgraph, node); edge; edge = agnxtout(subgraph, edge))
+    {
+      if (edge_t* edgeCopy = edges.value(edge))
+      {
+        agsubedge(copy, edgeCopy, 1);
+      }
+    }
+  }
+  for (graph_t* nested = agfstsubg(subgraph); nested; nested = agnxtsubg(nested))
+  {
+    copySubgraph(nested, copy, nodes, edges);
+  }
+}
+
+/**
+ * A new graph made of the nodes of part, with their edges and subgraphs and
+ * with the attributes of graph. Only the first part keeps the graph label
+ * and the subgraphs without nodes.
+ */
+graph_t* extract(graph_t* graph, const Part& part, bool firstPart)
+{
+  const Agdesc_t desc = agisdirected(graph) ? (agisstrict(graph) ? Agstrictdirected : Agdirected)
+                                            : (agisstrict(graph) ? Agstrictundirected : Agundirected);
+  graph_t* copy = agopen(agnameof(graph), desc, nullptr);
+  for (int kind : {AGRAPH, AGNODE, AGEDGE})
+  {
+    for (Agsym_t* sym = agnxtattr(graph, kind, nullptr); sym; sym = agnxtattr(graph, kind, sym))
+    {
+      agattr(copy, kind, sym->name, sym->defval);
+    }
+  }
+  agcopyattr(graph, copy);
+  const char* label = agget(graph, const_cast<char*>("label"));
+  if (!firstPart && label != nullptr && *label != '\0')
+  {
+    agset(copy, const_cast<char*>("label"), const_cast<char*>(""));
+  }
+
+  QHash<node_t*, node_t*> nodes;
+  nodes.reserve(part.nodes.size());
+  for (node_t* node : part.nodes)
+  {
+    node_t* nodeCopy = agnode(copy, agnameof(node), 1);
+    agcopyattr(node, nodeCopy);
+    nodes.insert(node, nodeCopy);
+  }
+  QHash<edge_t*, edge_t*> edges;
+  for (node_t* node : part.nodes)
+  {
+    for (edge_t* edge = agfstout(graph, node); edge; edge = agnxtout(graph, edge))
+    {
+      // anonymous edges have no name
+      edge_t* edgeCopy = agedge(copy, nodes.value(node), nodes.value(aghead(edge)), agnameof(edge), 1);
+      agcopyattr(edge, edgeCopy);
+      edges.insert(edge, edgeCopy);
+    }
+  }
+  // a subgraph is in the part of its nodes
+  for (graph_t* subgraph = agfstsubg(graph); subgraph; subgraph = agnxtsubg(subgraph))
+  {
+    node_t* first = agfstnode(subgraph);
+    if ((first == nullptr) ? firstPart : nodes.contains(first))
+    {
+      copySubgraph(subgraph, copy, nodes, edges);
+    }
+  }
+  return copy;
+}
+
+/**
+ * The model of the xdot output of a part. uniq numbers the anonymous
+ * subgraphs, so that the ones of different parts get different ids.
+ * @return nullptr if the output cannot be parsed
+ */
+DotGraph* parseDrawing(const QByteArray& output, const QString& layoutCommand, const QString& dotFileName, unsigned int& uniq)
+{
+  DotGraph* graph = new DotGraph(layoutCommand, dotFileName);
+  DotGraphParsingHelper helper;
+  helper.graph = graph;
+  helper.z = 1;
+  helper.maxZ = 1;
+  helper.uniq = uniq;
+  DotParser parser(helper);
+  if (!parser.parseInParallel(output.constData(), output.constData() + output.size()) || !parser.isFinished())
+  {
+    delete graph;
+    return nullptr;
+  }
+  uniq = helper.uniq;
+  return graph;
+}
+
+/**
+ * Places the drawings of the parts in rows, the tallest first, and gives
+ * the size of the whole.
+ */
+void pack(QVector<Part>& parts, double& width, double& height)
+{
+  QVector<Part*> order;
+  double area = 0;
+  double widest = 0;
+  for (Part& part : parts)
+  {
+    order.append(&part);
+    area += (part.model->width() + packMargin) * (part.model->height() + packMargin);
+    widest = qMax(widest, part.model->width());
+  }
+  std::sort(order.begin(), order.end(),
+            [](const Part* a, const Part* b) {return a->model->height() > b->model->height();});
+
+  // rows about as wide as the whole is high
+  const double rowWidth = qMax(widest, std::sqrt(area));
+  double x = 0;
+  double rowTop = 0;
+  double rowHeight = 0;
+  width = 0;
+  for (Part* part : order)
+  {
+    if (x > 0 && x + part->model->width() > rowWidth)
+    {
+      rowTop += rowHeight + packMargin;
+      x = 0;
+      rowHeight = 0;
+    }
+    part->x = x;
+    part->y = rowTop;
+    x += part->model->width() + packMargin;
+    rowHeight = qMax(rowHeight, part->model->height());
+    width = qMax(width, x - packMargin);
+  }
+  height = rowTop + rowHeight;
+  // the y axis of the drawings goes up, the rows being aligned on their top
+  for (Part* part : order)
+  {
+    part->y = height - part->y - part->model->height();
+  }
+}
+
+/** Moves the positions of the points in value, as given by pos or bb */
+QString translatedPoints(const QString& value, double dx, double dy)
+{
+  QString result;
+  result.reserve(value.size() + 16);
+  int coordinate = 0;
+  int start = 0;
+  for (int i = 0; i <= value.size(); i++)
+  {
+    const bool atEnd = (i == value.size());
+    const QChar c = atEnd ? QChar() : value.at(i);
+    if (!atEnd && c != QLatin1Char(',') && c != QLatin1Char(' ') && c != QLatin1Char(';'))
+    {
+      continue;
+    }
+    const QStringRef field = value.midRef(start, i - start);
+    // the position of a pinned node ends with !
+    const bool pinned = field.endsWith(QLatin1Char('!'));
+    bool ok;
+    const double number = (pinned ? field.left(field.size() - 1) : field).toDouble(&ok);
+    if (ok)
+    {
+      result += QString::number(number + ((coordinate % 2 == 0) ? dx : dy), 'g', 10);
+      if (pinned)
+      {
+        result += QLatin1Char('!');
+      }
+      ++coordinate;
+    }
+    else
+    {
+      // the e and s markers of the ends of an edge
+      result += field;
+    }
+    if (!atEnd)
+    {
+      result += c;
+      if (c != QLatin1Char(','))
+      {
+        coordinate = 0;
+      }
+    }
+    start = i + 1;
+  }
+  return result;
+}
+
+/** The move of the drawing of a part into the packed one */
+struct Translation
+{
+  double dx;
+  double dy;
+  /** Where the moved drawing operations are copied */
+  QSharedPointer<DotRenderOpArena> arena;
+  /** The symbols of the position attributes */
+  QVector<int> symbols;
+  /** The elements already moved */
+  QSet<GraphElement*> moved;
+};
+
+/** Moves the drawing of element and of its content */
+void translate(GraphElement* element, Translation& translation)
+{
+  // an element can be both in the content and in the subgraphs of a subgraph
+  if (translation.moved.contains(element))
+  {
+    return;
+  }
+  translation.moved.insert(element);
+
+  DotRenderOpVec operations(translation.arena);
+  operations.appendTranslated(element->renderOperations(), translation.dx, translation.dy);
+  element->setRenderOperations(operations);
+  if (GraphEdge* edge = dynamic_cast<GraphEdge*>(element))
+  {
+    DotRenderOpVec arrowheads(translation.arena);
+    arrowheads.appendTranslated(edge->arrowheads(), translation.dx, translation.dy);
+    edge->arrowheads() = arrowheads;
+  }
+  DotAttributes& attributes = element->attributes();
+  for (int symbol : translation.symbols)
+  {
+    if (attributes.contains(symbol))
+    {
+      attributes[symbol] = translatedPoints(attributes.value(symbol), translation.dx, translation.dy);
+    }
+  }
+
+  if (GraphSubgraph* subgraph = dynamic_cast<GraphSubgraph*>(element))
+  {
+    for (GraphElement* content : subgraph->content())
+    {
+      translate(content, translation);
+    }
+    for (GraphSubgraph* nested : subgraph->subgraphs())
+    {
+      translate(nested, translation);
+    }
+  }
+}
+
+/** Moves the drawing of graph by (dx, dy), copying its drawing operations in arena */
+void translate(DotGraph* graph, double dx, double dy, const QSharedPointer<DotRenderOpArena>& arena)
+{
+  Translation translation = {dx, dy, arena, QVector<int>(), QSet<GraphElement*>()};
+  for (const char* name : positionAttributes)
+  {
+    translation.symbols.append(DotAttributeSymbols::symbol(name));
+  }
+  translate(graph, translation);
+  for (GraphNode* node : graph->nodes())
+  {
+    translate(node, translation);
+  }
+  for (GraphEdge* edge : graph->edges())
+  {
+    translate(edge, translation);
+  }
+  for (GraphSubgraph* subgraph : graph->subgraphs())
+  {
+    translate(subgraph, translation);
+  }
+}
+
+/** true if op is the background of a drawing of width by height, covering all of it */
+bool isBackground(const DotRenderOp& op, const float* coordinates, double width, double height)
+{
+  if (!op.isPolygon() || op.count != 4)
+  {
+    return false;
+  }
+  double left = coordinates[0], right = coordinates[0], bottom = coordinates[1], top = coordinates[1];
+  for (quint32 i = 1; i < op.count; i++)
+  {
+    left = qMin(left, double(coordinates[2 * i]));
+    right = qMax(right, double(coordinates[2 * i]));
+    bottom = qMin(bottom, double(coordinates[2 * i + 1]));
+    top = qMax(top, double(coordinates[2 * i + 1]));
+  }
+  return qAbs(left) < 1 && qAbs(bottom) < 1 && qAbs(right - width) < 1 && qAbs(top - height) < 1;
+}
+
+/**
+ * The drawing operations of the packed graph, of width by height, from the
+ * ones of the graph of a part, of partWidth by partHeight, not moved: its
+ * background is stretched over the whole drawing and its label moved by
+ * (labelDx, labelDy), to be placed along the whole drawing.
+ */
+DotRenderOpVec packedGraphOperations(DotRenderOpVec operations, double partWidth, double partHeight,
+                                     double width, double height, double labelDx, double labelDy,
+                                     const QSharedPointer<DotRenderOpArena>& arena)
+{
+  operations.decode();
+  DotRenderOpVec result(arena);
+  // copied in runs of operations moved the same way, to keep their order
+  DotRenderOpVec run(operations.arena());
+  bool labelRun = false;
+  auto flush = [&]()
+  {
+    result.appendTranslated(run, labelRun ? labelDx : 0, labelRun ? labelDy : 0);
+    run = DotRenderOpVec(operations.arena());
+  };
+  for (const DotRenderOp& op : operations)
+  {
+    const float* coordinates = operations.coordinates(op);
+    if (partWidth > 0 && partHeight > 0 && isBackground(op, coordinates, partWidth, partHeight))
+    {
+      flush();
+      DotRenderOp stretched = op;
+      stretched.coordinates = result.nextCoordinate();
+      for (quint32 i = 0; i < 2 * op.count; i++)
+      {
+        result.appendCoordinate(coordinates[i] * ((i % 2 == 0) ? width / partWidth : height / partHeight));
+      }
+      result.append(stretched);
+      continue;
+    }
+    const bool label = (op.code == DotRenderOp::Text);
+    if (label != labelRun)
+    {
+      flush();
+      labelRun = label;
+    }
+    run.append(op);
+  }
+  flush();
+  return result;
+}
+
+}
+
+bool DotComponentLayout::isEnabled()
+{
+  return KGraphViewerPartSettings::layoutComponentsInParallel();
+}
+
+DotGraph* DotComponentLayout::layout(graph_t* graph, const QString& layoutCommand, const QString& dotFileName,
+                                     const Runner& runner, const QAtomicInt* cancelled)
+{
+  QElapsedTimer timer;
+  timer.start();
+  QVector<Part> parts = components(graph);
+  const int componentCount = parts.size();
+  if (componentCount > 1 && !concernsWholeDrawing(graph))
+  {
+    parts = group(parts, 2 * qMax(1, QThread::idealThreadCount()));
+    for (int i = 0; i < parts.size(); i++)
+    {
+      parts[i].graph = extract(graph, parts[i], i == 0);
+    }
+  }
+  else
+  {
+    parts = QVector<Part>(1);
+    parts[0].graph = graph;
+  }
+
+  QtConcurrent::blockingMap(parts, [&runner, cancelled](Part& part)
+  {
+    if (!isSet(cancelled))
+    {
+      part.laidOut = runner(part.graph, part.output);
+    }
+  });
+  bool laidOut = !isSet(cancelled);
+  for (Part& part : parts)
+  {
+    laidOut = laidOut && part.laidOut;
+    if (part.graph != graph)
+    {
+      agclose(part.graph);
+    }
+    part.graph = nullptr;
+  }
+  if (!laidOut)
+  {
+    return nullptr;
+  }
+
+  // parsed one after the other, each on all the cores
+  unsigned int uniq = 0;
+  bool parsed = true;
+  for (Part& part : parts)
+  {
+    part.model = parseDrawing(part.output, layoutCommand, dotFileName, uniq);
+    part.output = QByteArray();
+    if (part.model == nullptr)
+    {
+      qCWarning(KGRAPHVIEWERLIB_LOG) << "Cannot parse the output of the layout with" << layoutCommand;
+      parsed = false;
+      break;
+    }
+  }
+  if (!parsed)
+  {
+    for (const Part& part : parts)
+    {
+      delete part.model;
+    }
+    return nullptr;
+  }
+  if (parts.size() == 1)
+  {
+    return parts[0].model;
+  }
+
+  double width, height;
+  pack(parts, width, height);
+
+  // the graph label of the first part is placed along the whole drawing,
+  // in a band of its own
+  const DotGraph* first = parts[0].model;
+  const QString labelPosition = first->attributes().value("lp");
+  const double labelHeight = labelPosition.isEmpty() ? 0 : 72 * first->attributes().value("lheight").toDouble();
+  const bool labelOnTop = first->attributes().value("labelloc").startsWith(QLatin1Char('t'));
+  if (!labelOnTop)
+  {
+    for (Part& part : parts)
+    {
+      part.y += labelHeight;
+    }
+  }
+  height += labelHeight;
+  const QString labelJust = first->attributes().value("labeljust");
+  const double labelDx = labelJust.startsWith(QLatin1Char('l')) ? 0
+                       : labelJust.startsWith(QLatin1Char('r')) ? width - first->width()
+                       : (width - first->width()) / 2;
+  const double labelDy = labelOnTop ? height - first->height() : 0;
+  const DotRenderOpVec firstOperations = first->renderOperations();
+  const double firstWidth = first->width();
+  const double firstHeight = first->height();
+
+  DotGraph* result = new DotGraph(layoutCommand, dotFileName);
+  QSharedPointer<DotRenderOpArena> arena = QSharedPointer<DotRenderOpArena>::create();
+  // the first part, with the graph label, is merged last for its graph
+  // attributes to be kept
+  for (int i = parts.size() - 1; i >= 0; i--)
+  {
+    translate(parts[i].model, parts[i].x, parts[i].y, arena);
+    result->updateWithGraph(*parts[i].model);
+  }
+  result->setRenderOperations(packedGraphOperations(firstOperations, firstWidth, firstHeight,
+                                                    width, height, labelDx, labelDy, arena));
+  result->width(width);
+  result->height(height);
+  result->attributes()["bb"] = QString::fromLatin1("0,0,%1,%2").arg(width).arg(height);
+  if (!labelPosition.isEmpty())
+  {
+    result->attributes()["lp"] = translatedPoints(labelPosition, labelDx, labelDy);
+  }
+  for (const Part& part : parts)
+  {
+    delete part.model;
+  }
+  qCDebug(KGRAPHVIEWERLIB_LOG) << componentCount << "components laid out in" << parts.size() << "parts with"
+                               << layoutCommand << "in" << timer.elapsed() << "ms";
+  return result;
+}
+
+bool DotComponentLayout::runCommand(graph_t* graph, const QString& layoutCommand, QByteArray& output,
+                                    const QAtomicInt* cancelled)
+{
+  const QByteArray dot = DotLayoutWorkerPool::writeGraph(graph);
+  if (dot.isEmpty())
+  {
+    return false;
+  }
+  QProcess process;
+  process.start(layoutCommand, QStringList() << QStringLiteral("-Txdot"));
+  if (!process.waitForStarted())
+  {
+    qCWarning(KGRAPHVIEWERLIB_LOG) << "Unable to start" << layoutCommand;
+    return false;
+  }
+  process.write(dot);
+  process.closeWriteChannel();
+  while (!process.waitForFinished(100) && process.state() != QProcess::NotRunning)
+  {
+    if (isSet(cancelled))
+    {
+      process.kill();
+      process.waitForFinished();
+      return false;
+    }
+  }
+  output = process.readAllStandardOutput();
+  if (process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0)
+  {
+    qCWarning(KGRAPHVIEWERLIB_LOG) << layoutCommand << "failed with exit code" << process.exitCode();
+    return false;
+  }
+  return true;
+}
+
+}
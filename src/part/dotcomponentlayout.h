@@ -0,0 +1,82 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+/*
+ * Layout of the connected components of a graph in parallel
+ */
+
+#ifndef DOT_COMPONENT_LAYOUT_H
+#define DOT_COMPONENT_LAYOUT_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QString>
+
+#include <graphviz/gvc.h>
+
+#include <functional>
+
+namespace KGraphViewer
+{
+
+class DotGraph;
+
+/**
+ * Lays out a graph made of several independent parts, like a forest, on
+ * all the cores instead of in one single threaded run of the layout
+ * program.
+ *
+ * The graph is split in its connected components, the nodes of a same
+ * subgraph being kept together. They are grouped in twice as many parts as
+ * there are cores, balanced by size, each part being laid out separately.
+ * The drawings are then packed in rows, as gvpack does, their drawing
+ * operations and positions being moved while they are merged in one model.
+ */
+class DotComponentLayout
+{
+public:
+  /**
+   * Lays out a part of the graph, giving its drawing in the xdot format.
+   * Called from several threads at the same time.
+   */
+  typedef std::function<bool(graph_t* graph, QByteArray& output)> Runner;
+
+  /** true if the components are to be laid out in parallel */
+  static bool isEnabled();
+
+  /**
+   * Lays out graph, read from dotFileName, part by part with runner and
+   * packs the drawings. The graph is laid out as a whole if it is connected
+   * or if its attributes concern the whole drawing, like size or rotate.
+   * @param cancelled if given and set, the layouts still to run are skipped
+   * @return the new model, or nullptr if a layout failed or was cancelled
+   */
+  static DotGraph* layout(graph_t* graph, const QString& layoutCommand, const QString& dotFileName,
+                          const Runner& runner, const QAtomicInt* cancelled = nullptr);
+
+  /**
+   * A Runner running the external layoutCommand, for the command line
+   * mode.
+   */
+  static bool runCommand(graph_t* graph, const QString& layoutCommand, QByteArray& output,
+                         const QAtomicInt* cancelled = nullptr);
+};
+
+}
+
+#endif
@@ -0,0 +1,160 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+#include "dotcontextpool.h"
+#include "layoutagraphthread.h"
+#include "kgraphviewerlib_debug.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QMutexLocker>
+#include <QtConcurrentRun>
+
+namespace KGraphViewer
+{
+
+namespace
+{
+
+/** Contexts kept beyond this number are freed when given back */
+const int maxIdleContexts = 2;
+
+/**
+ * The creation of the pool started by warmUp(). It is waited for before the
+ * pool can be destroyed, which would otherwise race with it: when the
+ * application object is destroyed, or when the library is unloaded if that
+ * comes first.
+ */
+class WarmUp
+{
+public:
+  WarmUp() : m_started(false), m_future() {}
+  ~WarmUp();
+
+  void start();
+  void wait();
+
+private:
+  bool m_started;
+  QFuture<void> m_future;
+};
+
+WarmUp warmUpTask;
+
+void waitForWarmUp()
+{
+  warmUpTask.wait();
+}
+
+WarmUp::~WarmUp()
+{
+  if (m_started)
+  {
+    qRemovePostRoutine(&waitForWarmUp);
+    wait();
+  }
+}
+
+void WarmUp::start()
+{
+  if (m_started)
+  {
+    return;
+  }
+  m_started = true;
+  // the post routines are run before the application object waits for the
+  // threads of the global pool, and long before the static destructors
+  qAddPostRoutine(&waitForWarmUp);
+  m_future = QtConcurrent::run([]() {DotContextPool::instance();});
+}
+
+void WarmUp::wait()
+{
+  m_future.waitForFinished();
+}
+
+}
+
+DotContextPool& DotContextPool::instance()
+{
+  static DotContextPool pool;
+  return pool;
+}
+
+void DotContextPool::warmUp()
+{
+  warmUpTask.start();
+}
+
+DotContextPool::DotContextPool() :
+    m_mutex(),
+    m_idle()
+{
+  QElapsedTimer timer;
+  timer.start();
+  GVC_t* gvc = gvContext();
+  // the plugins are loaded on first use by a context
+  graph_t* graph = agopen(const_cast<char*>("warmup"), Agdirected, nullptr);
+  agnode(graph, const_cast<char*>("node"), 1);
+  if (threadsafe_wrap_gvLayout(gvc, graph, "dot") == 0)
+  {
+    threadsafe_wrap_gvRender(gvc, graph, "xdot", nullptr);
+    gvFreeLayout(gvc, graph);
+  }
+  agclose(graph);
+  m_idle.append(gvc);
+  qCDebug(KGRAPHVIEWERLIB_LOG) << "Graphviz context ready in" << timer.elapsed() << "ms";
+}
+
+DotContextPool::~DotContextPool()
+{
+  for (GVC_t* gvc : m_idle)
+  {
+    gvFreeContext(gvc);
+  }
+}
+
+GVC_t* DotContextPool::acquire()
+{
+  {
+    QMutexLocker locker(&m_mutex);
+    if (!m_idle.isEmpty())
+    {
+      return m_idle.takeLast();
+    }
+  }
+  qCDebug(KGRAPHVIEWERLIB_LOG) << "all the Graphviz contexts are in use, creating one";
+  return gvContext();
+}
+
+void DotContextPool::release(GVC_t* gvc)
+{
+  {
+    QMutexLocker locker(&m_mutex);
+    if (m_idle.size() < maxIdleContexts)
+    {
+      m_idle.append(gvc);
+      return;
+    }
+  }
+  gvFreeContext(gvc);
+}
+
+}
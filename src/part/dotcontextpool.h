@@ -0,0 +1,85 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+/*
+ * Pool of Graphviz contexts for the layouts run in process
+ */
+
+#ifndef DOT_CONTEXT_POOL_H
+#define DOT_CONTEXT_POOL_H
+
+#include <QMutex>
+#include <QVector>
+
+#include <graphviz/gvc.h>
+
+namespace KGraphViewer
+{
+
+/**
+ * Keeps Graphviz contexts for the layouts run in the viewer process, so
+ * that the configuration and the plugins are loaded once rather than for
+ * each layout. The contexts are borrowed with DotContext.
+ */
+class DotContextPool
+{
+public:
+  static DotContextPool& instance();
+
+  /**
+   * Creates the pool in the background, loading the plugins of the dot
+   * layout and of the xdot output, so that the first layout does not wait
+   * for them. Only the first call has an effect. Must be called from the
+   * thread of the application object, which waits for the creation to end
+   * when it is destroyed.
+   */
+  static void warmUp();
+
+  /** A context of the pool, or a new one if all are in use */
+  GVC_t* acquire();
+  /** Gives back gvc, obtained from acquire() */
+  void release(GVC_t* gvc);
+
+private:
+  DotContextPool();
+  ~DotContextPool();
+  DotContextPool(const DotContextPool&) = delete;
+  DotContextPool& operator=(const DotContextPool&) = delete;
+
+  QMutex m_mutex;
+  QVector<GVC_t*> m_idle;
+};
+
+/** A context borrowed from the DotContextPool for the lifetime of this object */
+class DotContext
+{
+public:
+  DotContext() : m_gvc(DotContextPool::instance().acquire()) {}
+  ~DotContext() {DotContextPool::instance().release(m_gvc);}
+  DotContext(const DotContext&) = delete;
+  DotContext& operator=(const DotContext&) = delete;
+
+  inline operator GVC_t*() const {return m_gvc;}
+
+private:
+  GVC_t* m_gvc;
+};
+
+}
+
+#endif
@@ -0,0 +1,658 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+#include "dotforcelayout.h"
+#include "dotnativelayout.h"
+#include "kgraphviewerlib_debug.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QVector>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace KGraphViewer
+{
+
+namespace
+{
+
+/** The number of nodes under which the coarsening stops */
+const int coarsestSize = 64;
+/** The coarsening stops when a level keeps more than this part of the nodes of the previous one */
+const float coarseningRatio = 0.8f;
+/** A cell of the quadtree far enough, seen under less than this ratio of its size to its distance, repels as a whole */
+const float openingRatio = 1.2f;
+/** The most nodes in a leaf of the quadtree */
+const int leafSize = 8;
+/** The depth of the quadtree, the Morton codes having 2 bits per level */
+const int treeDepth = 16;
+/** The Morton codes are sorted in three passes */
+const int radixBits = 11;
+const int radixSize = 1 << radixBits;
+/** The pull towards the center keeping the parts of the coarsest graph together */
+const float gravity = 0.05f;
+
+/** A graph of the coarsening, the first one being the graph to lay out */
+struct Level
+{
+  /** The neighbors of the node i are adjacency[starts[i]] to adjacency[starts[i+1] - 1] */
+  QVector<int> starts;
+  QVector<int> adjacency;
+  /** The number of nodes of the graph merged in each node */
+  QVector<int> masses;
+  /** The node of the next coarser level in which each node is merged */
+  QVector<int> coarse;
+
+  inline int nodeCount() const {return masses.size();}
+};
+
+/** The neighbors of the nodes of graph, without loops and parallel edges */
+Level finestLevel(const DotNativeGraph& graph)
+{
+  const int n = graph.nodeCount();
+  Level level;
+  level.masses.fill(1, n);
+  level.starts.fill(0, n + 1);
+  for (int e = 0; e < graph.edgeCount(); e++)
+  {
+    if (graph.tails[e] != graph.heads[e])
+    {
+      level.starts[graph.tails[e] + 1]++;
+      level.starts[graph.heads[e] + 1]++;
+    }
+  }
+  for (int i = 0; i < n; i++)
+  {
+    level.starts[i + 1] += level.starts[i];
+  }
+  QVector<int> ends = level.starts;
+  level.adjacency.resize(level.starts[n]);
+  for (int e = 0; e < graph.edgeCount(); e++)
+  {
+    const int tail = graph.tails[e];
+    const int head = graph.heads[e];
+    if (tail != head)
+    {
+      level.adjacency[ends[tail]++] = head;
+      level.adjacency[ends[head]++] = tail;
+    }
+  }
+
+  // removes the duplicates of each list in parallel, then compacts the lists
+  int* adjacency = level.adjacency.data();
+  const int* starts = level.starts.constData();
+  int* sizes = ends.data();
+  DotNativeLayout::parallelFor(n, [adjacency, starts, sizes](int begin, int end)
+  {
+    for (int i = begin; i < end; i++)
+    {
+      std::sort(adjacency + starts[i], adjacency + starts[i + 1]);
+      sizes[i] = int(std::unique(adjacency + starts[i], adjacency + starts[i + 1]) - (adjacency + starts[i]));
+    }
+  });
+  int size = 0;
+  for (int i = 0; i < n; i++)
+  {
+    // the lists only move towards the beginning
+    std::copy(adjacency + starts[i], adjacency + starts[i] + sizes[i], adjacency + size);
+    level.starts[i] = size;
+    size += sizes[i];
+  }
+  level.starts[n] = size;
+  level.adjacency.resize(size);
+  return level;
+}
+
+/**
+ * Merges each node of fine with its lightest unmatched neighbor, in a
+ * random order, then the unmatched nodes having the same first neighbor two
+ * by two, as the leaves of a star cannot be matched with its center. Sets
+ * the coarse nodes of fine.
+ */
+Level coarsen(Level& fine)
+{
+  const int n = fine.nodeCount();
+  const int* starts = fine.starts.constData();
+  const int* adjacency = fine.adjacency.constData();
+
+  QVector<int> order(n);
+  for (int i = 0; i < n; i++)
+  {
+    order[i] = i;
+  }
+  // the same graph always gets the same layout
+  std::mt19937 random(n);
+  std::shuffle(order.begin(), order.end(), random);
+
+  // the first node of the group of each node
+  QVector<int> groups(n, -1);
+  QVector<int> singles;
+  for (int u : order)
+  {
+    if (groups[u] >= 0)
+    {
+      continue;
+    }
+    int best = -1;
+    for (int a = starts[u]; a < starts[u + 1]; a++)
+    {
+      const int v = adjacency[a];
+      if (groups[v] < 0 && (best < 0 || fine.masses[v] < fine.masses[best]))
+      {
+        best = v;
+      }
+    }
+    groups[u] = u;
+    if (best >= 0)
+    {
+      groups[best] = u;
+    }
+    else
+    {
+      singles.append(u);
+    }
+  }
+  // the isolated nodes wait on the index n
+  QVector<int> waiting(n + 1, -1);
+  for (int u : singles)
+  {
+    const int hub = (starts[u] < starts[u + 1]) ? adjacency[starts[u]] : n;
+    if (waiting[hub] < 0)
+    {
+      waiting[hub] = u;
+    }
+    else
+    {
+      groups[u] = waiting[hub];
+      waiting[hub] = -1;
+    }
+  }
+
+  QVector<int> ids(n, -1);
+  int count = 0;
+  for (int u = 0; u < n; u++)
+  {
+    if (groups[u] == u)
+    {
+      ids[u] = count++;
+    }
+  }
+  Level coarse;
+  coarse.masses.fill(0, count);
+  fine.coarse.resize(n);
+  QVector<int> memberStarts(count + 1, 0);
+  for (int u = 0; u < n; u++)
+  {
+    const int c = ids[groups[u]];
+    fine.coarse[u] = c;
+    coarse.masses[c] += fine.masses[u];
+    memberStarts[c + 1]++;
+  }
+  for (int c = 0; c < count; c++)
+  {
+    memberStarts[c + 1] += memberStarts[c];
+  }
+  QVector<int> members(n);
+  QVector<int> memberEnds = memberStarts;
+  for (int u = 0; u < n; u++)
+  {
+    members[memberEnds[fine.coarse[u]]++] = u;
+  }
+
+  // the neighbors of the members, each one once
+  QVector<int> stamps(count, -1);
+  coarse.starts.resize(count + 1);
+  coarse.adjacency.reserve(fine.adjacency.size() / 2);
+  for (int c = 0; c < count; c++)
+  {
+    coarse.starts[c] = coarse.adjacency.size();
+    for (int m = memberStarts[c]; m < memberStarts[c + 1]; m++)
+    {
+      const int u = members[m];
+      for (int a = starts[u]; a < starts[u + 1]; a++)
+      {
+        const int neighbor = fine.coarse[adjacency[a]];
+        if (neighbor != c && stamps[neighbor] != c)
+        {
+          stamps[neighbor] = c;
+          coarse.adjacency.append(neighbor);
+        }
+      }
+    }
+  }
+  coarse.starts[count] = coarse.adjacency.size();
+  return coarse;
+}
+
+/** Spreads the 16 low bits of v on the even bits */
+inline quint32 spreadBits(quint32 v)
+{
+  v &= 0xffffu;
+  v = (v | (v << 8)) & 0x00ff00ffu;
+  v = (v | (v << 4)) & 0x0f0f0f0fu;
+  v = (v | (v << 2)) & 0x33333333u;
+  v = (v | (v << 1)) & 0x55555555u;
+  return v;
+}
+
+/** Interleaves the bits of x and y, x giving the even ones */
+inline quint32 mortonCode(quint32 x, quint32 y)
+{
+  return spreadBits(x) | (spreadBits(y) << 1);
+}
+
+/**
+ * A quadtree of the nodes, for the Barnes-Hut approximation of the
+ * repulsion. The nodes are sorted along a Morton curve, so that each cell of
+ * the tree is a range of them and the tree is built without moving them
+ * again.
+ */
+struct QuadTree
+{
+  struct Cell
+  {
+    /** The range of the sorted nodes in the cell */
+    int begin;
+    int end;
+    /** The children are consecutive, the first one being -1 for a leaf */
+    int firstChild;
+    int childCount;
+    /** The center of the nodes in the cell */
+    float x;
+    float y;
+    /** The side of the cell */
+    float size;
+  };
+
+  QVector<Cell> cells;
+  /** The nodes sorted by Morton code */
+  QVector<int> order;
+
+  void build(const QVector<float>& x, const QVector<float>& y)
+  {
+    const int n = x.size();
+    float left = x[0];
+    float right = x[0];
+    float bottom = y[0];
+    float top = y[0];
+    for (int i = 1; i < n; i++)
+    {
+      left = qMin(left, x[i]);
+      right = qMax(right, x[i]);
+      bottom = qMin(bottom, y[i]);
+      top = qMax(top, y[i]);
+    }
+    const float side = qMax(qMax(right - left, top - bottom), 1.f);
+    const float scale = float((1 << treeDepth) - 1) / side;
+
+    QVector<quint32> codes(n);
+    quint32* pcodes = codes.data();
+    const float* px = x.constData();
+    const float* py = y.constData();
+    DotNativeLayout::parallelFor(n, [=](int begin, int end)
+    {
+      for (int i = begin; i < end; i++)
+      {
+        pcodes[i] = mortonCode(quint32((px[i] - left) * scale), quint32((py[i] - bottom) * scale));
+      }
+    });
+
+    // radix sort of the codes, 11 bits at a time
+    order.resize(n);
+    for (int i = 0; i < n; i++)
+    {
+      order[i] = i;
+    }
+    QVector<int> sorted(n);
+    QVector<quint32> sortedCodes(n);
+    QVector<int> counts(radixSize + 1);
+    for (int shift = 0; shift < 32; shift += radixBits)
+    {
+      counts.fill(0);
+      for (int i = 0; i < n; i++)
+      {
+        counts[((codes[i] >> shift) & (radixSize - 1)) + 1]++;
+      }
+      for (int b = 0; b < radixSize; b++)
+      {
+        counts[b + 1] += counts[b];
+      }
+      for (int i = 0; i < n; i++)
+      {
+        const int b = (codes[i] >> shift) & (radixSize - 1);
+        sorted[counts[b]] = order[i];
+        sortedCodes[counts[b]++] = codes[i];
+      }
+      order.swap(sorted);
+      codes.swap(sortedCodes);
+    }
+
+    // the children of a cell are appended when it is reached, breadth first
+    cells.resize(0);
+    cells.append(Cell{0, n, -1, 0, 0, 0, side});
+    QVector<int> depths(1, 0);
+    for (int c = 0; c < cells.size(); c++)
+    {
+      const int depth = depths[c];
+      if (cells[c].end - cells[c].begin <= leafSize || depth == treeDepth)
+      {
+        continue;
+      }
+      const int shift = 2 * (treeDepth - 1 - depth);
+      const int firstChild = cells.size();
+      int begin = cells[c].begin;
+      const int end = cells[c].end;
+      for (quint32 quadrant = 0; quadrant < 4 && begin < end; quadrant++)
+      {
+        const int childEnd = int(std::partition_point(codes.constData() + begin, codes.constData() + end,
+                                                      [shift, quadrant](quint32 code) {return ((code >> shift) & 3u) <= quadrant;})
+                                 - codes.constData());
+        if (childEnd > begin)
+        {
+          cells.append(Cell{begin, childEnd, -1, 0, 0, 0, cells[c].size / 2});
+          depths.append(depth + 1);
+          begin = childEnd;
+        }
+      }
+      cells[c].firstChild = firstChild;
+      cells[c].childCount = cells.size() - firstChild;
+    }
+
+    // the centers of the leaves, then of their parents, which are before them
+    Cell* pcells = cells.data();
+    const int* porder = order.constData();
+    DotNativeLayout::parallelFor(cells.size(), [=](int begin, int end)
+    {
+      for (int c = begin; c < end; c++)
+      {
+        Cell& cell = pcells[c];
+        if (cell.firstChild < 0)
+        {
+          float sumX = 0;
+          float sumY = 0;
+          for (int m = cell.begin; m < cell.end; m++)
+          {
+            sumX += px[porder[m]];
+            sumY += py[porder[m]];
+          }
+          cell.x = sumX / (cell.end - cell.begin);
+          cell.y = sumY / (cell.end - cell.begin);
+        }
+      }
+    });
+    for (int c = cells.size() - 1; c >= 0; c--)
+    {
+      Cell& cell = cells[c];
+      if (cell.firstChild >= 0)
+      {
+        float sumX = 0;
+        float sumY = 0;
+        for (int child = cell.firstChild; child < cell.firstChild + cell.childCount; child++)
+        {
+          const int count = cells[child].end - cells[child].begin;
+          sumX += cells[child].x * count;
+          sumY += cells[child].y * count;
+        }
+        cell.x = sumX / (cell.end - cell.begin);
+        cell.y = sumY / (cell.end - cell.begin);
+      }
+    }
+  }
+};
+
+/**
+ * Moves the nodes of level under the forces of Fruchterman and Reingold, the
+ * moves being limited by a temperature cooling down. On the coarsest level,
+ * a weak gravity keeps the parts of a disconnected graph together.
+ * @return false if cancelled
+ */
+bool refine(const Level& level, QVector<float>& x, QVector<float>& y, float k,
+            int iterations, float temperature, float cooling, bool coarsest, const QAtomicInt* cancelled)
+{
+  const int n = level.nodeCount();
+  const float k2 = k * k;
+  const float opening2 = openingRatio * openingRatio;
+  // coincident nodes are pushed apart by this
+  const float separation = 0.01f * k;
+  QVector<float> newX(n);
+  QVector<float> newY(n);
+  QVector<float> moves(n);
+  QuadTree tree;
+  for (int iteration = 0; iteration < iterations; iteration++)
+  {
+    if (DotNativeLayout::isCancelled(cancelled))
+    {
+      return false;
+    }
+    tree.build(x, y);
+    const float centerX = tree.cells[0].x;
+    const float centerY = tree.cells[0].y;
+
+    const float* px = x.constData();
+    const float* py = y.constData();
+    float* nx = newX.data();
+    float* ny = newY.data();
+    float* pmoves = moves.data();
+    DotNativeLayout::parallelFor(n, [&, px, py, nx, ny, pmoves](int begin, int end)
+    {
+      const int* starts = level.starts.constData();
+      const int* adjacency = level.adjacency.constData();
+      const QuadTree::Cell* cells = tree.cells.constData();
+      const int* order = tree.order.constData();
+      // at most three siblings left on each level
+      int stack[4 * treeDepth + 4];
+      for (int i = begin; i < end; i++)
+      {
+        float fx = 0;
+        float fy = 0;
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0)
+        {
+          const QuadTree::Cell& cell = cells[stack[--top]];
+          const float dx = px[i] - cell.x;
+          const float dy = py[i] - cell.y;
+          const float d2 = dx * dx + dy * dy;
+          if (cell.size * cell.size < opening2 * d2)
+          {
+            // k^2 / d along the unit vector, for each node of the cell
+            const float f = k2 * (cell.end - cell.begin) / d2;
+            fx += dx * f;
+            fy += dy * f;
+          }
+          else if (cell.firstChild >= 0)
+          {
+            for (int child = cell.firstChild; child < cell.firstChild + cell.childCount; child++)
+            {
+              stack[top++] = child;
+            }
+          }
+          else
+          {
+            for (int m = cell.begin; m < cell.end; m++)
+            {
+              const int j = order[m];
+              if (j == i)
+              {
+                continue;
+              }
+              float ndx = px[i] - px[j];
+              float ndy = py[i] - py[j];
+              float nd2 = ndx * ndx + ndy * ndy;
+              if (nd2 < separation * separation)
+              {
+                ndx = (i < j) ? separation : -separation;
+                ndy = ((i ^ j) & 1) ? separation : -separation;
+                nd2 = 2 * separation * separation;
+              }
+              const float f = k2 / nd2;
+              fx += ndx * f;
+              fy += ndy * f;
+            }
+          }
+        }
+        for (int a = starts[i]; a < starts[i + 1]; a++)
+        {
+          const int j = adjacency[a];
+          const float dx = px[j] - px[i];
+          const float dy = py[j] - py[i];
+          // d^2 / k along the unit vector
+          const float f = std::sqrt(dx * dx + dy * dy) / k;
+          fx += dx * f;
+          fy += dy * f;
+        }
+        if (coarsest)
+        {
+          fx -= gravity * (px[i] - centerX);
+          fy -= gravity * (py[i] - centerY);
+        }
+        const float length = std::sqrt(fx * fx + fy * fy);
+        if (length > temperature)
+        {
+          fx *= temperature / length;
+          fy *= temperature / length;
+        }
+        nx[i] = px[i] + fx;
+        ny[i] = py[i] + fy;
+        pmoves[i] = qMin(length, temperature);
+      }
+    });
+    x.swap(newX);
+    y.swap(newY);
+    temperature *= cooling;
+
+    double total = 0;
+    for (int i = 0; i < n; i++)
+    {
+      total += moves[i];
+    }
+    if (total < 0.005 * k * n)
+    {
+      break;
+    }
+  }
+  return true;
+}
+
+/** A small deterministic offset in [-1, 1] */
+inline float jitter(unsigned int i)
+{
+  i ^= i >> 16;
+  i *= 0x45d9f3bu;
+  i ^= i >> 16;
+  return float(i & 0xffff) / 32768.f - 1.f;
+}
+
+}
+
+bool DotForceLayout::layout(DotNativeGraph& graph, const QAtomicInt* cancelled)
+{
+  QElapsedTimer timer;
+  timer.start();
+  const int n = graph.nodeCount();
+  graph.x.resize(n);
+  graph.y.resize(n);
+  graph.bendStarts.clear();
+  graph.bends.clear();
+  if (n == 0)
+  {
+    return true;
+  }
+
+  // the edges settle at about four times k, leaving room for the average node
+  float size = 0;
+  for (int i = 0; i < n; i++)
+  {
+    size += qMax(graph.widths[i], graph.heights[i]);
+  }
+  const float k = 0.3f * (size / n + 36.f);
+
+  QVector<Level> levels;
+  levels.append(finestLevel(graph));
+  while (levels.last().nodeCount() > coarsestSize)
+  {
+    if (DotNativeLayout::isCancelled(cancelled))
+    {
+      return false;
+    }
+    Level coarse = coarsen(levels.last());
+    if (coarse.nodeCount() > coarseningRatio * levels.last().nodeCount())
+    {
+      levels.last().coarse.clear();
+      break;
+    }
+    levels.append(coarse);
+  }
+
+  // the coarsest graph starts at random, in a square fitting its nodes
+  const int coarsestCount = levels.last().nodeCount();
+  float levelK = k * std::sqrt(float(n) / coarsestCount);
+  QVector<float> x(coarsestCount);
+  QVector<float> y(coarsestCount);
+  std::mt19937 random(n);
+  std::uniform_real_distribution<float> distribution(0.f, levelK * std::sqrt(float(coarsestCount)));
+  for (int i = 0; i < coarsestCount; i++)
+  {
+    x[i] = distribution(random);
+    y[i] = distribution(random);
+  }
+
+  for (int l = levels.size() - 1; l >= 0; l--)
+  {
+    const Level& level = levels[l];
+    levelK = k * std::sqrt(float(n) / level.nodeCount());
+    const bool coarsest = (l == levels.size() - 1);
+    bool done;
+    if (coarsest)
+    {
+      done = refine(level, x, y, levelK, 300, levelK * std::sqrt(float(coarsestCount)) / 4, 0.97f, true, cancelled);
+    }
+    else
+    {
+      done = refine(level, x, y, levelK, (l == 0) ? 15 : 20, levelK, 0.9f, false, cancelled);
+    }
+    if (!done)
+    {
+      return false;
+    }
+    if (l > 0)
+    {
+      // the nodes of the finer level start around the one they are merged in
+      const Level& finer = levels[l - 1];
+      const float finerK = k * std::sqrt(float(n) / finer.nodeCount());
+      QVector<float> finerX(finer.nodeCount());
+      QVector<float> finerY(finer.nodeCount());
+      for (int u = 0; u < finer.nodeCount(); u++)
+      {
+        finerX[u] = x[finer.coarse[u]] + 0.2f * finerK * jitter(2 * u);
+        finerY[u] = y[finer.coarse[u]] + 0.2f * finerK * jitter(2 * u + 1);
+      }
+      x.swap(finerX);
+      y.swap(finerY);
+    }
+  }
+  graph.x = x;
+  graph.y = y;
+  qCDebug(KGRAPHVIEWERLIB_LOG) << n << "nodes laid out with" << levels.size() << "levels in" << timer.elapsed() << "ms";
+  return true;
+}
+
+}
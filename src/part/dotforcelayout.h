@@ -0,0 +1,57 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+/*
+ * Built-in multilevel force directed layout engine
+ */
+
+#ifndef DOT_FORCE_LAYOUT_H
+#define DOT_FORCE_LAYOUT_H
+
+#include <QAtomicInt>
+
+namespace KGraphViewer
+{
+
+struct DotNativeGraph;
+
+/**
+ * A multilevel force directed layout for very large graphs, in the spirit
+ * of Walshaw's multilevel placement and of sfdp.
+ *
+ * The graph is coarsened by merging matched neighbors, then the leaves of a
+ * same node, until it is small. The coarsest graph is laid out from random
+ * positions, and each finer level starts from the positions of the coarser
+ * one. The repulsion is approximated with a Barnes-Hut quadtree, built over
+ * the nodes sorted along a Morton curve, and the forces are computed for all
+ * the nodes in parallel, over contiguous arrays of positions. The edges are
+ * left straight.
+ */
+class DotForceLayout
+{
+public:
+  /**
+   * Sets the positions of the nodes of graph.
+   * @return false if cancelled
+   */
+  static bool layout(DotNativeGraph& graph, const QAtomicInt* cancelled = nullptr);
+};
+
+}
+
+#endif
@@ -21,16 +21,16 @@
 #include "dotdefaults.h"
 #include "graphnode.h"
 #include "graphedge.h"
-#include "DotGraphParsingHelper.h"
 #include "kgraphviewerlib_debug.h"
 
 #include <iostream>
+#include <cmath>
+#include <cstring>
 
 #include <QDebug>
     
 #include <QFile>
 
-#include <boost/spirit/include/classic_confix.hpp>
 #include <boost/throw_exception.hpp> 
 namespace boost
 {
@@ -47,304 +47,6 @@ using namespace KGraphViewer;
 #define KGV_MAX_ITEMS_TO_LOAD std::numeric_limits<size_t>::max()
 #define BOOST_SPIRIT_DEBUG 1
 
-DotGraphParsingHelper* phelper = nullptr;
-
-std::string therenderop;
-std::string thestr;
-
-void anychar(char const c);
-
-// keyword_p for C++
-// (for basic usage instead of std_p)
-const boost::spirit::classic::distinct_parser<> keyword_p("0-9a-zA-Z_");
-
-template <typename ScannerT>
-DotGrammar::definition<ScannerT>::definition(DotGrammar const& /*self*/)
-{
-  graph  = (!(keyword_p("strict")[&strict]) >> (keyword_p("graph")[&undigraph] | keyword_p("digraph")[&digraph])
-  >> !ID[&graphid] >> ch_p('{') >> !stmt_list >> ch_p('}'))[&finalactions];
-  ID = (
-  ( ( (anychar_p - punct_p) | '_' ) >> *( (anychar_p - punct_p) | '_' ) )
-  | real_p
-  | ( '"' >>  *( (ch_p('\\') >> '"') | (anychar_p - '"') ) >>  '"' )
-  | ( ch_p('<') >>  *( (anychar_p  - '<' - '>') | tag ) >>  '>' )
-  );
-  tag = ('<' >> *( anychar_p  - '>') >> '>');
-  stmt_list  =  stmt >> !(ch_p(';')) >> !( stmt_list ) ;
-  stmt  =  (
-  attr_stmt
-  |  subgraph
-  |  edge_stmt
-  |  node_stmt
-  |  ( ID >> '=' >> ID )
-  );
-
-  attr_stmt  = (
-  (keyword_p("graph")[assign_a(phelper->attributed)] >> attr_list[&setattributedlist])[&setgraphattributes]
-  | (keyword_p("node")[assign_a(phelper->attributed)] >> attr_list[&setattributedlist])
-  | (keyword_p("edge")[assign_a(phelper->attributed)] >> attr_list[&setattributedlist])
-  ) ;
-
-  attr_list  = ch_p('[') >> !( a_list ) >> ch_p(']');
-  a_list  =  ((ID[&attrid] >> !( '=' >> ID[&valid] ))[&addattr] >> !(',' >> a_list ));
-  edge_stmt  =  ( (node_id[&edgebound] | subgraph) >>  edgeRHS >> !( attr_list[assign_a(phelper->attributed,"edge")] ) )[&pushAttrList][&setattributedlist][&createedges][&popAttrList];
-  edgeRHS  =  edgeop[&checkedgeop] >> (node_id[&edgebound] | subgraph) >> !( edgeRHS );
-  edgeop = str_p("->") | str_p("--");
-  node_stmt  = ( node_id[&createnode] >> !( attr_list ) )[assign_a(phelper->attributed,"node")][&pushAttrList][&setattributedlist][&setnodeattributes][&popAttrList];
-  node_id  =  (ID >> !( port ));
-  port  =  ( ch_p(':') >> ID >> !( ':' >> compass_pt ) )
-  |  ( ':' >> compass_pt );
-  subgraph  =  ( !( keyword_p("subgraph") >> !( ID[&subgraphid] ) ) >> ch_p('{')[&createsubgraph][&incrz][&pushAttrListC] >> stmt_list >> ch_p('}') [&decrz][&popAttrListC])
-  |  ( keyword_p("subgraph") >> ID[&subgraphid]);
-  compass_pt  =  (keyword_p("n") | keyword_p("ne") | keyword_p("e")
-  | keyword_p("se") | keyword_p("s") | keyword_p("sw")
-  | keyword_p("w") | keyword_p("nw") );
-}
-
-
-
-
-void incrz(char const /*first*/)
-{
-  if (phelper)
-  {
-    phelper->z++;
-    if (phelper->z > phelper->maxZ)
-    {
-      phelper->maxZ = phelper->z;
-    }
-  }
-}
-
-void anychar(char const c)
-{
-    Q_UNUSED(c);
-//   qCDebug(KGRAPHVIEWERLIB_LOG) << c;
-}
-
-void decrz(char const /*first*/)
-{
-  if (phelper)
-  {
-    phelper->z--;
-    phelper->gs = nullptr;
-  }
-}
-
-void dump(char const* first, char const* last)
-{
-  std::string str(first, last);
-  qCWarning(KGRAPHVIEWERLIB_LOG) << ">>>> " << QString::fromStdString(str) << " <<<<" << endl;
-}
-
-void strict(char const* /*first*/, char const* /*last*/)
-{
-  if (phelper) phelper->graph->strict(true);
-}
-
-void gotid(char const* first, char const* last)
-{
-  std::string id(first,last);
-//   qCDebug(KGRAPHVIEWERLIB_LOG) << "Got ID  = '"<<QString::fromStdString(phelper->attrid)<<"'";
-}
-
-void undigraph(char const* /*first*/, char const* /*last*/)
-{
-//   qCDebug(KGRAPHVIEWERLIB_LOG) << "Setting graph as undirected";
-  if (phelper) phelper->graph->directed(false);
-}
-
-void digraph(char const* /*first*/, char const* /*last*/)
-{
-//   qCDebug(KGRAPHVIEWERLIB_LOG) << "Setting graph as directed";
-  if (phelper) phelper->graph->directed(true);
-}
-
-void graphid(char const* first, char const* last)
-{
-//   qCDebug(KGRAPHVIEWERLIB_LOG) << QString::fromStdString(std::string(first,last));
-  if (phelper) phelper->graph->setId(QString::fromStdString(std::string(first,last)));
-}
-
-void attrid(char const* first, char const* last)
-{
-  if (phelper) 
-  {
-    std::string id(first,last);
-    if (id.size()>0 && id[0] == '"') id = id.substr(1);
-    if (id.size()>0 && id[id.size()-1] == '"') id = id.substr(0,id.size()-1);
-    phelper->attrid = id;
-    phelper->valid = "";
-//     qCDebug(KGRAPHVIEWERLIB_LOG) << "Got attr ID  = '"<<QString::fromStdString(phelper->attrid)<<"'";
-  }
-}
-
-void subgraphid(char const* first, char const* last)
-{
-  std::string id(first,last);
-//   qCDebug(KGRAPHVIEWERLIB_LOG) << QString::fromStdString(id);
-  if (phelper) 
-  {
-    if (id.size()>0 && id[0] == '"') id = id.substr(1);
-    if (id.size()>0 && id[id.size()-1] == '"') id = id.substr(0,id.size()-1);
-    phelper->subgraphid = id;
-//     qCDebug(KGRAPHVIEWERLIB_LOG) << "Got subgraph id = '"<<QString::fromStdString(phelper->subgraphid)<<"'";
-  }
-}
-
-void valid(char const* first, char const* last)
-{
-  std::string id(first,last);
-  if (phelper)
-  {
-    if (id.size()>0 && id[0] == '"') id = id.substr(1);
-    if (id.size()>0 && id[id.size()-1] == '"') id = id.substr(0,id.size()-1);
-    phelper->valid = id;
-//     qCDebug(KGRAPHVIEWERLIB_LOG) << "Got attr val = '"<<QString::fromStdString(id)<<"'";
-  }
-}
-
-void addattr(char const* /*first*/, char const* /*last*/)
-{
-  if (phelper) 
-  {
-    phelper->attributes.insert(std::make_pair(phelper->attrid,phelper->valid));
-  }
-}
-
-void pushAttrListC(char const /*c*/)
-{
-  pushAttrList(nullptr, nullptr);
-}
-
-void pushAttrList(char const* /*first*/, char const* /*last*/)
-{
-//   qCDebug(KGRAPHVIEWERLIB_LOG) << "Pushing attributes";
-  if (phelper)
-  {
-    phelper->graphAttributesStack.push_back(phelper->graphAttributes);
-    phelper->graphAttributes.clear();
-    phelper->nodesAttributesStack.push_back(phelper->nodesAttributes);
-    phelper->nodesAttributes.clear();
-    phelper->edgesAttributesStack.push_back(phelper->edgesAttributes);
-    phelper->edgesAttributes.clear();
-  }
-}
-
-void popAttrListC(char const /*c*/)
-{
-  popAttrList(nullptr, nullptr);
-}
-
-void popAttrList(char const* /*first*/, char const* /*last*/)
-{
-//   qCDebug(KGRAPHVIEWERLIB_LOG) << "Poping attributes";
-  if (phelper) 
-  {
-    phelper->graphAttributes = phelper->graphAttributesStack.back();
-    phelper->graphAttributesStack.pop_back();
-    phelper->nodesAttributes = phelper->nodesAttributesStack.back();
-    phelper->nodesAttributesStack.pop_back();
-    phelper->edgesAttributes = phelper->edgesAttributesStack.back();
-    phelper->edgesAttributesStack.pop_back();
-  }
-//   qCDebug(KGRAPHVIEWERLIB_LOG) << "Poped";
-}
-
-void createnode(char const* first, char const* last)
-{
-//   qCDebug(KGRAPHVIEWERLIB_LOG) << (void*)first << (void*)last << QString::fromStdString(std::string(first,last));
-  if (phelper && first && last)
-  {
-    std::string id(first,last);
-    if (id.size()>0 && id[0] == '"') id = id.substr(1);
-    if (id.size()>0 && id[id.size()-1] == '"') id = id.substr(0,id.size()-1);
-    phelper->createnode(id);
-  }
-}
-
-void createsubgraph(char const /*c*/)
-{
-  if (phelper) 
-  {
-    phelper->createsubgraph();
-  }
-}
-
-void setgraphattributes(char const* /*first*/, char const* /*last*/)
-{
-//   qCDebug(KGRAPHVIEWERLIB_LOG) << "setgraphattributes with z = " << phelper->z;
-  if (phelper) 
-  {
-    if (phelper->z == 1) // main graph
-    {
-      phelper->setgraphattributes();
-    }
-    else
-    {
-      phelper->setsubgraphattributes();
-    }
-  }
-}
-
-void setnodeattributes(char const* /*first*/, char const* /*last*/)
-{
-//   qCDebug(KGRAPHVIEWERLIB_LOG) << "setnodeattributes with z = " << phelper->z;
-  if (phelper) 
-  {
-    phelper->setnodeattributes();
-  }
-}
-
-void setattributedlist(char const* /*first*/, char const* /*last*/)
-{
-  if (phelper) 
-  {
-    phelper->setattributedlist();
-  }
-}
-
-void checkedgeop(char const* first, char const* last)
-{
-  std::string str(first,last);
-  if (phelper) 
-  {
-    if ( ( (phelper->graph->directed()) && (str == "->") ) || 
-      ( (!phelper->graph->directed()) && (str == "--") ) )
-      return;
-    
-    qCWarning(KGRAPHVIEWERLIB_LOG) << "Error !! uncoherent relation : directed = '" << phelper->graph->directed() << "' and op = '" << QString::fromStdString(str) << "'" << endl;
-  }
-}
-
-void edgebound(char const* first, char const* last)
-{
-//   qCDebug(KGRAPHVIEWERLIB_LOG) << "edgebound: " << QString::fromStdString(std::string(first,last));
-  if (phelper) 
-  {
-    std::string id(first,last);
-    if (id.size()>0 && id[0] == '"') id = id.substr(1);
-    if (id.size()>0 && id[id.size()-1] == '"') id = id.substr(0,id.size()-1);
-    phelper->edgebound(id);
-  }
-}
-
-void createedges(char const* /*first*/, char const* /*last*/)
-{
-  if (phelper) 
-  {
-    phelper->createedges();
-  }
-}
-
-void finalactions(char const* /*first*/, char const* /*last*/)
-{
-  if (phelper) 
-  {
-    phelper->finalactions();
-  }
-}
-
 bool parse_point(char const* str, QPoint& p)
 {
   int x,y;
@@ -460,97 +162,252 @@ bool parse_spline(char const* str, QVector< QPair< float, float > >& points)
   return true;
 }
 
-DotRenderOp renderop ;
+// Hand written decoder of the xdot drawing operations. See
+// http://www.graphviz.org/doc/info/output.html#d:xdot for the format.
+// It makes a single pass on the string without copying it and without going
+// through intermediate std::string objects.
+namespace
+{
 
-DotRenderOpVec* renderopvec = nullptr;
+inline bool isRenderOpSpace(char c)
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
 
-void init_op()
+inline void skipRenderOpSpaces(const char*& p, const char* last)
 {
-  renderop = DotRenderOp();
+  while (p != last && isRenderOpSpace(*p))
+  {
+    ++p;
+  }
 }
 
-void valid_op(char const* first, char const* last)
+/**
+ * Reads a count or a text size
+ */
+inline bool readRenderOpInt(const char*& p, const char* last, int& value)
 {
-  std::string s(first, last);
-  renderop.renderop = QString::fromUtf8(therenderop.c_str());
-  renderop.str = QString::fromUtf8(thestr.c_str());
+  skipRenderOpSpaces(p, last);
+  bool negative = false;
+  if (p != last && (*p == '-' || *p == '+'))
+  {
+    negative = (*p == '-');
+    ++p;
+  }
+  bool hasDigits = false;
+  int result = 0;
+  while (p != last && *p >= '0' && *p <= '9')
+  {
+    result = result * 10 + (*p - '0');
+    hasDigits = true;
+    ++p;
+  }
+  value = negative ? -result : result;
+  return hasDigits;
+}
 
-//   qCDebug(KGRAPHVIEWERLIB_LOG) << "Validating render operation '"<<QString::fromStdString(s)<<"': '"<<renderop.renderop<<"/"<<renderop.str<<"'";
-  renderopvec->push_back(renderop);
-  renderop.renderop = "";
-  renderop.integers = QList<int>();
-  renderop.str = "";
+/**
+ * Reads a coordinate, keeping its fractional part. A ',' is accepted as
+ * decimal separator, as some locales make Graphviz write it.
+ */
+inline bool readRenderOpReal(const char*& p, const char* last, float& value)
+{
+  skipRenderOpSpaces(p, last);
+  bool negative = false;
+  if (p != last && (*p == '-' || *p == '+'))
+  {
+    negative = (*p == '-');
+    ++p;
+  }
+  bool hasDigits = false;
+  double result = 0;
+  while (p != last && *p >= '0' && *p <= '9')
+  {
+    result = result * 10 + (*p - '0');
+    hasDigits = true;
+    ++p;
+  }
+  if (p != last && (*p == '.' || *p == ','))
+  {
+    ++p;
+    double scale = 0.1;
+    while (p != last && *p >= '0' && *p <= '9')
+    {
+      result += (*p - '0') * scale;
+      scale /= 10;
+      hasDigits = true;
+      ++p;
+    }
+  }
+  if (hasDigits && p != last && (*p == 'e' || *p == 'E'))
+  {
+    ++p;
+    int exponent;
+    if (!readRenderOpInt(p, last, exponent))
+    {
+      return false;
+    }
+    result *= std::pow(10.0, exponent);
+  }
+  value = float(negative ? -result : result);
+  return hasDigits;
 }
 
-bool parse_renderop(const std::string& str, DotRenderOpVec& arenderopvec)
+/**
+ * Reads a "n -b1b2...bn" text made of the n bytes following the '-'
+ */
+inline bool readRenderOpText(const char*& p, const char* last, QString& text)
 {
-//   qCDebug(KGRAPHVIEWERLIB_LOG) << QString::fromUtf8(str.c_str()) << str.size();
-  if (str.empty())
+  int size;
+  if (!readRenderOpInt(p, last, size) || size < 0)
   {
     return false;
   }
-  init_op();
-  renderopvec = &arenderopvec;
-  bool res;
-  int c;
-  res = parse(str.c_str(),
-              (
-                +(
-                   (
-                     (ch_p('E')|ch_p('e'))[assign_a(therenderop)] >> +space_p >>
-                     repeat_p(4)[int_p[push_back_a(renderop.integers)] >> !((ch_p(',')|ch_p('.')) >> int_p) >> +space_p]
-                   )[&valid_op] 
-                   | (
-                       (ch_p('P')|ch_p('p')|ch_p('L')|ch_p('B')|ch_p('b'))[assign_a(therenderop)] >> +space_p >>
-                       int_p[assign_a(c)][push_back_a(renderop.integers)] >> +space_p >> 
-                       repeat_p(boost::ref(c))[
-                                                int_p[push_back_a(renderop.integers)] >> !((ch_p(',')|ch_p('.')) >> int_p) >> +space_p >>
-                                                int_p[push_back_a(renderop.integers)] >> !((ch_p(',')|ch_p('.')) >> int_p) >> +space_p
-                                              ] 
-                     )[&valid_op]
-  // "T 1537 228 0 40 9 -#1 (== 0) T 1537 217 0 90 19 -MAIN:./main/main.pl "
-  // T x y j w n -b1b2...bn 	Text drawn using the baseline point (x,y). The text consists of the n bytes following '-'. The text should be left-aligned (centered, right-aligned) on the point if j is -1 (0, 1), respectively. The value w gives the width of the text as computed by the library. 
-  // I x y w h n -b1b2...bn 	Externally-specified image drawn in the box with lower left corner (x,y) and upper right corner (x+w,y+h). The name of the image consists of the n bytes following '-'. This is usually a bitmap image. Note that the image size, even when converted from pixels to points, might be different from the required size (w,h). It is assumed the renderer will perform the necessary scaling. (1.2) 
-                   | (
-                       (ch_p('T')|ch_p('I'))[assign_a(therenderop)] >> +space_p >>
-                       repeat_p(4)[int_p[push_back_a(renderop.integers)] >> !((ch_p(',')|ch_p('.')) >> int_p) >> +space_p] >>
-                       int_p[assign_a(c)] >> +space_p >> '-' >> 
-                       (repeat_p(boost::ref(c))[anychar_p])[assign_a(thestr)] >> +space_p
-                     )[&valid_op]
-  // c 9 -#000000ff 
-                     | (
-                       (ch_p('C')|ch_p('c')|ch_p('S'))[assign_a(therenderop)] >> +space_p >>
-                       int_p[assign_a(c)] >> +space_p >> '-' >> 
-                       (repeat_p(boost::ref(c))[anychar_p])[assign_a(thestr)] >> +space_p
-                     )[&valid_op] 
-  // t 0
-  // t f 	Set font characteristics. The integer f is the OR of BOLD=1, ITALIC=2, UNDERLINE=4, SUPERSCRIPT=8, SUBSCRIPT=16, (1.5) STRIKE-THROUGH=32 (1.6), and OVERLINE=64 (1.7). 
-                     | (
-                       (ch_p('t'))[assign_a(therenderop)] >> +space_p >>
-                       int_p[assign_a(c)] >> +space_p 
-                     )[&valid_op] 
-  // F 14,000000 11 -Times-Roman 
-                    | (
-                       ch_p('F')[assign_a(therenderop)] >> +space_p >>
-                       int_p[push_back_a(renderop.integers)] >> !((ch_p(',')|ch_p('.')) >> int_p) >> +space_p >>
-                       int_p[assign_a(c)] >> +space_p >> '-' >> 
-                       (repeat_p(boost::ref(c))[anychar_p])[assign_a(thestr)] >> +space_p
-                     )[&valid_op]
-                 )
-                 ) >> !end_p
-             ).full;
-  if (res ==false)
+  skipRenderOpSpaces(p, last);
+  if (p == last || *p != '-' || last - (p + 1) < size)
+  {
+    return false;
+  }
+  ++p;
+  text = QString::fromUtf8(p, size);
+  p += size;
+  return true;
+}
+
+inline bool readRenderOpCoordinates(const char*& p, const char* last, int count, DotRenderOpVec& ops)
+{
+  for (int i = 0; i < count; i++)
+  {
+    float value;
+    if (!readRenderOpReal(p, last, value))
+    {
+      return false;
+    }
+    ops.appendCoordinate(value);
+  }
+  return true;
+}
+
+inline bool renderOpCode(char c, DotRenderOp::Code& code)
+{
+  switch (c)
+  {
+    case 'c': code = DotRenderOp::PenColor; return true;
+    case 'C': code = DotRenderOp::FillColor; return true;
+    case 'S': code = DotRenderOp::Style; return true;
+    case 'p': code = DotRenderOp::Polygon; return true;
+    case 'P': code = DotRenderOp::FilledPolygon; return true;
+    case 'L': code = DotRenderOp::Polyline; return true;
+    case 'B': code = DotRenderOp::BSpline; return true;
+    case 'b': code = DotRenderOp::FilledBSpline; return true;
+    case 'e': code = DotRenderOp::Ellipse; return true;
+    case 'E': code = DotRenderOp::FilledEllipse; return true;
+    case 'T': code = DotRenderOp::Text; return true;
+    case 'F': code = DotRenderOp::Font; return true;
+    case 't': code = DotRenderOp::FontCharacteristics; return true;
+    case 'I': code = DotRenderOp::Image; return true;
+    default: return false;
+  }
+}
+
+}
+
+bool parse_renderop(const char* first, const char* last, DotRenderOpVec& arenderopvec)
+{
+  const char* p = first;
+  skipRenderOpSpaces(p, last);
+  if (p == last)
+  {
+    return false;
+  }
+  QString text;
+  while (p != last)
   {
-    qCWarning(KGRAPHVIEWERLIB_LOG) << "ERROR: parse_renderop failed on "<< QString::fromStdString(str);
-    qCWarning(KGRAPHVIEWERLIB_LOG) << "       Last renderop string is "<<QString::fromStdString(str.c_str());
+    DotRenderOp renderop;
+    const char c = *p++;
+    bool res = renderOpCode(c, renderop.code) && p != last && isRenderOpSpace(*p);
+    renderop.count = 0;
+    renderop.coordinates = arenderopvec.nextCoordinate();
+    renderop.text = 0;
+    int count;
+    if (res)
+    {
+      switch (renderop.code)
+      {
+        case DotRenderOp::PenColor:
+        case DotRenderOp::FillColor:
+          res = readRenderOpText(p, last, text);
+          if (res)
+          {
+            renderop.text = arenderopvec.internColor(text);
+          }
+          break;
+        case DotRenderOp::Style:
+          res = readRenderOpText(p, last, text);
+          if (res)
+          {
+            renderop.text = arenderopvec.internText(text);
+          }
+          break;
+        case DotRenderOp::Polygon:
+        case DotRenderOp::FilledPolygon:
+        case DotRenderOp::Polyline:
+        case DotRenderOp::BSpline:
+        case DotRenderOp::FilledBSpline:
+          res = readRenderOpInt(p, last, count) && count >= 0
+              && readRenderOpCoordinates(p, last, 2 * count, arenderopvec);
+          renderop.count = count;
+          break;
+        case DotRenderOp::Ellipse:
+        case DotRenderOp::FilledEllipse:
+          res = readRenderOpCoordinates(p, last, 4, arenderopvec);
+          break;
+        case DotRenderOp::Text:
+        case DotRenderOp::Image:
+          res = readRenderOpCoordinates(p, last, 4, arenderopvec)
+              && readRenderOpText(p, last, text);
+          if (res)
+          {
+            renderop.text = arenderopvec.internText(text);
+          }
+          break;
+        case DotRenderOp::Font:
+          res = readRenderOpCoordinates(p, last, 1, arenderopvec)
+              && readRenderOpText(p, last, text);
+          if (res)
+          {
+            renderop.text = arenderopvec.internText(text);
+          }
+          break;
+        case DotRenderOp::FontCharacteristics:
+          res = readRenderOpCoordinates(p, last, 1, arenderopvec);
+          break;
+      }
+    }
+    if (!res)
+    {
+      qCWarning(KGRAPHVIEWERLIB_LOG) << "ERROR: parse_renderop failed on "<< QString::fromUtf8(first, last - first);
+      qCWarning(KGRAPHVIEWERLIB_LOG) << "       at "<< QString::fromUtf8(p, last - p);
+      return false;
+    }
+//     qCDebug(KGRAPHVIEWERLIB_LOG) << "Validating render operation '"<<renderop.name()<<"'";
+    arenderopvec.append(renderop);
+    skipRenderOpSpaces(p, last);
+  }
+  return true;
+}
+
+bool parse_renderop(const char* str, DotRenderOpVec& arenderopvec)
+{
+  if (str == nullptr)
+  {
+    return false;
   }
-//   delete renderop; renderop = 0;
-  return res;
+  return parse_renderop(str, str + strlen(str), arenderopvec);
 }
 
-bool parse(const std::string& str)
+bool parse_renderop(const std::string& str, DotRenderOpVec& arenderopvec)
 {
-  DotGrammar g;
-  return boost::spirit::classic::parse(str.c_str(), g >> end_p, (+boost::spirit::classic::space_p|boost::spirit::classic::comment_p("/*", "*/"))).full;
+  return parse_renderop(str.data(), str.data() + str.size(), arenderopvec);
 }
 
@@ -20,50 +20,203 @@
 #include "dotgrammar.h"
 #include "graphexporter.h"
 #include "DotGraphParsingHelper.h"
+#include "dotparser.h"
+#include "dotjsonparser.h"
+#include "dotinput.h"
+#include "dotcontextpool.h"
+#include "dotcomponentlayout.h"
+#include "dotnativelayout.h"
+#include "dotlayoutcache.h"
+#include "dotlayoutchooser.h"
+#include "dotlayoutpreset.h"
+#include "dotrenderopcollector.h"
 #include "canvasedge.h"
 #include "canvassubgraph.h"
 #include "layoutagraphthread.h"
+#include "kgraphviewer_partsettings.h"
 #include "kgraphviewerlib_debug.h"
 
 #include <iostream>
 #include <stdio.h>
 #include <stdlib.h>
 #include "fdstream.hpp"
-#include <boost/spirit/include/classic_confix.hpp>
 #include <graphviz/gvc.h>
 
 #include <QMessageBox>
 
+#include <QBuffer>
 #include <QFile>
+#include <QFileInfo>
+#include <QFutureWatcher>
 #include <QPair>
 #include <QByteArray>
 #include <QProcess>
 #include <QMutexLocker>
-#include <QUuid>
+#include <QScopedPointer>
+#include <QSocketNotifier>
+#include <QtConcurrentRun>
 #include <klocalizedstring.h>
 
-using namespace boost;
-using namespace boost::spirit::classic;
-
-extern KGraphViewer::DotGraphParsingHelper* phelper;
-
 
 namespace KGraphViewer
 {
   
-  
-const distinct_parser<> keyword_p("0-9a-zA-Z_");
+/** What parseDot finds out in a thread about a graph before laying it out */
+struct DotLayoutPreparation
+{
+  QString fileName;
+  QSharedPointer<DotInput> input;
+  /** false if the input could not be opened */
+  bool opened = false;
+  /** The layout program to run, empty if there is none for the content */
+  QString layoutCommand;
+  /** The key of the layout in the layout cache, empty if it is not cached */
+  QByteArray cacheKey;
+  /** The graph of an already laid out file, nullptr if it has to be laid out */
+  DotGraph* laidOut = nullptr;
+};
+
+namespace
+{
+
+/**
+ * Reads the graph of the xdot content of input, laid out by layoutCommand
+ * @return nullptr if the content cannot be parsed
+ */
+DotGraph* readLaidOutDot(const QString& str, const QString& layoutCommand, DotInput& input)
+{
+  input.readToEnd();
+  QScopedPointer<DotGraph> graph(new DotGraph(layoutCommand, str));
+  DotGraphParsingHelper helper;
+  helper.graph = graph.data();
+  helper.z = 1;
+  helper.maxZ = 1;
+  helper.uniq = 0;
+  DotParser parser(helper);
+  if (!parser.parseInParallel(input.data(), input.data() + input.size()) || !parser.isFinished())
+  {
+    qCWarning(KGRAPHVIEWERLIB_LOG) << "parsing failed" << str;
+    return nullptr;
+  }
+  return graph.take();
+}
+
+/**
+ * Reads the layout of str by layoutCommand stored in the layout cache in path
+ * @param json true if the layout is in the -Tjson format
+ * @return nullptr if it cannot be read
+ */
+DotGraph* readCachedLayout(const QString& str, const QString& layoutCommand, const QString& path, bool json)
+{
+  qCDebug(KGRAPHVIEWERLIB_LOG) << "Using the cached layout" << path << "of" << str;
+  if (!json)
+  {
+    DotInput cacheInput(path);
+    return cacheInput.open() ? readLaidOutDot(str, layoutCommand, cacheInput) : nullptr;
+  }
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly))
+  {
+    return nullptr;
+  }
+  QScopedPointer<DotGraph> graph(new DotGraph(layoutCommand, str));
+  DotJsonParser parser(graph.data());
+  if (!parser.readFrom(&file) || !parser.finish())
+  {
+    return nullptr;
+  }
+  return graph.take();
+}
+
+DotLayoutPreparation prepareLayout(const QString& str, const QSharedPointer<DotInput>& input, const QString& layoutCommand, bool json)
+{
+  DotLayoutPreparation result;
+  result.fileName = str;
+  result.input = input;
+  if (!input->open())
+  {
+    return result;
+  }
+  result.opened = true;
+  result.layoutCommand = layoutCommand;
+  // an .xdot file is shown as it is laid out, unless the user chose a
+  // layout program or it is only named like one, without the positions
+  // Graphviz gives with the bounding box of the graph
+  if (layoutCommand.isEmpty() && QFileInfo(str).suffix() == QLatin1String("xdot") && !input->isCompressed())
+  {
+    QScopedPointer<DotGraph> graph(readLaidOutDot(str, input->layoutCommand(), *input));
+    if (graph && graph->width() > 0 && graph->height() > 0)
+    {
+      result.layoutCommand = graph->layoutCommand();
+      result.laidOut = graph.take();
+      return result;
+    }
+    qCDebug(KGRAPHVIEWERLIB_LOG) << str << "is not laid out";
+    input->rewind();
+  }
+  if (result.layoutCommand.isEmpty())
+  {
+    result.layoutCommand = DotLayoutChooser::choose(str, *input);
+    if (result.layoutCommand.isEmpty())
+    {
+      return result;
+    }
+  }
+
+  // a stream cannot be hashed before being laid out without holding it all,
+  // and the built-in engines give no output to cache
+  if (!DotLayoutCache::isEnabled() || input->isStream() || DotNativeLayout::isNative(result.layoutCommand))
+  {
+    return result;
+  }
+  const QByteArray contentHash = input->hash();
+  input->rewind();
+  if (contentHash.isEmpty())
+  {
+    return result;
+  }
+  result.cacheKey = DotLayoutCache::key(contentHash, result.layoutCommand, QLatin1String(json ? "json" : "xdot"));
+  const QString cachedPath = DotLayoutCache::find(result.cacheKey);
+  if (!cachedPath.isEmpty())
+  {
+    result.laidOut = readCachedLayout(str, result.layoutCommand, cachedPath, json);
+    if (result.laidOut == nullptr)
+    {
+      // laid out again, and written again in the cache
+      DotLayoutCache::discard(cachedPath);
+      qCWarning(KGRAPHVIEWERLIB_LOG) << "Invalid cached layout" << cachedPath << "running" << result.layoutCommand;
+    }
+  }
+  return result;
+}
+
+}
 
 DotGraph::DotGraph() :
   GraphElement(),
   m_dotFileName(""),m_width(0.0), m_height(0.0),m_scale(1.0),
   m_directed(true),m_strict(false),
   m_layoutCommand(""),
+  m_layoutTime(-1),
   m_horizCellFactor(0), m_vertCellFactor(0),
   m_wdhcf(0), m_hdvcf(0),
   m_readWrite(false),
   m_dot(nullptr),
+  m_dotInput(),
+  m_dotInputNotifier(nullptr),
+  m_layoutCacheEntry(nullptr),
+  m_layoutCacheKey(),
+  m_dotOutputGraph(nullptr),
+  m_dotOutputHelper(nullptr),
+  m_dotOutputParser(nullptr),
+  m_jsonOutputParser(nullptr),
+  m_dotTimer(),
+  m_dotParsingTime(0),
   m_phase(Initial),
+  m_layoutPreparation(nullptr),
+  m_preparedInput(),
+  m_threadLayout(nullptr),
+  m_threadLayoutCancelled(),
   m_useLibrary(false)
 {
   setId("unnamed");
@@ -74,11 +227,26 @@ DotGraph::DotGraph(const QString& command, const QString& fileName) :
   m_dotFileName(fileName),m_width(0.0), m_height(0.0),m_scale(1.0),
   m_directed(true),m_strict(false),
   m_layoutCommand(command),
+  m_layoutTime(-1),
   m_horizCellFactor(0), m_vertCellFactor(0),
   m_wdhcf(0), m_hdvcf(0),
   m_readWrite(false),
   m_dot(nullptr),
+  m_dotInput(),
+  m_dotInputNotifier(nullptr),
+  m_layoutCacheEntry(nullptr),
+  m_layoutCacheKey(),
+  m_dotOutputGraph(nullptr),
+  m_dotOutputHelper(nullptr),
+  m_dotOutputParser(nullptr),
+  m_jsonOutputParser(nullptr),
+  m_dotTimer(),
+  m_dotParsingTime(0),
   m_phase(Initial),
+  m_layoutPreparation(nullptr),
+  m_preparedInput(),
+  m_threadLayout(nullptr),
+  m_threadLayoutCancelled(),
   m_useLibrary(false)
 {
   setId("unnamed");
@@ -86,52 +254,116 @@ DotGraph::DotGraph(const QString& command, const QString& fileName) :
 
 DotGraph::~DotGraph()  
 {
+  if (m_preparedInput)
+  {
+    // do not keep a thread waiting for a stream
+    m_preparedInput->cancel();
+  }
+  cancelThreadLayout();
+  stopDotOutputParsing();
+  closeDotInput();
+  closeLayoutCacheEntry(false);
   qDeleteAll(m_subgraphsMap);
   m_subgraphsMap.clear();
   qDeleteAll(m_nodesMap);
   m_nodesMap.clear();
   qDeleteAll(m_edgesMap);
   m_edgesMap.clear();
+  m_elementsIndex.clear();
+  m_edgesIndex.clear();
 }
 
 QString DotGraph::chooseLayoutProgramForFile(const QString& str)
 {
-  QFile iFILE(str);
-
-  if (!iFILE.open(QIODevice::ReadOnly))
+  DotInput input(str);
+  if (!input.open())
   {
     qCWarning(KGRAPHVIEWERLIB_LOG) << "Can't test dot file. Will try to use the dot command on the file: '" << str << "'" << endl;
     return "dot";// -Txdot";
   }
-
-  QByteArray fileContent = iFILE.readAll();
-  if (fileContent.isEmpty()) return "";
-  std::string s =  fileContent.data();
-  std::string cmd = "dot";
-  parse(s.c_str(),
-        (
-          !(keyword_p("strict")) >> (keyword_p("graph")[assign_a(cmd,"neato")])
-        ), (space_p|comment_p("/*", "*/")) );
-
-  return  QString::fromStdString(cmd);// + " -Txdot" ;
+  return DotLayoutChooser::choose(str, input);
 }
 
 bool DotGraph::parseDot(const QString& str)
 {
   qCDebug(KGRAPHVIEWERLIB_LOG) << str;
   m_useLibrary = false;
-  if (m_layoutCommand.isEmpty())
+  m_layoutTime = -1;
+  // a missing file is reported at once; opening the file and waiting for
+  // the header of a stream are done with the rest of the preparation
+  if (str != QLatin1String("-") && !QFileInfo(str).isReadable())
   {
-    m_layoutCommand = chooseLayoutProgramForFile(str);
-    if (m_layoutCommand.isEmpty())
-    {
-      m_layoutCommand = chooseLayoutProgramForFile(str);
-      return false;
-    }
+    qCWarning(KGRAPHVIEWERLIB_LOG) << "Failed to open file" << str;
+    return false;
+  }
+  // opened once, the file being possibly the standard input or a pipe
+  QSharedPointer<DotInput> input(new DotInput(str));
+  stopLayout();
+  // opening a pipe waits for a writer and its header for the producer,
+  // while reading an already laid out file, choosing the layout program
+  // and hashing the content for the layout cache go through the whole
+  // content: they are not done on the GUI thread
+  const QString layoutCommand = m_layoutCommand;
+  // the drawing operations are either xdot strings in DOT attributes or
+  // JSON objects
+  const bool json = (KGraphViewerPartSettings::layoutOutputFormat() == "json");
+  m_preparedInput = input;
+  m_layoutPreparation = new QFutureWatcher<DotLayoutPreparation>(this);
+  connect(m_layoutPreparation, &QFutureWatcherBase::finished, this, &DotGraph::slotLayoutPrepared);
+  m_layoutPreparation->setFuture(QtConcurrent::run([str, input, layoutCommand, json]()
+  {
+    return prepareLayout(str, input, layoutCommand, json);
+  }));
+  return true;
+}
+
+void DotGraph::slotLayoutPrepared()
+{
+  QFutureWatcher<DotLayoutPreparation>* watcher = static_cast<QFutureWatcher<DotLayoutPreparation>*>(sender());
+  watcher->deleteLater();
+  const DotLayoutPreparation preparation = watcher->result();
+  QScopedPointer<DotGraph> laidOut(preparation.laidOut);
+  if (watcher != m_layoutPreparation)
+  {
+    return;
+  }
+  m_layoutPreparation = nullptr;
+  m_preparedInput.clear();
+  if (!preparation.opened)
+  {
+    // the file disappeared or cannot be read since parseDot checked it
+    emit(readyToDisplay());
+    return;
+  }
+  if (preparation.layoutCommand.isEmpty())
+  {
+    qCWarning(KGRAPHVIEWERLIB_LOG) << "no layout program found for" << preparation.fileName;
+    emit(readyToDisplay());
+    return;
+  }
+  m_layoutCommand = preparation.layoutCommand;
+  if (laidOut)
+  {
+    qCDebug(KGRAPHVIEWERLIB_LOG) << "calling updateWithGraph";
+    updateWithGraph(*laidOut);
+    qCDebug(KGRAPHVIEWERLIB_LOG) << "emiting readyToDisplay";
+    emit(readyToDisplay());
+    return;
+  }
+  layOut(preparation.fileName, preparation.input, preparation.cacheKey);
+}
+
+bool DotGraph::layOut(const QString& str, QSharedPointer<DotInput> input, const QByteArray& cacheKey)
+{
+  const bool json = (KGraphViewerPartSettings::layoutOutputFormat() == "json");
+  const bool native = DotNativeLayout::isNative(m_layoutCommand);
+  if (native || DotComponentLayout::isEnabled())
+  {
+    return parseDotInThread(str, input);
   }
 
   qCDebug(KGRAPHVIEWERLIB_LOG) << "Running " << m_layoutCommand  << str;
-  QStringList options;
+  QStringList options = DotLayoutPreset::commandLineOptions();
   /// @TODO handle the non-dot commands that could don't know the -T option
 //  if (m_readWrite && m_phase == Initial)
 //  {
@@ -139,9 +371,17 @@ bool DotGraph::parseDot(const QString& str)
 //  }
 //  else
 //  {
-    options << "-Txdot";
+    options << (json ? "-Tjson" : "-Txdot");
 //   }
-  options << str;
+
+  // the layout programs cannot read a compressed file, and a stream has
+  // already been partly read: the content is written to their standard
+  // input instead
+  if (!input->isCompressed() && !input->isStream())
+  {
+    input.clear();
+    options << str;
+  }
 
   qCDebug(KGRAPHVIEWERLIB_LOG) << "m_dot is " << m_dot  << ". Acquiring mutex";
   QMutexLocker locker(&m_dotProcessMutex);
@@ -152,16 +392,168 @@ bool DotGraph::parseDot(const QString& str)
     m_dot->kill();
     delete m_dot;
   }
+  cancelThreadLayout();
+  closeDotInput();
+  closeLayoutCacheEntry(false);
+  startDotOutputParsing(json);
+  if (!cacheKey.isEmpty())
+  {
+    m_layoutCacheEntry = new QFile(DotLayoutCache::newEntryPath(cacheKey));
+    if (m_layoutCacheEntry->open(QIODevice::WriteOnly))
+    {
+      m_layoutCacheKey = cacheKey;
+    }
+    else
+    {
+      qCWarning(KGRAPHVIEWERLIB_LOG) << "Cannot write the layout cache entry" << m_layoutCacheEntry->fileName();
+      delete m_layoutCacheEntry;
+      m_layoutCacheEntry = nullptr;
+    }
+  }
   m_dot = new QProcess();
+  m_dotInput = input;
+  if (m_dotInput)
+  {
+    connect(m_dot, &QProcess::started, this, &DotGraph::slotDotInputWritten);
+    connect(m_dot, &QProcess::bytesWritten, this, &DotGraph::slotDotInputWritten);
+  }
+  if (m_dotInput && m_dotInput->isStream())
+  {
+    m_dotInputNotifier = new QSocketNotifier(m_dotInput->handle(), QSocketNotifier::Read, this);
+    m_dotInputNotifier->setEnabled(false);
+    connect(m_dotInputNotifier, &QSocketNotifier::activated, this, &DotGraph::slotDotInputWritten);
+  }
+  connect(m_dot, &QProcess::readyReadStandardOutput,
+          this, &DotGraph::slotDotOutputReady);
   connect(m_dot, static_cast<void(QProcess::*)(int,QProcess::ExitStatus)>(&QProcess::finished),
           this, &DotGraph::slotDotRunningDone);
   connect(m_dot, static_cast<void(QProcess::*)(QProcess::ProcessError)>(&QProcess::error),
           this, &DotGraph::slotDotRunningError);
+  m_dotTimer.start();
+  m_dotParsingTime = 0;
   m_dot->start(m_layoutCommand, options);
   qCDebug(KGRAPHVIEWERLIB_LOG) << "process started";
  return true;
 }
 
+void DotGraph::stopLayout()
+{
+  // a layout still running for a previous load is not wanted anymore
+  if (m_preparedInput)
+  {
+    // the preparation may be waiting for a stream: it stops and its result is ignored
+    m_preparedInput->cancel();
+    m_preparedInput.clear();
+    m_layoutPreparation = nullptr;
+  }
+  QMutexLocker locker(&m_dotProcessMutex);
+  if (m_dot)
+  {
+    disconnect(m_dot, nullptr, this, nullptr);
+    m_dot->kill();
+    delete m_dot;
+    m_dot = nullptr;
+  }
+  cancelThreadLayout();
+  closeDotInput();
+  closeLayoutCacheEntry(false);
+  stopDotOutputParsing();
+}
+
+bool DotGraph::parseCachedLayout(const QString& str, const QString& path, bool json)
+{
+  stopLayout();
+  QScopedPointer<DotGraph> graph(readCachedLayout(str, m_layoutCommand, path, json));
+  if (!graph)
+  {
+    return false;
+  }
+  updateWithGraph(*graph);
+  qCDebug(KGRAPHVIEWERLIB_LOG) << "emiting readyToDisplay";
+  emit(readyToDisplay());
+  return true;
+}
+
+bool DotGraph::parseDotInThread(const QString& str, const QSharedPointer<DotInput>& input)
+{
+  stopLayout();
+  qCDebug(KGRAPHVIEWERLIB_LOG) << "Laying out" << str << "with" << m_layoutCommand << "in a thread";
+  // the parts are merged from their xdot output, whatever the output
+  // format chosen, and the packed drawing is not cached
+  const QSharedPointer<DotInput> content = input;
+  const QString layoutCommand = m_layoutCommand;
+  const QSharedPointer<QAtomicInt> cancelled = QSharedPointer<QAtomicInt>::create(0);
+  m_threadLayoutCancelled = cancelled;
+  m_threadLayout = new QFutureWatcher<DotGraph*>(this);
+  connect(m_threadLayout, &QFutureWatcherBase::finished, this, &DotGraph::slotThreadLayoutDone);
+  m_dotTimer.start();
+  m_threadLayout->setFuture(QtConcurrent::run([content, layoutCommand, str, cancelled]() -> DotGraph*
+  {
+    graph_t* graph = content->read();
+    if (graph == nullptr)
+    {
+      return nullptr;
+    }
+    DotGraph* laidOut;
+    if (DotNativeLayout::isNative(layoutCommand))
+    {
+      laidOut = DotNativeLayout::layout(graph, layoutCommand, str, cancelled.data());
+    }
+    else
+    {
+      // copied to the components with the other graph attributes
+      DotLayoutPreset::apply(graph);
+      laidOut = DotComponentLayout::layout(graph, layoutCommand, str,
+          [&layoutCommand, &cancelled](graph_t* part, QByteArray& output)
+          {
+            return DotComponentLayout::runCommand(part, layoutCommand, output, cancelled.data());
+          },
+          cancelled.data());
+    }
+    agclose(graph);
+    return laidOut;
+  }));
+  return true;
+}
+
+void DotGraph::cancelThreadLayout()
+{
+  // its end is ignored once it is not the current one anymore
+  m_layoutPreparation = nullptr;
+  if (m_threadLayout)
+  {
+    m_threadLayoutCancelled->store(1);
+    m_threadLayout = nullptr;
+    m_threadLayoutCancelled.clear();
+  }
+}
+
+void DotGraph::slotThreadLayoutDone()
+{
+  QFutureWatcher<DotGraph*>* watcher = static_cast<QFutureWatcher<DotGraph*>*>(sender());
+  watcher->deleteLater();
+  QScopedPointer<DotGraph> laidOut(watcher->result());
+  if (watcher != m_threadLayout)
+  {
+    return;
+  }
+  m_threadLayout = nullptr;
+  m_threadLayoutCancelled.clear();
+  if (laidOut)
+  {
+    m_layoutTime = m_dotTimer.elapsed();
+    DotLayoutChooser::recordDuration(m_dotFileName, m_layoutCommand, laidOut->elementCount(), m_layoutTime);
+    qCDebug(KGRAPHVIEWERLIB_LOG) << "calling updateWithGraph";
+    updateWithGraph(*laidOut);
+  }
+  else
+  {
+    qCWarning(KGRAPHVIEWERLIB_LOG) << "layout with" << m_layoutCommand << "failed";
+  }
+  qCDebug(KGRAPHVIEWERLIB_LOG) << "emiting readyToDisplay";
+  emit(readyToDisplay());
+}
+
 bool DotGraph::update()
 {
   GraphExporter exporter;
@@ -174,84 +566,206 @@ bool DotGraph::update()
   else
   {
     qCDebug(KGRAPHVIEWERLIB_LOG) << "library";
+    QElapsedTimer timer;
+    timer.start();
     graph_t* graph = exporter.exportToGraphviz(this);
 
-    GVC_t* gvc = gvContext();
+    if (DotNativeLayout::isNative(m_layoutCommand))
+    {
+      QScopedPointer<DotGraph> laidOut(DotNativeLayout::layout(graph, m_layoutCommand, m_dotFileName));
+      agclose(graph);
+      if (!laidOut)
+      {
+        return false;
+      }
+      m_layoutTime = timer.elapsed();
+      updateWithGraph(*laidOut);
+      emit(readyToDisplay());
+      qCDebug(KGRAPHVIEWERLIB_LOG) << "library relayout done in" << m_layoutTime << "ms";
+      return true;
+    }
+
+    DotLayoutPreset::apply(graph);
+    DotContext gvc;
     threadsafe_wrap_gvLayout(gvc, graph, m_layoutCommand.toUtf8().data());
     threadsafe_wrap_gvRender(gvc, graph, "xdot", nullptr);
+    m_layoutTime = timer.elapsed();
 
     updateWithGraph(graph);
     
     gvFreeLayout(gvc, graph);
     agclose(graph);
-    bool result = true; //(gvFreeContext(gvc) == 0);
-    return result;
+    qCDebug(KGRAPHVIEWERLIB_LOG) << "library relayout done in" << timer.elapsed() << "ms";
+    return true;
   }
 }
 
-QByteArray DotGraph::getDotResult(int , QProcess::ExitStatus )
+void DotGraph::startDotOutputParsing(bool json)
 {
-  qCDebug(KGRAPHVIEWERLIB_LOG);
+  stopDotOutputParsing();
+  m_dotOutputGraph = new DotGraph(m_layoutCommand, m_dotFileName);
+  if (json)
+  {
+    m_jsonOutputParser = new DotJsonParser(m_dotOutputGraph);
+    return;
+  }
+  m_dotOutputHelper = new DotGraphParsingHelper;
+  m_dotOutputHelper->graph = m_dotOutputGraph;
+  m_dotOutputHelper->z = 1;
+  m_dotOutputHelper->maxZ = 1;
+  m_dotOutputHelper->uniq = 0;
+  m_dotOutputParser = new DotStreamParser(*m_dotOutputHelper);
+}
+
+void DotGraph::stopDotOutputParsing()
+{
+  delete m_jsonOutputParser;
+  m_jsonOutputParser = nullptr;
+  delete m_dotOutputParser;
+  m_dotOutputParser = nullptr;
+  delete m_dotOutputHelper;
+  m_dotOutputHelper = nullptr;
+  delete m_dotOutputGraph;
+  m_dotOutputGraph = nullptr;
+}
 
+void DotGraph::closeDotInput()
+{
+  delete m_dotInputNotifier;
+  m_dotInputNotifier = nullptr;
+  m_dotInput.clear();
+}
+
+void DotGraph::closeLayoutCacheEntry(bool store)
+{
+  if (m_layoutCacheEntry == nullptr)
+  {
+    return;
+  }
+  const QString path = m_layoutCacheEntry->fileName();
+  const bool written = m_layoutCacheEntry->flush() && m_layoutCacheEntry->error() == QFileDevice::NoError;
+  delete m_layoutCacheEntry;
+  m_layoutCacheEntry = nullptr;
+  if (store && written)
+  {
+    DotLayoutCache::store(m_layoutCacheKey, path);
+  }
+  else
+  {
+    DotLayoutCache::discard(path);
+  }
+  m_layoutCacheKey.clear();
+}
+
+void DotGraph::slotDotInputWritten()
+{
   QMutexLocker locker(&m_dotProcessMutex);
-  if (m_dot == nullptr)
+  if (m_dotInputNotifier)
   {
-    return QByteArray();
+    m_dotInputNotifier->setEnabled(false);
   }
-  QByteArray result = m_dot->readAll();
-  delete m_dot;
-  m_dot = nullptr;
-  return result;
+  // one block at a time, so that the decompressed content is never held
+  if (m_dot == nullptr || m_dotInput.isNull() || m_dot->bytesToWrite() > 0)
+  {
+    return;
+  }
+  if (m_dotInput->isWaitingForData())
+  {
+    // the producer of a stream is not waited for on the GUI thread
+    if (m_dotInputNotifier)
+    {
+      m_dotInputNotifier->setEnabled(true);
+    }
+    return;
+  }
+  QByteArray block(1 << 16, Qt::Uninitialized);
+  const qint64 length = m_dotInput->readBlock(block.data(), block.size());
+  if (length > 0)
+  {
+    m_dot->write(block.constData(), length);
+    return;
+  }
+  if (length < 0)
+  {
+    qCWarning(KGRAPHVIEWERLIB_LOG) << "Failed to decompress" << m_dotInput->fileName() << "for" << m_layoutCommand;
+  }
+  m_dot->closeWriteChannel();
+  closeDotInput();
 }
 
-void DotGraph::slotDotRunningDone(int exitCode, QProcess::ExitStatus exitStatus)
+bool DotGraph::readDotOutput()
 {
-  qCDebug(KGRAPHVIEWERLIB_LOG);
-  
-  QByteArray result = getDotResult(exitCode, exitStatus);
-  result.replace("\\\n","");
+  QElapsedTimer timer;
+  timer.start();
+  QIODevice* device = m_dot;
+  // the output is copied as is in the cache entry before being parsed
+  QByteArray data;
+  QBuffer buffer(&data);
+  if (m_layoutCacheEntry)
+  {
+    data = m_dot->readAll();
+    m_layoutCacheEntry->write(data);
+    buffer.open(QIODevice::ReadOnly);
+    device = &buffer;
+  }
+  const bool result = m_jsonOutputParser ? m_jsonOutputParser->readFrom(device) : m_dotOutputParser->readFrom(device);
+  m_dotParsingTime += timer.elapsed();
+  return result;
+}
 
-  qCDebug(KGRAPHVIEWERLIB_LOG) << "string content is:" << endl << result << endl << "=====================" << result.size();
-  std::string s =  result.data();
-  //   std::cerr << "stdstring content is:" << std::endl << s << std::endl << "===================== " << s.size() << std::endl;
-  if (phelper)
+void DotGraph::slotDotOutputReady()
+{
+  QMutexLocker locker(&m_dotProcessMutex);
+  if (m_dot == nullptr || (m_dotOutputParser == nullptr && m_jsonOutputParser == nullptr))
   {
-    phelper->graph = nullptr;
-    delete phelper;
+    return;
   }
-//   if (parsingResult)
-//   {
-//     if (m_readWrite)
-//     {
-//       storeOriginalAttributes();
-//       update();
-//     }
-//     computeCells();
-//   }
+  // the model is built while the layout program is still writing
+  if (!readDotOutput())
+  {
+    qCWarning(KGRAPHVIEWERLIB_LOG) << "parsing failed, ignoring the rest of the" << m_layoutCommand << "output";
+    disconnect(m_dot, &QProcess::readyReadStandardOutput, this, &DotGraph::slotDotOutputReady);
+  }
+}
 
-  DotGraph newGraph(m_layoutCommand, m_dotFileName);
-  phelper = new DotGraphParsingHelper;
-  phelper->graph = &newGraph;
-  phelper->z = 1;
-  phelper->maxZ = 1;
-  phelper->uniq = 0;
+void DotGraph::slotDotRunningDone(int exitCode, QProcess::ExitStatus exitStatus)
+{
+  qCDebug(KGRAPHVIEWERLIB_LOG) << exitCode << exitStatus;
 
-  qCDebug(KGRAPHVIEWERLIB_LOG) << "parsing new dot";
-  bool parsingResult = parse(s);
-  delete phelper;
-  phelper = nullptr;
-  qCDebug(KGRAPHVIEWERLIB_LOG) << "phelper deleted";
+  bool parsingResult = false;
+  {
+    QMutexLocker locker(&m_dotProcessMutex);
+    if (m_dot == nullptr || (m_dotOutputParser == nullptr && m_jsonOutputParser == nullptr))
+    {
+      return;
+    }
+    parsingResult = readDotOutput()
+        && (m_jsonOutputParser ? m_jsonOutputParser->finish() : m_dotOutputParser->finish());
+    qCDebug(KGRAPHVIEWERLIB_LOG) << (m_jsonOutputParser ? "json" : "xdot") << "output of" << m_layoutCommand
+                                 << "read in" << m_dotParsingTime << "ms, layout done in" << m_dotTimer.elapsed() << "ms";
+    closeLayoutCacheEntry(parsingResult && exitStatus == QProcess::NormalExit && exitCode == 0);
+    if (parsingResult && exitStatus == QProcess::NormalExit && exitCode == 0)
+    {
+      m_layoutTime = m_dotTimer.elapsed();
+      DotLayoutChooser::recordDuration(m_dotFileName, m_layoutCommand,
+                                       m_dotOutputGraph->elementCount(), m_layoutTime);
+    }
+    disconnect(m_dot, nullptr, this, nullptr);
+    m_dot->deleteLater();
+    m_dot = nullptr;
+    closeDotInput();
+  }
 
   if (parsingResult)
   {
     qCDebug(KGRAPHVIEWERLIB_LOG) << "calling updateWithGraph";
-    updateWithGraph(newGraph);
+    updateWithGraph(*m_dotOutputGraph);
   }
   else
   {
     qCWarning(KGRAPHVIEWERLIB_LOG) << "parsing failed";
   }
-//   return parsingResult;
+  stopDotOutputParsing();
 //   if (m_readWrite && m_phase == Initial)
 //   {
 //     m_phase = Final;
@@ -392,29 +906,18 @@ void DotGraph::updateWithGraph(graph_t* newGraph)
 {
   qCDebug(KGRAPHVIEWERLIB_LOG);
 
-  // copy global graph render operations and attributes
-  DotRenderOpVec ops;
-  // decrease mem peak
-  setRenderOperations(ops);
-
-  if (agget(newGraph, (char*)"_draw_"))
-  {
-    parse_renderop(agget(newGraph, (char*)"_draw_"), ops);
-    qCDebug(KGRAPHVIEWERLIB_LOG) << "_draw_: element renderOperations size is now " << ops.size();
-  }
-  if (agget(newGraph, (char*)"_ldraw_"))
-  {
-    parse_renderop(agget(newGraph, (char*)"_ldraw_"), ops);
-    qCDebug(KGRAPHVIEWERLIB_LOG) << "_ldraw_: element renderOperations size is now " << ops.size();
-  }
+  // the xdot attributes of the elements are kept and only decoded when the
+  // elements are first painted
+  DotRenderOpCollector collector;
 
-  setRenderOperations(ops);
+  // copy global graph render operations and attributes
+  collector.add(this, newGraph, {"_draw_", "_ldraw_"});
 
   Agsym_t *attr = agnxtattr(newGraph, AGRAPH, nullptr);
   while(attr)
   {
     qCDebug(KGRAPHVIEWERLIB_LOG) << agnameof(newGraph) << ":" << attr->name << agxget(newGraph,attr);
-    m_attributes[attr->name] = agxget(newGraph,attr);
+    m_attributes[attr->name] = collector.attributeValues().intern(agxget(newGraph,attr));
     attr = agnxtattr(newGraph, AGRAPH, attr);
   }
   
@@ -422,29 +925,31 @@ void DotGraph::updateWithGraph(graph_t* newGraph)
   for (graph_t* sg = agfstsubg(newGraph); sg; sg = agnxtsubg(sg))
   {
     qCDebug(KGRAPHVIEWERLIB_LOG) << "subgraph:" << agnameof(sg);
-    if (subgraphs().contains(agnameof(sg)))
+    GraphSubgraph* gsg = subgraphs().value(agnameof(sg), nullptr);
+    if (gsg)
     {
       qCDebug(KGRAPHVIEWERLIB_LOG) << "known";
       // ???
       //       nodes()[ngn->name]->setZ(ngn->z());
-      subgraphs()[agnameof(sg)]->updateWithSubgraph(sg);
-      if (subgraphs()[agnameof(sg)]->canvasElement())
-      {
-        //         nodes()[ngn->id()]->canvasElement()->setGh(m_height);
-      }
+      gsg->updateWithSubgraph(sg, collector);
+      // nested subgraphs may have been added
+      indexSubgraph(gsg);
     }
     else
     {
       qCDebug(KGRAPHVIEWERLIB_LOG) << "new";
-      GraphSubgraph* newsg = new GraphSubgraph(sg);
+      GraphSubgraph* newsg = new GraphSubgraph(sg, collector);
       //       qCDebug(KGRAPHVIEWERLIB_LOG) << "new created";
-      subgraphs().insert(agnameof(sg), newsg);
+      insertSubgraph(agnameof(sg), newsg);
       //       qCDebug(KGRAPHVIEWERLIB_LOG) << "new inserted";
     }
 
   }
 
   // copy nodes
+  const bool directed = agisdirected(newGraph);
+  // the number of edges without key already seen between two nodes
+  QHash< QPair<node_t*, node_t*>, int > parallelEdges;
   node_t* ngn = agfstnode(newGraph);
   qCDebug(KGRAPHVIEWERLIB_LOG) << "first node:" << (void*)ngn;
   
@@ -452,23 +957,21 @@ void DotGraph::updateWithGraph(graph_t* newGraph)
 //   foreach (GraphNode* ngn, newGraph.nodes())
   {
     qCDebug(KGRAPHVIEWERLIB_LOG) << "node " << agnameof(ngn);
-    if (nodes().contains(agnameof(ngn)))
+    const QString nodeName = QString::fromUtf8(agnameof(ngn));
+    GraphNode* gn = dynamic_cast<GraphNode*>(elementNamed(nodeName));
+    if (gn)
     {
       qCDebug(KGRAPHVIEWERLIB_LOG) << "known";
 // ???
 //       nodes()[ngn->name]->setZ(ngn->z());
-      nodes()[agnameof(ngn)]->updateWithNode(ngn);
-      if (nodes()[agnameof(ngn)]->canvasElement())
-      {
-        //         nodes()[ngn->id()]->canvasElement()->setGh(m_height);
-      }
+      gn->updateWithNode(ngn, collector);
     }
     else
     {
       qCDebug(KGRAPHVIEWERLIB_LOG) << "new";
-      GraphNode* newgn = new GraphNode(ngn);
+      GraphNode* newgn = new GraphNode(ngn, collector);
       //       qCDebug(KGRAPHVIEWERLIB_LOG) << "new created";
-      nodes().insert(agnameof(ngn), newgn);
+      insertNode(nodeName, newgn);
       //       qCDebug(KGRAPHVIEWERLIB_LOG) << "new inserted";
     }
 
@@ -477,16 +980,19 @@ void DotGraph::updateWithGraph(graph_t* newGraph)
     while (nge)
     {
 //      qCDebug(KGRAPHVIEWERLIB_LOG) << "edge " << nge->id;
-      const QString edgeName = QString::fromUtf8(agnameof(aghead(nge))) + QString::fromUtf8(agnameof(agtail(nge)));
-      if (edges().contains(edgeName))
+      // cgraph gives a name to keyed edges only, anonymous ones are local ids
+      const char* edgeKey = agnameof(nge);
+      const QString key = (edgeKey && edgeKey[0] != '%') ? QString::fromUtf8(edgeKey) : QString();
+      const int ordinal = key.isEmpty() ? parallelEdges[qMakePair(agtail(nge), aghead(nge))]++ : 0;
+      const QString edgeName = GraphEdge::edgeId(QString::fromUtf8(agnameof(agtail(nge))),
+                                                 QString::fromUtf8(agnameof(aghead(nge))),
+                                                 directed, key, ordinal);
+      GraphEdge* ge = edgeNamed(edgeName);
+      if (ge)
       {
 //        () << "edge known" << nge->id;
 //         edges()[nge->name]->setZ(nge->z());
-        edges()[edgeName]->updateWithEdge(nge);
-        if (edges()[edgeName]->canvasEdge())
-        {
-          //         edges()[nge->id()]->canvasEdge()->setGh(m_height);
-        }
+        ge->updateWithEdge(nge, collector);
       }
       else
       {
@@ -494,25 +1000,29 @@ void DotGraph::updateWithGraph(graph_t* newGraph)
         {
           GraphEdge* newEdge = new GraphEdge();
           newEdge->setId(edgeName);
-          newEdge->updateWithEdge(nge);
-          if (elementNamed(agnameof(agtail(nge))) == nullptr)
+          newEdge->updateWithEdge(nge, collector);
+          const QString tailName = QString::fromUtf8(agnameof(agtail(nge)));
+          GraphElement* tail = elementNamed(tailName);
+          if (tail == nullptr)
           {
-            GraphNode* newgn = new GraphNode();
+            tail = new GraphNode();
             //       qCDebug(KGRAPHVIEWERLIB_LOG) << "new created";
-            nodes().insert(agnameof(agtail(nge)), newgn);
+            insertNode(tailName, static_cast<GraphNode*>(tail));
           }
-          newEdge->setFromNode(elementNamed(agnameof(agtail(nge))));
-          if (elementNamed(agnameof(aghead(nge))) == nullptr)
+          newEdge->setFromNode(tail);
+          const QString headName = QString::fromUtf8(agnameof(aghead(nge)));
+          GraphElement* head = elementNamed(headName);
+          if (head == nullptr)
           {
-            GraphNode* newgn = new GraphNode();
+            head = new GraphNode();
             //       qCDebug(KGRAPHVIEWERLIB_LOG) << "new created";
-            nodes().insert(agnameof(aghead(nge)), newgn);
+            insertNode(headName, static_cast<GraphNode*>(head));
           }
-          newEdge->setToNode(elementNamed(agnameof(aghead(nge))));
-          edges().insert(edgeName, newEdge);
+          newEdge->setToNode(head);
+          insertEdge(edgeName, newEdge);
         }
       }
-      nge = agnxtedge(newGraph, nge, ngn);
+      nge = agnxtout(newGraph, nge);
     }
     ngn = agnxtnode(newGraph, ngn);
   }
@@ -537,6 +1047,7 @@ void DotGraph::updateWithGraph(const DotGraph& newGraph)
     {
       qCDebug(KGRAPHVIEWERLIB_LOG) << "subgraph known" << nsg->id();
       subgraphs().value(nsg->id())->updateWithSubgraph(*nsg);
+      indexSubgraph(subgraphs().value(nsg->id()));
       if (subgraphs().value(nsg->id())->canvasElement())
       {
 //         subgraphs().value(nsg->id())->canvasElement()->setGh(m_height);
@@ -548,43 +1059,37 @@ void DotGraph::updateWithGraph(const DotGraph& newGraph)
       GraphSubgraph* newSubgraph = new GraphSubgraph();
       newSubgraph->updateWithSubgraph(*nsg);
       newSubgraph->setZ(0);
-      subgraphs().insert(nsg->id(), newSubgraph);
+      insertSubgraph(nsg->id(), newSubgraph);
     }
   }
   foreach (GraphNode* ngn, newGraph.nodes())
   {
     qCDebug(KGRAPHVIEWERLIB_LOG) << "node " << ngn->id();
-    if (nodes().contains(ngn->id()))
+    GraphNode* gn = dynamic_cast<GraphNode*>(elementNamed(ngn->id()));
+    if (gn)
     {
       qCDebug(KGRAPHVIEWERLIB_LOG) << "known";
-      nodes()[ngn->id()]->setZ(ngn->z());
-      nodes()[ngn->id()]->updateWithNode(*ngn);
-      if (nodes()[ngn->id()]->canvasElement())
-      {
-//         nodes()[ngn->id()]->canvasElement()->setGh(m_height);
-      }
+      gn->setZ(ngn->z());
+      gn->updateWithNode(*ngn);
     }
     else
     {
       qCDebug(KGRAPHVIEWERLIB_LOG) << "new";
       GraphNode* newgn = new GraphNode(*ngn);
 //       qCDebug(KGRAPHVIEWERLIB_LOG) << "new created";
-      nodes().insert(ngn->id(), newgn);
+      insertNode(ngn->id(), newgn);
 //       qCDebug(KGRAPHVIEWERLIB_LOG) << "new inserted";
     }
   }
   foreach (GraphEdge* nge, newGraph.edges())
   {
     qCDebug(KGRAPHVIEWERLIB_LOG) << "edge " << nge->id();
-    if (edges().contains(nge->id()))
+    GraphEdge* ge = edgeNamed(nge->id());
+    if (ge)
     {
       qCDebug(KGRAPHVIEWERLIB_LOG) << "edge known" << nge->id();
-      edges()[nge->id()]->setZ(nge->z());
-      edges()[nge->id()]->updateWithEdge(*nge);
-      if (edges()[nge->id()]->canvasEdge())
-      {
-//         edges()[nge->id()]->canvasEdge()->setGh(m_height);
-      }
+      ge->setZ(nge->z());
+      ge->updateWithEdge(*nge);
     }
     else
     {
@@ -595,7 +1100,7 @@ void DotGraph::updateWithGraph(const DotGraph& newGraph)
         newEdge->updateWithEdge(*nge);
         newEdge->setFromNode(elementNamed(nge->fromNode()->id()));
         newEdge->setToNode(elementNamed(nge->toNode()->id()));
-        edges().insert(nge->id(), newEdge);
+        insertEdge(nge->id(), newEdge);
       }
     }
   }
@@ -621,6 +1126,7 @@ void DotGraph::removeNodeNamed(const QString& nodeName)
         || it.value()->toNode() == node )
     {
       GraphEdge* edge = it.value();
+      unindexElement(it.key(), edge);
       if (edge->canvasEdge())
       {
         edge->canvasEdge()->hide();
@@ -642,6 +1148,7 @@ void DotGraph::removeNodeNamed(const QString& nodeName)
     node->setCanvasNode(nullptr);
   }
   nodes().remove(nodeName);
+  unindexElement(nodeName, node);
   delete node;
 
 }
@@ -666,6 +1173,7 @@ void DotGraph::removeNodeFromSubgraph(
   }
   
   subgraph->removeElement(node);
+  unindexElement(nodeName, node);
   if (subgraph->content().isEmpty())
   {
     removeSubgraphNamed(subgraphName);
@@ -690,6 +1198,7 @@ void DotGraph::removeSubgraphNamed(const QString& subgraphName)
         || it.value()->toNode() == subgraph )
     {
       GraphEdge* edge = it.value();
+      unindexElement(it.key(), edge);
       if (edge->canvasEdge())
       {
         edge->canvasEdge()->hide();
@@ -728,6 +1237,7 @@ void DotGraph::removeSubgraphNamed(const QString& subgraphName)
   }
   subgraph->content().clear();
   subgraphs().remove(subgraphName);
+  unindexElement(subgraphName, subgraph);
   delete subgraph;
 }
 
@@ -740,6 +1250,7 @@ void DotGraph::removeEdge(const QString& id)
     GraphEdge* edge = it.value();
     if (edge->id() ==id)
     {
+      unindexElement(id, edge);
       if (edge->canvasEdge())
       {
         edge->canvasEdge()->hide();
@@ -803,21 +1314,66 @@ void DotGraph::setAttribute(const QString& elementId, const QString& attributeNa
   }
 }
 
-GraphElement* DotGraph::elementNamed(const QString& id)
+void DotGraph::insertNode(const QString& id, GraphNode* node)
+{
+  m_nodesMap.insert(id, node);
+  m_elementsIndex.insert(id, node);
+}
+
+void DotGraph::insertEdge(const QString& id, GraphEdge* edge)
+{
+  m_edgesMap.insert(id, edge);
+  m_edgesIndex.insert(id, edge);
+}
+
+void DotGraph::insertSubgraph(const QString& id, GraphSubgraph* subgraph)
 {
-  GraphElement* ret = nullptr;
-  if ((ret = m_nodesMap.value(id, nullptr))) {
-    return ret;
+  m_subgraphsMap.insert(id, subgraph);
+  m_elementsIndex.insert(id, subgraph);
+  indexSubgraph(subgraph);
+}
+
+void DotGraph::insertInSubgraph(GraphSubgraph* subgraph, GraphElement* element)
+{
+  subgraph->content().push_back(element);
+  m_elementsIndex.insert(element->id(), element);
+}
+
+void DotGraph::indexSubgraph(GraphSubgraph* subgraph)
+{
+  foreach (GraphElement* element, subgraph->content())
+  {
+    m_elementsIndex.insert(element->id(), element);
+    GraphSubgraph* nested = dynamic_cast<GraphSubgraph*>(element);
+    if (nested)
+    {
+      indexSubgraph(nested);
+    }
   }
-  if ((ret = m_edgesMap.value(id, nullptr))) {
-    return ret;
+  GraphSubgraphMap::const_iterator it = subgraph->subgraphs().constBegin();
+  for (; it != subgraph->subgraphs().constEnd(); it++)
+  {
+    m_elementsIndex.insert(it.key(), it.value());
+    indexSubgraph(it.value());
   }
-  foreach(GraphSubgraph* subGraph, m_subgraphsMap) {
-    if ((ret = subGraph->elementNamed(id))) {
-      return ret;
-    }
+}
+
+void DotGraph::unindexElement(const QString& id, GraphElement* element)
+{
+  QHash<QString, GraphElement*>::iterator it = m_elementsIndex.find(id);
+  if (it != m_elementsIndex.end() && it.value() == element)
+  {
+    m_elementsIndex.erase(it);
+  }
+}
+
+void DotGraph::unindexElement(const QString& id, GraphEdge* edge)
+{
+  QHash<QString, GraphEdge*>::iterator it = m_edgesIndex.find(id);
+  if (it != m_edgesIndex.end() && it.value() == edge)
+  {
+    m_edgesIndex.erase(it);
   }
-  return nullptr;
 }
 
 void DotGraph::setGraphAttributes(QMap<QString,QString> attribs)
@@ -832,7 +1388,7 @@ void DotGraph::addNewNode(QMap<QString,QString> attribs)
   qCDebug(KGRAPHVIEWERLIB_LOG) << attribs;
   GraphNode* newNode = new GraphNode();
   newNode->attributes() = attribs;
-  nodes().insert(newNode->id(), newNode);
+  insertNode(newNode->id(), newNode);
   qCDebug(KGRAPHVIEWERLIB_LOG) << "node added as" << newNode->id();
 }
 
@@ -841,7 +1397,7 @@ void DotGraph::addNewSubgraph(QMap<QString,QString> attribs)
   qCDebug(KGRAPHVIEWERLIB_LOG) << attribs;
   GraphSubgraph* newSG = new GraphSubgraph();
   newSG->attributes() = attribs;
-  subgraphs()[newSG->id()] = newSG;
+  insertSubgraph(newSG->id(), newSG);
   qCDebug(KGRAPHVIEWERLIB_LOG) << "subgraph added as" << newSG->id();
 }
 
@@ -850,7 +1406,7 @@ void DotGraph::addNewNodeToSubgraph(QMap<QString,QString> attribs, QString subgr
   qCDebug(KGRAPHVIEWERLIB_LOG) << attribs << "to" << subgraph;
   GraphNode* newNode = new GraphNode();
   newNode->attributes() = attribs;
-  subgraphs()[subgraph]->content().push_back(newNode);
+  insertInSubgraph(subgraphs()[subgraph], newNode);
 
   qCDebug(KGRAPHVIEWERLIB_LOG) << "node added as" << newNode->id() << "in" << subgraph;
 }
@@ -962,16 +1518,26 @@ void DotGraph::addNewEdge(QString src, QString tgt, QMap<QString,QString> attrib
   }
   else
   {
-    newEdge->setId(src+tgt+QUuid::createUuid().toString().remove('{').remove('}').remove('-'));
+    const QString key = attribs.value("key");
+    QString id = GraphEdge::edgeId(srcElement->id(), tgtElement->id(), directed(), key, 0);
+    for (int ordinal = 1; key.isEmpty() && edgeNamed(id) != nullptr; ordinal++)
+    {
+      id = GraphEdge::edgeId(srcElement->id(), tgtElement->id(), directed(), key, ordinal);
+    }
+    newEdge->setId(id);
   }
   newEdge->setFromNode(srcElement);
   newEdge->setToNode(tgtElement);
-  edges().insert(newEdge->id(), newEdge);
+  insertEdge(newEdge->id(), newEdge);
 }
 
 void DotGraph::removeAttribute(const QString& nodeName, const QString& attribName)
 {
   GraphElement* element = elementNamed(nodeName);
+  if (element == nullptr)
+  {
+    element = edgeNamed(nodeName);
+  }
   if (element)
   {
     element->removeAttribute(attribName);
@@ -983,16 +1549,61 @@ void DotGraph::renameNode(const QString& oldNodeName, const QString& newNodeName
   if (oldNodeName != newNodeName)
   {
     qCDebug(KGRAPHVIEWERLIB_LOG) << "Renaming " << oldNodeName << " into " << newNodeName;
-    GraphNode* node = nodes()[oldNodeName];
-    nodes().remove(oldNodeName);
+    GraphNode* node = dynamic_cast<GraphNode*>(elementNamed(oldNodeName));
+    if (node == nullptr)
+    {
+      qCWarning(KGRAPHVIEWERLIB_LOG) << "No such node " << oldNodeName;
+      return;
+    }
+    unindexElement(oldNodeName, node);
     node->setId(newNodeName);
-    nodes()[newNodeName] = node;
+    if (nodes().remove(oldNodeName) > 0)
+    {
+      insertNode(newNodeName, node);
+    }
+    else
+    {
+      // in a subgraph
+      m_elementsIndex.insert(newNodeName, node);
+    }
+
+    // the ids of its edges are derived from its name, followed by their
+    // key or ordinal: they are renamed too, unless set explicitly
+    QList<GraphEdge*> renamed;
+    GraphEdgeMap::iterator it = m_edgesMap.begin();
+    while (it != m_edgesMap.end())
+    {
+      GraphEdge* edge = it.value();
+      if (edge->fromNode() != node && edge->toNode() != node)
+      {
+        ++it;
+        continue;
+      }
+      const QString oldTail = edge->fromNode() == node ? oldNodeName : edge->fromNode()->id();
+      const QString oldHead = edge->toNode() == node ? oldNodeName : edge->toNode()->id();
+      const QString oldPrefix = GraphEdge::edgeId(oldTail, oldHead, directed(), QString(), 0);
+      const QString suffix = it.key().mid(oldPrefix.size());
+      if (!it.key().startsWith(oldPrefix)
+          || !(suffix.isEmpty() || suffix.startsWith(QLatin1Char(':')) || suffix.startsWith(QLatin1Char('#'))))
+      {
+        ++it;
+        continue;
+      }
+      unindexElement(it.key(), edge);
+      edge->setId(GraphEdge::edgeId(edge->fromNode()->id(), edge->toNode()->id(), directed(), QString(), 0) + suffix);
+      renamed.append(edge);
+      it = m_edgesMap.erase(it);
+    }
+    foreach (GraphEdge* edge, renamed)
+    {
+      insertEdge(edge->id(), edge);
+    }
   }
 }
 
 QString DotGraph::backColor() const
 {
-  if (m_attributes.find("bgcolor") != m_attributes.end())
+  if (m_attributes.contains("bgcolor"))
   {
     return m_attributes["bgcolor"];
   }
@@ -23,11 +23,14 @@
 #ifndef DOT_GRAPH_H
 #define DOT_GRAPH_H
 
+#include <QElapsedTimer>
+#include <QHash>
 #include <QList>
 #include <QSet>
 #include <QString>
 #include <QProcess>
 #include <QMutex>
+#include <QSharedPointer>
 
 #include <graphviz/gvc.h>
 
@@ -38,9 +41,19 @@
 #include "graphedge.h"
 #include "dotdefaults.h"
 
+class QFile;
+class QSocketNotifier;
+template <typename T> class QFutureWatcher;
+
 namespace KGraphViewer
 {
-  
+
+struct DotGraphParsingHelper;
+class DotStreamParser;
+class DotJsonParser;
+class DotInput;
+struct DotLayoutPreparation;
+
 /**
   * A class representing the model of a Graphviz DOT graph
   */
@@ -55,8 +68,19 @@ public:
 
   ~DotGraph() override;
 
+  /**
+   * The layout program for the graph in the file str, chosen by
+   * DotLayoutChooser from its size and from how long its previous layouts
+   * took.
+   */
   QString chooseLayoutProgramForFile(const QString& str);
   bool parseDot(const QString& str);
+  /**
+   * Loads the layout of str found in the layout cache, in path, instead of
+   * running the layout program
+   * @param json true if the layout is in the -Tjson format
+   */
+  bool parseCachedLayout(const QString& str, const QString& path, bool json);
   
   /** Constant accessor to the nodes of this graph */
   inline const GraphNodeMap& nodes() const {return m_nodesMap;}
@@ -90,6 +114,13 @@ public:
   
   inline void layoutCommand(const QString& command) {m_layoutCommand = command;}
   inline const QString& layoutCommand() {return m_layoutCommand;}
+
+  /**
+   * How long the layout program took to lay the graph out, in ms, -1 if
+   * the layout was read from the cache or from an already laid out file
+   */
+  inline void layoutTime(qint64 milliseconds) {m_layoutTime = milliseconds;}
+  inline qint64 layoutTime() const {return m_layoutTime;}
   
   inline void dotFileName(const QString& fileName) {m_dotFileName = fileName;}
   inline const QString& dotFileName() const {return m_dotFileName;}
@@ -108,7 +139,34 @@ public:
 
   void KGRAPHVIEWER_EXPORT setAttribute(const QString& elementId, const QString& attributeName, const QString& attributeValue);
 
-  GraphElement* elementNamed(const QString& id);
+  /**
+   * The node or subgraph registered under id, at any subgraph nesting
+   * level, found in constant time.
+   * @return nullptr if there is none
+   */
+  inline GraphElement* elementNamed(const QString& id) const {return m_elementsIndex.value(id, nullptr);}
+  /**
+   * The edge registered under id, found in constant time. The edges have
+   * their own namespace: a node may be named like an edge id.
+   * @return nullptr if there is none
+   */
+  inline GraphEdge* edgeNamed(const QString& id) const {return m_edgesIndex.value(id, nullptr);}
+  /** The number of nodes, edges and subgraphs, at any subgraph nesting level */
+  inline int elementCount() const {return m_elementsIndex.size() + m_edgesIndex.size();}
+
+  /**
+   * @name Insertion of elements in the model
+   * The elements must be added through these methods to be found by
+   * elementNamed and edgeNamed. The maps accessors can still be used to modify the
+   * existing elements.
+   */
+  //@{
+  void insertNode(const QString& id, GraphNode* node);
+  void insertEdge(const QString& id, GraphEdge* edge);
+  /** Inserts subgraph with its content and nested subgraphs */
+  void insertSubgraph(const QString& id, GraphSubgraph* subgraph);
+  void insertInSubgraph(GraphSubgraph* subgraph, GraphElement* element);
+  //@}
 
   inline void setUseLibrary(bool value) {m_useLibrary = value;}
   inline bool useLibrary() {return m_useLibrary;}
@@ -133,23 +191,60 @@ Q_SIGNALS:
   void readyToDisplay();
 
 private Q_SLOTS:
+  void slotDotOutputReady();
   void slotDotRunningDone(int,QProcess::ExitStatus);
   void slotDotRunningError(QProcess::ProcessError);
+  /** Writes the next block of a compressed or stream input to the layout process */
+  void slotDotInputWritten();
+  void slotLayoutPrepared();
+  void slotThreadLayoutDone();
   
 private:
   unsigned int cellNumber(int x, int y);
   void computeCells();
-  QByteArray getDotResult(int exitCode, QProcess::ExitStatus exitStatus);
+  /** @param json true to read the -Tjson output instead of the xdot one */
+  void startDotOutputParsing(bool json);
+  void stopDotOutputParsing();
+  void closeDotInput();
+  /** Reads the output of the layout process available */
+  bool readDotOutput();
+  /** Stops the layout process or thread still running for a previous load */
+  void stopLayout();
+  /**
+   * Lays out the graph read from input with m_layoutCommand, once its
+   * layout has been prepared
+   * @param cacheKey the key of the layout in the layout cache, empty if it is not to be cached
+   */
+  bool layOut(const QString& str, QSharedPointer<DotInput> input, const QByteArray& cacheKey);
+  /** Stores the layout output written to the cache entry, or discards it */
+  void closeLayoutCacheEntry(bool store);
+  /**
+   * Lays out the graph read from input in a thread, either with a built-in
+   * engine or component by component, running several layout processes at
+   * the same time.
+   */
+  bool parseDotInThread(const QString& str, const QSharedPointer<DotInput>& input);
+  /** Drops the layout running or being prepared in a thread, if any */
+  void cancelThreadLayout();
+  void indexSubgraph(GraphSubgraph* subgraph);
+  /** Removes id from the index if it designates element */
+  void unindexElement(const QString& id, GraphElement* element);
+  void unindexElement(const QString& id, GraphEdge* edge);
     
   QString m_dotFileName;
   GraphSubgraphMap m_subgraphsMap;
   GraphNodeMap m_nodesMap;
   GraphEdgeMap m_edgesMap;
+  /** All the nodes and subgraphs of the model, nested ones included, by id */
+  QHash<QString, GraphElement*> m_elementsIndex;
+  /** All the edges of the model, by id */
+  QHash<QString, GraphEdge*> m_edgesIndex;
   double m_width, m_height;
   double m_scale;
   bool m_directed;
   bool m_strict;
   QString m_layoutCommand;
+  qint64 m_layoutTime;
   
   unsigned int m_horizCellFactor, m_vertCellFactor;
   QVector< QSet< GraphNode* > > m_cells;
@@ -158,11 +253,35 @@ private:
 
   bool m_readWrite;
   QProcess* m_dot;
+  /** A compressed or stream input, written to the standard input of m_dot */
+  QSharedPointer<DotInput> m_dotInput;
+  /** Signals new data on a stream m_dotInput */
+  QSocketNotifier* m_dotInputNotifier;
+  /** Where the output of m_dot is copied, to be stored in the layout cache */
+  QFile* m_layoutCacheEntry;
+  QByteArray m_layoutCacheKey;
+
+  /** The graph built while the output of the layout process is read */
+  DotGraph* m_dotOutputGraph;
+  DotGraphParsingHelper* m_dotOutputHelper;
+  DotStreamParser* m_dotOutputParser;
+  DotJsonParser* m_jsonOutputParser;
+  /** Measure the layout process run and the time spent reading its output */
+  QElapsedTimer m_dotTimer;
+  qint64 m_dotParsingTime;
 
   ParsePhase m_phase;
 
   QMutex m_dotProcessMutex;
 
+  /** The examination of the file before its layout, run by parseDot in a thread */
+  QFutureWatcher<DotLayoutPreparation>* m_layoutPreparation;
+  /** The input opened by m_layoutPreparation, cancelled if it is not wanted anymore */
+  QSharedPointer<DotInput> m_preparedInput;
+  /** The layout running in a thread, if any */
+  QFutureWatcher<DotGraph*>* m_threadLayout;
+  QSharedPointer<QAtomicInt> m_threadLayoutCancelled;
+
   bool m_useLibrary;
 };
 
@@ -46,7 +46,13 @@
 #include "simpleprintingcommand.h"
 #include "graphexporter.h"
 #include "loadagraphthread.h"
+#include "dotinput.h"
 #include "layoutagraphthread.h"
+#include "dotlayoutcache.h"
+#include "dotcontextpool.h"
+#include "dotnativelayout.h"
+#include "dotlayoutchooser.h"
+#include "dotlayoutpreset.h"
 
 #include <stdlib.h>
 #include <math.h>
@@ -62,6 +68,7 @@
 #include <QPixmap>
 #include <QBitmap>
 #include <QResizeEvent>
+#include <QPaintEvent>
 #include <QFocusEvent>
 #include <QMouseEvent>
 #include <QWheelEvent>
@@ -73,6 +80,8 @@
 #include <QSvgGenerator>
 #include <QApplication>
 #include <QInputDialog>
+#include <QScopedPointer>
+#include <QElapsedTimer>
 #include <QDebug>
 #include <kmessagebox.h>
 #include <kselectaction.h>
@@ -142,6 +151,19 @@ public:
   KActionCollection* actionCollection() {return m_actions;}
   double detailAdjustedScale();
   int displaySubgraph(GraphSubgraph* gsubgraph, int zValue, CanvasElement* parent = nullptr);
+  /**
+   * Replaces the graph by a new one for dotFileName on a new canvas
+   * @return the loading label shown on the canvas
+   */
+  QGraphicsSimpleTextItem* newGraph(const QString& dotFileName, const QString& layoutCommand);
+  /**
+   * Loads the layout of dotFileName by the library if it is in the layout
+   * cache, instead of running the layout again.
+   * @return false if there is no such layout
+   */
+  bool loadCachedLibraryLayout(const QString& dotFileName, const QString& layoutCommand, const QByteArray& contentHash);
+  /** Checks the layout action of layoutCommand, the built-in engines being shown by name */
+  void setCurrentLayoutAction(const QString& layoutCommand);
 
 
   QSet<QGraphicsSimpleTextItem*> m_labelViews;
@@ -149,6 +171,11 @@ public:
   QMenu* m_popup;
   KSelectAction* m_bevPopup;
   KSelectAction* m_layoutAlgoSelectAction;
+  KSelectAction* m_layoutPresetSelectAction;
+  QAction* m_forceLayoutAction;
+  QAction* m_layeredLayoutAction;
+  /** The layout command chosen by the user, empty for it to be chosen for each graph */
+  QString m_layoutCommand;
   int m_xMargin, m_yMargin;
   PannerView *m_birdEyeView;
   double m_cvZoom;
@@ -400,6 +427,88 @@ int DotGraphViewPrivate::displaySubgraph(GraphSubgraph* gsubgraph, int zValue, C
   return newZvalue;
 }
 
+QGraphicsSimpleTextItem* DotGraphViewPrivate::newGraph(const QString& dotFileName, const QString& layoutCommand)
+{
+  Q_Q(DotGraphView);
+  m_birdEyeView->setScene(nullptr);
+
+  if (m_canvas)
+  {
+    m_canvas->deleteLater();
+    m_canvas = nullptr;
+  }
+
+  delete m_graph;
+
+  m_graph = new DotGraph(layoutCommand,dotFileName);
+  QObject::connect(m_graph, &DotGraph::readyToDisplay,
+                   q, &DotGraphView::displayGraph);
+
+  if (m_readWrite)
+  {
+    m_graph->setReadWrite();
+  }
+
+  m_xMargin = 50;
+  m_yMargin = 50;
+
+  QGraphicsScene* newCanvas = new QGraphicsScene();
+  qCDebug(KGRAPHVIEWERLIB_LOG) << "Created canvas " << newCanvas;
+
+  m_birdEyeView->setScene(newCanvas);
+  q->setScene(newCanvas);
+  QObject::connect(newCanvas, &QGraphicsScene::selectionChanged,
+                   q, &DotGraphView::slotSelectionChanged);
+  m_canvas = newCanvas;
+
+  QGraphicsSimpleTextItem* loadingLabel = newCanvas->addSimpleText(i18n("graph %1 is getting loaded...", dotFileName));
+  loadingLabel->setZValue(100);
+  q->centerOn(loadingLabel);
+
+  m_cvZoom = 0;
+  return loadingLabel;
+}
+
+bool DotGraphViewPrivate::loadCachedLibraryLayout(const QString& dotFileName, const QString& layoutCommand, const QByteArray& contentHash)
+{
+  if (!DotLayoutCache::isEnabled() || contentHash.isEmpty())
+  {
+    return false;
+  }
+  // the library stores the laid out graph as an xdot file
+  const QString path = DotLayoutCache::find(DotLayoutCache::key(contentHash, layoutCommand, QStringLiteral("xdot")));
+  if (path.isEmpty())
+  {
+    return false;
+  }
+  m_layoutThread.cancel();
+  newGraph(dotFileName, layoutCommand);
+  m_graph->setUseLibrary(true);
+  if (!m_graph->parseCachedLayout(dotFileName, path, false))
+  {
+    qCWarning(KGRAPHVIEWERLIB_LOG) << "Invalid cached layout" << path;
+    DotLayoutCache::discard(path);
+    return false;
+  }
+  setCurrentLayoutAction(layoutCommand);
+  return true;
+}
+
+void DotGraphViewPrivate::setCurrentLayoutAction(const QString& layoutCommand)
+{
+  if (layoutCommand == DotNativeLayout::forceDirectedCommand())
+  {
+    m_layoutAlgoSelectAction->setCurrentAction(m_forceLayoutAction);
+    return;
+  }
+  if (layoutCommand == DotNativeLayout::layeredCommand())
+  {
+    m_layoutAlgoSelectAction->setCurrentAction(m_layeredLayoutAction);
+    return;
+  }
+  m_layoutAlgoSelectAction->setCurrentAction(layoutCommand, Qt::CaseInsensitive);
+}
+
 void DotGraphViewPrivate::setupPopup()
 {
   Q_Q(DotGraphView);
@@ -418,6 +527,12 @@ void DotGraphViewPrivate::setupPopup()
   actionCollection()->addAction("layout_dot",lda);
   lda->setCheckable(true);
   
+  m_layeredLayoutAction = new QAction(i18n("Layered (Built-in)"), q);
+  m_layeredLayoutAction->setWhatsThis(i18n("Layout the graph in ranks, like dot, using the layered engine of KGraphViewer, "
+                                           "much faster than dot on large directed graphs at some cost in quality."));
+  actionCollection()->addAction("layout_kgraphviewer_layered",m_layeredLayoutAction);
+  m_layeredLayoutAction->setCheckable(true);
+  
   QAction* lna = new QAction(i18n("Neato"), q);
   lna->setWhatsThis(i18n("Layout the graph using the neato program."));
   actionCollection()->addAction("layout_neato",lna);
@@ -438,11 +553,19 @@ void DotGraphViewPrivate::setupPopup()
   actionCollection()->addAction("layout_c",lca);
   lca->setCheckable(true);
   
+  m_forceLayoutAction = new QAction(i18n("Force Directed (Built-in)"), q);
+  m_forceLayoutAction->setWhatsThis(i18n("Layout the graph using the multilevel force directed engine of KGraphViewer, "
+                                         "faster than the Graphviz programs on very large graphs."));
+  actionCollection()->addAction("layout_kgraphviewer_force",m_forceLayoutAction);
+  m_forceLayoutAction->setCheckable(true);
+  
   m_layoutAlgoSelectAction->addAction(lda);
+  m_layoutAlgoSelectAction->addAction(m_layeredLayoutAction);
   m_layoutAlgoSelectAction->addAction(lna);
   m_layoutAlgoSelectAction->addAction(lta);
   m_layoutAlgoSelectAction->addAction(lfa);
   m_layoutAlgoSelectAction->addAction(lca);
+  m_layoutAlgoSelectAction->addAction(m_forceLayoutAction);
   
   m_layoutAlgoSelectAction->setCurrentAction(lda);
   m_layoutAlgoSelectAction->setEditable(true);
@@ -461,7 +584,22 @@ void DotGraphViewPrivate::setupPopup()
   QAction* slc = layoutPopup->addAction(i18n("Specify layout command"), q, SLOT(slotLayoutSpecify()));
   slc->setWhatsThis(i18n("Specify yourself the layout command to use. Given a dot file, it should produce an xdot file on its standard output."));
   QAction* rlc = layoutPopup->addAction(i18n("Reset layout command to default"), q, SLOT(slotLayoutReset()));
-  rlc->setWhatsThis(i18n("Resets the layout command to use to the default depending on the graph type (directed or not)."));
+  rlc->setWhatsThis(i18n("Resets the layout command to use to the default, chosen for each graph depending on its type (directed or not), its size and the time its previous layouts took."));
+  
+  m_layoutPresetSelectAction = new KSelectAction(i18n("Layout Preset"), q);
+  actionCollection()->addAction("view_layout_preset",m_layoutPresetSelectAction);
+  // in the order of the choices of the settings
+  m_layoutPresetSelectAction->setItems(QStringList() << i18n("Fast") << i18n("Balanced") << i18n("Quality"));
+  m_layoutPresetSelectAction->setCurrentItem(KGraphViewerPartSettings::layoutPreset());
+  m_layoutPresetSelectAction->setToolTip(i18n("Choose how the Graphviz programs trade the quality of the layout for its speed."));
+  m_layoutPresetSelectAction->setWhatsThis(i18n(
+    "Choose how the Graphviz programs trade the quality of the layout for its speed. "
+    "Fast limits their passes and iterations and draws straight edges, Balanced keeps the "
+    "Graphviz defaults and Quality spends more passes on the edge crossings. The attributes "
+    "set by the graph itself are kept. The time the layout took is shown in the status bar."));
+  QObject::connect(m_layoutPresetSelectAction, static_cast<void(KSelectAction::*)(int)>(&KSelectAction::triggered),
+          q, &DotGraphView::slotSelectLayoutPreset);
+  layoutPopup->addAction(m_layoutPresetSelectAction);
   
   m_popup->addAction(QIcon::fromTheme("zoom-in"), i18n("Zoom In"), q, SLOT(zoomIn()));
   m_popup->addAction(QIcon::fromTheme("zoom-out"), i18n("Zoom Out"), q, SLOT(zoomOut()));
@@ -682,6 +820,9 @@ DotGraphView::DotGraphView(KActionCollection* actions, QWidget* parent) :
   setDragMode(NoDrag);
   setRenderHint(QPainter::Antialiasing);
 
+  // the library mode layouts run in process when editing
+  DotContextPool::warmUp();
+
   connect(&d->m_loadThread, &LoadAGraphThread::finished,
           this, &DotGraphView::slotAGraphReadFinished);
   connect(&d->m_layoutThread, &LoadAGraphThread::finished,
@@ -778,11 +919,13 @@ bool DotGraphView::slotLoadLibrary(graph_t* graph)
     d->m_canvas = nullptr;
   }
 
-  QString layoutCommand = (d->m_graph ? d->m_graph->layoutCommand() : QString());
+  QString layoutCommand = d->m_layoutCommand;
   delete d->m_graph;
 
   if (layoutCommand.isEmpty())
-  layoutCommand = "dot";
+  {
+    layoutCommand = DotLayoutChooser::choose(QString(), graph);
+  }
 
   qCDebug(KGRAPHVIEWERLIB_LOG) << "layoutCommand:" << layoutCommand;
   d->m_graph = new DotGraph(layoutCommand,"");
@@ -802,16 +945,8 @@ bool DotGraphView::slotLoadLibrary(graph_t* graph)
     d->m_graph->setReadWrite();
   }
 
-  if (layoutCommand.isEmpty())
-  {
-    layoutCommand = d->m_graph->chooseLayoutProgramForFile(d->m_graph->dotFileName());
-  }
   d->m_graph->layoutCommand(layoutCommand);
 
-  GVC_t* gvc = gvContext();
-  threadsafe_wrap_gvLayout(gvc, graph, layoutCommand.toUtf8().data());
-  threadsafe_wrap_gvRender(gvc, graph, "xdot", nullptr);
-
   d->m_xMargin = 50;
   d->m_yMargin = 50;
 
@@ -828,63 +963,48 @@ bool DotGraphView::slotLoadLibrary(graph_t* graph)
 
   d->m_cvZoom = 0;
 
-  d->m_graph->updateWithGraph(graph);
-  d->m_layoutAlgoSelectAction->setCurrentAction(d->m_graph->layoutCommand(), Qt::CaseInsensitive);
-
-  gvFreeLayout(gvc, graph);
-  gvFreeContext(gvc);
-  return true;
+  // the built-in engines build the model themselves, without a Graphviz context
+  const bool native = DotNativeLayout::isNative(layoutCommand);
+  QScopedPointer<DotGraph> laidOut;
+  QElapsedTimer timer;
+  timer.start();
+  if (native)
+  {
+    laidOut.reset(DotNativeLayout::layout(graph, layoutCommand, d->m_graph->dotFileName()));
+    d->m_graph->layoutTime(timer.elapsed());
+    if (laidOut)
+    {
+      d->m_graph->updateWithGraph(*laidOut);
+      displayGraph();
+    }
+  }
+  else
+  {
+    DotContext gvc;
+    // graph belongs to the caller: the preset is only set for the layout
+    const DotLayoutPreset::Attributes applied = DotLayoutPreset::apply(graph);
+    threadsafe_wrap_gvLayout(gvc, graph, layoutCommand.toUtf8().data());
+    threadsafe_wrap_gvRender(gvc, graph, "xdot", nullptr);
+    DotLayoutPreset::unapply(graph, applied);
+    d->m_graph->layoutTime(timer.elapsed());
+    d->m_graph->updateWithGraph(graph);
+    gvFreeLayout(gvc, graph);
+  }
+  d->setCurrentLayoutAction(d->m_graph->layoutCommand());
+  return !native || !laidOut.isNull();
 }
 
 bool DotGraphView::loadDot(const QString& dotFileName)
 {
   qCDebug(KGRAPHVIEWERLIB_LOG) << "'" << dotFileName << "'";
   Q_D(DotGraphView);
-  d->m_birdEyeView->setScene(nullptr);
-
-  if (d->m_canvas)
-  {
-    d->m_canvas->deleteLater();
-    d->m_canvas = nullptr;
-  }
-
-  QString layoutCommand = (d->m_graph ? d->m_graph->layoutCommand() : QString());
-  delete d->m_graph;
-
-  d->m_graph = new DotGraph(layoutCommand,dotFileName);
-  connect(d->m_graph, &DotGraph::readyToDisplay,
-          this, &DotGraphView::displayGraph);
+  // a library mode load in progress is not wanted anymore
+  d->m_loadThread.cancel();
+  d->m_layoutThread.cancel();
 
-  if (d->m_readWrite)
-  {
-    d->m_graph->setReadWrite();
-  }
-  if (layoutCommand.isEmpty())
-  {
-    layoutCommand = d->m_graph->chooseLayoutProgramForFile(d->m_graph->dotFileName());
-  }
-  d->m_graph->layoutCommand(layoutCommand);
-
-//   qCDebug(KGRAPHVIEWERLIB_LOG) << "Parsing " << m_graph->dotFileName() << " with " << m_graph->layoutCommand();
-  d->m_xMargin = 50;
-  d->m_yMargin = 50;
-
-  QGraphicsScene* newCanvas = new QGraphicsScene();
-  qCDebug(KGRAPHVIEWERLIB_LOG) << "Created canvas " << newCanvas;
-
-  d->m_birdEyeView->setScene(newCanvas);
-//   std::cerr << "After m_birdEyeView set canvas" << std::endl;
-
-  setScene(newCanvas);
-  connect(newCanvas, &QGraphicsScene::selectionChanged,
-          this, &DotGraphView::slotSelectionChanged);
-  d->m_canvas = newCanvas;
-
-  QGraphicsSimpleTextItem* loadingLabel = newCanvas->addSimpleText(i18n("graph %1 is getting loaded...", dotFileName));
-  loadingLabel->setZValue(100);
-  centerOn(loadingLabel);
-
-  d->m_cvZoom = 0;
+  // an empty command is chosen by parseDot() from the content of the file,
+  // which is opened only once as it can be a pipe
+  QGraphicsSimpleTextItem* loadingLabel = d->newGraph(dotFileName, d->m_layoutCommand);
 
   if (!d->m_graph->parseDot(d->m_graph->dotFileName()))
   {
@@ -892,7 +1012,6 @@ bool DotGraphView::loadDot(const QString& dotFileName)
     loadingLabel->setText(i18n("error parsing file %1", dotFileName));
     return false;
   }
-  d->m_layoutAlgoSelectAction->setCurrentAction(d->m_graph->layoutCommand(), Qt::CaseInsensitive);
   return true;
 }
 
@@ -906,39 +1025,32 @@ bool DotGraphView::loadLibrarySync(const QString& dotFileName)
   loadingLabel->setZValue(100);
   centerOn(loadingLabel);
 
-  // HACK: store filename in m_loadThread data structure for pick up by slotAGraphLayoutFinished()
-  // Both methods loadLibrarySync(QString) and loadLibrary(QString) after loading the file
-  // activate the m_layoutThread. And it is only the handler of that thread's finished signal.
-  // slotAGraphLayoutFinished(), which then completes the loading of the file and stores the
-  // filename with the graph data, taking it from m_loadThread.
-  // As intermediate solution to a rewrite of the loading code, for now the filename is simply
-  // also stored in the m_loadThread object from this code path, so the rest of the existing code
-  // does not need to be further adapted.
-  d->m_loadThread.setDotFileName(dotFileName);
+  d->m_loadThread.cancel();
 
   qCDebug(KGRAPHVIEWERLIB_LOG) << dotFileName;
-  FILE* fp = fopen(dotFileName.toUtf8().data(), "r");
-  if (!fp) {
-      qCWarning(KGRAPHVIEWERLIB_LOG) << "Failed to open file " << dotFileName;
+  DotInput input(dotFileName);
+  if (!input.open()) {
       return false;
   }
-  graph_t* graph = agread(fp, nullptr);
+  graph_t* graph = input.read();
   if (!graph) {
-      qCWarning(KGRAPHVIEWERLIB_LOG) << "Failed to read file, retrying to work around graphviz bug(?)";
-      rewind(fp);
-     graph = agread(fp, nullptr);
-  }
-  fclose(fp);
-  if (!graph) {
-      qCWarning(KGRAPHVIEWERLIB_LOG) << "Failed to read file " << dotFileName;
       return false;
   }
 
-  QString layoutCommand = (d->m_graph ? d->m_graph->layoutCommand() : QString());
+  QString layoutCommand = d->m_layoutCommand;
   if (layoutCommand.isEmpty()) {
-      layoutCommand = d->m_graph ? d->m_graph->chooseLayoutProgramForFile(dotFileName) : "dot";
+      layoutCommand = DotLayoutChooser::choose(dotFileName, graph);
+  }
+  const QByteArray contentHash = input.hash();
+  if (d->loadCachedLibraryLayout(dotFileName, layoutCommand, contentHash)) {
+      agclose(graph);
+      return true;
   }
-  d->m_layoutThread.layoutGraph(graph, layoutCommand);
+  QByteArray cacheKey;
+  if (DotLayoutCache::isEnabled() && !contentHash.isEmpty()) {
+      cacheKey = DotLayoutCache::key(contentHash, layoutCommand, QStringLiteral("xdot"));
+  }
+  d->m_layoutThread.layoutGraph(graph, dotFileName, layoutCommand, cacheKey);
 
   return true;
 }
@@ -953,6 +1065,8 @@ bool DotGraphView::loadLibrary(const QString& dotFileName)
   loadingLabel->setZValue(100);
   centerOn(loadingLabel);
 
+  // the layout of a previous file would replace this one
+  d->m_layoutThread.cancel();
   d->m_loadThread.loadFile(dotFileName);
   
   return true;
@@ -1003,7 +1117,7 @@ bool DotGraphView::loadLibrary(graph_t* graph, const QString& layoutCommand)
   d->m_cvZoom = 0;
                                  
   d->m_graph->updateWithGraph(graph);
-  d->m_layoutAlgoSelectAction->setCurrentAction(d->m_graph->layoutCommand(), Qt::CaseInsensitive);
+  d->setCurrentLayoutAction(d->m_graph->layoutCommand());
 
   return true;
 }
@@ -1104,13 +1218,15 @@ bool DotGraphView::displayGraph()
       gedge->canvasEdge()->computeBoundingRect();
   }
   qCDebug(KGRAPHVIEWERLIB_LOG) << "Adding graph render operations: " << d->m_graph->renderOperations().size();
-  foreach (const DotRenderOp& dro, d->m_graph->renderOperations())
+  const DotRenderOpVec& graphOps = d->m_graph->renderOperations();
+  for (const DotRenderOp& dro : graphOps)
   {
-    if ( dro.renderop == "T" )
+    if (dro.code == DotRenderOp::Text)
     {
-//       std::cerr << "Adding graph label '"<<dro.str<<"'" << std::endl;
-      const QString& str = dro.str;
-      int stringWidthGoal = int(dro.integers[3] * scale);
+      const QString& str = graphOps.text(dro);
+      const float* coordinates = graphOps.coordinates(dro);
+//       std::cerr << "Adding graph label '"<<str<<"'" << std::endl;
+      int stringWidthGoal = int(coordinates[3] * scale);
       int fontSize = d->m_graph->fontSize();
       QFont* font = FontsCache::changeable().fromName(d->m_graph->fontName());
       font->setPointSize(fontSize);
@@ -1126,12 +1242,12 @@ bool DotGraphView::displayGraph()
       labelView->setPos(
                   (scale *
                        (
-                         (dro.integers[0])
-                         + (((dro.integers[2])*(dro.integers[3]))/2)
-                         - ( (dro.integers[3])/2 )
+                         (coordinates[0])
+                         + (((coordinates[2])*(coordinates[3]))/2)
+                         - ( (coordinates[3])/2 )
                        )
                       + d->m_xMargin ),
-                      ((gh - (dro.integers[1]))*scale)+ d->m_yMargin);
+                      ((gh - (coordinates[1]))*scale)+ d->m_yMargin);
       /// @todo port that ; how to set text color ?
       labelView->setPen(QPen(Dot2QtConsts::componentData().qtColor(d->m_graph->fontColor())));
       labelView->setFont(*font);
@@ -1153,8 +1269,10 @@ bool DotGraphView::displayGraph()
     (*labelViewsIt)->show();
   }
   d->m_canvas->update();
+  d->setCurrentLayoutAction(d->m_graph->layoutCommand());
   
   emit graphLoaded();
+  emit graphLaidOut(d->m_graph->layoutCommand(), d->m_graph->layoutTime());
 
   return true;
 }
@@ -1299,6 +1417,34 @@ void DotGraphView::resizeEvent(QResizeEvent* e)
 //   std::cerr << "resizeEvent end" << std::endl;
 }
 
+void DotGraphView::paintEvent(QPaintEvent* e)
+{
+  decodeRenderOperations(mapToScene(e->rect()).boundingRect());
+  QGraphicsView::paintEvent(e);
+}
+
+void DotGraphView::decodeRenderOperations(const QRectF& rect)
+{
+  Q_D(DotGraphView);
+  if (!d->m_canvas)
+  {
+    return;
+  }
+  QVector<GraphElement*> elements;
+  for (QGraphicsItem* item : d->m_canvas->items(rect, Qt::IntersectsItemBoundingRect))
+  {
+    if (CanvasElement* element = dynamic_cast<CanvasElement*>(item))
+    {
+      elements.append(element->element());
+    }
+    else if (CanvasEdge* edge = dynamic_cast<CanvasEdge*>(item))
+    {
+      elements.append(edge->edge());
+    }
+  }
+  GraphElement::decodeRenderOperations(elements);
+}
+
 void DotGraphView::zoomRectMovedTo(QPointF newZoomPos)
 {
 //   qCDebug(KGRAPHVIEWERLIB_LOG) << "DotGraphView::zoomRectMovedTo " << newZoomPos;
@@ -1334,15 +1480,15 @@ void DotGraphView::mousePressEvent(QMouseEvent* e)
         e->pos().y()-d->m_defaultNewElementPixmap.height()/2);
     GraphNode* newNode = new GraphNode();
     newNode->attributes() = d->m_newElementAttributes;
-    if (newNode->attributes().find("id") == newNode->attributes().end())
+    if (!newNode->attributes().contains("id"))
     {
       newNode->setId(QString("NewNode%1").arg(d->m_graph->nodes().size()));
     }
-    if (newNode->attributes().find("label") == newNode->attributes().end())
+    if (!newNode->attributes().contains("label"))
     {
       newNode->setLabel(newNode->id());
     }
-    d->m_graph->nodes().insert(newNode->id(), newNode);
+    d->m_graph->insertNode(newNode->id(), newNode);
     CanvasNode* newCNode = new CanvasNode(this, newNode, d->m_canvas);
     newCNode->initialize(scale, scale, d->m_xMargin, d->m_yMargin, gh);
     newNode->setCanvasNode(newCNode);
@@ -1536,6 +1682,7 @@ void DotGraphView::slotElementHoverLeave(CanvasEdge* element)
 void DotGraphView::setLayoutCommand(const QString& command)
 {
   Q_D(DotGraphView);
+  d->m_layoutCommand = command;
   d->m_graph->layoutCommand(command);
   reload();
 }
@@ -1642,6 +1789,11 @@ bool DotGraphView::reload()
 {
   Q_D(DotGraphView);
   QString fileName = d->m_graph->dotFileName();
+  if (DotInput::isStreamFile(fileName))
+  {
+    qCWarning(KGRAPHVIEWERLIB_LOG) << "Cannot reload" << fileName << ": it has been read once";
+    return false;
+  }
   if (d->m_graph->useLibrary())
     return loadLibrary(fileName);
   else
@@ -1770,9 +1922,20 @@ void DotGraphView::slotLayoutSpecify()
 
 void DotGraphView::slotLayoutReset()
 {
-  Q_D(DotGraphView);
-  d->m_layoutAlgoSelectAction->setCurrentAction("Dot");
-  slotSelectLayoutAlgo("Dot");
+  // chosen again for each graph
+  setLayoutCommand(QString());
+}
+
+void DotGraphView::slotSelectLayoutPreset(int preset)
+{
+  if (preset == KGraphViewerPartSettings::layoutPreset())
+  {
+    return;
+  }
+  KGraphViewerPartSettings::setLayoutPreset(preset);
+  KGraphViewerPartSettings::self()->save();
+  // laid out again with the attributes of the new preset
+  reload();
 }
 
 void DotGraphView::slotSelectLayoutAlgo(const QString& ttext)
@@ -1799,6 +1962,14 @@ void DotGraphView::slotSelectLayoutAlgo(const QString& ttext)
   {
     setLayoutCommand("circo");
   }
+  else if (text == i18n("Force Directed (Built-in)"))
+  {
+    setLayoutCommand(DotNativeLayout::forceDirectedCommand());
+  }
+  else if (text == i18n("Layered (Built-in)"))
+  {
+    setLayoutCommand(DotNativeLayout::layeredCommand());
+  }
   else 
   {
     setLayoutCommand(text);
@@ -1872,7 +2043,7 @@ void DotGraphView::slotUpdate()
 {
   Q_D(DotGraphView);
   d->m_graph->update();
-  d->m_layoutAlgoSelectAction->setCurrentAction(d->m_graph->layoutCommand(), Qt::CaseInsensitive);
+  d->setCurrentLayoutAction(d->m_graph->layoutCommand());
 }
 
 void DotGraphView::prepareAddNewElement(QMap<QString,QString> attribs)
@@ -2244,44 +2415,82 @@ void DotGraphView::enterEvent ( QEvent * /*event*/ )
 void DotGraphView::slotAGraphReadFinished()
 {
   Q_D(DotGraphView);
-  QString layoutCommand = (d->m_graph ? d->m_graph->layoutCommand() : QString());
-  if (layoutCommand.isEmpty())
+  if (d->m_loadThread.discardStale())
   {
-    if (!d->m_loadThread.dotFileName().isEmpty())
-      layoutCommand = d->m_graph->chooseLayoutProgramForFile(d->m_loadThread.dotFileName());
-    else
+    return;
+  }
+  graph_t* graph = d->m_loadThread.takeGraph();
+  const QString& dotFileName = d->m_loadThread.dotFileName();
+  QString layoutCommand = d->m_layoutCommand;
+  if (layoutCommand.isEmpty() && graph)
+  {
+    layoutCommand = DotLayoutChooser::choose(dotFileName, graph);
+  }
+  else if (layoutCommand.isEmpty())
+  {
+    // detected while the file was read
+    layoutCommand = d->m_loadThread.layoutCommand();
+    if (layoutCommand.isEmpty())
       layoutCommand = "dot";
   }
-  d->m_layoutThread.layoutGraph(d->m_loadThread.g(), layoutCommand);
-  d->m_loadThread.processed_finished();
+  const QByteArray& contentHash = d->m_loadThread.contentHash();
+  if (graph && d->loadCachedLibraryLayout(dotFileName, layoutCommand, contentHash))
+  {
+    agclose(graph);
+    return;
+  }
+  QByteArray cacheKey;
+  if (DotLayoutCache::isEnabled() && !contentHash.isEmpty())
+  {
+    cacheKey = DotLayoutCache::key(contentHash, layoutCommand, QStringLiteral("xdot"));
+  }
+  d->m_layoutThread.layoutGraph(graph, dotFileName, layoutCommand, cacheKey);
 }
 
 void DotGraphView::slotAGraphLayoutFinished()
 {
   Q_D(DotGraphView);
-  graph_t *g = d->m_layoutThread.g();
-  bool result = loadLibrary(g, d->m_layoutThread.layoutCommand());
-  if (result)
-    // file name can be taken from m_loadThread both in sync and async loading cases
-    // see comment in loadLibrarySync()
-    d->m_graph->dotFileName(d->m_loadThread.dotFileName());
+  // the result of a superseded or cancelled layout is not displayed
+  if (d->m_layoutThread.discardStale())
+  {
+    return;
+  }
+  if (!d->m_layoutThread.cacheEntryPath().isEmpty())
+  {
+    DotLayoutCache::store(d->m_layoutThread.cacheKey(), d->m_layoutThread.cacheEntryPath());
+  }
+  const QString dotFileName = d->m_layoutThread.dotFileName();
+  DotGraph* laidOutGraph = d->m_layoutThread.takeLaidOutGraph();
+  if (laidOutGraph)
+  {
+    DotLayoutChooser::recordDuration(dotFileName, d->m_layoutThread.layoutCommand(), laidOutGraph->elementCount(),
+                                     d->m_layoutThread.layoutTime());
+    d->newGraph(dotFileName, d->m_layoutThread.layoutCommand());
+    d->m_graph->setUseLibrary(true);
+    d->m_graph->layoutTime(d->m_layoutThread.layoutTime());
+    d->m_graph->updateWithGraph(*laidOutGraph);
+    delete laidOutGraph;
+    d->setCurrentLayoutAction(d->m_graph->layoutCommand());
+    displayGraph();
+  }
   else
   {
-    Q_ASSERT(!d->m_canvas);
+    d->m_birdEyeView->setScene(nullptr);
+    if (d->m_canvas)
+    {
+      d->m_canvas->deleteLater();
+      d->m_canvas = nullptr;
+    }
+    delete d->m_graph;
+    d->m_graph = nullptr;
+
     QGraphicsScene *newCanvas = new QGraphicsScene();
-    QGraphicsSimpleTextItem* loadingLabel = newCanvas->addSimpleText(i18n("Failed to open %1", d->m_loadThread.dotFileName()));
+    QGraphicsSimpleTextItem* loadingLabel = newCanvas->addSimpleText(i18n("Failed to open %1", dotFileName));
     loadingLabel->setZValue(100);
     centerOn(loadingLabel);
     setScene(newCanvas);
     d->m_canvas = newCanvas;
   }
-
-  if (g)
-  {
-    gvFreeLayout(d->m_layoutThread.gvc(), g);
-    agclose(g);
-  }
-  d->m_layoutThread.processed_finished();
 }
 
 void DotGraphView::slotSelectNode(const QString& nodeName)
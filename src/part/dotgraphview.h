@@ -153,6 +153,12 @@ public:
   void contextMenuEvent(QContextMenuEvent*) override;
 
   void setBackgroundColor(const QColor& color);
+
+  /**
+   * Decodes in parallel the drawing operations of the elements in the
+   * scene rectangle rect not painted yet, before they are painted
+   */
+  void decodeRenderOperations(const QRectF& rect);
   
 Q_SIGNALS:
   void zoomed(double factor);
@@ -176,6 +182,12 @@ Q_SIGNALS:
   void contextMenuEvent(const QString&, const QPoint&);
   void hoverEnter(const QString&);
   void hoverLeave(const QString&);
+  /**
+   * signals that a graph laid out by layoutCommand is displayed, the layout
+   * having taken milliseconds, or -1 if it was read from the cache or from
+   * an already laid out file
+   */
+  void graphLaidOut(const QString& layoutCommand, qint64 milliseconds);
   
 public Q_SLOTS:
   void zoomIn();
@@ -194,6 +206,8 @@ public Q_SLOTS:
   void slotSelectLayoutAlgo(const QString& text);
   void slotLayoutSpecify();
   void slotLayoutReset();
+  /** @param preset the index of the Fast, Balanced or Quality preset */
+  void slotSelectLayoutPreset(int preset);
   void slotSelectLayoutDot();
   void slotSelectLayoutNeato();
   void slotSelectLayoutTwopi();
@@ -223,6 +237,7 @@ protected:
 
   void scrollContentsBy(int dx, int dy) override;
   void resizeEvent(QResizeEvent*) override;
+  void paintEvent(QPaintEvent*) override;
   void mousePressEvent(QMouseEvent*) override;
   void mouseMoveEvent(QMouseEvent*) override;
   void mouseReleaseEvent(QMouseEvent*) override;
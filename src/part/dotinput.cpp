@@ -0,0 +1,387 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+#include "dotinput.h"
+#include "dotlexer.h"
+#include "kgraphviewerlib_debug.h"
+
+#include <QDebug>
+
+#include <cerrno>
+#include <cstring>
+#include <limits>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace KGraphViewer
+{
+
+DotInput::DotInput(const QString& fileName) :
+    m_file(fileName),
+    m_device(),
+    m_header(),
+    m_content(),
+    m_data(nullptr),
+    m_size(0),
+    m_readPosition(0),
+    m_stream(false),
+    m_streamEnded(false),
+    m_hash(QCryptographicHash::Sha1),
+    m_hashResult(),
+    m_cancelled(0)
+{
+}
+
+DotInput::~DotInput()
+{
+}
+
+bool DotInput::isStreamFile(const QString& fileName)
+{
+  if (fileName == QLatin1String("-"))
+  {
+    return true;
+  }
+  // a directory or any other file which is not read as a stream is not one
+  struct stat status;
+  if (::stat(QFile::encodeName(fileName).constData(), &status) != 0)
+  {
+    return false;
+  }
+  return S_ISFIFO(status.st_mode) || S_ISSOCK(status.st_mode) || S_ISCHR(status.st_mode);
+}
+
+bool DotInput::open()
+{
+  bool opened;
+  if (m_file.fileName() == QLatin1String("-"))
+  {
+    opened = m_file.open(STDIN_FILENO, QIODevice::ReadOnly);
+  }
+  else if (isStreamFile(m_file.fileName()))
+  {
+    // opening a named pipe blocks until a writer connects: it is opened
+    // without blocking, then waited for until data arrives
+    const int handle = ::open(QFile::encodeName(m_file.fileName()).constData(), O_RDONLY | O_NONBLOCK);
+    if (handle >= 0 && !waitForData(handle))
+    {
+      qCDebug(KGRAPHVIEWERLIB_LOG) << "Opening cancelled" << m_file.fileName();
+      ::close(handle);
+      return false;
+    }
+    opened = handle >= 0
+        && fcntl(handle, F_SETFL, fcntl(handle, F_GETFL) & ~O_NONBLOCK) == 0
+        && m_file.open(handle, QIODevice::ReadOnly, QFileDevice::AutoCloseHandle);
+    if (handle >= 0 && !opened)
+    {
+      ::close(handle);
+    }
+  }
+  else
+  {
+    opened = m_file.open(QIODevice::ReadOnly);
+  }
+  if (!opened)
+  {
+    qCWarning(KGRAPHVIEWERLIB_LOG) << "Failed to open file" << m_file.fileName();
+    return false;
+  }
+  if (m_file.isSequential())
+  {
+    // standard input or named pipe: it is read once, what is received being
+    // kept so that it can be read again, and only the header is waited for
+    m_stream = true;
+    while (m_content.indexOf('{') < 0)
+    {
+      if (!waitForData(m_file.handle()))
+      {
+        qCDebug(KGRAPHVIEWERLIB_LOG) << "Opening cancelled" << m_file.fileName();
+        return false;
+      }
+      if (!receive())
+      {
+        break;
+      }
+    }
+    return true;
+  }
+  if (m_file.peek(2) == QByteArray("\x1f\x8b"))
+  {
+    // gzip: the content is decompressed each time it is read
+    m_device.reset(new KCompressionDevice(&m_file, false, KCompressionDevice::GZip));
+    if (!m_device->open(QIODevice::ReadOnly))
+    {
+      qCWarning(KGRAPHVIEWERLIB_LOG) << "Failed to decompress file" << m_file.fileName();
+      m_device.reset();
+      return false;
+    }
+    m_header = m_device->read(4096);
+    m_device->reset();
+    return true;
+  }
+  m_size = m_file.size();
+  if (m_size > 0)
+  {
+    m_data = reinterpret_cast<const char*>(m_file.map(0, m_size));
+  }
+  if (m_data == nullptr)
+  {
+    // not a regular file or mapping not supported
+    m_content = m_file.readAll();
+    m_data = m_content.constData();
+    m_size = m_content.size();
+  }
+  return true;
+}
+
+bool DotInput::waitForData(int handle) const
+{
+  pollfd poller;
+  poller.fd = handle;
+  poller.events = POLLIN;
+  while (m_cancelled.loadAcquire() == 0)
+  {
+    poller.revents = 0;
+    // the cancellation is checked ten times per second
+    const int result = ::poll(&poller, 1, 100);
+    if (result > 0 || (result < 0 && errno != EINTR))
+    {
+      // data, the end of the stream or an error reported by the next read
+      return true;
+    }
+  }
+  return false;
+}
+
+bool DotInput::receive()
+{
+  if (m_streamEnded)
+  {
+    return false;
+  }
+  // QFile would wait for the whole block on a pipe: take what has arrived
+  const int blockSize = 1 << 16;
+  const int size = m_content.size();
+  if (size > std::numeric_limits<int>::max() - 2 * blockSize)
+  {
+    // a QByteArray holds less than 2 GiB: the truncated graph fails to parse
+    qCWarning(KGRAPHVIEWERLIB_LOG) << "The stream" << m_file.fileName() << "is too big to be kept, more than" << size << "bytes";
+    m_streamEnded = true;
+    return false;
+  }
+  m_content.resize(size + blockSize);
+  qint64 length;
+  do
+  {
+    length = ::read(m_file.handle(), m_content.data() + size, blockSize);
+  } while (length < 0 && errno == EINTR);
+  if (length < 0)
+  {
+    qCWarning(KGRAPHVIEWERLIB_LOG) << "Failed to read" << m_file.fileName() << strerror(errno);
+  }
+  m_content.resize(size + int(qMax(length, qint64(0))));
+  m_data = m_content.constData();
+  m_size = m_content.size();
+  if (length <= 0)
+  {
+    m_streamEnded = true;
+    return false;
+  }
+  return true;
+}
+
+void DotInput::readToEnd()
+{
+  while (receive())
+  {
+  }
+}
+
+QString DotInput::layoutCommand() const
+{
+  const char* first = isCompressed() ? m_header.constData() : m_data;
+  const char* last = isCompressed() ? first + m_header.size() : m_data + m_size;
+  if (first == last)
+  {
+    return QString();
+  }
+  // the lexer stops at the first tokens, so only the header bytes are touched
+  DotLexer lexer(first, last);
+  DotToken token = lexer.next();
+  if (token.isKeyword("strict"))
+  {
+    token = lexer.next();
+  }
+  return token.isKeyword("graph") ? QString("neato") : QString("dot");
+}
+
+int DotInput::readLine(void* channel, char* buffer, int bufferSize)
+{
+  DotInput* input = static_cast<DotInput*>(channel);
+  if (input->isCompressed() && bufferSize > 1)
+  {
+    const qint64 length = input->m_device->readLine(buffer, bufferSize);
+    if (length <= 0)
+    {
+      return 0;
+    }
+    input->m_hash.addData(buffer, int(length));
+    input->m_readPosition += length;
+    return int(length);
+  }
+  if (input->isCompressed())
+  {
+    return int(input->readBlock(buffer, bufferSize));
+  }
+  if (input->isWaitingForData())
+  {
+    input->receive();
+  }
+  if (bufferSize <= 0 || input->m_readPosition >= input->m_size)
+  {
+    return 0;
+  }
+  // like the cgraph memory reader, give one line at a time
+  const char* first = input->m_data + input->m_readPosition;
+  qint64 length = qMin(qint64(bufferSize), input->m_size - input->m_readPosition);
+  const char* newline = static_cast<const char*>(memchr(first, '\n', length));
+  if (newline != nullptr)
+  {
+    length = newline - first + 1;
+  }
+  memcpy(buffer, first, length);
+  input->m_hash.addData(first, int(length));
+  input->m_readPosition += length;
+  return int(length);
+}
+
+graph_t* DotInput::readFromStart()
+{
+  static Agiodisc_t memoryIoDisc = {&DotInput::readLine, AgIoDisc.putstr, AgIoDisc.flush};
+  Agdisc_t disc;
+  disc.mem = &AgMemDisc;
+  disc.id = &AgIdDisc;
+  disc.io = &memoryIoDisc;
+
+  rewind();
+  graph_t* graph = agread(this, &disc);
+  if (atEnd())
+  {
+    m_hashResult = m_hash.result();
+  }
+  return graph;
+}
+
+graph_t* DotInput::read()
+{
+  if (m_data == nullptr && !isCompressed())
+  {
+    return nullptr;
+  }
+  graph_t* graph = readFromStart();
+  if (graph == nullptr)
+  {
+    qCWarning(KGRAPHVIEWERLIB_LOG) << "Failed to read file, retrying to work around graphviz bug(?)";
+    graph = readFromStart();
+  }
+  if (graph == nullptr)
+  {
+    qCWarning(KGRAPHVIEWERLIB_LOG) << "Failed to read file" << m_file.fileName();
+  }
+  return graph;
+}
+
+void DotInput::rewind()
+{
+  m_readPosition = 0;
+  m_hash.reset();
+  if (isCompressed())
+  {
+    m_device->reset();
+  }
+}
+
+bool DotInput::atEnd() const
+{
+  return isCompressed() ? m_device->atEnd() : (m_readPosition >= m_size && !isWaitingForData());
+}
+
+qint64 DotInput::readBlock(char* buffer, qint64 size)
+{
+  qint64 length;
+  if (isCompressed())
+  {
+    length = m_device->read(buffer, size);
+    if (length < 0)
+    {
+      qCWarning(KGRAPHVIEWERLIB_LOG) << "Failed to decompress file" << m_file.fileName() << m_device->errorString();
+      return -1;
+    }
+  }
+  else
+  {
+    if (isWaitingForData())
+    {
+      receive();
+    }
+    length = qMax(qint64(0), qMin(size, m_size - m_readPosition));
+    memcpy(buffer, m_data + m_readPosition, length);
+  }
+  if (length == 0)
+  {
+    m_hashResult = m_hash.result();
+    return 0;
+  }
+  m_hash.addData(buffer, int(length));
+  m_readPosition += length;
+  return length;
+}
+
+QByteArray DotInput::hash()
+{
+  if (m_hashResult.isEmpty() && isCompressed())
+  {
+    rewind();
+    QByteArray block(1 << 16, Qt::Uninitialized);
+    qint64 length;
+    while ((length = readBlock(block.data(), block.size())) > 0)
+    {
+    }
+    if (length < 0)
+    {
+      m_hashResult.clear();
+    }
+  }
+  else if (m_hashResult.isEmpty() && m_data != nullptr)
+  {
+    readToEnd();
+    m_hash.reset();
+    const qint64 blockSize = 1 << 30;
+    for (qint64 position = 0; position < m_size; position += blockSize)
+    {
+      m_hash.addData(m_data + position, int(qMin(blockSize, m_size - position)));
+    }
+    m_hashResult = m_hash.result();
+  }
+  return m_hashResult;
+}
+
+}
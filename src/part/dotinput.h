@@ -0,0 +1,161 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+/*
+ * Single read access to the content of a DOT file
+ */
+
+#ifndef DOT_INPUT_H
+#define DOT_INPUT_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QFile>
+#include <QScopedPointer>
+#include <QString>
+
+#include <KCompressionDevice>
+
+#include <graphviz/gvc.h>
+
+namespace KGraphViewer
+{
+
+/**
+ * The content of a DOT file, memory mapped once and shared by all the
+ * consumers of the file: the detection of the layout program, which only
+ * looks at the graph header, the reading of the graph by cgraph and the
+ * computation of the content hash identifying the graph.
+ *
+ * A gzip compressed file is not mapped: it is decompressed while it is
+ * read, without being written anywhere.
+ *
+ * The standard input, named "-", and named pipes are read once, as the
+ * graph is read: what has been received is kept in a growing buffer.
+ */
+class DotInput
+{
+public:
+  explicit DotInput(const QString& fileName);
+  ~DotInput();
+
+  /**
+   * @return true if fileName is the standard input, a named pipe, a socket
+   * or a character device, which can only be read once
+   */
+  static bool isStreamFile(const QString& fileName);
+
+  /**
+   * Maps the file in memory, or reads it if it cannot be mapped. A
+   * compressed file is only opened and only the header of a stream is read.
+   *
+   * On a named pipe, it waits for a writer to connect, then on any stream
+   * for the header to arrive: it is thus not to be called on the GUI
+   * thread. The wait ends when cancel() is called.
+   * @return false if the file cannot be opened or if the opening is cancelled
+   */
+  bool open();
+
+  /** Ends the wait of open() for a stream, from any thread */
+  inline void cancel() {m_cancelled.storeRelease(1);}
+
+  inline bool isCompressed() const {return !m_device.isNull();}
+  inline bool isStream() const {return m_stream;}
+  /** true if the reading of a stream has to wait for more data */
+  inline bool isWaitingForData() const {return m_stream && !m_streamEnded && m_readPosition >= m_size;}
+  /** The file descriptor of a stream, to be notified of new data */
+  inline int handle() const {return m_file.handle();}
+
+  /** Waits for the whole content of a stream, so that data() holds all of it */
+  void readToEnd();
+
+  /**
+   * The content of an uncompressed file, nullptr for a compressed one. For
+   * a stream, what has been received so far.
+   */
+  inline const char* data() const {return m_data;}
+  /** The size of data() */
+  inline qint64 size() const {return m_size;}
+  inline const QString& fileName() const {return m_file.fileName();}
+
+  /**
+   * The layout program suited to the graph: neato for undirected graphs
+   * and dot for directed ones. Only the header of the graph is read.
+   * @return an empty string if the file is empty
+   */
+  QString layoutCommand() const;
+
+  /**
+   * Reads the graph with cgraph directly from the mapped or decompressed
+   * content. The content hash is computed during the same pass.
+   * @return nullptr on error
+   */
+  graph_t* read();
+
+  /** Restarts the reading by readBlock() from the beginning of the content */
+  void rewind();
+
+  /**
+   * Copies to buffer the next bytes of the content, decompressed, and adds
+   * them to the content hash. Waits for data on a stream if none has been
+   * received yet.
+   * @return the number of bytes copied, 0 at the end of the content and -1
+   * on error
+   */
+  qint64 readBlock(char* buffer, qint64 size);
+
+  /** The SHA-1 hash of the content, computed on first use if read() was not called */
+  QByteArray hash();
+
+private:
+  static int readLine(void* channel, char* buffer, int bufferSize);
+
+  graph_t* readFromStart();
+  /**
+   * Appends what arrives on the stream to the content, waiting for it.
+   * @return false at the end of the stream
+   */
+  bool receive();
+  /**
+   * Waits for data or for the end on the stream handle, checking
+   * regularly whether cancel() has been called.
+   * @return false if the wait has been cancelled
+   */
+  bool waitForData(int handle) const;
+  bool atEnd() const;
+
+  QFile m_file;
+  /** The decompressing device of a compressed file */
+  QScopedPointer<KCompressionDevice> m_device;
+  /** The beginning of a compressed content, enough for layoutCommand() */
+  QByteArray m_header;
+  QByteArray m_content;
+  const char* m_data;
+  qint64 m_size;
+  qint64 m_readPosition;
+  bool m_stream;
+  bool m_streamEnded;
+  QCryptographicHash m_hash;
+  QByteArray m_hashResult;
+  QAtomicInt m_cancelled;
+};
+
+}
+
+#endif
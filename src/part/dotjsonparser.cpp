@@ -0,0 +1,667 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+#include "dotjsonparser.h"
+#include "dotgraph.h"
+#include "dotgrammar.h"
+#include "kgraphviewerlib_debug.h"
+
+#include <QDebug>
+#include <QIODevice>
+
+namespace KGraphViewer
+{
+
+namespace
+{
+
+bool isDrawAttribute(const std::string& name)
+{
+  static const char* const drawAttributes[] = {"_draw_", "_ldraw_", "_hldraw_", "_tldraw_", "_tdraw_", "_hdraw_"};
+  for (const char* drawAttribute : drawAttributes)
+  {
+    if (name == drawAttribute)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+inline bool isArrowheadAttribute(const std::string& name)
+{
+  return name == "_tdraw_" || name == "_hdraw_";
+}
+
+bool operationCode(char c, DotRenderOp::Code& code)
+{
+  switch (c)
+  {
+    case 'c': code = DotRenderOp::PenColor; return true;
+    case 'C': code = DotRenderOp::FillColor; return true;
+    case 'S': code = DotRenderOp::Style; return true;
+    case 'p': code = DotRenderOp::Polygon; return true;
+    case 'P': code = DotRenderOp::FilledPolygon; return true;
+    case 'L': code = DotRenderOp::Polyline; return true;
+    case 'B': code = DotRenderOp::BSpline; return true;
+    case 'b': code = DotRenderOp::FilledBSpline; return true;
+    case 'e': code = DotRenderOp::Ellipse; return true;
+    case 'E': code = DotRenderOp::FilledEllipse; return true;
+    case 'T': code = DotRenderOp::Text; return true;
+    case 'F': code = DotRenderOp::Font; return true;
+    case 't': code = DotRenderOp::FontCharacteristics; return true;
+    default: return false;
+  }
+}
+
+}
+
+DotJsonParser::DotJsonParser(DotGraph* graph) :
+    m_graph(graph),
+    m_reader(*this),
+    m_buffer(),
+    m_failed(false),
+    m_contexts(),
+    m_key(),
+    m_arena(QSharedPointer<DotRenderOpArena>::create()),
+    m_attributeValues(),
+    m_graphOps(m_arena),
+    m_ops(&m_graphOps),
+    m_opsAreArrowheads(false),
+    m_operation(),
+    m_element(),
+    m_subgraphCount(0),
+    m_subgraphs(),
+    m_nodes(),
+    m_nodesByIndex(),
+    m_parallelEdges(),
+    m_maxZ(1)
+{
+  resetElement();
+}
+
+DotJsonParser::~DotJsonParser()
+{
+  // on error, the subgraphs and nodes read but not placed in the graph yet
+  for (const SubgraphContent& content : m_subgraphs)
+  {
+    delete content.subgraph;
+  }
+  for (const QPair<int, GraphNode*>& node : m_nodes)
+  {
+    delete node.second;
+  }
+}
+
+bool DotJsonParser::readFrom(QIODevice* device)
+{
+  if (m_failed)
+  {
+    return false;
+  }
+  const qint64 available = device->bytesAvailable();
+  if (available <= 0)
+  {
+    return true;
+  }
+  // the reader keeps no reference to the buffer: only a token cut by the
+  // end of the data read is kept for the next call
+  const int size = m_buffer.size();
+  m_buffer.resize(size + int(available));
+  const qint64 read = device->read(m_buffer.data() + size, available);
+  m_buffer.resize(size + int(qMax(read, qint64(0))));
+
+  const char* first = m_buffer.constData();
+  const char* next = m_reader.read(first, first + m_buffer.size(), false);
+  if (next == nullptr)
+  {
+    m_failed = true;
+    return false;
+  }
+  m_buffer.remove(0, int(next - first));
+  return true;
+}
+
+bool DotJsonParser::finish()
+{
+  if (m_failed)
+  {
+    return false;
+  }
+  const char* first = m_buffer.constData();
+  if (m_reader.read(first, first + m_buffer.size(), true) == nullptr)
+  {
+    m_failed = true;
+    return false;
+  }
+  m_buffer.clear();
+  return m_reader.isFinished();
+}
+
+bool DotJsonParser::startObject()
+{
+  if (m_contexts.empty())
+  {
+    m_contexts.push_back(GraphObject);
+    return true;
+  }
+  switch (m_contexts.back())
+  {
+    case ObjectArray:
+    case EdgeArray:
+      resetElement();
+      m_contexts.push_back(ElementObject);
+      break;
+    case OperationArray:
+      m_operation.code = '\0';
+      m_operation.text.clear();
+      m_operation.color.clear();
+      m_operation.coordinates.clear();
+      m_operation.align = 'c';
+      m_operation.width = 0;
+      m_operation.size = 0;
+      m_operation.flags = 0;
+      m_contexts.push_back(OperationObject);
+      break;
+    case StopArray:
+      m_contexts.push_back(StopObject);
+      break;
+    default:
+      m_contexts.push_back(Skipped);
+  }
+  return true;
+}
+
+bool DotJsonParser::endObject()
+{
+  const Context context = m_contexts.back();
+  m_contexts.pop_back();
+  switch (context)
+  {
+    case ElementObject:
+      finishElement();
+      break;
+    case OperationObject:
+      finishOperation();
+      break;
+    case GraphObject:
+      m_graph->setRenderOperations(m_graphOps);
+      break;
+    default:
+      break;
+  }
+  return true;
+}
+
+bool DotJsonParser::startArray()
+{
+  Context context = Skipped;
+  switch (currentContext())
+  {
+    case GraphObject:
+      if (m_key == "objects")
+      {
+        context = ObjectArray;
+      }
+      else if (m_key == "edges")
+      {
+        context = EdgeArray;
+      }
+      else if (isDrawAttribute(m_key))
+      {
+        m_ops = &m_graphOps;
+        m_opsAreArrowheads = false;
+        context = OperationArray;
+      }
+      break;
+    case ElementObject:
+      if (m_key == "nodes" || m_key == "subgraphs")
+      {
+        context = IndexArray;
+      }
+      else if (isDrawAttribute(m_key))
+      {
+        m_ops = &m_element.ops;
+        m_opsAreArrowheads = isArrowheadAttribute(m_key);
+        context = OperationArray;
+      }
+      break;
+    case OperationObject:
+      if (m_key == "points" || m_key == "rect" || m_key == "pt")
+      {
+        context = CoordinateArray;
+      }
+      else if (m_key == "stops")
+      {
+        context = StopArray;
+      }
+      break;
+    case CoordinateArray:
+      // the points of a polygon, polyline or B-spline
+      context = CoordinateArray;
+      break;
+    default:
+      break;
+  }
+  m_contexts.push_back(context);
+  return true;
+}
+
+bool DotJsonParser::endArray()
+{
+  const Context context = m_contexts.back();
+  m_contexts.pop_back();
+  if (context == ObjectArray)
+  {
+    placeObjects();
+  }
+  return true;
+}
+
+bool DotJsonParser::key(const DotStringRef& name)
+{
+  m_key.assign(name.first, name.size());
+  return true;
+}
+
+bool DotJsonParser::stringValue(const DotStringRef& value)
+{
+  switch (currentContext())
+  {
+    case GraphObject:
+      if (m_key == "name")
+      {
+        m_graph->setId(value.toString());
+      }
+      else if (isDrawAttribute(m_key))
+      {
+        // -Tjson0 gives the xdot strings
+        m_graphOps.appendXdot(value.first, value.last);
+      }
+      else
+      {
+        setAttribute(value.toString());
+      }
+      break;
+    case ElementObject:
+      if (m_key == "name")
+      {
+        m_element.name = value.toString();
+      }
+      else if (isDrawAttribute(m_key))
+      {
+        m_element.ops.appendXdot(value.first, value.last);
+        if (isArrowheadAttribute(m_key))
+        {
+          m_element.arrowheads.appendXdot(value.first, value.last);
+        }
+      }
+      else
+      {
+        setAttribute(value.toString());
+      }
+      break;
+    case OperationObject:
+      if (m_key == "op")
+      {
+        m_operation.code = value.isEmpty() ? '\0' : *value.first;
+      }
+      else if (m_key == "color")
+      {
+        m_operation.color = value.toString();
+      }
+      else if (m_key == "text" || m_key == "face" || m_key == "style")
+      {
+        m_operation.text = value.toString();
+      }
+      else if (m_key == "align")
+      {
+        m_operation.align = value.isEmpty() ? 'c' : *value.first;
+      }
+      break;
+    case StopObject:
+      // gradients are drawn with the color of their first stop
+      if (m_key == "color" && m_operation.color.isEmpty())
+      {
+        m_operation.color = value.toString();
+      }
+      break;
+    default:
+      break;
+  }
+  return true;
+}
+
+bool DotJsonParser::numberValue(double value)
+{
+  switch (currentContext())
+  {
+    case GraphObject:
+      if (m_key == "_subgraph_cnt")
+      {
+        m_subgraphCount = int(value);
+      }
+      else
+      {
+        setAttribute(QString::number(value));
+      }
+      break;
+    case ElementObject:
+      if (m_key == "_gvid")
+      {
+        m_element.index = int(value);
+      }
+      else if (m_key == "tail")
+      {
+        m_element.tail = int(value);
+      }
+      else if (m_key == "head")
+      {
+        m_element.head = int(value);
+      }
+      else
+      {
+        setAttribute(QString::number(value));
+      }
+      break;
+    case OperationObject:
+      if (m_key == "width")
+      {
+        m_operation.width = float(value);
+      }
+      else if (m_key == "size")
+      {
+        m_operation.size = float(value);
+      }
+      else if (m_key == "fontchar")
+      {
+        m_operation.flags = float(value);
+      }
+      break;
+    case CoordinateArray:
+      m_operation.coordinates.push_back(float(value));
+      break;
+    case IndexArray:
+      (m_key == "nodes" ? m_element.nodes : m_element.subgraphs).push_back(int(value));
+      break;
+    default:
+      break;
+  }
+  return true;
+}
+
+bool DotJsonParser::boolValue(bool value)
+{
+  const Context context = currentContext();
+  if (context == GraphObject && m_key == "directed")
+  {
+    m_graph->directed(value);
+  }
+  else if (context == GraphObject && m_key == "strict")
+  {
+    m_graph->strict(value);
+  }
+  else if (context == GraphObject || context == ElementObject)
+  {
+    setAttribute(value ? QString("true") : QString("false"));
+  }
+  return true;
+}
+
+bool DotJsonParser::nullValue()
+{
+  return true;
+}
+
+void DotJsonParser::setAttribute(const QString& value)
+{
+  const int symbol = DotAttributeSymbols::symbol(m_key.data(), m_key.data() + m_key.size());
+  QString attribute = m_attributeValues.intern(value);
+  if (m_key == "label")
+  {
+    attribute.replace("\\n", "\n");
+  }
+  if (m_contexts.back() == GraphObject)
+  {
+    if (m_key == "bb")
+    {
+      std::vector< double > v;
+      parse_reals(value.toUtf8().constData(), v);
+      if (v.size() >= 4)
+      {
+        m_graph->width(v[2]);
+        m_graph->height(v[3]);
+      }
+    }
+    m_graph->attributes()[symbol] = attribute;
+  }
+  else
+  {
+    m_element.attributes[symbol] = attribute;
+  }
+}
+
+void DotJsonParser::resetElement()
+{
+  m_element.index = -1;
+  m_element.name.clear();
+  m_element.attributes.clear();
+  m_element.ops = DotRenderOpVec(m_arena);
+  m_element.arrowheads = DotRenderOpVec(m_arena);
+  m_element.nodes.clear();
+  m_element.subgraphs.clear();
+  m_element.tail = -1;
+  m_element.head = -1;
+}
+
+void DotJsonParser::finishOperation()
+{
+  const Operation& operation = m_operation;
+  const std::vector<float>& coordinates = operation.coordinates;
+  DotRenderOpVec& ops = *m_ops;
+  DotRenderOp op;
+  if (!operationCode(operation.code, op.code))
+  {
+    // images are not given in this format
+    qCDebug(KGRAPHVIEWERLIB_LOG) << "Ignoring drawing operation" << operation.code;
+    return;
+  }
+  op.count = 0;
+  op.coordinates = ops.nextCoordinate();
+  op.text = 0;
+  switch (op.code)
+  {
+    case DotRenderOp::PenColor:
+    case DotRenderOp::FillColor:
+      op.text = ops.internColor(operation.color);
+      break;
+    case DotRenderOp::Style:
+      op.text = ops.internText(operation.text);
+      break;
+    case DotRenderOp::Polygon:
+    case DotRenderOp::FilledPolygon:
+    case DotRenderOp::Polyline:
+    case DotRenderOp::BSpline:
+    case DotRenderOp::FilledBSpline:
+      op.count = quint32(coordinates.size() / 2);
+      for (quint32 i = 0; i < 2 * op.count; i++)
+      {
+        ops.appendCoordinate(coordinates[i]);
+      }
+      break;
+    case DotRenderOp::Ellipse:
+    case DotRenderOp::FilledEllipse:
+      if (coordinates.size() < 4)
+      {
+        return;
+      }
+      for (int i = 0; i < 4; i++)
+      {
+        ops.appendCoordinate(coordinates[i]);
+      }
+      break;
+    case DotRenderOp::Text:
+      if (coordinates.size() < 2)
+      {
+        return;
+      }
+      // the xdot justification: -1, 0 or 1 for left, centered or right
+      ops.appendCoordinate(coordinates[0]);
+      ops.appendCoordinate(coordinates[1]);
+      ops.appendCoordinate(operation.align == 'l' ? -1 : (operation.align == 'r' ? 1 : 0));
+      ops.appendCoordinate(operation.width);
+      op.text = ops.internText(operation.text);
+      break;
+    case DotRenderOp::Font:
+      ops.appendCoordinate(operation.size);
+      op.text = ops.internText(operation.text);
+      break;
+    case DotRenderOp::FontCharacteristics:
+      ops.appendCoordinate(operation.flags);
+      break;
+    default:
+      return;
+  }
+  ops.append(op);
+  if (m_opsAreArrowheads)
+  {
+    // the operations of the edge and its arrowheads share the arena
+    m_element.arrowheads.append(op);
+  }
+}
+
+void DotJsonParser::fillElement(GraphElement* element)
+{
+  DotAttributes::const_iterator it = m_element.attributes.constBegin();
+  for (; it != m_element.attributes.constEnd(); it++)
+  {
+    element->attributes()[it.symbol()] = it.value();
+  }
+  element->setRenderOperations(m_element.ops);
+}
+
+void DotJsonParser::finishElement()
+{
+  if (m_contexts.back() == EdgeArray)
+  {
+    GraphNode* tail = m_nodesByIndex.value(m_element.tail, nullptr);
+    GraphNode* head = m_nodesByIndex.value(m_element.head, nullptr);
+    if (tail == nullptr || head == nullptr)
+    {
+      qCWarning(KGRAPHVIEWERLIB_LOG) << "Ignoring edge" << m_element.index << "with unknown bounds" << m_element.tail << m_element.head;
+      return;
+    }
+    GraphEdge* edge = new GraphEdge();
+    edge->setFromNode(tail);
+    edge->setToNode(head);
+    fillElement(edge);
+    if (!m_element.arrowheads.isEmpty() || m_element.arrowheads.hasPending())
+    {
+      edge->arrowheads() = m_element.arrowheads;
+    }
+    edge->setZ(m_maxZ + 1);
+    if (edge->id().isEmpty())
+    {
+      const QString key = edge->attributes().value("key");
+      const int ordinal = key.isEmpty() ? m_parallelEdges[qMakePair<GraphElement*, GraphElement*>(tail, head)]++ : 0;
+      edge->setId(GraphEdge::edgeId(tail->id(), head->id(), m_graph->directed(), key, ordinal));
+    }
+    m_graph->insertEdge(edge->id(), edge);
+  }
+  else if (m_element.index < m_subgraphCount)
+  {
+    GraphSubgraph* subgraph = new GraphSubgraph();
+    subgraph->setId(m_element.name);
+    fillElement(subgraph);
+    SubgraphContent& content = m_subgraphs[m_element.index];
+    content.subgraph = subgraph;
+    content.nodes.swap(m_element.nodes);
+    content.subgraphs.swap(m_element.subgraphs);
+  }
+  else
+  {
+    GraphNode* node = new GraphNode();
+    node->setId(m_element.name);
+    fillElement(node);
+    m_nodes.push_back(qMakePair(m_element.index, node));
+    m_nodesByIndex.insert(m_element.index, node);
+  }
+}
+
+void DotJsonParser::placeObjects()
+{
+  // the depth of the subgraphs, the top level ones being at depth 1
+  QHash<int, int> parents;
+  QHash<int, SubgraphContent>::const_iterator it = m_subgraphs.constBegin();
+  for (; it != m_subgraphs.constEnd(); it++)
+  {
+    for (int child : it.value().subgraphs)
+    {
+      parents.insert(child, it.key());
+    }
+  }
+  QHash<int, int> depths;
+  for (it = m_subgraphs.constBegin(); it != m_subgraphs.constEnd(); it++)
+  {
+    int depth = 1;
+    for (int parent = it.key(); parents.contains(parent) && depth <= m_subgraphs.size(); depth++)
+    {
+      parent = parents.value(parent);
+    }
+    depths.insert(it.key(), depth);
+    it.value().subgraph->setZ(1 + depth);
+    m_maxZ = qMax(m_maxZ, 1u + depth);
+    m_graph->insertSubgraph(it.value().subgraph->id(), it.value().subgraph);
+  }
+
+  // a node is in the innermost subgraph listing it
+  QHash<int, int> nodeSubgraphs;
+  for (it = m_subgraphs.constBegin(); it != m_subgraphs.constEnd(); it++)
+  {
+    for (int node : it.value().nodes)
+    {
+      QHash<int, int>::iterator known = nodeSubgraphs.find(node);
+      if (known == nodeSubgraphs.end())
+      {
+        nodeSubgraphs.insert(node, it.key());
+      }
+      else if (depths.value(it.key()) > depths.value(known.value()))
+      {
+        known.value() = it.key();
+      }
+    }
+  }
+  for (const QPair<int, GraphNode*>& node : m_nodes)
+  {
+    QHash<int, int>::const_iterator subgraph = nodeSubgraphs.constFind(node.first);
+    if (subgraph == nodeSubgraphs.constEnd())
+    {
+      node.second->setZ(2);
+      m_graph->insertNode(node.second->id(), node.second);
+    }
+    else
+    {
+      node.second->setZ(depths.value(subgraph.value()) + 2);
+      m_graph->insertInSubgraph(m_subgraphs[subgraph.value()].subgraph, node.second);
+    }
+  }
+  m_subgraphs.clear();
+  m_nodes.clear();
+}
+
+}
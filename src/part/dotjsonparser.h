@@ -0,0 +1,184 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+/*
+ * Parser of the JSON output of the Graphviz layout programs
+ */
+
+#ifndef DOT_JSON_PARSER_H
+#define DOT_JSON_PARSER_H
+
+#include "jsonreader.h"
+#include "dotattributes.h"
+#include "dotrenderop.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QPair>
+#include <QString>
+
+#include <string>
+#include <vector>
+
+class QIODevice;
+
+namespace KGraphViewer
+{
+
+class DotGraph;
+class GraphElement;
+class GraphNode;
+class GraphSubgraph;
+
+/**
+ * Builds a DotGraph from the output of a layout program run with -Tjson,
+ * while it is being read.
+ *
+ * In this format, the drawing operations are JSON objects: they are
+ * appended to the render operations of the elements as they are read,
+ * without going through the xdot text. The xdot strings given by -Tjson0
+ * are also accepted.
+ *
+ * The subgraphs and the nodes are listed first, then the edges, and the
+ * subgraphs reference their nodes by index. The nodes are thus only placed
+ * in the graph or in their innermost subgraph once all of them are known.
+ */
+class DotJsonParser : public JsonHandler
+{
+public:
+  explicit DotJsonParser(DotGraph* graph);
+  ~DotJsonParser() override;
+
+  /**
+   * Reads all the data currently available on device and builds the
+   * elements it completes.
+   * @return false on error
+   */
+  bool readFrom(QIODevice* device);
+
+  /**
+   * To be called once all the input has been read.
+   * @return true if a whole graph has been read
+   */
+  bool finish();
+
+private:
+  enum Context
+  {
+    GraphObject,
+    /** The subgraphs and the nodes */
+    ObjectArray,
+    EdgeArray,
+    ElementObject,
+    OperationArray,
+    OperationObject,
+    CoordinateArray,
+    StopArray,
+    StopObject,
+    /** The indexes of the nodes or subgraphs of a subgraph */
+    IndexArray,
+    Skipped
+  };
+
+  /** The subgraph, node or edge being read */
+  struct Element
+  {
+    int index;
+    QString name;
+    DotAttributes attributes;
+    DotRenderOpVec ops;
+    DotRenderOpVec arrowheads;
+    std::vector<int> nodes;
+    std::vector<int> subgraphs;
+    int tail;
+    int head;
+  };
+
+  /** The drawing operation being read */
+  struct Operation
+  {
+    char code;
+    QString text;
+    QString color;
+    std::vector<float> coordinates;
+    char align;
+    float width;
+    float size;
+    float flags;
+  };
+
+  /** A subgraph with the indexes of its nodes and subgraphs */
+  struct SubgraphContent
+  {
+    GraphSubgraph* subgraph;
+    std::vector<int> nodes;
+    std::vector<int> subgraphs;
+  };
+
+  bool startObject() override;
+  bool endObject() override;
+  bool startArray() override;
+  bool endArray() override;
+  bool key(const DotStringRef& name) override;
+  bool stringValue(const DotStringRef& value) override;
+  bool numberValue(double value) override;
+  bool boolValue(bool value) override;
+  bool nullValue() override;
+
+  inline Context currentContext() const {return m_contexts.empty() ? Skipped : m_contexts.back();}
+
+  /** Handles a member of the graph or of an element which is not structural */
+  void setAttribute(const QString& value);
+  void resetElement();
+  void finishOperation();
+  void finishElement();
+  /** Sets the attributes and operations read to element */
+  void fillElement(GraphElement* element);
+  /** Adds the subgraphs and nodes to the graph, once all are read */
+  void placeObjects();
+
+  DotGraph* m_graph;
+  JsonReader m_reader;
+  QByteArray m_buffer;
+  bool m_failed;
+
+  std::vector<Context> m_contexts;
+  /** The key of the current member */
+  std::string m_key;
+
+  QSharedPointer<DotRenderOpArena> m_arena;
+  DotAttributeValues m_attributeValues;
+  DotRenderOpVec m_graphOps;
+  /** Where the operations of the current array go */
+  DotRenderOpVec* m_ops;
+  bool m_opsAreArrowheads;
+  Operation m_operation;
+  Element m_element;
+
+  int m_subgraphCount;
+  QHash<int, SubgraphContent> m_subgraphs;
+  /** The nodes, by index, in the order they are read */
+  std::vector< QPair<int, GraphNode*> > m_nodes;
+  QHash<int, GraphNode*> m_nodesByIndex;
+  QHash< QPair<GraphElement*, GraphElement*>, int > m_parallelEdges;
+  unsigned int m_maxZ;
+};
+
+}
+
+#endif
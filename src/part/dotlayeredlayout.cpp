@@ -0,0 +1,679 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+#include "dotlayeredlayout.h"
+#include "dotnativelayout.h"
+#include "kgraphviewerlib_debug.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QPair>
+#include <QVector>
+
+#include <algorithm>
+#include <cmath>
+
+namespace KGraphViewer
+{
+
+namespace
+{
+
+/** The most passes moving the nodes to shorten the edges after their longest path ranking */
+const int maxRankingPasses = 8;
+/** The crossing reduction stops after this many sweeps down and up, or after this many without improvement */
+const int maxSweeps = 12;
+const int maxStaleSweeps = 2;
+/** The placement stops after this many iterations, or once no node moves by more than minimumMove points */
+const int maxPlacementIterations = 24;
+const float minimumMove = 0.5f;
+/** The pull of an edge between two real nodes, a real and a virtual one and two virtual ones, as in dot */
+const float realWeight = 1;
+const float mixedWeight = 2;
+const float virtualWeight = 8;
+/** The pull keeping a node without neighbors where it is */
+const float isolatedWeight = 0.01f;
+
+/**
+ * The graph cut in ranks, all its edges going down from a rank to the next
+ * one. The nodes of the graph come first, followed by the virtual nodes
+ * splitting the edges spanning several ranks.
+ */
+struct Hierarchy
+{
+  int realCount;
+  QVector<int> ranks;
+  QVector<float> widths;
+  /** The nodes of each rank, in order, and the position of each node in its rank */
+  QVector< QVector<int> > layers;
+  QVector<int> positions;
+  /**
+   * The neighbors of the node i in the rank above are above[aboveStarts[i]]
+   * to above[aboveStarts[i+1] - 1], and the same for the rank below
+   */
+  QVector<int> aboveStarts;
+  QVector<int> above;
+  QVector<int> belowStarts;
+  QVector<int> below;
+  /** The virtual nodes of the edge e, from top to bottom, are chains[chainStarts[e]] to chains[chainStarts[e+1] - 1] */
+  QVector<int> chainStarts;
+  QVector<int> chains;
+  /** The edges going up, reversed to break the cycles */
+  QVector<bool> reversed;
+
+  inline int nodeCount() const {return ranks.size();}
+  inline int rankCount() const {return layers.size();}
+  inline bool isVirtual(int v) const {return v >= realCount;}
+  inline float weight(int u, int v) const
+  {
+    return isVirtual(u) ? (isVirtual(v) ? virtualWeight : mixedWeight) : (isVirtual(v) ? mixedWeight : realWeight);
+  }
+};
+
+/** Fills starts and result with the targets of the arcs, by source, in the order of the arcs */
+void adjacency(int nodeCount, const QVector<int>& sources, const QVector<int>& targets,
+               QVector<int>& starts, QVector<int>& result)
+{
+  starts.fill(0, nodeCount + 1);
+  for (int source : sources)
+  {
+    starts[source + 1]++;
+  }
+  for (int i = 0; i < nodeCount; i++)
+  {
+    starts[i + 1] += starts[i];
+  }
+  QVector<int> next = starts;
+  result.resize(sources.size());
+  for (int a = 0; a < sources.size(); a++)
+  {
+    result[next[sources[a]]++] = targets[a];
+  }
+}
+
+/** The edges to reverse for graph to have no cycle: the back edges of a depth first search */
+QVector<bool> backEdges(const DotNativeGraph& graph)
+{
+  const int n = graph.nodeCount();
+  const int m = graph.edgeCount();
+  QVector<int> edgeIndexes(m);
+  for (int e = 0; e < m; e++)
+  {
+    edgeIndexes[e] = e;
+  }
+  QVector<int> starts;
+  QVector<int> outEdges;
+  adjacency(n, graph.tails, edgeIndexes, starts, outEdges);
+
+  QVector<bool> result(m, false);
+  // not visited yet, on the path of the search, done
+  enum State : char {New, Open, Closed};
+  QVector<char> states(n, New);
+  QVector<int> cursors = starts;
+  QVector<int> path;
+  for (int root = 0; root < n; root++)
+  {
+    if (states[root] != New)
+    {
+      continue;
+    }
+    states[root] = Open;
+    path.append(root);
+    while (!path.isEmpty())
+    {
+      const int v = path.last();
+      if (cursors[v] == starts[v + 1])
+      {
+        states[v] = Closed;
+        path.removeLast();
+        continue;
+      }
+      const int e = outEdges[cursors[v]++];
+      const int w = graph.heads[e];
+      if (states[w] == New)
+      {
+        states[w] = Open;
+        path.append(w);
+      }
+      else if (states[w] == Open && w != v)
+      {
+        result[e] = true;
+      }
+    }
+  }
+  return result;
+}
+
+/**
+ * The rank of each node: the length of its longest path from a source, then
+ * improved by moving the nodes with more successors than predecessors down,
+ * and the others up, as far as their neighbors allow, each move shortening
+ * the edges as a move of a node by the network simplex of dot would.
+ */
+QVector<int> ranksOf(const DotNativeGraph& graph, const QVector<bool>& reversed)
+{
+  const int n = graph.nodeCount();
+  QVector<int> uppers;
+  QVector<int> lowers;
+  for (int e = 0; e < graph.edgeCount(); e++)
+  {
+    if (graph.tails[e] != graph.heads[e])
+    {
+      uppers.append(reversed[e] ? graph.heads[e] : graph.tails[e]);
+      lowers.append(reversed[e] ? graph.tails[e] : graph.heads[e]);
+    }
+  }
+  QVector<int> successorStarts;
+  QVector<int> successors;
+  adjacency(n, uppers, lowers, successorStarts, successors);
+  QVector<int> predecessorStarts;
+  QVector<int> predecessors;
+  adjacency(n, lowers, uppers, predecessorStarts, predecessors);
+
+  // in topological order
+  QVector<int> ranks(n, 0);
+  QVector<int> remaining(n);
+  QVector<int> order;
+  order.reserve(n);
+  for (int v = 0; v < n; v++)
+  {
+    remaining[v] = predecessorStarts[v + 1] - predecessorStarts[v];
+    if (remaining[v] == 0)
+    {
+      order.append(v);
+    }
+  }
+  for (int i = 0; i < order.size(); i++)
+  {
+    const int v = order[i];
+    for (int j = successorStarts[v]; j < successorStarts[v + 1]; j++)
+    {
+      const int w = successors[j];
+      ranks[w] = qMax(ranks[w], ranks[v] + 1);
+      if (--remaining[w] == 0)
+      {
+        order.append(w);
+      }
+    }
+  }
+
+  for (int pass = 0; pass < maxRankingPasses; pass++)
+  {
+    bool moved = false;
+    for (int i = 0; i < n; i++)
+    {
+      // down from the bottom, then up from the top
+      const int v = order[(pass % 2 == 0) ? n - 1 - i : i];
+      const int predecessorCount = predecessorStarts[v + 1] - predecessorStarts[v];
+      const int successorCount = successorStarts[v + 1] - successorStarts[v];
+      int rank = ranks[v];
+      if (successorCount > predecessorCount)
+      {
+        rank = ranks[successors[successorStarts[v]]] - 1;
+        for (int j = successorStarts[v] + 1; j < successorStarts[v + 1]; j++)
+        {
+          rank = qMin(rank, ranks[successors[j]] - 1);
+        }
+      }
+      else if (predecessorCount > successorCount)
+      {
+        rank = 0;
+        for (int j = predecessorStarts[v]; j < predecessorStarts[v + 1]; j++)
+        {
+          rank = qMax(rank, ranks[predecessors[j]] + 1);
+        }
+      }
+      if (rank != ranks[v])
+      {
+        ranks[v] = rank;
+        moved = true;
+      }
+    }
+    if (!moved)
+    {
+      break;
+    }
+  }
+
+  // the ranks left empty are removed
+  int rankCount = 0;
+  for (int rank : ranks)
+  {
+    rankCount = qMax(rankCount, rank + 1);
+  }
+  QVector<int> newRanks(rankCount, 0);
+  for (int rank : ranks)
+  {
+    newRanks[rank] = 1;
+  }
+  for (int r = 1; r < rankCount; r++)
+  {
+    newRanks[r] += newRanks[r - 1];
+  }
+  for (int& rank : ranks)
+  {
+    rank = newRanks[rank] - 1;
+  }
+  return ranks;
+}
+
+/** Splits the edges of graph spanning several ranks with chains of virtual nodes */
+Hierarchy hierarchy(const DotNativeGraph& graph, const QVector<bool>& reversed, const QVector<int>& ranks)
+{
+  const int n = graph.nodeCount();
+  const int m = graph.edgeCount();
+  Hierarchy h;
+  h.realCount = n;
+  h.ranks = ranks;
+  h.widths = graph.widths;
+  h.reversed = reversed;
+  h.chainStarts.reserve(m + 1);
+  // the segments of the edges, from top to bottom
+  QVector<int> uppers;
+  QVector<int> lowers;
+  for (int e = 0; e < m; e++)
+  {
+    h.chainStarts.append(h.chains.size());
+    if (graph.tails[e] == graph.heads[e])
+    {
+      continue;
+    }
+    const int upper = reversed[e] ? graph.heads[e] : graph.tails[e];
+    const int lower = reversed[e] ? graph.tails[e] : graph.heads[e];
+    int previous = upper;
+    for (int r = ranks[upper] + 1; r < ranks[lower]; r++)
+    {
+      const int v = h.ranks.size();
+      h.ranks.append(r);
+      h.widths.append(0);
+      h.chains.append(v);
+      uppers.append(previous);
+      lowers.append(v);
+      previous = v;
+    }
+    uppers.append(previous);
+    lowers.append(lower);
+  }
+  h.chainStarts.append(h.chains.size());
+  adjacency(h.nodeCount(), uppers, lowers, h.belowStarts, h.below);
+  adjacency(h.nodeCount(), lowers, uppers, h.aboveStarts, h.above);
+
+  int rankCount = 0;
+  for (int rank : ranks)
+  {
+    rankCount = qMax(rankCount, rank + 1);
+  }
+  h.layers.resize(rankCount);
+  h.positions.resize(h.nodeCount());
+  for (int v = 0; v < h.nodeCount(); v++)
+  {
+    QVector<int>& layer = h.layers[h.ranks[v]];
+    h.positions[v] = layer.size();
+    layer.append(v);
+  }
+  return h;
+}
+
+/**
+ * Sorts the rank r by the barycenter of the positions of the neighbors of
+ * its nodes in the rank above, or below. The nodes without such neighbors
+ * keep their relative position.
+ */
+void sortRank(Hierarchy& h, int r, bool downward)
+{
+  QVector<int>& layer = h.layers[r];
+  const int count = layer.size();
+  const int referenceCount = h.layers[downward ? r - 1 : r + 1].size();
+  const QVector<int>& starts = downward ? h.aboveStarts : h.belowStarts;
+  const QVector<int>& neighbors = downward ? h.above : h.below;
+  QVector< QPair<float, int> > keys(count);
+  DotNativeLayout::parallelFor(count, [&](int begin, int end) {
+    for (int i = begin; i < end; i++)
+    {
+      const int v = layer[i];
+      if (starts[v] == starts[v + 1])
+      {
+        keys[i] = qMakePair(float(i) * referenceCount / count, i);
+        continue;
+      }
+      float sum = 0;
+      for (int j = starts[v]; j < starts[v + 1]; j++)
+      {
+        sum += h.positions[neighbors[j]];
+      }
+      keys[i] = qMakePair(sum / (starts[v + 1] - starts[v]), i);
+    }
+  });
+  // the ties keep their order
+  std::sort(keys.begin(), keys.end());
+  QVector<int> sorted(count);
+  for (int i = 0; i < count; i++)
+  {
+    sorted[i] = layer[keys[i].second];
+    h.positions[sorted[i]] = i;
+  }
+  layer.swap(sorted);
+}
+
+/**
+ * The number of crossings between the ranks r and r + 1: the inversions of
+ * the positions of the lower ends of the segments, in the order of their
+ * upper ends, counted with a Fenwick tree.
+ */
+qint64 crossings(const Hierarchy& h, int r)
+{
+  const int count = h.layers[r + 1].size();
+  QVector<int> tree(count + 1, 0);
+  QVector<int> ends;
+  qint64 result = 0;
+  int inserted = 0;
+  for (int v : h.layers[r])
+  {
+    ends.clear();
+    for (int j = h.belowStarts[v]; j < h.belowStarts[v + 1]; j++)
+    {
+      ends.append(h.positions[h.below[j]]);
+    }
+    std::sort(ends.begin(), ends.end());
+    // the segments of v do not cross each other
+    for (int end : ends)
+    {
+      int notRight = 0;
+      for (int i = end + 1; i > 0; i -= i & -i)
+      {
+        notRight += tree[i];
+      }
+      result += inserted - notRight;
+    }
+    for (int end : ends)
+    {
+      for (int i = end + 1; i <= count; i += i & -i)
+      {
+        tree[i]++;
+      }
+      inserted++;
+    }
+  }
+  return result;
+}
+
+/** The number of crossings between all the ranks, counted in parallel */
+qint64 crossings(const Hierarchy& h)
+{
+  const int pairCount = h.rankCount() - 1;
+  if (pairCount <= 0)
+  {
+    return 0;
+  }
+  QVector<qint64> counts(pairCount);
+  DotNativeLayout::parallelFor(pairCount, [&](int begin, int end) {
+    for (int r = begin; r < end; r++)
+    {
+      counts[r] = crossings(h, r);
+    }
+  }, 1);
+  qint64 result = 0;
+  for (qint64 count : counts)
+  {
+    result += count;
+  }
+  return result;
+}
+
+/**
+ * Reduces the crossings by sorting the ranks by barycenter, from the top to
+ * the bottom then back, keeping the best order found.
+ * @return false if cancelled
+ */
+bool orderRanks(Hierarchy& h, const QAtomicInt* cancelled)
+{
+  qint64 best = crossings(h);
+  QVector< QVector<int> > bestLayers = h.layers;
+  int staleSweeps = 0;
+  for (int sweep = 0; sweep < maxSweeps && best > 0 && staleSweeps < maxStaleSweeps; sweep++)
+  {
+    if (DotNativeLayout::isCancelled(cancelled))
+    {
+      return false;
+    }
+    for (int r = 1; r < h.rankCount(); r++)
+    {
+      sortRank(h, r, true);
+    }
+    for (int r = h.rankCount() - 2; r >= 0; r--)
+    {
+      sortRank(h, r, false);
+    }
+    const qint64 count = crossings(h);
+    if (count < best)
+    {
+      best = count;
+      bestLayers = h.layers;
+      staleSweeps = 0;
+    }
+    else
+    {
+      staleSweeps++;
+    }
+  }
+  h.layers = bestLayers;
+  for (const QVector<int>& layer : h.layers)
+  {
+    for (int i = 0; i < layer.size(); i++)
+    {
+      h.positions[layer[i]] = i;
+    }
+  }
+  qCDebug(KGRAPHVIEWERLIB_LOG) << best << "crossings left";
+  return true;
+}
+
+/**
+ * Places the nodes of the rank r at the weighted mean of the positions of
+ * their neighbors, or as close to it as their order and separation allow.
+ * Shifting each position by the room taken by the nodes on its left, this
+ * is the isotonic regression of the shifted means, solved by pooling the
+ * adjacent violators.
+ * @return the largest move of a node of the rank
+ */
+float placeRank(const Hierarchy& h, int r, float separation, QVector<float>& x)
+{
+  // consecutive nodes placed together, at the mean of their shifted means
+  struct Block
+  {
+    float weight;
+    float sum;
+    int end;
+  };
+  const QVector<int>& layer = h.layers[r];
+  const int count = layer.size();
+  QVector<float> shifts(count);
+  QVector<Block> blocks;
+  float shift = 0;
+  for (int i = 0; i < count; i++)
+  {
+    const int v = layer[i];
+    if (i > 0)
+    {
+      shift += (h.widths[layer[i - 1]] + h.widths[v]) / 2 + separation;
+    }
+    shifts[i] = shift;
+    float weight = 0;
+    float sum = 0;
+    for (int j = h.aboveStarts[v]; j < h.aboveStarts[v + 1]; j++)
+    {
+      const float w = h.weight(h.above[j], v);
+      weight += w;
+      sum += w * x[h.above[j]];
+    }
+    for (int j = h.belowStarts[v]; j < h.belowStarts[v + 1]; j++)
+    {
+      const float w = h.weight(v, h.below[j]);
+      weight += w;
+      sum += w * x[h.below[j]];
+    }
+    if (weight == 0)
+    {
+      weight = isolatedWeight;
+      sum = weight * x[v];
+    }
+    Block block = {weight, sum - weight * shift, i + 1};
+    while (!blocks.isEmpty() && blocks.last().sum * block.weight > block.sum * blocks.last().weight)
+    {
+      block.weight += blocks.last().weight;
+      block.sum += blocks.last().sum;
+      blocks.removeLast();
+    }
+    blocks.append(block);
+  }
+  float move = 0;
+  int i = 0;
+  for (const Block& block : blocks)
+  {
+    const float position = block.sum / block.weight;
+    for (; i < block.end; i++)
+    {
+      const float newX = position + shifts[i];
+      move = qMax(move, std::abs(newX - x[layer[i]]));
+      x[layer[i]] = newX;
+    }
+  }
+  return move;
+}
+
+/**
+ * Sets the horizontal positions of the nodes, starting from the ranks packed
+ * and centered, and placing the even ranks in parallel, then the odd ones,
+ * until they settle.
+ * @return false if cancelled
+ */
+bool placeNodes(const Hierarchy& h, float separation, QVector<float>& x, const QAtomicInt* cancelled)
+{
+  x.fill(0, h.nodeCount());
+  for (const QVector<int>& layer : h.layers)
+  {
+    QVector<float> shifts(layer.size());
+    float shift = 0;
+    for (int i = 1; i < layer.size(); i++)
+    {
+      shift += (h.widths[layer[i - 1]] + h.widths[layer[i]]) / 2 + separation;
+      shifts[i] = shift;
+    }
+    for (int i = 0; i < layer.size(); i++)
+    {
+      x[layer[i]] = shifts[i] - shift / 2;
+    }
+  }
+
+  const int rankCount = h.rankCount();
+  QVector<float> moves(rankCount, 0.f);
+  int iteration = 0;
+  for (; iteration < maxPlacementIterations; iteration++)
+  {
+    if (DotNativeLayout::isCancelled(cancelled))
+    {
+      return false;
+    }
+    // the neighbors of the nodes of a rank are in the ranks of the other parity
+    for (int parity = 0; parity < 2; parity++)
+    {
+      DotNativeLayout::parallelFor((rankCount + 1 - parity) / 2, [&](int begin, int end) {
+        for (int i = begin; i < end; i++)
+        {
+          const int r = 2 * i + parity;
+          moves[r] = placeRank(h, r, separation, x);
+        }
+      }, 1);
+    }
+    if (*std::max_element(moves.constBegin(), moves.constEnd()) < minimumMove)
+    {
+      break;
+    }
+  }
+  qCDebug(KGRAPHVIEWERLIB_LOG) << "nodes placed in" << iteration << "iterations";
+  return true;
+}
+
+}
+
+bool DotLayeredLayout::layout(DotNativeGraph& graph, const QAtomicInt* cancelled)
+{
+  QElapsedTimer timer;
+  timer.start();
+  const int n = graph.nodeCount();
+  const int m = graph.edgeCount();
+  graph.x.resize(n);
+  graph.y.resize(n);
+  graph.bendStarts.clear();
+  graph.bends.clear();
+  if (n == 0)
+  {
+    return true;
+  }
+
+  const QVector<bool> reversed = backEdges(graph);
+  Hierarchy h = hierarchy(graph, reversed, ranksOf(graph, reversed));
+  qCDebug(KGRAPHVIEWERLIB_LOG) << n << "nodes in" << h.rankCount() << "ranks with" << h.nodeCount() - n << "virtual nodes";
+  if (!orderRanks(h, cancelled))
+  {
+    return false;
+  }
+  QVector<float> x;
+  if (!placeNodes(h, graph.nodeSeparation, x, cancelled))
+  {
+    return false;
+  }
+
+  // the ranks are as high as their highest node, the first one at the top
+  QVector<float> heights(h.rankCount(), 0.f);
+  for (int v = 0; v < n; v++)
+  {
+    heights[h.ranks[v]] = qMax(heights[h.ranks[v]], graph.heights[v]);
+  }
+  QVector<float> rankY(h.rankCount(), 0.f);
+  for (int r = 1; r < h.rankCount(); r++)
+  {
+    rankY[r] = rankY[r - 1] - (heights[r - 1] + heights[r]) / 2 - graph.rankSeparation;
+  }
+
+  for (int v = 0; v < n; v++)
+  {
+    graph.x[v] = x[v];
+    graph.y[v] = rankY[h.ranks[v]];
+  }
+  // the virtual nodes are the bends, from the tail to the head
+  graph.bendStarts.reserve(m + 1);
+  graph.bends.reserve(2 * h.chains.size());
+  for (int e = 0; e < m; e++)
+  {
+    graph.bendStarts.append(graph.bends.size() / 2);
+    const int first = h.chainStarts[e];
+    const int last = h.chainStarts[e + 1] - 1;
+    for (int c = first; c <= last; c++)
+    {
+      const int v = h.chains[reversed[e] ? first + last - c : c];
+      graph.bends.append(x[v]);
+      graph.bends.append(rankY[h.ranks[v]]);
+    }
+  }
+  graph.bendStarts.append(graph.bends.size() / 2);
+  qCDebug(KGRAPHVIEWERLIB_LOG) << n << "nodes laid out in" << h.rankCount() << "ranks in" << timer.elapsed() << "ms";
+  return true;
+}
+
+}
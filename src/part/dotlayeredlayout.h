@@ -0,0 +1,63 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+/*
+ * Built-in layered layout engine
+ */
+
+#ifndef DOT_LAYERED_LAYOUT_H
+#define DOT_LAYERED_LAYOUT_H
+
+#include <QAtomicInt>
+
+namespace KGraphViewer
+{
+
+struct DotNativeGraph;
+
+/**
+ * A layered layout for large directed graphs, following the steps of
+ * Sugiyama et al. as dot does, with simpler and faster heuristics at each
+ * step.
+ *
+ * The cycles are broken by reversing the back edges of a depth first
+ * search. The nodes are ranked by their longest path from the sources, then
+ * moved between their neighbors to shorten the edges, and the edges spanning
+ * several ranks get a chain of virtual nodes. The crossings are
+ * reduced by sorting the ranks by barycenter, sweeping down and up while the
+ * number of crossings, counted in parallel for all the pairs of ranks,
+ * decreases. Finally, the nodes are pulled towards their neighbors, the even
+ * and the odd ranks in turn, each rank being placed in parallel with the
+ * others as the closest positions keeping the order and the separation of
+ * its nodes. The virtual nodes give the bends of the edges.
+ *
+ * The ranks go from top to bottom.
+ */
+class DotLayeredLayout
+{
+public:
+  /**
+   * Sets the positions of the nodes of graph and the bends of its edges.
+   * @return false if cancelled
+   */
+  static bool layout(DotNativeGraph& graph, const QAtomicInt* cancelled = nullptr);
+};
+
+}
+
+#endif
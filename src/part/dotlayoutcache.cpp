@@ -0,0 +1,175 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+#include "dotlayoutcache.h"
+#include "dotcontextpool.h"
+#include "dotlayoutpreset.h"
+#include "kgraphviewer_partsettings.h"
+#include "kgraphviewerlib_debug.h"
+
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
+
+#include <graphviz/gvc.h>
+
+namespace KGraphViewer
+{
+
+namespace
+{
+
+QAtomicInt hits;
+QAtomicInt misses;
+QAtomicInt newEntries;
+
+const QString entrySuffix = QStringLiteral(".layout");
+
+}
+
+bool DotLayoutCache::isEnabled()
+{
+  return KGraphViewerPartSettings::layoutCacheEnabled();
+}
+
+QString DotLayoutCache::directory()
+{
+  return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/kgraphviewer/layouts");
+}
+
+QString DotLayoutCache::entryPath(const QByteArray& key)
+{
+  return directory() + QLatin1Char('/') + QString::fromLatin1(key) + entrySuffix;
+}
+
+const QString& DotLayoutCache::graphvizVersion()
+{
+  // the layout programs are installed with the library
+  static const QString version = []()
+  {
+    DotContext gvc;
+    return QString::fromUtf8(gvcVersion(gvc));
+  }();
+  return version;
+}
+
+QByteArray DotLayoutCache::key(const QByteArray& contentHash, const QString& layoutCommand, const QString& format)
+{
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+  hash.addData(contentHash);
+  hash.addData(QByteArray(1, '\0'));
+  hash.addData(layoutCommand.toUtf8());
+  hash.addData(QByteArray(1, '\0'));
+  hash.addData(format.toUtf8());
+  hash.addData(QByteArray(1, '\0'));
+  hash.addData(graphvizVersion().toUtf8());
+  // the attributes of the preset change the layout
+  hash.addData(QByteArray(1, '\0'));
+  hash.addData(DotLayoutPreset::commandLineOptions().join(QLatin1Char(' ')).toUtf8());
+  return hash.result().toHex();
+}
+
+QString DotLayoutCache::find(const QByteArray& key)
+{
+  const QString path = entryPath(key);
+  QFile entry(path);
+  if (!entry.exists())
+  {
+    misses.ref();
+    qCDebug(KGRAPHVIEWERLIB_LOG) << "layout cache miss," << hits.load() << "hits and" << misses.load() << "misses";
+    return QString();
+  }
+  // the modification time orders the entries by last use
+  if (entry.open(QIODevice::ReadWrite))
+  {
+    entry.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+  }
+  hits.ref();
+  qCDebug(KGRAPHVIEWERLIB_LOG) << "layout cache hit," << hits.load() << "hits and" << misses.load() << "misses";
+  return path;
+}
+
+QString DotLayoutCache::newEntryPath(const QByteArray& key)
+{
+  QDir().mkpath(directory());
+  return directory() + QLatin1Char('/') + QString::fromLatin1(key) + QLatin1Char('-')
+      + QString::number(QCoreApplication::applicationPid()) + QLatin1Char('-')
+      + QString::number(newEntries.fetchAndAddRelaxed(1)) + QLatin1String(".part");
+}
+
+bool DotLayoutCache::store(const QByteArray& key, const QString& path)
+{
+  const QString entry = entryPath(key);
+  QFile::remove(entry);
+  if (!QFile::rename(path, entry))
+  {
+    qCWarning(KGRAPHVIEWERLIB_LOG) << "Failed to store the layout in" << entry;
+    QFile::remove(path);
+    return false;
+  }
+  qCDebug(KGRAPHVIEWERLIB_LOG) << "layout stored in cache" << entry;
+  evict();
+  return true;
+}
+
+void DotLayoutCache::discard(const QString& path)
+{
+  QFile::remove(path);
+}
+
+void DotLayoutCache::evict()
+{
+  const qint64 maxSize = qint64(KGraphViewerPartSettings::layoutCacheSize()) << 20;
+  const QDir dir(directory());
+
+  // the parts left by interrupted writes
+  const QDateTime yesterday = QDateTime::currentDateTime().addDays(-1);
+  for (const QFileInfo& part : dir.entryInfoList(QStringList(QStringLiteral("*.part")), QDir::Files))
+  {
+    if (part.lastModified() < yesterday)
+    {
+      QFile::remove(part.absoluteFilePath());
+    }
+  }
+
+  // the least recently used first
+  const QFileInfoList entries = dir.entryInfoList(QStringList(QLatin1Char('*') + entrySuffix), QDir::Files, QDir::Time | QDir::Reversed);
+  qint64 size = 0;
+  for (const QFileInfo& entry : entries)
+  {
+    size += entry.size();
+  }
+  for (const QFileInfo& entry : entries)
+  {
+    if (size <= maxSize)
+    {
+      break;
+    }
+    qCDebug(KGRAPHVIEWERLIB_LOG) << "layout cache full, removing" << entry.fileName();
+    size -= entry.size();
+    QFile::remove(entry.absoluteFilePath());
+  }
+}
+
+}
@@ -0,0 +1,76 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+/*
+ * On disk cache of the laid out graphs
+ */
+
+#ifndef DOT_LAYOUT_CACHE_H
+#define DOT_LAYOUT_CACHE_H
+
+#include <QByteArray>
+#include <QString>
+
+namespace KGraphViewer
+{
+
+/**
+ * Keeps the output of the layouts in the user cache directory, so that
+ * reopening a graph which did not change does not run the layout again.
+ *
+ * An entry is identified by the hash of the graph content, the layout
+ * program, the output format, the Graphviz version and the attributes of
+ * the layout preset. The size of the cache is bounded: the entries used
+ * least recently are removed first.
+ */
+class DotLayoutCache
+{
+public:
+  /** true if the cache is enabled in the settings */
+  static bool isEnabled();
+
+  /** The key of the layout by layoutCommand, in format, of the content hashed as contentHash */
+  static QByteArray key(const QByteArray& contentHash, const QString& layoutCommand, const QString& format);
+
+  /**
+   * The file holding the layout of key, marked as used.
+   * @return an empty string if there is no such layout
+   */
+  static QString find(const QByteArray& key);
+
+  /**
+   * A new file where to write the layout of key, to be given to store()
+   * once complete or to discard() on failure.
+   */
+  static QString newEntryPath(const QByteArray& key);
+
+  /** Makes the layout written in path the entry of key, then bounds the cache size */
+  static bool store(const QByteArray& key, const QString& path);
+  static void discard(const QString& path);
+
+private:
+  static QString directory();
+  static QString entryPath(const QByteArray& key);
+  static const QString& graphvizVersion();
+  /** Removes the least recently used entries until the cache fits in its size */
+  static void evict();
+};
+
+}
+
+#endif
@@ -0,0 +1,311 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+#include "dotlayoutchooser.h"
+#include "dotinput.h"
+#include "dotlexer.h"
+#include "dotnativelayout.h"
+#include "kgraphviewer_partsettings.h"
+#include "kgraphviewerlib_debug.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QFileInfo>
+#include <QSet>
+#include <QStandardPaths>
+#include <QStringList>
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace KGraphViewer
+{
+
+namespace
+{
+
+/** The timed layouts are kept in this file, the ones timed the longest ago being forgotten */
+const char historyFile[] = "kgraphviewer_layouthistoryrc";
+const char historyGroup[] = "Durations";
+const int maxHistorySize = 1000;
+
+KConfigGroup history()
+{
+  return KConfigGroup(KSharedConfig::openConfig(QLatin1String(historyFile), KConfig::SimpleConfig,
+                                                QStandardPaths::GenericDataLocation),
+                      historyGroup);
+}
+
+/** The history entry of the layout of fileName by layoutCommand */
+QString historyKey(const QString& fileName, const QString& layoutCommand)
+{
+  const QByteArray text = QFileInfo(fileName).absoluteFilePath().toUtf8() + '\n' + layoutCommand.toUtf8();
+  return QString::fromLatin1(QCryptographicHash::hash(text, QCryptographicHash::Sha1).toHex());
+}
+
+/** The programs suited to a graph of statistics, from the best looking to the fastest */
+QStringList candidates(const DotLayoutChooser::GraphStatistics& statistics)
+{
+  QStringList result;
+  if (statistics.directed)
+  {
+    result << QStringLiteral("dot") << DotNativeLayout::layeredCommand() << QStringLiteral("sfdp");
+  }
+  else
+  {
+    result << (statistics.clusterCount > 0 ? QStringLiteral("fdp") : QStringLiteral("neato")) << QStringLiteral("sfdp");
+  }
+  return result;
+}
+
+int clusterCount(graph_t* graph)
+{
+  int result = 0;
+  for (graph_t* subgraph = agfstsubg(graph); subgraph; subgraph = agnxtsubg(subgraph))
+  {
+    if (strncmp(agnameof(subgraph), "cluster", 7) == 0)
+    {
+      result++;
+    }
+    result += clusterCount(subgraph);
+  }
+  return result;
+}
+
+inline bool isStatementKeyword(const DotToken& token)
+{
+  return token.isKeyword("node") || token.isKeyword("edge") || token.isKeyword("graph") || token.isKeyword("subgraph");
+}
+
+}
+
+bool DotLayoutChooser::isEnabled()
+{
+  return KGraphViewerPartSettings::layoutAutomaticChoice();
+}
+
+DotLayoutChooser::GraphStatistics DotLayoutChooser::statistics(graph_t* graph)
+{
+  GraphStatistics result;
+  result.directed = agisdirected(graph);
+  result.nodeCount = agnnodes(graph);
+  result.edgeCount = agnedges(graph);
+  result.clusterCount = clusterCount(graph);
+  return result;
+}
+
+bool DotLayoutChooser::statistics(const DotInput& input, GraphStatistics& result)
+{
+  if (input.isCompressed() || input.isStream() || input.data() == nullptr || input.size() == 0)
+  {
+    return false;
+  }
+  result = GraphStatistics();
+  // the node ids, referencing the content
+  QSet<QByteArray> names;
+  DotLexer lexer(input.data(), input.data() + input.size());
+  DotToken previous;
+  bool header = true;
+  int brackets = 0;
+  // an id is a node unless it is followed by =
+  DotStringRef pending;
+  for (DotToken token = lexer.next(); token.type != DotToken::End && token.type != DotToken::Incomplete
+       && token.type != DotToken::Error; previous = token, token = lexer.next())
+  {
+    if (!pending.isEmpty() && token.type != DotToken::Equal)
+    {
+      names.insert(QByteArray::fromRawData(pending.first, int(pending.size())));
+    }
+    pending = DotStringRef();
+    if (header)
+    {
+      if (token.isKeyword("digraph") || token.isKeyword("graph"))
+      {
+        result.directed = token.isKeyword("digraph");
+      }
+      header = (token.type != DotToken::LeftBrace);
+      continue;
+    }
+    if (token.type == DotToken::LeftBracket)
+    {
+      brackets++;
+    }
+    else if (token.type == DotToken::RightBracket)
+    {
+      brackets--;
+    }
+    else if (brackets > 0)
+    {
+      continue;
+    }
+    else if (token.type == DotToken::EdgeOp)
+    {
+      result.edgeCount++;
+    }
+    else if (token.isId() && previous.isKeyword("subgraph"))
+    {
+      const DotStringRef name = token.value();
+      if (name.size() >= 7 && strncmp(name.first, "cluster", 7) == 0)
+      {
+        result.clusterCount++;
+      }
+    }
+    else if (token.isId() && !isStatementKeyword(token)
+             && previous.type != DotToken::Colon && previous.type != DotToken::Equal)
+    {
+      pending = token.value();
+    }
+  }
+  if (!pending.isEmpty())
+  {
+    names.insert(QByteArray::fromRawData(pending.first, int(pending.size())));
+  }
+  result.nodeCount = names.size();
+  return true;
+}
+
+QString DotLayoutChooser::choose(const QString& fileName, const GraphStatistics& statistics)
+{
+  if (!isEnabled())
+  {
+    return statistics.directed ? QStringLiteral("dot") : QStringLiteral("neato");
+  }
+  const double budget = 1000.0 * KGraphViewerPartSettings::layoutTimeBudget();
+  for (const QString& layoutCommand : candidates(statistics))
+  {
+    const double duration = expectedDuration(fileName, layoutCommand, statistics);
+    if (duration <= budget)
+    {
+      qCDebug(KGRAPHVIEWERLIB_LOG) << "laying out" << fileName << "with" << statistics.nodeCount << "nodes and"
+                                   << statistics.edgeCount << "edges by" << layoutCommand << "expected in" << duration << "ms";
+      return layoutCommand;
+    }
+  }
+  qCDebug(KGRAPHVIEWERLIB_LOG) << "no layout program expected to lay out" << fileName << "with" << statistics.nodeCount
+                               << "nodes and" << statistics.edgeCount << "edges in" << budget << "ms";
+  return DotNativeLayout::forceDirectedCommand();
+}
+
+QString DotLayoutChooser::choose(const QString& fileName, graph_t* graph)
+{
+  return choose(fileName, statistics(graph));
+}
+
+QString DotLayoutChooser::choose(const QString& fileName, const DotInput& input)
+{
+  GraphStatistics graphStatistics;
+  if (!isEnabled() || !statistics(input, graphStatistics))
+  {
+    return input.layoutCommand();
+  }
+  return choose(fileName, graphStatistics);
+}
+
+void DotLayoutChooser::recordDuration(const QString& fileName, const QString& layoutCommand, int elementCount, qint64 milliseconds)
+{
+  if (fileName.isEmpty() || layoutCommand.isEmpty() || elementCount <= 0)
+  {
+    return;
+  }
+  KConfigGroup group = history();
+  const QString key = historyKey(fileName, layoutCommand);
+  if (!group.hasKey(key))
+  {
+    const QMap<QString, QString> entries = group.entryMap();
+    if (entries.size() >= maxHistorySize)
+    {
+      QString oldestKey;
+      qint64 oldest = std::numeric_limits<qint64>::max();
+      for (auto it = entries.constBegin(); it != entries.constEnd(); ++it)
+      {
+        const qint64 time = it.value().section(QLatin1Char(','), 2, 2).toLongLong();
+        if (time < oldest)
+        {
+          oldest = time;
+          oldestKey = it.key();
+        }
+      }
+      group.deleteEntry(oldestKey);
+    }
+  }
+  // the duration, the size of the graph and when it was laid out
+  group.writeEntry(key, QString::number(milliseconds) % QLatin1Char(',') % QString::number(elementCount)
+                        % QLatin1Char(',') % QString::number(QDateTime::currentMSecsSinceEpoch() / 1000));
+  group.sync();
+}
+
+double DotLayoutChooser::estimatedDuration(const QString& layoutCommand, const GraphStatistics& statistics)
+{
+  const double nodes = statistics.nodeCount;
+  const double edges = statistics.edgeCount;
+  const double size = nodes + edges;
+  // orders of magnitude measured on a single core, in ms
+  if (layoutCommand == QLatin1String("dot"))
+  {
+    // the crossing reduction and the network simplex grow faster than the
+    // graph, and even more on dense graphs and with clusters
+    return 0.002 * std::pow(size, 1.5) * qMax(1.0, statistics.density() / 4) * (statistics.clusterCount > 0 ? 2 : 1);
+  }
+  if (layoutCommand == QLatin1String("neato") || layoutCommand == QLatin1String("fdp"))
+  {
+    // the distances between all the pairs of nodes
+    return (layoutCommand == QLatin1String("fdp") ? 5e-4 : 2e-4) * nodes * nodes + 0.01 * edges;
+  }
+  if (layoutCommand == QLatin1String("sfdp"))
+  {
+    return 0.02 * size * std::log2(size + 2);
+  }
+  if (layoutCommand == DotNativeLayout::layeredCommand())
+  {
+    // with the virtual nodes of the long edges of dense graphs
+    return 0.01 * size * qMax(1.0, statistics.density() / 4);
+  }
+  return 0.005 * size;
+}
+
+double DotLayoutChooser::expectedDuration(const QString& fileName, const QString& layoutCommand, const GraphStatistics& statistics)
+{
+  const double estimated = estimatedDuration(layoutCommand, statistics);
+  const qint64 size = statistics.nodeCount + statistics.edgeCount;
+  if (fileName.isEmpty() || size == 0)
+  {
+    return estimated;
+  }
+  const QStringList fields = history().readEntry(historyKey(fileName, layoutCommand), QString()).split(QLatin1Char(','));
+  bool durationRead = false;
+  bool sizeRead = false;
+  const double duration = fields.value(0).toDouble(&durationRead);
+  const double recordedSize = fields.value(1).toDouble(&sizeRead);
+  if (!durationRead || !sizeRead || recordedSize <= 0)
+  {
+    return estimated;
+  }
+  // scaled as the estimations if the graph changed since
+  GraphStatistics recorded = statistics;
+  recorded.nodeCount = qint64(statistics.nodeCount * recordedSize / size);
+  recorded.edgeCount = qint64(statistics.edgeCount * recordedSize / size);
+  const double recordedEstimation = estimatedDuration(layoutCommand, recorded);
+  return recordedEstimation > 0 ? duration * estimated / recordedEstimation : duration;
+}
+
+}
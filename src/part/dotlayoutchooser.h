@@ -0,0 +1,103 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+/*
+ * Automatic choice of the layout program of a graph
+ */
+
+#ifndef DOT_LAYOUT_CHOOSER_H
+#define DOT_LAYOUT_CHOOSER_H
+
+#include <QString>
+
+#include <graphviz/gvc.h>
+
+namespace KGraphViewer
+{
+
+class DotInput;
+
+/**
+ * Chooses the layout program of a graph the user did not choose one for, so
+ * that it is laid out within the time budget of the settings.
+ *
+ * The programs suited to the graph are tried from the best looking to the
+ * fastest: dot, the built-in layered engine then sfdp for a directed graph,
+ * neato, or fdp if it has clusters, then sfdp for an undirected one. The
+ * first one expected to be fast enough is chosen, and the built-in force
+ * directed engine, with its straight edges, otherwise. The durations are
+ * estimated from the numbers of nodes, edges and clusters, unless a layout
+ * of the same file by the same program was already timed.
+ */
+class DotLayoutChooser
+{
+public:
+  /** What the choice depends on in a graph */
+  struct GraphStatistics
+  {
+    GraphStatistics() : directed(true), nodeCount(0), edgeCount(0), clusterCount(0) {}
+
+    /** The average number of edges of a node */
+    inline double density() const {return nodeCount > 0 ? 2.0 * edgeCount / nodeCount : 0;}
+
+    bool directed;
+    qint64 nodeCount;
+    qint64 edgeCount;
+    int clusterCount;
+  };
+
+  /** true if the layout program is chosen by size in the settings, instead of by the graph type only */
+  static bool isEnabled();
+
+  static GraphStatistics statistics(graph_t* graph);
+
+  /**
+   * The statistics of the content of input, counted on its tokens without
+   * building the graph: the edges are the edge operators and the nodes the
+   * distinct ids of the statements.
+   * @return false if the content is not available, for a compressed file
+   * or a stream, or empty
+   */
+  static bool statistics(const DotInput& input, GraphStatistics& result);
+
+  /** The layout command for a graph of statistics read from fileName */
+  static QString choose(const QString& fileName, const GraphStatistics& statistics);
+  static QString choose(const QString& fileName, graph_t* graph);
+  /**
+   * The layout command for the graph read from input, by the graph type only
+   * if its content is not available.
+   * @return an empty string if the file is empty
+   */
+  static QString choose(const QString& fileName, const DotInput& input);
+
+  /** Keeps how long the layout of fileName, of elementCount nodes and edges, by layoutCommand took */
+  static void recordDuration(const QString& fileName, const QString& layoutCommand, int elementCount, qint64 milliseconds);
+
+private:
+  /** The expected duration of the layout of a graph of statistics by layoutCommand, in ms */
+  static double estimatedDuration(const QString& layoutCommand, const GraphStatistics& statistics);
+  /**
+   * The duration of the layout of fileName by layoutCommand, the one
+   * recorded if any, scaled to the size of the graph, or the estimated one.
+   */
+  static double expectedDuration(const QString& fileName, const QString& layoutCommand, const GraphStatistics& statistics);
+};
+
+}
+
+#endif
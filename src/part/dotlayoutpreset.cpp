@@ -0,0 +1,116 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+#include "dotlayoutpreset.h"
+#include "kgraphviewer_partsettings.h"
+#include "kgraphviewerlib_debug.h"
+
+#include <QDebug>
+
+#include <klocalizedstring.h>
+
+namespace KGraphViewer
+{
+
+DotLayoutPreset::Attributes DotLayoutPreset::attributes()
+{
+  Attributes result;
+  switch (KGraphViewerPartSettings::layoutPreset())
+  {
+  case KGraphViewerPartSettings::EnumLayoutPreset::Fast:
+    // network simplex iterations per node, for the positions then the ranks
+    result << qMakePair(QByteArray("nslimit"), QByteArray("0.5"))
+           << qMakePair(QByteArray("nslimit1"), QByteArray("0.5"))
+           << qMakePair(QByteArray("searchsize"), QByteArray("10"))
+           // a few crossing minimization passes instead of 24
+           << qMakePair(QByteArray("mclimit"), QByteArray("0.1"))
+           << qMakePair(QByteArray("remincross"), QByteArray("false"))
+           << qMakePair(QByteArray("maxiter"), QByteArray("200"))
+           << qMakePair(QByteArray("splines"), QByteArray("line"));
+    break;
+  case KGraphViewerPartSettings::EnumLayoutPreset::Quality:
+    result << qMakePair(QByteArray("searchsize"), QByteArray("100"))
+           << qMakePair(QByteArray("mclimit"), QByteArray("4"))
+           << qMakePair(QByteArray("remincross"), QByteArray("true"));
+    break;
+  default:
+    break;
+  }
+  return result;
+}
+
+QString DotLayoutPreset::name()
+{
+  switch (KGraphViewerPartSettings::layoutPreset())
+  {
+  case KGraphViewerPartSettings::EnumLayoutPreset::Fast:
+    return i18n("Fast");
+  case KGraphViewerPartSettings::EnumLayoutPreset::Quality:
+    return i18n("Quality");
+  default:
+    return i18n("Balanced");
+  }
+}
+
+QStringList DotLayoutPreset::commandLineOptions()
+{
+  QStringList options;
+  for (const auto& attribute : attributes())
+  {
+    options << QLatin1String("-G") + QString::fromLatin1(attribute.first) + QLatin1Char('=') + QString::fromLatin1(attribute.second);
+  }
+  return options;
+}
+
+DotLayoutPreset::Attributes DotLayoutPreset::apply(graph_t* graph)
+{
+  Attributes applied;
+  if (graph == nullptr)
+  {
+    return applied;
+  }
+  for (const auto& attribute : attributes())
+  {
+    QByteArray name = attribute.first;
+    // without a default value, agattr only looks the attribute up
+    Agsym_t* symbol = agattr(graph, AGRAPH, name.data(), nullptr);
+    if (symbol != nullptr && *agxget(graph, symbol) != '\0')
+    {
+      qCDebug(KGRAPHVIEWERLIB_LOG) << "keeping" << name << "=" << agxget(graph, symbol) << "set by the graph";
+      continue;
+    }
+    QByteArray value = attribute.second;
+    QByteArray empty;
+    agsafeset(graph, name.data(), value.data(), empty.data());
+    applied.append(attribute);
+  }
+  return applied;
+}
+
+void DotLayoutPreset::unapply(graph_t* graph, const Attributes& applied)
+{
+  for (const auto& attribute : applied)
+  {
+    // an empty value is the one of an attribute the graph does not set
+    QByteArray name = attribute.first;
+    QByteArray empty;
+    agsafeset(graph, name.data(), empty.data(), empty.data());
+  }
+}
+
+}
@@ -0,0 +1,72 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+/*
+ * Speed and quality presets of the layouts
+ */
+
+#ifndef DOT_LAYOUT_PRESET_H
+#define DOT_LAYOUT_PRESET_H
+
+#include <QByteArray>
+#include <QList>
+#include <QPair>
+#include <QStringList>
+
+#include <graphviz/gvc.h>
+
+namespace KGraphViewer
+{
+
+/**
+ * The Graphviz attributes given to the graphs laid out by the external
+ * programs, depending on the layout preset of the settings:
+ * - Fast bounds the network simplex and crossing minimization passes of dot
+ *   and the iterations of neato and fdp, and draws straight edges;
+ * - Balanced leaves the Graphviz defaults;
+ * - Quality lets dot spend more passes on the edge crossings.
+ *
+ * They are only defaults: the attributes set by a graph itself are kept.
+ * The built-in engines do not read them.
+ */
+class DotLayoutPreset
+{
+public:
+  typedef QList< QPair<QByteArray, QByteArray> > Attributes;
+
+  /** The graph attributes of the preset of the settings */
+  static Attributes attributes();
+
+  /** The name of the preset of the settings, to be displayed */
+  static QString name();
+
+  /** The options giving the attributes to a layout program, -Gname=value */
+  static QStringList commandLineOptions();
+
+  /**
+   * Sets the attributes of the preset graph does not set itself
+   * @return the attributes set, to be given to unapply()
+   */
+  static Attributes apply(graph_t* graph);
+  /** Clears the attributes set by apply(), on a graph owned by the caller of the part */
+  static void unapply(graph_t* graph, const Attributes& applied);
+};
+
+}
+
+#endif
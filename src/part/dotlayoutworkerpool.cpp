@@ -0,0 +1,303 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+#include "dotlayoutworkerpool.h"
+#include "kgraphviewerlib_debug.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QThread>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace KGraphViewer
+{
+
+namespace
+{
+
+inline bool isSet(const QAtomicInt* flag)
+{
+  return flag != nullptr && flag->load() != 0;
+}
+
+/** cgraph writes through global state */
+QMutex writeMutex;
+
+/** The size of the blocks in which the output of a worker is read */
+const int outputBlockSize = 1 << 16;
+
+/**
+ * The largest output of a worker: a QByteArray holds less than 2 GiB, its
+ * header included, and its size is an int
+ */
+const int maxOutputSize = std::numeric_limits<int>::max() - 2 * outputBlockSize;
+
+}
+
+QByteArray DotLayoutWorkerPool::writeGraph(graph_t* graph)
+{
+  char* text = nullptr;
+  size_t size = 0;
+  FILE* stream = open_memstream(&text, &size);
+  if (stream == nullptr)
+  {
+    return QByteArray();
+  }
+  int result;
+  {
+    QMutexLocker locker(&writeMutex);
+    result = agwrite(graph, stream);
+  }
+  fclose(stream);
+  QByteArray dot;
+  if (result == 0)
+  {
+    dot = QByteArray(text, int(size));
+  }
+  free(text);
+  return dot;
+}
+
+DotLayoutWorkerPool& DotLayoutWorkerPool::instance()
+{
+  static DotLayoutWorkerPool pool;
+  return pool;
+}
+
+DotLayoutWorkerPool::DotLayoutWorkerPool() :
+    m_program(QFile::encodeName(QStringLiteral(KGRAPHVIEWER_LAYOUT_WORKER))),
+    m_size(qMax(1, QThread::idealThreadCount())),
+    m_running(0),
+    m_idle(),
+    m_mutex(),
+    m_available()
+{
+  Worker worker;
+  if (isAvailable() && spawn(worker))
+  {
+    m_idle.append(worker);
+  }
+}
+
+DotLayoutWorkerPool::~DotLayoutWorkerPool()
+{
+  // the idle workers exit when their input is closed
+  for (const Worker& worker : m_idle)
+  {
+    close(worker.socket);
+    waitpid(worker.pid, nullptr, 0);
+  }
+}
+
+bool DotLayoutWorkerPool::isAvailable() const
+{
+  return QFileInfo(QFile::decodeName(m_program)).isExecutable();
+}
+
+bool DotLayoutWorkerPool::spawn(Worker& worker)
+{
+  int sockets[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets) != 0)
+  {
+    qCWarning(KGRAPHVIEWERLIB_LOG) << "Cannot create the socket of a layout worker:" << strerror(errno);
+    return false;
+  }
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, sockets[1], STDIN_FILENO);
+  posix_spawn_file_actions_adddup2(&actions, sockets[1], STDOUT_FILENO);
+  char* const argv[] = {const_cast<char*>(m_program.constData()), nullptr};
+  const int result = posix_spawn(&worker.pid, m_program.constData(), &actions, nullptr, argv, environ);
+  posix_spawn_file_actions_destroy(&actions);
+  close(sockets[1]);
+  if (result != 0)
+  {
+    qCWarning(KGRAPHVIEWERLIB_LOG) << "Cannot start the layout worker" << m_program << ":" << strerror(result);
+    close(sockets[0]);
+    return false;
+  }
+  worker.socket = sockets[0];
+  return true;
+}
+
+bool DotLayoutWorkerPool::layout(graph_t* graph, const QString& layoutCommand, QByteArray& output, const QAtomicInt* cancelled)
+{
+  output.clear();
+  const QByteArray dot = writeGraph(graph);
+  if (dot.isEmpty())
+  {
+    qCWarning(KGRAPHVIEWERLIB_LOG) << "Cannot write the graph to lay out";
+    return false;
+  }
+
+  Worker worker;
+  bool started;
+  {
+    QMutexLocker locker(&m_mutex);
+    while (m_running >= m_size)
+    {
+      if (isSet(cancelled))
+      {
+        return false;
+      }
+      m_available.wait(&m_mutex, 100);
+    }
+    ++m_running;
+    started = !m_idle.isEmpty();
+    if (started)
+    {
+      worker = m_idle.takeLast();
+    }
+  }
+  if (!started)
+  {
+    started = spawn(worker);
+  }
+
+  bool result = false;
+  if (started)
+  {
+    QByteArray input = layoutCommand.toUtf8();
+    input += '\n';
+    input += dot;
+    result = exchange(worker, input, output, cancelled);
+    if (!result)
+    {
+      // cancelled, or its output cannot be read or held: it is not waited for
+      kill(worker.pid, SIGKILL);
+    }
+    close(worker.socket);
+    result = reap(worker, layoutCommand) && result;
+  }
+
+  // the replacement is started while the output is being used
+  Worker replacement;
+  const bool replaced = started && spawn(replacement);
+  QMutexLocker locker(&m_mutex);
+  if (replaced)
+  {
+    m_idle.append(replacement);
+  }
+  --m_running;
+  m_available.wakeOne();
+  return result;
+}
+
+bool DotLayoutWorkerPool::exchange(const Worker& worker, const QByteArray& input, QByteArray& output, const QAtomicInt* cancelled)
+{
+  // the worker reads the whole graph before writing anything
+  const char* data = input.constData();
+  qint64 remaining = input.size();
+  while (remaining > 0)
+  {
+    // a crashed worker must not kill the viewer with SIGPIPE
+    const ssize_t written = send(worker.socket, data, size_t(remaining), MSG_NOSIGNAL);
+    if (written < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      qCWarning(KGRAPHVIEWERLIB_LOG) << "Cannot send the graph to the layout worker:" << strerror(errno);
+      return false;
+    }
+    data += written;
+    remaining -= written;
+  }
+  shutdown(worker.socket, SHUT_WR);
+
+  for (;;)
+  {
+    // the layout can last long: the cancellation is checked while waiting
+    pollfd readable = {worker.socket, POLLIN, 0};
+    int ready;
+    do
+    {
+      if (isSet(cancelled))
+      {
+        return false;
+      }
+      ready = poll(&readable, 1, 100);
+    }
+    while (ready == 0 || (ready < 0 && errno == EINTR));
+    const int size = output.size();
+    if (size > maxOutputSize)
+    {
+      qCWarning(KGRAPHVIEWERLIB_LOG) << "The output of the layout worker is too big, more than" << maxOutputSize << "bytes";
+      output.clear();
+      return false;
+    }
+    output.resize(size + outputBlockSize);
+    const ssize_t length = ::read(worker.socket, output.data() + size, outputBlockSize);
+    output.resize(size + int(qMax(length, ssize_t(0))));
+    if (length == 0)
+    {
+      return true;
+    }
+    if (length < 0 && errno != EINTR)
+    {
+      qCWarning(KGRAPHVIEWERLIB_LOG) << "Cannot read the output of the layout worker:" << strerror(errno);
+      return false;
+    }
+  }
+}
+
+bool DotLayoutWorkerPool::reap(const Worker& worker, const QString& layoutCommand)
+{
+  int status;
+  while (waitpid(worker.pid, &status, 0) < 0)
+  {
+    if (errno != EINTR)
+    {
+      return false;
+    }
+  }
+  if (WIFSIGNALED(status) && WTERMSIG(status) == SIGKILL)
+  {
+    qCDebug(KGRAPHVIEWERLIB_LOG) << "The layout worker running" << layoutCommand << "was killed";
+    return false;
+  }
+  if (WIFSIGNALED(status))
+  {
+    qCWarning(KGRAPHVIEWERLIB_LOG) << "The layout worker crashed running" << layoutCommand << "with signal" << WTERMSIG(status);
+    return false;
+  }
+  if (WEXITSTATUS(status) != 0)
+  {
+    qCWarning(KGRAPHVIEWERLIB_LOG) << "The layout worker failed running" << layoutCommand << "with code" << WEXITSTATUS(status);
+    return false;
+  }
+  return true;
+}
+
+}
@@ -0,0 +1,102 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+/*
+ * Pool of the processes running the library mode layouts
+ */
+
+#ifndef DOT_LAYOUT_WORKER_POOL_H
+#define DOT_LAYOUT_WORKER_POOL_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <QWaitCondition>
+
+#include <graphviz/gvc.h>
+
+#include <sys/types.h>
+
+namespace KGraphViewer
+{
+
+/**
+ * Runs the Graphviz layouts in kgraphviewer-layout-worker processes, each
+ * with its own context, instead of serializing them in the viewer process
+ * where Graphviz is not thread safe. As many layouts as there are cores run
+ * at the same time, and a crash of Graphviz does not take the viewer down.
+ *
+ * The workers are started ahead of time: a worker lays out a single graph
+ * and is replaced by a new one, started while nothing waits for it.
+ */
+class DotLayoutWorkerPool
+{
+public:
+  static DotLayoutWorkerPool& instance();
+
+  /** false if the worker program is not installed */
+  bool isAvailable() const;
+
+  /**
+   * Lays out graph with layoutCommand in a worker, blocking until the
+   * output is read: to be called from a layout thread.
+   * @param output receives the laid out graph in the xdot format
+   * @param cancelled if given, the layout is abandoned and its worker
+   * killed as soon as it is set
+   * @return false if no worker could be started, if the layout failed or
+   * if it was cancelled
+   */
+  bool layout(graph_t* graph, const QString& layoutCommand, QByteArray& output, const QAtomicInt* cancelled = nullptr);
+
+  /** The DOT text of graph, or an empty array on failure */
+  static QByteArray writeGraph(graph_t* graph);
+
+private:
+  struct Worker
+  {
+    pid_t pid;
+    /** A socket being both the standard input and output of the worker */
+    int socket;
+  };
+
+  DotLayoutWorkerPool();
+  ~DotLayoutWorkerPool();
+  DotLayoutWorkerPool(const DotLayoutWorkerPool&) = delete;
+  DotLayoutWorkerPool& operator=(const DotLayoutWorkerPool&) = delete;
+
+  bool spawn(Worker& worker);
+  /** Sends input to worker and reads its whole output, unless cancelled */
+  bool exchange(const Worker& worker, const QByteArray& input, QByteArray& output, const QAtomicInt* cancelled);
+  /** Waits for the end of worker, returning true if it succeeded */
+  bool reap(const Worker& worker, const QString& layoutCommand);
+
+  const QByteArray m_program;
+  const int m_size;
+  /** The number of layouts running */
+  int m_running;
+  /** The started workers waiting for a graph */
+  QVector<Worker> m_idle;
+  QMutex m_mutex;
+  QWaitCondition m_available;
+};
+
+}
+
+#endif
@@ -0,0 +1,359 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+#include "dotlexer.h"
+
+#include <cstring>
+
+namespace KGraphViewer
+{
+
+namespace
+{
+
+enum CharClass
+{
+  OtherChar = 0,
+  SpaceChar = 1,
+  // letters, digits, '_', '.' and the bytes of non ASCII UTF-8 characters
+  IdChar = 2
+};
+
+struct CharClasses
+{
+  CharClasses()
+  {
+    for (int c = 0; c < 256; c++)
+    {
+      if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v')
+        classes[c] = SpaceChar;
+      else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')
+            || c == '_' || c == '.' || c >= 128)
+        classes[c] = IdChar;
+      else
+        classes[c] = OtherChar;
+    }
+  }
+  unsigned char classes[256];
+};
+
+const CharClasses charClasses;
+
+inline unsigned char charClass(char c)
+{
+  return charClasses.classes[static_cast<unsigned char>(c)];
+}
+
+inline bool isDigit(char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+inline char toLower(char c)
+{
+  return (c >= 'A' && c <= 'Z') ? char(c - 'A' + 'a') : c;
+}
+
+}
+
+bool DotStringRef::operator==(const char* str) const
+{
+  const std::size_t length = strlen(str);
+  return length == size() && memcmp(first, str, length) == 0;
+}
+
+bool DotStringRef::hasLineBreaks() const
+{
+  return first != last && memchr(first, '\n', size()) != nullptr;
+}
+
+QString DotStringRef::toString() const
+{
+  if (!hasLineBreaks())
+  {
+    return QString::fromUtf8(first, int(size()));
+  }
+  const std::string str = toStdString();
+  return QString::fromUtf8(str.data(), int(str.size()));
+}
+
+std::string DotStringRef::toStdString() const
+{
+  if (!hasLineBreaks())
+  {
+    return std::string(first, last);
+  }
+  std::string result;
+  result.reserve(size());
+  for (const char* p = first; p != last; ++p)
+  {
+    if (*p == '\\' && last - p > 1 && p[1] == '\n')
+    {
+      ++p;
+    }
+    else if (*p == '\\' && last - p > 2 && p[1] == '\r' && p[2] == '\n')
+    {
+      p += 2;
+    }
+    else
+    {
+      result += *p;
+    }
+  }
+  return result;
+}
+
+bool DotToken::isKeyword(const char* keyword) const
+{
+  if (type != Id)
+  {
+    return false;
+  }
+  const char* p = text.first;
+  for (; *keyword != '\0'; ++keyword, ++p)
+  {
+    if (p == text.last || toLower(*p) != *keyword)
+    {
+      return false;
+    }
+  }
+  return p == text.last;
+}
+
+DotStringRef DotToken::value() const
+{
+  if (type == QuotedId)
+  {
+    return DotStringRef(text.first + 1, text.last - 1);
+  }
+  return text;
+}
+
+DotLexer::DotLexer(const char* first, const char* last, bool atEnd) :
+    m_position(first),
+    m_last(last),
+    m_atEnd(atEnd)
+{
+}
+
+DotToken DotLexer::endOfBuffer(const char* first)
+{
+  if (m_atEnd)
+  {
+    m_position = m_last;
+    return DotToken(DotToken::Error, first, m_last);
+  }
+  m_position = first;
+  return DotToken(DotToken::Incomplete, first, m_last);
+}
+
+bool DotLexer::skipSpacesAndComments()
+{
+  while (m_position != m_last)
+  {
+    const char c = *m_position;
+    if (charClass(c) == SpaceChar)
+    {
+      ++m_position;
+    }
+    else if (c == '/' && m_last - m_position == 1 && !m_atEnd)
+    {
+      // maybe the beginning of a comment
+      return false;
+    }
+    else if (c == '/' && m_last - m_position > 1 && m_position[1] == '*')
+    {
+      const char* p = m_position + 2;
+      for (;;)
+      {
+        p = static_cast<const char*>(memchr(p, '*', m_last - p));
+        if (p == nullptr || m_last - p < 2)
+        {
+          if (!m_atEnd)
+          {
+            return false;
+          }
+          // unterminated comment: skip up to the end of the buffer
+          p = m_last;
+          break;
+        }
+        if (p[1] == '/')
+        {
+          p += 2;
+          break;
+        }
+        ++p;
+      }
+      m_position = p;
+    }
+    else if ((c == '/' && m_last - m_position > 1 && m_position[1] == '/') || c == '#')
+    {
+      // C++ style comments and preprocessor output lines
+      const char* p = static_cast<const char*>(memchr(m_position, '\n', m_last - m_position));
+      if (p == nullptr && !m_atEnd)
+      {
+        return false;
+      }
+      m_position = (p == nullptr) ? m_last : p + 1;
+    }
+    else
+    {
+      return true;
+    }
+  }
+  return true;
+}
+
+DotToken DotLexer::next()
+{
+  if (!skipSpacesAndComments())
+  {
+    return DotToken(DotToken::Incomplete, m_position, m_last);
+  }
+  if (m_position == m_last)
+  {
+    return DotToken(m_atEnd ? DotToken::End : DotToken::Incomplete, m_last, m_last);
+  }
+
+  const char* first = m_position;
+  DotToken::Type type;
+  switch (*first)
+  {
+    case '{': type = DotToken::LeftBrace; break;
+    case '}': type = DotToken::RightBrace; break;
+    case '[': type = DotToken::LeftBracket; break;
+    case ']': type = DotToken::RightBracket; break;
+    case '=': type = DotToken::Equal; break;
+    case ';': type = DotToken::Semicolon; break;
+    case ',': type = DotToken::Comma; break;
+    case ':': type = DotToken::Colon; break;
+    case '"':
+    {
+      // the quoted string ends at the first quote not escaped by a backslash
+      const char* p = first + 1;
+      for (;;)
+      {
+        p = static_cast<const char*>(memchr(p, '"', m_last - p));
+        if (p == nullptr)
+        {
+          return endOfBuffer(first);
+        }
+        const char* q = p;
+        while (q[-1] == '\\' && q - 1 > first)
+        {
+          --q;
+        }
+        ++p;
+        if ((p - 1 - q) % 2 == 0)
+        {
+          break;
+        }
+      }
+      m_position = p;
+      return DotToken(DotToken::QuotedId, first, p);
+    }
+    case '<':
+    {
+      int depth = 0;
+      const char* p = first;
+      for (; p != m_last; ++p)
+      {
+        if (*p == '<')
+        {
+          ++depth;
+        }
+        else if (*p == '>' && --depth == 0)
+        {
+          break;
+        }
+      }
+      if (p == m_last)
+      {
+        return endOfBuffer(first);
+      }
+      m_position = p + 1;
+      return DotToken(DotToken::HtmlId, first, m_position);
+    }
+    case '-':
+      if (m_last - first == 1 && !m_atEnd)
+      {
+        return endOfBuffer(first);
+      }
+      if (m_last - first > 1 && (first[1] == '>' || first[1] == '-'))
+      {
+        m_position = first + 2;
+        return DotToken(DotToken::EdgeOp, first, m_position);
+      }
+      if (m_last - first > 1 && (isDigit(first[1]) || first[1] == '.'))
+      {
+        // a negative numeral: '-' [0-9]* ('.' [0-9]*)? with at least one digit
+        const char* p = first + 1;
+        while (p != m_last && isDigit(*p))
+        {
+          ++p;
+        }
+        if (p != m_last && *p == '.')
+        {
+          ++p;
+          while (p != m_last && isDigit(*p))
+          {
+            ++p;
+          }
+        }
+        if (p == m_last && !m_atEnd)
+        {
+          return endOfBuffer(first);
+        }
+        const bool hasDigits = (p - first > 2 || isDigit(first[1]));
+        if (hasDigits && (p == m_last || charClass(*p) != IdChar))
+        {
+          m_position = p;
+          return DotToken(DotToken::Id, first, p);
+        }
+        // "-." or a numeral followed by other ID characters, as in "-1a"
+        while (p != m_last && charClass(*p) == IdChar)
+        {
+          ++p;
+        }
+        m_position = p;
+        return DotToken(DotToken::Error, first, p);
+      }
+      type = DotToken::Error;
+      break;
+    default:
+      if (charClass(*first) == IdChar)
+      {
+        const char* p = first + 1;
+        while (p != m_last && charClass(*p) == IdChar)
+        {
+          ++p;
+        }
+        if (p == m_last && !m_atEnd)
+        {
+          return endOfBuffer(first);
+        }
+        m_position = p;
+        return DotToken(DotToken::Id, first, p);
+      }
+      type = DotToken::Error;
+  }
+  m_position = first + 1;
+  return DotToken(type, first, m_position);
+}
+
+}
@@ -0,0 +1,132 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+/*
+ * Zero-copy lexer of the Graphviz DOT language
+ */
+
+#ifndef DOT_LEXER_H
+#define DOT_LEXER_H
+
+#include <QString>
+
+#include <cstddef>
+#include <string>
+
+namespace KGraphViewer
+{
+
+/**
+ * A non owning reference to a part of the buffer being parsed. Its content
+ * is copied only when it is converted to the strings stored in the model.
+ */
+struct DotStringRef
+{
+  DotStringRef() : first(nullptr), last(nullptr) {}
+  DotStringRef(const char* f, const char* l) : first(f), last(l) {}
+
+  inline bool isEmpty() const {return first == last;}
+  inline std::size_t size() const {return last - first;}
+
+  /** Compares the referenced bytes with the given nul terminated string */
+  bool operator==(const char* str) const;
+  inline bool operator!=(const char* str) const {return !(*this == str);}
+
+  /**
+   * The converters drop the backslash-newline line continuations Graphviz
+   * inserts in long quoted strings.
+   */
+  QString toString() const;
+  std::string toStdString() const;
+
+  /** true if the referenced text contains line breaks, escaped or not */
+  bool hasLineBreaks() const;
+
+  const char* first;
+  const char* last;
+};
+
+struct DotToken
+{
+  enum Type
+  {
+    Id,
+    QuotedId,
+    HtmlId,
+    EdgeOp,
+    LeftBrace,
+    RightBrace,
+    LeftBracket,
+    RightBracket,
+    Equal,
+    Semicolon,
+    Comma,
+    Colon,
+    End,
+    /** The end of the buffer was reached before the token was complete */
+    Incomplete,
+    Error
+  };
+
+  DotToken() : type(End) {}
+  DotToken(Type t, const char* first, const char* last) : type(t), text(first, last) {}
+
+  inline bool isId() const {return type == Id || type == QuotedId || type == HtmlId;}
+
+  /** DOT keywords are case insensitive and are never quoted */
+  bool isKeyword(const char* keyword) const;
+
+  /** The value of an ID token: its text without the quotes of a quoted string */
+  DotStringRef value() const;
+
+  Type type;
+  /** The token as it appears in the buffer */
+  DotStringRef text;
+};
+
+/**
+ * Splits a DOT buffer into tokens. Tokens reference the buffer, which must
+ * thus outlive them. Neither the lexer nor the tokens allocate memory.
+ *
+ * When the buffer holds only the beginning of the input (atEnd is false), a
+ * token or a comment which could continue after the end of the buffer gives
+ * an Incomplete token and the lexing has to be restarted at position() once
+ * more data is available.
+ */
+class DotLexer
+{
+public:
+  DotLexer(const char* first, const char* last, bool atEnd = true);
+
+  DotToken next();
+
+  inline const char* position() const {return m_position;}
+
+private:
+  /** @return false if the buffer ends inside a comment */
+  bool skipSpacesAndComments();
+  DotToken endOfBuffer(const char* first);
+
+  const char* m_position;
+  const char* m_last;
+  bool m_atEnd;
+};
+
+}
+
+#endif
@@ -0,0 +1,911 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+#include "dotnativelayout.h"
+#include "dotforcelayout.h"
+#include "dotlayeredlayout.h"
+#include "dotgraph.h"
+#include "kgraphviewerlib_debug.h"
+
+#include <QColor>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QPointF>
+#include <QStringList>
+
+#include <cmath>
+
+namespace KGraphViewer
+{
+
+namespace
+{
+
+const float pointsPerInch = 72;
+/** The Graphviz defaults */
+const float defaultNodeWidth = 0.75f;
+const float defaultNodeHeight = 0.5f;
+const float defaultPointSize = 0.05f;
+const float defaultFontSize = 14;
+const float defaultNodeSeparation = 0.25f;
+const float defaultRankSeparation = 0.5f;
+/** The space around the labels in the nodes, in points, as the default margin of Graphviz */
+const float labelMarginX = 16;
+const float labelMarginY = 8;
+/** The space between a cluster and its content, and around the drawing */
+const float clusterMargin = 8;
+/** As no font metrics are available out of the GUI thread, the average width of a character relative to the font size */
+const float characterWidth = 0.6f;
+const float lineSpacing = 1.2f;
+/** The length of the arrowheads and half their width */
+const float arrowLength = 10;
+const float arrowHalfWidth = 3.5f;
+/** The distance between parallel edges, and the size of the first loop on a node */
+const float edgeSpacing = 12;
+const float loopSize = 18;
+
+enum Shape
+{
+  EllipseShape,
+  CircleShape,
+  BoxShape,
+  DiamondShape,
+  PointShape,
+  /** Only the label is drawn */
+  PlainShape
+};
+
+Shape shapeNamed(const QString& name)
+{
+  if (name == QLatin1String("box") || name == QLatin1String("rect") || name == QLatin1String("rectangle")
+      || name == QLatin1String("square"))
+  {
+    return BoxShape;
+  }
+  if (name == QLatin1String("circle") || name == QLatin1String("doublecircle"))
+  {
+    return CircleShape;
+  }
+  if (name == QLatin1String("diamond"))
+  {
+    return DiamondShape;
+  }
+  if (name == QLatin1String("point"))
+  {
+    return PointShape;
+  }
+  if (name == QLatin1String("plaintext") || name == QLatin1String("plain") || name == QLatin1String("none"))
+  {
+    return PlainShape;
+  }
+  return EllipseShape;
+}
+
+/** The attributes read by the engines for a kind of object, looked up once */
+struct Symbols
+{
+  Symbols(graph_t* graph, int kind)
+  {
+    label = find(graph, kind, "label");
+    fontName = find(graph, kind, "fontname");
+    fontSize = find(graph, kind, "fontsize");
+    fontColor = find(graph, kind, "fontcolor");
+    color = find(graph, kind, "color");
+    penColor = find(graph, kind, "pencolor");
+    fillColor = find(graph, kind, "fillcolor");
+    style = find(graph, kind, "style");
+    shape = find(graph, kind, "shape");
+    width = find(graph, kind, "width");
+    height = find(graph, kind, "height");
+    fixedSize = find(graph, kind, "fixedsize");
+    dir = find(graph, kind, "dir");
+    arrowHead = find(graph, kind, "arrowhead");
+    arrowTail = find(graph, kind, "arrowtail");
+  }
+
+  static Agsym_t* find(graph_t* graph, int kind, const char* name)
+  {
+    // without a default value, agattr only looks the attribute up
+    return agattr(graph, kind, const_cast<char*>(name), nullptr);
+  }
+
+  Agsym_t* label;
+  Agsym_t* fontName;
+  Agsym_t* fontSize;
+  Agsym_t* fontColor;
+  Agsym_t* color;
+  Agsym_t* penColor;
+  Agsym_t* fillColor;
+  Agsym_t* style;
+  Agsym_t* shape;
+  Agsym_t* width;
+  Agsym_t* height;
+  Agsym_t* fixedSize;
+  Agsym_t* dir;
+  Agsym_t* arrowHead;
+  Agsym_t* arrowTail;
+};
+
+/** The value of the attribute of object, or defaultValue if it is not declared or empty */
+QString attribute(void* object, Agsym_t* symbol, const QString& defaultValue = QString())
+{
+  if (symbol == nullptr)
+  {
+    return defaultValue;
+  }
+  const char* value = agxget(object, symbol);
+  return (value == nullptr || *value == '\0') ? defaultValue : QString::fromUtf8(value);
+}
+
+float numberAttribute(void* object, Agsym_t* symbol, float defaultValue)
+{
+  bool ok;
+  const float value = attribute(object, symbol).toFloat(&ok);
+  return ok ? value : defaultValue;
+}
+
+/**
+ * A color as stored by the xdot decoder: Graphviz names and lists are
+ * resolved here, the render operations only knowing #rrggbb.
+ */
+QString colorAttribute(void* object, Agsym_t* symbol, const QString& defaultValue)
+{
+  // the first color of a list, without its weight
+  const QString value = attribute(object, symbol).section(QLatin1Char(':'), 0, 0).section(QLatin1Char(';'), 0, 0);
+  const QColor color(value);
+  return color.isValid() ? color.name() : defaultValue;
+}
+
+bool hasStyle(void* object, const Symbols& symbols, const char* style)
+{
+  return attribute(object, symbols.style).contains(QLatin1String(style));
+}
+
+/** A label with its font, its size being estimated from the number of characters */
+struct Label
+{
+  QStringList lines;
+  QString fontName;
+  float fontSize;
+  QString color;
+
+  inline bool isEmpty() const {return lines.isEmpty();}
+  inline float lineWidth(int i) const {return lines.at(i).size() * characterWidth * fontSize;}
+  float width() const
+  {
+    float result = 0;
+    for (int i = 0; i < lines.size(); i++)
+    {
+      result = qMax(result, lineWidth(i));
+    }
+    return result;
+  }
+  inline float height() const {return lines.size() * fontSize * lineSpacing;}
+};
+
+/** The label of object, with the escapes of Graphviz for its name and the name of the graph */
+Label readLabel(void* object, const Symbols& symbols, const QString& name, const QString& graphName,
+                const QString& defaultText)
+{
+  Label label;
+  label.fontName = attribute(object, symbols.fontName, QStringLiteral("Times-Roman"));
+  label.fontSize = numberAttribute(object, symbols.fontSize, defaultFontSize);
+  label.color = colorAttribute(object, symbols.fontColor, QStringLiteral("#000000"));
+  QString text = attribute(object, symbols.label, defaultText);
+  if (symbols.label != nullptr && aghtmlstr(agxget(object, symbols.label)))
+  {
+    // HTML labels are not laid out
+    text = name;
+  }
+  text.replace(QLatin1String("\\N"), name);
+  text.replace(QLatin1String("\\G"), graphName);
+  // the centered, left and right justified line ends
+  text.replace(QLatin1String("\\n"), QLatin1String("\n"));
+  text.replace(QLatin1String("\\l"), QLatin1String("\n"));
+  text.replace(QLatin1String("\\r"), QLatin1String("\n"));
+  if (text.endsWith(QLatin1Char('\n')))
+  {
+    text.chop(1);
+  }
+  if (!text.isEmpty())
+  {
+    label.lines = text.split(QLatin1Char('\n'));
+  }
+  return label;
+}
+
+inline QString point(float x, float y)
+{
+  return QString::number(x, 'f', 2) % QLatin1Char(',') % QString::number(y, 'f', 2);
+}
+
+inline float length(const QPointF& v)
+{
+  return float(std::sqrt(v.x() * v.x() + v.y() * v.y()));
+}
+
+/** @name Building the drawing operations, in the form given by the xdot decoder */
+//@{
+void appendColor(DotRenderOpVec& ops, DotRenderOp::Code code, const QString& color)
+{
+  DotRenderOp op;
+  op.code = code;
+  op.count = 0;
+  op.coordinates = ops.nextCoordinate();
+  op.text = ops.internColor(color);
+  ops.append(op);
+}
+
+void appendPoints(DotRenderOpVec& ops, DotRenderOp::Code code, const QVector<QPointF>& points)
+{
+  DotRenderOp op;
+  op.code = code;
+  op.count = points.size();
+  op.coordinates = ops.nextCoordinate();
+  op.text = 0;
+  for (const QPointF& p : points)
+  {
+    ops.appendCoordinate(p.x());
+    ops.appendCoordinate(p.y());
+  }
+  ops.append(op);
+}
+
+void appendEllipse(DotRenderOpVec& ops, DotRenderOp::Code code, float x, float y, float rx, float ry)
+{
+  DotRenderOp op;
+  op.code = code;
+  op.count = 0;
+  op.coordinates = ops.nextCoordinate();
+  op.text = 0;
+  ops.appendCoordinate(x);
+  ops.appendCoordinate(y);
+  ops.appendCoordinate(rx);
+  ops.appendCoordinate(ry);
+  ops.append(op);
+}
+
+/** Appends the font, color and texts of label, centered on (x, y) */
+void appendLabel(DotRenderOpVec& ops, const Label& label, float x, float y)
+{
+  if (label.isEmpty())
+  {
+    return;
+  }
+  DotRenderOp font;
+  font.code = DotRenderOp::Font;
+  font.count = 0;
+  font.coordinates = ops.nextCoordinate();
+  font.text = ops.internText(label.fontName);
+  ops.appendCoordinate(label.fontSize);
+  ops.append(font);
+  appendColor(ops, DotRenderOp::PenColor, label.color);
+
+  const float lineHeight = label.fontSize * lineSpacing;
+  // the baseline of the first line
+  float baseline = y + label.height() / 2 - lineHeight + 0.3f * label.fontSize;
+  for (int i = 0; i < label.lines.size(); i++)
+  {
+    DotRenderOp text;
+    text.code = DotRenderOp::Text;
+    text.count = 0;
+    text.coordinates = ops.nextCoordinate();
+    text.text = ops.internText(label.lines.at(i));
+    ops.appendCoordinate(x);
+    ops.appendCoordinate(baseline);
+    // centered
+    ops.appendCoordinate(0);
+    ops.appendCoordinate(label.lineWidth(i));
+    ops.append(text);
+    baseline -= lineHeight;
+  }
+}
+
+QVector<QPointF> rectangle(float left, float bottom, float right, float top)
+{
+  return QVector<QPointF>() << QPointF(left, bottom) << QPointF(right, bottom)
+                            << QPointF(right, top) << QPointF(left, top);
+}
+//@}
+
+/** The geometry of a node once laid out */
+struct NodeBox
+{
+  Shape shape;
+  QPointF center;
+  float halfWidth;
+  float halfHeight;
+
+  /** The point where the segment from the center towards p leaves the node */
+  QPointF border(const QPointF& p) const
+  {
+    const float dx = p.x() - center.x();
+    const float dy = p.y() - center.y();
+    if (dx == 0 && dy == 0)
+    {
+      return center;
+    }
+    const float nx = std::fabs(dx) / qMax(halfWidth, 0.5f);
+    const float ny = std::fabs(dy) / qMax(halfHeight, 0.5f);
+    float t;
+    switch (shape)
+    {
+      case BoxShape:
+      case PlainShape:
+        t = 1 / qMax(nx, ny);
+        break;
+      case DiamondShape:
+        t = 1 / (nx + ny);
+        break;
+      default:
+        t = 1 / std::sqrt(nx * nx + ny * ny);
+    }
+    // p is in the node
+    t = qMin(t, 1.f);
+    return QPointF(center.x() + t * dx, center.y() + t * dy);
+  }
+};
+
+/** A cluster and the box around its nodes and clusters */
+struct ClusterBox
+{
+  graph_t* subgraph;
+  float left;
+  float bottom;
+  float right;
+  float top;
+  Label label;
+};
+
+/**
+ * Computes the boxes of the clusters in graph, the inner ones first.
+ * @return false if there are no nodes in graph
+ */
+bool clusterBoxes(graph_t* graph, const Symbols& symbols, const QHash<node_t*, int>& indexes,
+                  const QVector<NodeBox>& boxes, QVector<ClusterBox>& clusters,
+                  float& left, float& bottom, float& right, float& top)
+{
+  bool found = false;
+  for (node_t* node = agfstnode(graph); node; node = agnxtnode(graph, node))
+  {
+    const NodeBox& box = boxes.at(indexes.value(node));
+    const float nodeLeft = box.center.x() - box.halfWidth;
+    const float nodeRight = box.center.x() + box.halfWidth;
+    const float nodeBottom = box.center.y() - box.halfHeight;
+    const float nodeTop = box.center.y() + box.halfHeight;
+    left = found ? qMin(left, nodeLeft) : nodeLeft;
+    right = found ? qMax(right, nodeRight) : nodeRight;
+    bottom = found ? qMin(bottom, nodeBottom) : nodeBottom;
+    top = found ? qMax(top, nodeTop) : nodeTop;
+    found = true;
+  }
+  for (graph_t* subgraph = agfstsubg(graph); subgraph; subgraph = agnxtsubg(subgraph))
+  {
+    float l, b, r, t;
+    if (!clusterBoxes(subgraph, symbols, indexes, boxes, clusters, l, b, r, t))
+    {
+      continue;
+    }
+    const QString name = QString::fromUtf8(agnameof(subgraph));
+    if (!name.startsWith(QLatin1String("cluster")))
+    {
+      continue;
+    }
+    ClusterBox cluster = {subgraph, l - clusterMargin, b - clusterMargin, r + clusterMargin, t + clusterMargin,
+                          readLabel(subgraph, symbols, name, name, QString())};
+    if (!cluster.label.isEmpty())
+    {
+      cluster.top += cluster.label.height();
+      cluster.right = qMax(cluster.right, cluster.left + cluster.label.width() + 2 * clusterMargin);
+    }
+    // the content of a graph includes the one of its clusters
+    left = qMin(left, cluster.left);
+    bottom = qMin(bottom, cluster.bottom);
+    right = qMax(right, cluster.right);
+    top = qMax(top, cluster.top);
+    clusters.append(cluster);
+  }
+  return found;
+}
+
+/** The path of an edge: its ends, clipped by the nodes, and its bends */
+struct EdgePath
+{
+  QVector<QPointF> points;
+  /** The tips of the arrowheads, when there are some */
+  QPointF headTip;
+  QPointF tailTip;
+  bool headArrow;
+  bool tailArrow;
+};
+
+/** Moves the end of a path back by the length of an arrowhead, whose tip stays at the end */
+QPointF shorten(QPointF& end, const QPointF& previous)
+{
+  const QPointF tip = end;
+  const QPointF direction = end - previous;
+  const float l = length(direction);
+  if (l > 0)
+  {
+    end -= direction * (qMin(arrowLength, l / 2) / l);
+  }
+  return tip;
+}
+
+/** The cubic B-spline through points, as a Catmull-Rom spline, in the form of the xdot ones */
+QVector<QPointF> spline(const QVector<QPointF>& points)
+{
+  QVector<QPointF> result;
+  result.append(points.first());
+  const int last = points.size() - 1;
+  for (int i = 0; i < last; i++)
+  {
+    const QPointF& before = points.at(qMax(0, i - 1));
+    const QPointF& after = points.at(qMin(last, i + 2));
+    result.append(points.at(i) + (points.at(i + 1) - before) / 6);
+    result.append(points.at(i + 1) - (after - points.at(i)) / 6);
+    result.append(points.at(i + 1));
+  }
+  return result;
+}
+
+void appendArrowhead(DotRenderOpVec& ops, const QPointF& tip, const QPointF& base, const QString& color)
+{
+  const QPointF direction = tip - base;
+  const float l = length(direction);
+  if (l == 0)
+  {
+    return;
+  }
+  const QPointF normal(-direction.y() / l * arrowHalfWidth, direction.x() / l * arrowHalfWidth);
+  appendColor(ops, DotRenderOp::PenColor, color);
+  appendColor(ops, DotRenderOp::FillColor, color);
+  appendPoints(ops, DotRenderOp::FilledPolygon, QVector<QPointF>() << tip << base + normal << base - normal);
+}
+
+/**
+ * Moves a point of a layout whose ranks go down for them to go in the
+ * direction rankDir, the first nodes of a rank staying on the left or at
+ * the top.
+ */
+void turn(float& x, float& y, const QString& rankDir)
+{
+  const float oldX = x;
+  if (rankDir == QLatin1String("LR"))
+  {
+    x = -y;
+    y = -oldX;
+  }
+  else if (rankDir == QLatin1String("RL"))
+  {
+    x = y;
+    y = -oldX;
+  }
+  else if (rankDir == QLatin1String("BT"))
+  {
+    y = -y;
+  }
+}
+
+void turn(QVector<float>& x, QVector<float>& y, const QString& rankDir)
+{
+  for (int i = 0; i < x.size(); i++)
+  {
+    turn(x[i], y[i], rankDir);
+  }
+}
+
+}
+
+bool DotNativeLayout::isNative(const QString& layoutCommand)
+{
+  return layoutCommand == forceDirectedCommand() || layoutCommand == layeredCommand();
+}
+
+DotGraph* DotNativeLayout::layout(graph_t* graph, const QString& layoutCommand, const QString& dotFileName,
+                                  const QAtomicInt* cancelled)
+{
+  QElapsedTimer timer;
+  timer.start();
+  const QString graphName = QString::fromUtf8(agnameof(graph));
+  const Symbols graphSymbols(graph, AGRAPH);
+  const Symbols nodeSymbols(graph, AGNODE);
+  const Symbols edgeSymbols(graph, AGEDGE);
+
+  // the sizes of the nodes, from their attributes and labels
+  DotNativeGraph input;
+  input.directed = agisdirected(graph);
+  QVector<node_t*> nodes;
+  QVector<Shape> shapes;
+  QHash<node_t*, int> indexes;
+  const int nodeCount = agnnodes(graph);
+  nodes.reserve(nodeCount);
+  indexes.reserve(nodeCount);
+  for (node_t* node = agfstnode(graph); node; node = agnxtnode(graph, node))
+  {
+    const QString name = QString::fromUtf8(agnameof(node));
+    const Shape shape = shapeNamed(attribute(node, nodeSymbols.shape, QStringLiteral("ellipse")));
+    float width = numberAttribute(node, nodeSymbols.width, shape == PointShape ? defaultPointSize : defaultNodeWidth) * pointsPerInch;
+    float height = numberAttribute(node, nodeSymbols.height, shape == PointShape ? defaultPointSize : defaultNodeHeight) * pointsPerInch;
+    const QString fixedSize = attribute(node, nodeSymbols.fixedSize);
+    if (shape == PointShape)
+    {
+      width = height = qMin(width, height);
+    }
+    else if (fixedSize != QLatin1String("true") && fixedSize != QLatin1String("shape"))
+    {
+      const Label label = readLabel(node, nodeSymbols, name, graphName, QStringLiteral("\\N"));
+      float labelWidth = label.width() + labelMarginX;
+      float labelHeight = label.height() + labelMarginY;
+      // the label fits in the box inscribed in the shape
+      if (shape == EllipseShape || shape == CircleShape)
+      {
+        labelWidth *= std::sqrt(2.f);
+        labelHeight *= std::sqrt(2.f);
+      }
+      else if (shape == DiamondShape)
+      {
+        labelWidth *= 2;
+        labelHeight *= 2;
+      }
+      width = qMax(width, labelWidth);
+      height = qMax(height, labelHeight);
+      if (shape == CircleShape)
+      {
+        width = height = qMax(width, height);
+      }
+    }
+    indexes.insert(node, nodes.size());
+    nodes.append(node);
+    shapes.append(shape);
+    input.widths.append(width);
+    input.heights.append(height);
+  }
+  QVector<edge_t*> edges;
+  for (node_t* node : nodes)
+  {
+    for (edge_t* edge = agfstout(graph, node); edge; edge = agnxtout(graph, edge))
+    {
+      edges.append(edge);
+      input.tails.append(indexes.value(agtail(edge)));
+      input.heads.append(indexes.value(aghead(edge)));
+    }
+  }
+
+  bool laidOut = false;
+  if (layoutCommand == forceDirectedCommand())
+  {
+    laidOut = DotForceLayout::layout(input, cancelled);
+  }
+  else if (layoutCommand == layeredCommand())
+  {
+    input.nodeSeparation = numberAttribute(graph, Symbols::find(graph, AGRAPH, "nodesep"), defaultNodeSeparation) * pointsPerInch;
+    input.rankSeparation = numberAttribute(graph, Symbols::find(graph, AGRAPH, "ranksep"), defaultRankSeparation) * pointsPerInch;
+    // the ranks go down, the other directions are drawn by turning the layout
+    const QString rankDir = attribute(graph, Symbols::find(graph, AGRAPH, "rankdir"), QStringLiteral("TB"));
+    const bool horizontal = (rankDir == QLatin1String("LR") || rankDir == QLatin1String("RL"));
+    if (horizontal)
+    {
+      input.widths.swap(input.heights);
+    }
+    laidOut = DotLayeredLayout::layout(input, cancelled);
+    if (horizontal)
+    {
+      input.widths.swap(input.heights);
+    }
+    if (laidOut && rankDir != QLatin1String("TB"))
+    {
+      turn(input.x, input.y, rankDir);
+      for (int b = 0; b + 1 < input.bends.size(); b += 2)
+      {
+        turn(input.bends[b], input.bends[b + 1], rankDir);
+      }
+    }
+  }
+  if (!laidOut)
+  {
+    return nullptr;
+  }
+  const qint64 layoutTime = timer.elapsed();
+
+  QVector<NodeBox> boxes(nodes.size());
+  for (int i = 0; i < nodes.size(); i++)
+  {
+    boxes[i] = {shapes.at(i), QPointF(input.x.at(i), input.y.at(i)), input.widths.at(i) / 2, input.heights.at(i) / 2};
+  }
+  QVector<ClusterBox> clusters;
+  float left = 0, bottom = 0, right = 0, top = 0;
+  clusterBoxes(graph, graphSymbols, indexes, boxes, clusters, left, bottom, right, top);
+  for (int b = 0; b + 1 < input.bends.size(); b += 2)
+  {
+    left = qMin(left, input.bends.at(b));
+    right = qMax(right, input.bends.at(b));
+    bottom = qMin(bottom, input.bends.at(b + 1));
+    top = qMax(top, input.bends.at(b + 1));
+  }
+  // the loops go on the right of their nodes
+  QVector<int> loopCounts(nodes.size(), 0);
+  for (int e = 0; e < edges.size(); e++)
+  {
+    const int i = input.tails.at(e);
+    if (i == input.heads.at(e))
+    {
+      const NodeBox& box = boxes.at(i);
+      right = qMax(right, float(box.center.x()) + box.halfWidth + loopSize + edgeSpacing * loopCounts[i]++);
+    }
+  }
+  const Label graphLabel = readLabel(graph, graphSymbols, graphName, graphName, QString());
+  const float graphLabelHeight = graphLabel.isEmpty() ? 0 : graphLabel.height() + clusterMargin;
+
+  // the drawing starts at the origin, the graph label being below
+  const QPointF offset(clusterMargin - left, clusterMargin + graphLabelHeight - bottom);
+  const float width = qMax(right - left + 2 * clusterMargin, graphLabel.width() + 2 * clusterMargin);
+  const float height = top - bottom + 2 * clusterMargin + graphLabelHeight;
+  for (NodeBox& box : boxes)
+  {
+    box.center += offset;
+  }
+
+  DotGraph* model = new DotGraph(layoutCommand, dotFileName);
+  model->updateWithGraph(graph);
+  const QSharedPointer<DotRenderOpArena> arena = QSharedPointer<DotRenderOpArena>::create();
+  const QString black = QStringLiteral("#000000");
+
+  DotRenderOpVec graphOps(arena);
+  appendLabel(graphOps, graphLabel, width / 2, clusterMargin + graphLabelHeight / 2);
+  model->setRenderOperations(graphOps);
+  model->width(width);
+  model->height(height);
+  model->attributes()["bb"] = QStringLiteral("0,0,") % point(width, height);
+  if (!graphLabel.isEmpty())
+  {
+    model->attributes()["lp"] = point(width / 2, clusterMargin + graphLabelHeight / 2);
+  }
+
+  for (const ClusterBox& cluster : clusters)
+  {
+    GraphSubgraph* subgraph = dynamic_cast<GraphSubgraph*>(model->elementNamed(QString::fromUtf8(agnameof(cluster.subgraph))));
+    if (subgraph == nullptr)
+    {
+      continue;
+    }
+    const float l = cluster.left + offset.x();
+    const float b = cluster.bottom + offset.y();
+    const float r = cluster.right + offset.x();
+    const float t = cluster.top + offset.y();
+    DotRenderOpVec ops(arena);
+    if (!hasStyle(cluster.subgraph, graphSymbols, "invis"))
+    {
+      const QString color = colorAttribute(cluster.subgraph, graphSymbols.color, black);
+      if (hasStyle(cluster.subgraph, graphSymbols, "filled"))
+      {
+        appendColor(ops, DotRenderOp::FillColor, colorAttribute(cluster.subgraph, graphSymbols.fillColor, color));
+        appendColor(ops, DotRenderOp::PenColor, colorAttribute(cluster.subgraph, graphSymbols.penColor, color));
+        appendPoints(ops, DotRenderOp::FilledPolygon, rectangle(l, b, r, t));
+      }
+      else
+      {
+        appendColor(ops, DotRenderOp::PenColor, colorAttribute(cluster.subgraph, graphSymbols.penColor, color));
+        appendPoints(ops, DotRenderOp::Polygon, rectangle(l, b, r, t));
+      }
+      appendLabel(ops, cluster.label, (l + r) / 2, t - cluster.label.height() / 2 - clusterMargin / 2);
+    }
+    subgraph->setRenderOperations(ops);
+    subgraph->attributes()["bb"] = point(l, b) % QLatin1Char(',') % point(r, t);
+    if (!cluster.label.isEmpty())
+    {
+      subgraph->attributes()["lp"] = point((l + r) / 2, t - cluster.label.height() / 2 - clusterMargin / 2);
+    }
+  }
+
+  for (int i = 0; i < nodes.size(); i++)
+  {
+    node_t* node = nodes.at(i);
+    const QString name = QString::fromUtf8(agnameof(node));
+    GraphNode* graphNode = dynamic_cast<GraphNode*>(model->elementNamed(name));
+    if (graphNode == nullptr)
+    {
+      continue;
+    }
+    const NodeBox& box = boxes.at(i);
+    const float x = box.center.x();
+    const float y = box.center.y();
+    DotRenderOpVec ops(arena);
+    if (!hasStyle(node, nodeSymbols, "invis"))
+    {
+      const QString color = colorAttribute(node, nodeSymbols.color, black);
+      const bool filled = hasStyle(node, nodeSymbols, "filled") || box.shape == PointShape;
+      appendColor(ops, DotRenderOp::PenColor, color);
+      if (filled)
+      {
+        appendColor(ops, DotRenderOp::FillColor,
+                    colorAttribute(node, nodeSymbols.fillColor, box.shape == PointShape ? color : QStringLiteral("#d3d3d3")));
+      }
+      const float hw = box.halfWidth;
+      const float hh = box.halfHeight;
+      switch (box.shape)
+      {
+        case BoxShape:
+          appendPoints(ops, filled ? DotRenderOp::FilledPolygon : DotRenderOp::Polygon, rectangle(x - hw, y - hh, x + hw, y + hh));
+          break;
+        case DiamondShape:
+          appendPoints(ops, filled ? DotRenderOp::FilledPolygon : DotRenderOp::Polygon,
+                       QVector<QPointF>() << QPointF(x, y - hh) << QPointF(x + hw, y) << QPointF(x, y + hh) << QPointF(x - hw, y));
+          break;
+        case PlainShape:
+          break;
+        default:
+          appendEllipse(ops, filled ? DotRenderOp::FilledEllipse : DotRenderOp::Ellipse, x, y, hw, hh);
+      }
+      if (box.shape != PointShape)
+      {
+        appendLabel(ops, readLabel(node, nodeSymbols, name, graphName, QStringLiteral("\\N")), x, y);
+      }
+    }
+    graphNode->setRenderOperations(ops);
+    DotAttributes& attributes = graphNode->attributes();
+    attributes["pos"] = point(x, y);
+    attributes["width"] = QString::number(2 * box.halfWidth / pointsPerInch, 'f', 4);
+    attributes["height"] = QString::number(2 * box.halfHeight / pointsPerInch, 'f', 4);
+  }
+
+  // the edges, numbered as in DotGraph::updateWithGraph
+  QHash< QPair<node_t*, node_t*>, int > parallelEdges;
+  // the edges already drawn between two nodes, in any direction
+  QHash< QPair<int, int>, int > drawnEdges;
+  loopCounts.fill(0);
+  for (int e = 0; e < edges.size(); e++)
+  {
+    edge_t* edge = edges.at(e);
+    const char* edgeKey = agnameof(edge);
+    const QString key = (edgeKey && edgeKey[0] != '%') ? QString::fromUtf8(edgeKey) : QString();
+    const int ordinal = key.isEmpty() ? parallelEdges[qMakePair(agtail(edge), aghead(edge))]++ : 0;
+    const QString edgeName = GraphEdge::edgeId(QString::fromUtf8(agnameof(agtail(edge))),
+                                               QString::fromUtf8(agnameof(aghead(edge))),
+                                               input.directed, key, ordinal);
+    GraphEdge* graphEdge = model->edgeNamed(edgeName);
+    if (graphEdge == nullptr)
+    {
+      continue;
+    }
+    const int tail = input.tails.at(e);
+    const int head = input.heads.at(e);
+    const NodeBox& tailBox = boxes.at(tail);
+    const NodeBox& headBox = boxes.at(head);
+
+    const QString dir = attribute(edge, edgeSymbols.dir, input.directed ? QStringLiteral("forward") : QStringLiteral("none"));
+    EdgePath path;
+    path.headArrow = (dir == QLatin1String("forward") || dir == QLatin1String("both"))
+                     && attribute(edge, edgeSymbols.arrowHead) != QLatin1String("none");
+    path.tailArrow = (dir == QLatin1String("back") || dir == QLatin1String("both"))
+                     && attribute(edge, edgeSymbols.arrowTail) != QLatin1String("none");
+
+    QVector<QPointF> bends;
+    if (!input.bendStarts.isEmpty())
+    {
+      for (int b = input.bendStarts.at(e); b < input.bendStarts.at(e + 1); b++)
+      {
+        bends.append(QPointF(input.bends.at(2 * b), input.bends.at(2 * b + 1)) + offset);
+      }
+    }
+    QVector<QPointF> controlPoints;
+    if (tail == head)
+    {
+      // a loop on the right of the node, the next ones around it
+      const float size = loopSize + edgeSpacing * loopCounts[tail]++;
+      const QPointF center = tailBox.center;
+      QPointF start = tailBox.border(center + QPointF(tailBox.halfWidth, tailBox.halfHeight / 2));
+      QPointF end = tailBox.border(center + QPointF(tailBox.halfWidth, -tailBox.halfHeight / 2));
+      const QPointF startControl(center.x() + tailBox.halfWidth + size, start.y() + size);
+      const QPointF endControl(center.x() + tailBox.halfWidth + size, end.y() - size);
+      if (path.headArrow)
+      {
+        path.headTip = shorten(end, endControl);
+      }
+      if (path.tailArrow)
+      {
+        path.tailTip = shorten(start, startControl);
+      }
+      controlPoints << start << startControl << endControl << end;
+    }
+    else
+    {
+      if (bends.isEmpty())
+      {
+        // the parallel edges are curved apart, on both sides of the straight line
+        const QPair<int, int> pair(qMin(tail, head), qMax(tail, head));
+        const int drawn = drawnEdges[pair]++;
+        if (drawn > 0)
+        {
+          const QPointF from = boxes.at(pair.first).center;
+          const QPointF to = boxes.at(pair.second).center;
+          const QPointF direction = to - from;
+          const float l = length(direction);
+          if (l > 0)
+          {
+            const float side = (drawn % 2 == 1) ? 1 : -1;
+            const float distance = side * edgeSpacing * ((drawn + 1) / 2);
+            bends.append((from + to) / 2 + QPointF(-direction.y(), direction.x()) * (distance / l));
+          }
+        }
+      }
+      path.points.append(tailBox.border(bends.isEmpty() ? headBox.center : bends.first()));
+      path.points += bends;
+      path.points.append(headBox.border(bends.isEmpty() ? tailBox.center : bends.last()));
+      if (path.headArrow)
+      {
+        path.headTip = shorten(path.points.last(), path.points.at(path.points.size() - 2));
+      }
+      if (path.tailArrow)
+      {
+        path.tailTip = shorten(path.points.first(), path.points.at(1));
+      }
+      controlPoints = spline(path.points);
+    }
+
+    DotRenderOpVec ops(arena);
+    DotRenderOpVec arrowheads(arena);
+    const Label label = readLabel(edge, edgeSymbols, edgeName, graphName, QString());
+    const QPointF middle = (path.points.isEmpty() || path.points.size() % 2 == 0)
+                           ? (controlPoints.at(controlPoints.size() / 2 - 1) + controlPoints.at(controlPoints.size() / 2)) / 2
+                           : path.points.at(path.points.size() / 2);
+    if (!hasStyle(edge, edgeSymbols, "invis"))
+    {
+      const QString color = colorAttribute(edge, edgeSymbols.color, black);
+      appendColor(ops, DotRenderOp::PenColor, color);
+      appendPoints(ops, DotRenderOp::BSpline, controlPoints);
+      if (path.headArrow)
+      {
+        appendArrowhead(arrowheads, path.headTip, controlPoints.last(), color);
+      }
+      if (path.tailArrow)
+      {
+        appendArrowhead(arrowheads, path.tailTip, controlPoints.first(), color);
+      }
+      appendLabel(ops, label, middle.x(), middle.y());
+    }
+    graphEdge->setRenderOperations(ops);
+    graphEdge->arrowheads() = arrowheads;
+
+    QString pos;
+    if (path.tailArrow)
+    {
+      pos += QStringLiteral("s,") % point(path.tailTip.x(), path.tailTip.y()) % QLatin1Char(' ');
+    }
+    if (path.headArrow)
+    {
+      pos += QStringLiteral("e,") % point(path.headTip.x(), path.headTip.y()) % QLatin1Char(' ');
+    }
+    for (int p = 0; p < controlPoints.size(); p++)
+    {
+      pos += ((p == 0) ? QString() : QStringLiteral(" ")) % point(controlPoints.at(p).x(), controlPoints.at(p).y());
+    }
+    DotAttributes& attributes = graphEdge->attributes();
+    attributes["pos"] = pos;
+    if (!label.isEmpty())
+    {
+      attributes["lp"] = point(middle.x(), middle.y());
+    }
+  }
+  qCDebug(KGRAPHVIEWERLIB_LOG) << nodes.size() << "nodes and" << edges.size() << "edges laid out with" << layoutCommand
+                               << "in" << layoutTime << "ms, drawn in" << timer.elapsed() - layoutTime << "ms";
+  return model;
+}
+
+}
@@ -0,0 +1,129 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+/*
+ * Layout engines built in the part library
+ */
+
+#ifndef DOT_NATIVE_LAYOUT_H
+#define DOT_NATIVE_LAYOUT_H
+
+#include <QAtomicInt>
+#include <QPair>
+#include <QString>
+#include <QThread>
+#include <QVector>
+#include <QtConcurrentMap>
+
+#include <graphviz/gvc.h>
+
+namespace KGraphViewer
+{
+
+class DotGraph;
+
+/**
+ * The graph given to a built-in layout engine: its nodes and edges by
+ * index, with the sizes of the nodes. The engine gives back the positions.
+ */
+struct DotNativeGraph
+{
+  /** The sizes of the nodes, in points */
+  QVector<float> widths;
+  QVector<float> heights;
+  /** The ends of the edges, by node index, loops and parallel edges included */
+  QVector<int> tails;
+  QVector<int> heads;
+  bool directed = true;
+  /** The space between the nodes of a rank and between the ranks, in points, for the layered engine */
+  float nodeSeparation = 18;
+  float rankSeparation = 36;
+
+  /** @name Set by the engine */
+  //@{
+  /** The centers of the nodes, in points, the y axis going up */
+  QVector<float> x;
+  QVector<float> y;
+  /**
+   * The bends of the edges, if the engine routes them: the ones of the edge
+   * i are the points bendStarts[i] to bendStarts[i+1] - 1 of bends, given
+   * as x y pairs. Left empty for straight edges.
+   */
+  QVector<int> bendStarts;
+  QVector<float> bends;
+  //@}
+
+  inline int nodeCount() const {return widths.size();}
+  inline int edgeCount() const {return tails.size();}
+};
+
+/**
+ * Lays out graphs with the engines of the library instead of the Graphviz
+ * programs, for the graphs too large for them. They are selected by their
+ * layout command, like the Graphviz ones, and build the model with its
+ * drawing operations directly, in the same form as the xdot ones.
+ */
+class DotNativeLayout
+{
+public:
+  /** The layout command of the multilevel force directed engine */
+  static inline QString forceDirectedCommand() {return QStringLiteral("kgraphviewer-force");}
+  /** The layout command of the layered engine, for directed graphs */
+  static inline QString layeredCommand() {return QStringLiteral("kgraphviewer-layered");}
+
+  /** true if layoutCommand selects a built-in engine */
+  static bool isNative(const QString& layoutCommand);
+
+  /**
+   * Lays out graph, read from dotFileName, with the built-in engine
+   * selected by layoutCommand, on all the cores.
+   * @param cancelled if given, the layout is abandoned as soon as it is set
+   * @return the laid out model or nullptr if cancelled
+   */
+  static DotGraph* layout(graph_t* graph, const QString& layoutCommand, const QString& dotFileName,
+                          const QAtomicInt* cancelled = nullptr);
+
+  static inline bool isCancelled(const QAtomicInt* cancelled) {return cancelled != nullptr && cancelled->load() != 0;}
+
+  /**
+   * Calls function(begin, end) for contiguous ranges covering [0, count),
+   * on all the cores, and returns when all are done.
+   * @param minimumRange the fewest items worth a range, under which they
+   * are processed on the calling thread
+   */
+  template <typename Function>
+  static void parallelFor(int count, Function function, int minimumRange = 1024)
+  {
+    const int rangeCount = qMin(4 * qMax(1, QThread::idealThreadCount()), (count + minimumRange - 1) / minimumRange);
+    if (rangeCount <= 1)
+    {
+      function(0, count);
+      return;
+    }
+    QVector< QPair<int, int> > ranges(rangeCount);
+    for (int i = 0; i < rangeCount; i++)
+    {
+      ranges[i] = qMakePair(int(qint64(count) * i / rangeCount), int(qint64(count) * (i + 1) / rangeCount));
+    }
+    QtConcurrent::blockingMap(ranges, [&function](const QPair<int, int>& range) {function(range.first, range.second);});
+  }
+};
+
+}
+
+#endif
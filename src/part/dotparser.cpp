@@ -0,0 +1,778 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+#include "dotparser.h"
+#include "dotgraph.h"
+#include "DotGraphParsingHelper.h"
+#include "kgraphviewerlib_debug.h"
+
+#include <QDebug>
+#include <QFuture>
+#include <QIODevice>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+#include <cstring>
+
+namespace KGraphViewer
+{
+
+DotParser::DotParser(DotGraphParsingHelper& helper) :
+    m_helper(helper),
+    m_state(ExpectGraph),
+    m_portReturnState(AfterStatementId),
+    m_subgraphIsEdgeOperand(false),
+    m_kind(NodeStatement),
+    m_statementId(),
+    m_attributeKey(),
+    m_blocks()
+{
+}
+
+bool DotParser::parse(const char* first, const char* last)
+{
+  DotLexer lexer(first, last);
+  DotToken token;
+  do
+  {
+    token = lexer.next();
+    if (!push(token))
+    {
+      return false;
+    }
+  } while (token.type != DotToken::End);
+  return true;
+}
+
+namespace
+{
+
+/** The size of the chunks of the input tokenized in parallel */
+const std::ptrdiff_t chunkSize = 1 << 20;
+
+/** A part of the input tokenized by one thread */
+struct DotTokenChunk
+{
+  /** Where the lexing starts: a line beginning, maybe not outside strings */
+  const char* first;
+  /** The tokens starting before last belong to this chunk */
+  const char* last;
+  /** The end of the input */
+  const char* end;
+  std::vector<DotToken> tokens;
+  /** The start of the first token after the chunk, or end */
+  const char* next;
+};
+
+void tokenizeChunk(DotTokenChunk& chunk)
+{
+  // the lexer may go past last to complete a token
+  DotLexer lexer(chunk.first, chunk.end);
+  for (;;)
+  {
+    const DotToken token = lexer.next();
+    if (token.type == DotToken::End || token.text.first >= chunk.last)
+    {
+      chunk.next = token.text.first;
+      return;
+    }
+    chunk.tokens.push_back(token);
+  }
+}
+
+/**
+ * Splits the input from first in at most count chunks, each one ending after
+ * a newline.
+ * @return the end of the last chunk
+ */
+const char* splitWindow(const char* first, const char* end, int count, std::vector<DotTokenChunk>& chunks)
+{
+  chunks.clear();
+  while (first != end && int(chunks.size()) < count)
+  {
+    const char* last = end;
+    if (end - first > chunkSize)
+    {
+      const char* newline = static_cast<const char*>(memchr(first + chunkSize, '\n', end - first - chunkSize));
+      last = (newline == nullptr) ? end : newline + 1;
+    }
+    DotTokenChunk chunk;
+    chunk.first = first;
+    chunk.last = last;
+    chunk.end = end;
+    chunk.next = end;
+    chunks.push_back(chunk);
+    first = last;
+  }
+  return first;
+}
+
+/**
+ * Pushes the tokens of chunk to parser. resume is the position from which
+ * the actual tokens are lexed: the start of a token or of the input. Until
+ * a token lexed from there starts where a token of the chunk starts, the
+ * tokens of the chunk cannot be trusted. From then on, the lexer being
+ * stateless between tokens, they are the same.
+ */
+bool replayChunk(DotParser& parser, const DotTokenChunk& chunk, const char*& resume)
+{
+  std::size_t i = 0;
+  if (resume != chunk.first)
+  {
+    DotLexer lexer(resume, chunk.end);
+    for (;;)
+    {
+      const DotToken token = lexer.next();
+      if (token.type == DotToken::End || token.text.first >= chunk.last)
+      {
+        // the chunk is covered by tokens starting before it
+        resume = token.text.first;
+        return true;
+      }
+      while (i < chunk.tokens.size() && chunk.tokens[i].text.first < token.text.first)
+      {
+        ++i;
+      }
+      if (i < chunk.tokens.size() && chunk.tokens[i].text.first == token.text.first)
+      {
+        break;
+      }
+      if (!parser.push(token))
+      {
+        return false;
+      }
+    }
+  }
+  for (; i < chunk.tokens.size(); ++i)
+  {
+    if (!parser.push(chunk.tokens[i]))
+    {
+      return false;
+    }
+  }
+  resume = chunk.next;
+  return true;
+}
+
+}
+
+bool DotParser::parseInParallel(const char* first, const char* last)
+{
+  const int threads = QThreadPool::globalInstance()->maxThreadCount();
+  if (threads < 2 || last - first < 4 * chunkSize)
+  {
+    return parse(first, last);
+  }
+
+  // The input is tokenized one window of a chunk per thread at a time, to
+  // bound the memory used by the tokens. The next window is tokenized while
+  // the current one is replayed.
+  std::vector<DotTokenChunk> windows[2];
+  QFuture<void> tokenized[2];
+  const char* split = splitWindow(first, last, threads, windows[0]);
+  tokenized[0] = QtConcurrent::map(windows[0], tokenizeChunk);
+
+  const char* resume = first;
+  bool result = true;
+  for (int current = 0; !windows[current].empty(); current = 1 - current)
+  {
+    const int following = 1 - current;
+    split = splitWindow(split, last, threads, windows[following]);
+    tokenized[following] = QtConcurrent::map(windows[following], tokenizeChunk);
+
+    tokenized[current].waitForFinished();
+    for (const DotTokenChunk& chunk : windows[current])
+    {
+      if (!replayChunk(*this, chunk, resume))
+      {
+        result = false;
+        break;
+      }
+    }
+    windows[current].clear();
+    if (!result)
+    {
+      // the chunks still being tokenized reference the input
+      tokenized[following].waitForFinished();
+      return false;
+    }
+  }
+  return push(DotToken(DotToken::End, last, last));
+}
+
+namespace
+{
+
+inline void pin(const DotStringRef& ref, const char*& first)
+{
+  if (ref.first != nullptr && (first == nullptr || ref.first < first))
+  {
+    first = ref.first;
+  }
+}
+
+inline void relocateRef(DotStringRef& ref, std::ptrdiff_t offset)
+{
+  if (ref.first != nullptr)
+  {
+    ref.first += offset;
+    ref.last += offset;
+  }
+}
+
+}
+
+const char* DotParser::pinned() const
+{
+  const char* first = nullptr;
+  pin(m_statementId.text, first);
+  pin(m_attributeKey.text, first);
+  pin(m_helper.subgraphid, first);
+  // the references are stored in input order
+  if (!m_helper.attributes.empty())
+  {
+    pin(m_helper.attributes.front().first, first);
+  }
+  if (!m_helper.edgebounds.empty())
+  {
+    pin(m_helper.edgebounds.front(), first);
+  }
+  for (const Block& block : m_blocks)
+  {
+    if (!block.edgebounds.empty())
+    {
+      pin(block.edgebounds.front(), first);
+    }
+  }
+  return first;
+}
+
+void DotParser::relocate(std::ptrdiff_t offset)
+{
+  relocateRef(m_statementId.text, offset);
+  relocateRef(m_attributeKey.text, offset);
+  relocateRef(m_helper.subgraphid, offset);
+  for (auto& attribute : m_helper.attributes)
+  {
+    relocateRef(attribute.first, offset);
+    relocateRef(attribute.second, offset);
+  }
+  for (DotStringRef& bound : m_helper.edgebounds)
+  {
+    relocateRef(bound, offset);
+  }
+  for (Block& block : m_blocks)
+  {
+    for (DotStringRef& bound : block.edgebounds)
+    {
+      relocateRef(bound, offset);
+    }
+  }
+}
+
+bool DotParser::error(const DotToken& token, const char* expected)
+{
+  qCWarning(KGRAPHVIEWERLIB_LOG) << "DOT syntax error:" << expected << "expected but got"
+                                 << (token.type == DotToken::End ? QString("end of input") : token.text.toString());
+  m_state = Failed;
+  return false;
+}
+
+void DotParser::checkEdgeOp(const DotToken& token)
+{
+  const bool directed = m_helper.graph->directed();
+  if ((directed && token.text == "->") || (!directed && token.text == "--"))
+  {
+    return;
+  }
+  qCWarning(KGRAPHVIEWERLIB_LOG) << "Error !! uncoherent relation : directed = '" << directed << "' and op = '" << token.text.toString() << "'";
+}
+
+void DotParser::openSubgraph(bool edgeOperand)
+{
+  Block block;
+  block.edgeOperand = edgeOperand;
+  if (edgeOperand)
+  {
+    // the statements of the subgraph must not see the bounds of the
+    // enclosing edge statement
+    block.edgebounds.swap(m_helper.edgebounds);
+  }
+  m_blocks.push_back(block);
+
+  m_helper.createsubgraph();
+  m_helper.incrz();
+  m_helper.pushAttrList();
+  m_state = ExpectStatement;
+}
+
+bool DotParser::closeBlock()
+{
+  if (m_blocks.size() == 1)
+  {
+    m_blocks.clear();
+    m_helper.finalactions();
+    m_state = Finished;
+    return true;
+  }
+
+  m_helper.decrz();
+  m_helper.popAttrList();
+
+  Block& block = m_blocks.back();
+  if (block.edgeOperand)
+  {
+    m_helper.edgebounds.swap(block.edgebounds);
+    m_kind = EdgeStatement;
+    m_state = AfterEdgeOperand;
+  }
+  else
+  {
+    m_state = AfterSubgraph;
+  }
+  m_blocks.pop_back();
+  return true;
+}
+
+void DotParser::finishStatement()
+{
+  switch (m_kind)
+  {
+    case NodeStatement:
+      m_helper.createnode(m_statementId.value());
+      m_helper.setnodeattributes();
+      break;
+    case EdgeStatement:
+      m_helper.createedges();
+      break;
+    case GraphAttributesStatement:
+      m_helper.setattributedlist();
+      if (m_helper.z == 1) // main graph
+      {
+        m_helper.setgraphattributes();
+      }
+      else
+      {
+        m_helper.setsubgraphattributes();
+      }
+      break;
+    case NodeAttributesStatement:
+    case EdgeAttributesStatement:
+      m_helper.setattributedlist();
+      break;
+  }
+  m_helper.attributes.clear();
+  m_statementId = DotToken();
+  m_state = ExpectStatement;
+}
+
+bool DotParser::push(const DotToken& token)
+{
+  if (token.type == DotToken::Error || token.type == DotToken::Incomplete)
+  {
+    return error(token, "a valid token");
+  }
+
+  // some tokens end the current construct and have then to be handled again
+  // in the new state
+  for (;;)
+  {
+    switch (m_state)
+    {
+      case ExpectGraph:
+        if (token.isKeyword("strict"))
+        {
+          m_helper.graph->strict(true);
+          return true;
+        }
+        if (token.isKeyword("graph") || token.isKeyword("digraph"))
+        {
+          m_helper.graph->directed(token.isKeyword("digraph"));
+          m_state = ExpectGraphIdOrBrace;
+          return true;
+        }
+        return error(token, "graph or digraph");
+
+      case ExpectGraphIdOrBrace:
+        if (token.isId())
+        {
+          // the quotes are kept in the graph id
+          m_helper.graph->setId(token.text.toString());
+          m_state = ExpectGraphBrace;
+          return true;
+        }
+        // fall through
+      case ExpectGraphBrace:
+        if (token.type == DotToken::LeftBrace)
+        {
+          m_blocks.push_back(Block());
+          m_blocks.back().edgeOperand = false;
+          m_state = ExpectStatement;
+          return true;
+        }
+        return error(token, "{");
+
+      case ExpectStatement:
+        switch (token.type)
+        {
+          case DotToken::Semicolon:
+            return true;
+          case DotToken::RightBrace:
+            return closeBlock();
+          case DotToken::LeftBrace:
+            m_helper.subgraphid = DotStringRef();
+            openSubgraph(false);
+            return true;
+          case DotToken::Id:
+            if (token.isKeyword("subgraph"))
+            {
+              m_subgraphIsEdgeOperand = false;
+              m_state = ExpectSubgraphIdOrBrace;
+              return true;
+            }
+            if (token.isKeyword("graph") || token.isKeyword("node") || token.isKeyword("edge"))
+            {
+              if (token.isKeyword("graph"))
+              {
+                m_kind = GraphAttributesStatement;
+                m_helper.attributed = "graph";
+              }
+              else if (token.isKeyword("node"))
+              {
+                m_kind = NodeAttributesStatement;
+                m_helper.attributed = "node";
+              }
+              else
+              {
+                m_kind = EdgeAttributesStatement;
+                m_helper.attributed = "edge";
+              }
+              m_state = ExpectAttributeList;
+              return true;
+            }
+            // fall through
+          case DotToken::QuotedId:
+          case DotToken::HtmlId:
+            m_statementId = token;
+            m_state = AfterStatementId;
+            return true;
+          default:
+            return error(token, "a statement");
+        }
+
+      case AfterStatementId:
+        switch (token.type)
+        {
+          case DotToken::Equal:
+            m_state = ExpectAssignedValue;
+            return true;
+          case DotToken::Colon:
+            m_portReturnState = AfterStatementId;
+            m_state = ExpectPort;
+            return true;
+          case DotToken::EdgeOp:
+            checkEdgeOp(token);
+            m_kind = EdgeStatement;
+            m_helper.edgebounds.clear();
+            m_helper.edgebound(m_statementId.value());
+            m_statementId = DotToken();
+            m_state = ExpectEdgeOperand;
+            return true;
+          case DotToken::LeftBracket:
+            m_kind = NodeStatement;
+            m_state = InAttributeList;
+            return true;
+          default:
+            m_kind = NodeStatement;
+            finishStatement();
+            continue;
+        }
+
+      case ExpectAssignedValue:
+        // ID '=' ID statements are ignored
+        if (token.isId())
+        {
+          m_statementId = DotToken();
+          m_state = ExpectStatement;
+          return true;
+        }
+        return error(token, "a value");
+
+      case ExpectPort:
+        if (token.isId())
+        {
+          m_state = AfterPort;
+          return true;
+        }
+        return error(token, "a port");
+
+      case AfterPort:
+        if (token.type == DotToken::Colon)
+        {
+          m_state = ExpectCompassPoint;
+          return true;
+        }
+        m_state = m_portReturnState;
+        continue;
+
+      case ExpectCompassPoint:
+        if (token.isId())
+        {
+          m_state = m_portReturnState;
+          return true;
+        }
+        return error(token, "a compass point");
+
+      case ExpectEdgeOperand:
+        if (token.type == DotToken::LeftBrace)
+        {
+          m_helper.subgraphid = DotStringRef();
+          openSubgraph(true);
+          return true;
+        }
+        if (token.isKeyword("subgraph"))
+        {
+          m_subgraphIsEdgeOperand = true;
+          m_state = ExpectSubgraphIdOrBrace;
+          return true;
+        }
+        if (token.isId())
+        {
+          m_helper.edgebound(token.value());
+          m_state = AfterEdgeOperand;
+          return true;
+        }
+        return error(token, "a node or a subgraph");
+
+      case AfterEdgeOperand:
+        switch (token.type)
+        {
+          case DotToken::EdgeOp:
+            checkEdgeOp(token);
+            m_state = ExpectEdgeOperand;
+            return true;
+          case DotToken::Colon:
+            m_portReturnState = AfterEdgeOperand;
+            m_state = ExpectPort;
+            return true;
+          case DotToken::LeftBracket:
+            m_state = InAttributeList;
+            return true;
+          default:
+            finishStatement();
+            continue;
+        }
+
+      case ExpectSubgraphIdOrBrace:
+        if (token.type == DotToken::LeftBrace)
+        {
+          m_helper.subgraphid = DotStringRef();
+          openSubgraph(m_subgraphIsEdgeOperand);
+          return true;
+        }
+        if (token.isId())
+        {
+          m_helper.subgraphid = token.value();
+          m_state = AfterSubgraphId;
+          return true;
+        }
+        return error(token, "a subgraph id or {");
+
+      case AfterSubgraphId:
+        if (token.type == DotToken::LeftBrace)
+        {
+          openSubgraph(m_subgraphIsEdgeOperand);
+          return true;
+        }
+        // a reference to a subgraph: nothing to create
+        m_helper.subgraphid = DotStringRef();
+        m_state = m_subgraphIsEdgeOperand ? AfterEdgeOperand : AfterSubgraph;
+        continue;
+
+      case AfterSubgraph:
+        if (token.type == DotToken::EdgeOp)
+        {
+          // subgraphs are not used as edge bounds
+          checkEdgeOp(token);
+          m_kind = EdgeStatement;
+          m_helper.edgebounds.clear();
+          m_state = ExpectEdgeOperand;
+          return true;
+        }
+        m_state = ExpectStatement;
+        continue;
+
+      case ExpectAttributeList:
+        if (token.type == DotToken::LeftBracket)
+        {
+          m_state = InAttributeList;
+          return true;
+        }
+        return error(token, "[");
+
+      case InAttributeList:
+        if (token.type == DotToken::RightBracket)
+        {
+          m_state = AfterAttributeList;
+          return true;
+        }
+        if (token.type == DotToken::Comma || token.type == DotToken::Semicolon)
+        {
+          return true;
+        }
+        if (token.isId())
+        {
+          m_attributeKey = token;
+          m_state = AfterAttributeKey;
+          return true;
+        }
+        return error(token, "an attribute or ]");
+
+      case AfterAttributeKey:
+        if (token.type == DotToken::Equal)
+        {
+          m_state = ExpectAttributeValue;
+          return true;
+        }
+        m_helper.attributes.push_back(std::make_pair(m_attributeKey.value(), DotStringRef()));
+        m_attributeKey = DotToken();
+        m_state = InAttributeList;
+        continue;
+
+      case ExpectAttributeValue:
+        if (token.isId())
+        {
+          m_helper.attributes.push_back(std::make_pair(m_attributeKey.value(), token.value()));
+          m_attributeKey = DotToken();
+          m_state = InAttributeList;
+          return true;
+        }
+        return error(token, "an attribute value");
+
+      case AfterAttributeList:
+        if (token.type == DotToken::LeftBracket)
+        {
+          m_state = InAttributeList;
+          return true;
+        }
+        finishStatement();
+        continue;
+
+      case Finished:
+        if (token.type == DotToken::End)
+        {
+          return true;
+        }
+        return error(token, "end of input");
+
+      case Failed:
+        return false;
+    }
+  }
+}
+
+DotStreamParser::DotStreamParser(DotGraphParsingHelper& helper) :
+    m_parser(helper),
+    m_buffer(),
+    m_position(0),
+    m_failed(false)
+{
+}
+
+bool DotStreamParser::readFrom(QIODevice* device)
+{
+  if (m_failed)
+  {
+    return false;
+  }
+  const qint64 available = device->bytesAvailable();
+  if (available <= 0)
+  {
+    return true;
+  }
+
+  // Drop the bytes that are neither referenced by the parser nor part of an
+  // incomplete token. To amortize the move, this is done only when they make
+  // up at least half of the buffer.
+  const char* oldBase = m_buffer.constData();
+  int discarded = m_position;
+  const char* pinned = m_parser.pinned();
+  if (pinned != nullptr && pinned - oldBase < discarded)
+  {
+    discarded = int(pinned - oldBase);
+  }
+  if (discarded < m_buffer.size() / 2)
+  {
+    discarded = 0;
+  }
+  else
+  {
+    m_buffer.remove(0, discarded);
+    m_position -= discarded;
+  }
+
+  const int size = m_buffer.size();
+  m_buffer.resize(size + int(available));
+  const qint64 read = device->read(m_buffer.data() + size, available);
+  m_buffer.resize(size + int(qMax(read, qint64(0))));
+
+  // the buffer may have been reallocated or its content moved
+  const std::ptrdiff_t offset = reinterpret_cast<std::intptr_t>(m_buffer.constData())
+                              - reinterpret_cast<std::intptr_t>(oldBase + discarded);
+  if (offset != 0)
+  {
+    m_parser.relocate(offset);
+  }
+  return parseAvailable(false);
+}
+
+bool DotStreamParser::finish()
+{
+  if (m_failed || !parseAvailable(true))
+  {
+    return false;
+  }
+  return m_parser.isFinished();
+}
+
+bool DotStreamParser::parseAvailable(bool atEnd)
+{
+  const char* base = m_buffer.constData();
+  DotLexer lexer(base + m_position, base + m_buffer.size(), atEnd);
+  for (;;)
+  {
+    const DotToken token = lexer.next();
+    if (token.type == DotToken::Incomplete)
+    {
+      break;
+    }
+    if (!m_parser.push(token))
+    {
+      m_failed = true;
+      return false;
+    }
+    if (token.type == DotToken::End)
+    {
+      break;
+    }
+  }
+  m_position = int(lexer.position() - base);
+  return true;
+}
+
+}
@@ -0,0 +1,189 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+/*
+ * Graphviz DOT graph parser
+ */
+
+#ifndef DOT_PARSER_H
+#define DOT_PARSER_H
+
+#include "dotlexer.h"
+
+#include <QByteArray>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class QIODevice;
+
+namespace KGraphViewer
+{
+
+struct DotGraphParsingHelper;
+
+/**
+ * A parser of the DOT language building its graph through a
+ * DotGraphParsingHelper.
+ *
+ * It is written as a state machine to which the tokens are pushed one after
+ * the other, so that no recursion is necessary for deeply nested graphs and
+ * so that a graph can be parsed while its text is still being produced. The
+ * tokens it keeps references to must stay valid until the statement using
+ * them is complete.
+ */
+class DotParser
+{
+public:
+  explicit DotParser(DotGraphParsingHelper& helper);
+
+  /** Parses the whole DOT graph held in [first, last) */
+  bool parse(const char* first, const char* last);
+
+  /**
+   * Parses the whole DOT graph held in [first, last), like parse(), but
+   * tokenizes it on all the cores. The input is split in chunks starting at
+   * line beginnings, which may fall inside a quoted string, an HTML string or
+   * a comment: the tokens of a chunk are then only used from the point where
+   * they get in sync with the ones of the previous chunk, the rest being
+   * lexed again. The statements are built sequentially, in input order.
+   */
+  bool parseInParallel(const char* first, const char* last);
+
+  /**
+   * Gives the next token of the graph to the parser.
+   * @return false on syntax error
+   */
+  bool push(const DotToken& token);
+
+  inline bool isFinished() const {return m_state == Finished;}
+
+  /**
+   * The first byte of the input still referenced by the parser or by its
+   * helper, or nullptr if no reference is kept. Everything before can be
+   * discarded from the input buffer.
+   */
+  const char* pinned() const;
+
+  /**
+   * To be called when the input buffer has been moved in memory: shifts all
+   * the references kept to it by offset bytes.
+   */
+  void relocate(std::ptrdiff_t offset);
+
+private:
+  enum State
+  {
+    ExpectGraph,
+    ExpectGraphIdOrBrace,
+    ExpectGraphBrace,
+    ExpectStatement,
+    AfterStatementId,
+    ExpectAssignedValue,
+    ExpectPort,
+    AfterPort,
+    ExpectCompassPoint,
+    ExpectEdgeOperand,
+    AfterEdgeOperand,
+    ExpectSubgraphIdOrBrace,
+    AfterSubgraphId,
+    AfterSubgraph,
+    ExpectAttributeList,
+    InAttributeList,
+    AfterAttributeKey,
+    ExpectAttributeValue,
+    AfterAttributeList,
+    Finished,
+    Failed
+  };
+
+  enum StatementKind
+  {
+    NodeStatement,
+    EdgeStatement,
+    GraphAttributesStatement,
+    NodeAttributesStatement,
+    EdgeAttributesStatement
+  };
+
+  /** A {} block: the graph itself or a subgraph */
+  struct Block
+  {
+    /** true if the subgraph is an operand of an edge statement */
+    bool edgeOperand;
+    /** The bounds of this edge statement, saved while parsing the subgraph */
+    std::vector<DotStringRef> edgebounds;
+  };
+
+  bool error(const DotToken& token, const char* expected);
+  void checkEdgeOp(const DotToken& token);
+  void openSubgraph(bool edgeOperand);
+  bool closeBlock();
+  void finishStatement();
+
+  DotGraphParsingHelper& m_helper;
+  State m_state;
+  State m_portReturnState;
+  bool m_subgraphIsEdgeOperand;
+  StatementKind m_kind;
+  DotToken m_statementId;
+  DotToken m_attributeKey;
+  std::vector<Block> m_blocks;
+};
+
+/**
+ * Parses a DOT graph while it is being read, typically from the standard
+ * output of a running layout process, so that the model is built while the
+ * layout program is still writing.
+ *
+ * A single buffer is kept: it holds the input not yet parsed and the parts
+ * still referenced by the parser, the rest being discarded as new data
+ * arrives.
+ */
+class DotStreamParser
+{
+public:
+  explicit DotStreamParser(DotGraphParsingHelper& helper);
+
+  /**
+   * Reads all the data currently available on device and parses the
+   * complete tokens it contains.
+   * @return false on syntax error
+   */
+  bool readFrom(QIODevice* device);
+
+  /**
+   * To be called once all the input has been read.
+   * @return true if a whole graph has been parsed
+   */
+  bool finish();
+
+private:
+  bool parseAvailable(bool atEnd);
+
+  DotParser m_parser;
+  QByteArray m_buffer;
+  /** The offset in the buffer of the first byte not tokenized yet */
+  int m_position;
+  bool m_failed;
+};
+
+}
+
+#endif
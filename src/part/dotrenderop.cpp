@@ -0,0 +1,220 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+#include "dotrenderop.h"
+#include "dotgrammar.h"
+
+#include <limits>
+
+namespace
+{
+
+/** The number of coordinates of an operation */
+int coordinatesCount(const DotRenderOp& op)
+{
+  switch (op.code)
+  {
+    case DotRenderOp::Polygon:
+    case DotRenderOp::FilledPolygon:
+    case DotRenderOp::Polyline:
+    case DotRenderOp::BSpline:
+    case DotRenderOp::FilledBSpline:
+      return 2 * op.count;
+    case DotRenderOp::Ellipse:
+    case DotRenderOp::FilledEllipse:
+    case DotRenderOp::Text:
+    case DotRenderOp::Image:
+      return 4;
+    case DotRenderOp::Font:
+    case DotRenderOp::FontCharacteristics:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+bool hasText(const DotRenderOp& op)
+{
+  return op.code == DotRenderOp::PenColor || op.code == DotRenderOp::FillColor
+      || op.code == DotRenderOp::Style || op.code == DotRenderOp::Text
+      || op.code == DotRenderOp::Font || op.code == DotRenderOp::Image;
+}
+
+}
+
+quint32 DotRenderOpVec::nextCoordinate()
+{
+  if (m_arena.isNull())
+  {
+    m_arena = QSharedPointer<DotRenderOpArena>::create();
+  }
+  return m_arena->coordinates.size();
+}
+
+quint32 DotRenderOpVec::internText(const QString& text)
+{
+  QHash<QString, quint32>::const_iterator it = m_arena->textIndexes.constFind(text);
+  if (it != m_arena->textIndexes.constEnd())
+  {
+    return it.value();
+  }
+  const quint32 index = m_arena->strings.size();
+  m_arena->strings.append(text);
+  m_arena->colors.append(QColor());
+  m_arena->textIndexes.insert(text, index);
+  return index;
+}
+
+quint32 DotRenderOpVec::internColor(const QString& color)
+{
+  QHash<QString, quint32>::const_iterator it = m_arena->colorIndexes.constFind(color);
+  if (it != m_arena->colorIndexes.constEnd())
+  {
+    return it.value();
+  }
+  // a color is either a name or #rrggbb followed by an optional alpha
+  const QString name = color.left(7);
+  QColor c(name);
+  bool ok;
+  c.setAlpha(255 - color.mid(8).toInt(&ok, 16));
+
+  const quint32 index = m_arena->strings.size();
+  m_arena->strings.append(name);
+  m_arena->colors.append(c);
+  m_arena->colorIndexes.insert(color, index);
+  return index;
+}
+
+void DotRenderOpVec::appendXdot(const char* first, const char* last)
+{
+  nextCoordinate();
+  QByteArray& xdot = m_arena->xdot;
+  if (last - first > std::numeric_limits<int>::max() - xdot.size())
+  {
+    // the buffer is full: decode now, after the pending strings
+    decode();
+    parse_renderop(first, last, *this);
+    return;
+  }
+  m_pending.append(qMakePair(xdot.size(), int(last - first)));
+  xdot.append(first, int(last - first));
+}
+
+void DotRenderOpVec::decode()
+{
+  if (m_pending.isEmpty())
+  {
+    return;
+  }
+  QVector< QPair<int, int> > pending;
+  pending.swap(m_pending);
+  // the decoding only appends to the other arena buffers
+  const char* xdot = m_arena->xdot.constData();
+  for (const QPair<int, int>& string : pending)
+  {
+    parse_renderop(xdot + string.first, xdot + string.first + string.second, *this);
+  }
+}
+
+DotRenderOpVec DotRenderOpVec::decoded(const QSharedPointer<DotRenderOpArena>& arena) const
+{
+  DotRenderOpVec result(arena);
+  if (!m_ops.isEmpty())
+  {
+    result.appendCopies(*this, 0, 0);
+  }
+  const char* xdot = m_arena->xdot.constData();
+  for (const QPair<int, int>& string : m_pending)
+  {
+    parse_renderop(xdot + string.first, xdot + string.first + string.second, result);
+  }
+  return result;
+}
+
+DotRenderOpVec& DotRenderOpVec::operator+=(const DotRenderOpVec& other)
+{
+  decode();
+  if (other.hasPending())
+  {
+    DotRenderOpVec decoded(other);
+    decoded.decode();
+    return *this += decoded;
+  }
+  if (other.isEmpty())
+  {
+    return *this;
+  }
+  if (m_ops.isEmpty() && m_arena.isNull())
+  {
+    m_arena = other.m_arena;
+  }
+  if (m_arena == other.m_arena)
+  {
+    m_ops += other.m_ops;
+    return *this;
+  }
+
+  appendCopies(other, 0, 0);
+  return *this;
+}
+
+void DotRenderOpVec::appendTranslated(const DotRenderOpVec& other, float dx, float dy)
+{
+  decode();
+  if (other.hasPending())
+  {
+    DotRenderOpVec decoded(other);
+    decoded.decode();
+    appendTranslated(decoded, dx, dy);
+    return;
+  }
+  if (!other.isEmpty())
+  {
+    appendCopies(other, dx, dy);
+  }
+}
+
+void DotRenderOpVec::appendCopies(const DotRenderOpVec& other, float dx, float dy)
+{
+  nextCoordinate();
+  for (DotRenderOp op : other.m_ops)
+  {
+    const float* coordinates = other.coordinates(op);
+    const int count = coordinatesCount(op);
+    // all the points of a polygon, polyline or B-spline, only the position
+    // of an ellipse, a text or an image and nothing for the other ones
+    const bool points = op.isPolygon() || op.isBSpline() || op.code == DotRenderOp::Polyline;
+    const int moved = points ? count : (count == 4 ? 2 : 0);
+    op.coordinates = nextCoordinate();
+    for (int i = 0; i < count; i++)
+    {
+      appendCoordinate(i < moved ? coordinates[i] + ((i % 2 == 0) ? dx : dy) : coordinates[i]);
+    }
+    if (op.isColor())
+    {
+      m_arena->strings.append(other.text(op));
+      m_arena->colors.append(other.color(op));
+      op.text = m_arena->strings.size() - 1;
+    }
+    else if (hasText(op))
+    {
+      op.text = internText(other.text(op));
+    }
+    m_ops.append(op);
+  }
+}
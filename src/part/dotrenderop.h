@@ -19,21 +19,154 @@
 #ifndef DOT_RENDEROP_H
 #define DOT_RENDEROP_H
 
+#include <QByteArray>
+#include <QColor>
+#include <QHash>
+#include <QPair>
+#include <QSharedPointer>
 #include <QString>
-#include <QList>
-#include <QTextStream>
+#include <QVector>
 
 /**
- * members are interpreted in function of render operations definitions given at:
- * @URL http://www.graphviz.org/cvs/doc/info/output.html#d:dot
+ * An xdot drawing operation, as defined at:
+ * @URL http://www.graphviz.org/doc/info/output.html#d:xdot
+ *
+ * It is a plain value: its coordinates and its string are stored in the
+ * DotRenderOpArena of the DotRenderOpVec holding it.
  */
 struct DotRenderOp
 {
-  QString renderop;
-  QList< int > integers;
-  QString str;
+  enum Code : quint8
+  {
+    PenColor,            ///< c
+    FillColor,           ///< C
+    Style,               ///< S
+    Polygon,             ///< p
+    FilledPolygon,       ///< P
+    Polyline,            ///< L
+    BSpline,             ///< B
+    FilledBSpline,       ///< b
+    Ellipse,             ///< e
+    FilledEllipse,       ///< E
+    Text,                ///< T
+    Font,                ///< F
+    FontCharacteristics, ///< t
+    Image                ///< I
+  };
+
+  /** The xdot letter of the operation */
+  inline char name() const {return "cCSpPLBbeETFtI"[code];}
+
+  inline bool isColor() const {return code == PenColor || code == FillColor;}
+  inline bool isPolygon() const {return code == Polygon || code == FilledPolygon;}
+  inline bool isBSpline() const {return code == BSpline || code == FilledBSpline;}
+  inline bool isEllipse() const {return code == Ellipse || code == FilledEllipse;}
+
+  Code code;
+  /** The number of points of a polygon, polyline or B-spline */
+  quint32 count;
+  /**
+   * The index in the arena of the first coordinate. They are:
+   * - x1 y1 ... xn yn for polygons, polylines and B-splines,
+   * - x y w h for ellipses (w and h being the half axes) and images,
+   * - x y j w for texts,
+   * - the size for fonts and the flags for font characteristics.
+   */
+  quint32 coordinates;
+  /** The index in the arena of the color, style, font, text or image name */
+  quint32 text;
 };
 
-typedef QList< DotRenderOp > DotRenderOpVec;
+/**
+ * The storage shared by the drawing operations of a graph: all their
+ * coordinates in one array and their strings, each one stored once.
+ */
+struct DotRenderOpArena
+{
+  QVector<float> coordinates;
+  QVector<QString> strings;
+  /** For color strings, the color they define. Invalid for other strings. */
+  QVector<QColor> colors;
+  QHash<QString, quint32> textIndexes;
+  QHash<QString, quint32> colorIndexes;
+  /** The xdot strings whose decoding is deferred, one after the other */
+  QByteArray xdot;
+};
+
+/**
+ * The drawing operations of an element. Iterating them and accessing their
+ * data does not allocate memory.
+ *
+ * They can also be given as xdot strings, stored in the arena and decoded
+ * only when decode() is called. The operations still pending are not seen
+ * by the accessors.
+ */
+class DotRenderOpVec
+{
+public:
+  typedef QVector<DotRenderOp>::const_iterator const_iterator;
+
+  DotRenderOpVec() {}
+  explicit DotRenderOpVec(const QSharedPointer<DotRenderOpArena>& arena) : m_arena(arena) {}
+
+  inline bool isEmpty() const {return m_ops.isEmpty();}
+  inline int size() const {return m_ops.size();}
+  inline const DotRenderOp& at(int i) const {return m_ops.at(i);}
+  inline const_iterator begin() const {return m_ops.constBegin();}
+  inline const_iterator end() const {return m_ops.constEnd();}
+  inline const_iterator constBegin() const {return m_ops.constBegin();}
+  inline const_iterator constEnd() const {return m_ops.constEnd();}
+
+  inline const float* coordinates(const DotRenderOp& op) const {return m_arena->coordinates.constData() + op.coordinates;}
+  inline const QString& text(const DotRenderOp& op) const {return m_arena->strings.at(op.text);}
+  /** The color set by a PenColor or FillColor operation */
+  inline const QColor& color(const DotRenderOp& op) const {return m_arena->colors.at(op.text);}
+
+  inline const QSharedPointer<DotRenderOpArena>& arena() const {return m_arena;}
+
+  /** Appends the operations of other, copying their data if they use another arena */
+  DotRenderOpVec& operator+=(const DotRenderOpVec& other);
+  /**
+   * Appends copies of the operations of other moved by (dx, dy), when
+   * several drawings are packed in one. Only the positions move, not the
+   * sizes.
+   */
+  void appendTranslated(const DotRenderOpVec& other, float dx, float dy);
+
+  /** @name Building, used by the xdot decoder */
+  //@{
+  inline void append(const DotRenderOp& op) {m_ops.append(op);}
+  /** The index the next coordinate appended will have */
+  quint32 nextCoordinate();
+  inline void appendCoordinate(float value) {m_arena->coordinates.append(value);}
+  quint32 internText(const QString& text);
+  /** Stores the color name and the color it defines, with its alpha */
+  quint32 internColor(const QString& color);
+  //@}
+
+  /** @name Deferred decoding */
+  //@{
+  /** Stores a copy of the xdot string [first, last), to be decoded by decode() */
+  void appendXdot(const char* first, const char* last);
+  inline bool hasPending() const {return !m_pending.isEmpty();}
+  /** Decodes the pending xdot strings and appends their operations */
+  void decode();
+  /**
+   * A copy of these operations, with the pending ones decoded, built in
+   * arena. This vec is not modified and its arena is only read, so several
+   * vecs sharing an arena can be decoded at the same time, each into its own.
+   */
+  DotRenderOpVec decoded(const QSharedPointer<DotRenderOpArena>& arena) const;
+  //@}
+
+private:
+  /** Copies the decoded operations of other in this arena, moving them by (dx, dy) */
+  void appendCopies(const DotRenderOpVec& other, float dx, float dy);
+
+  QVector<DotRenderOp> m_ops;
+  /** The offsets and sizes in the arena xdot buffer of the strings to decode */
+  QVector< QPair<int, int> > m_pending;
+  QSharedPointer<DotRenderOpArena> m_arena;
+};
 
 #endif
@@ -0,0 +1,49 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+#include "dotrenderopcollector.h"
+#include "graphelement.h"
+
+#include <graphviz/gvc.h>
+
+#include <cstring>
+
+namespace KGraphViewer
+{
+
+DotRenderOpCollector::DotRenderOpCollector() :
+    m_arena(QSharedPointer<DotRenderOpArena>::create()),
+    m_attributeValues()
+{
+}
+
+void DotRenderOpCollector::add(GraphElement* element, void* object, std::initializer_list<const char*> attributes)
+{
+  DotRenderOpVec ops(m_arena);
+  for (const char* attribute : attributes)
+  {
+    const char* value = agget(object, const_cast<char*>(attribute));
+    if (value != nullptr && *value != '\0')
+    {
+      ops.appendXdot(value, value + strlen(value));
+    }
+  }
+  element->setRenderOperations(ops);
+}
+
+}
@@ -0,0 +1,68 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+/*
+ * Collection of the xdot attributes of a laid out graph, decoded later
+ */
+
+#ifndef DOT_RENDEROP_COLLECTOR_H
+#define DOT_RENDEROP_COLLECTOR_H
+
+#include "dotattributes.h"
+#include "dotrenderop.h"
+
+#include <QSharedPointer>
+
+#include <initializer_list>
+
+namespace KGraphViewer
+{
+
+class GraphElement;
+
+/**
+ * Gives the xdot attribute strings of the elements of a cgraph graph to the
+ * elements, while the model is updated. The strings are copied in an arena
+ * shared by all the elements and only decoded when the operations of an
+ * element are first used, typically just before it is first painted, when
+ * the view decodes those of all the exposed elements in parallel with
+ * GraphElement::decodeRenderOperations. The other attribute values are
+ * interned in a table living as long as the update.
+ */
+class DotRenderOpCollector
+{
+public:
+  DotRenderOpCollector();
+
+  /**
+   * Sets as operations of element the given xdot attributes, in this order,
+   * of the cgraph object (graph, node or edge).
+   */
+  void add(GraphElement* element, void* object, std::initializer_list<const char*> attributes);
+
+  /** Shares the attribute values copied to the elements during the update */
+  inline DotAttributeValues& attributeValues() {return m_attributeValues;}
+
+private:
+  QSharedPointer<DotRenderOpArena> m_arena;
+  DotAttributeValues m_attributeValues;
+};
+
+}
+
+#endif
@@ -74,7 +74,7 @@ void GraphEdge::colors(const QString& cs)
 
 const QString GraphEdge::color(uint i) 
 {
-  if (i >= (uint)m_colors.count() && m_attributes.find(KEY_COLOR) != m_attributes.end())
+  if (i >= (uint)m_colors.count() && m_attributes.contains(KEY_COLOR))
   {
     colors(m_attributes[KEY_COLOR]);
   }
@@ -91,10 +91,59 @@ const QString GraphEdge::color(uint i)
   }
 }
 
+namespace
+{
+
+/**
+ * Escapes with a backslash the characters separating the parts of an edge
+ * id, and the backslash itself, so that the parts cannot be confused
+ */
+QString escapedEdgeIdPart(const QString& part)
+{
+  // most names have nothing to escape: they are only copied if needed
+  QString escaped;
+  bool copying = false;
+  for (int i = 0; i < part.size(); i++)
+  {
+    const QChar c = part.at(i);
+    if (c == QLatin1Char('\\') || c == QLatin1Char('-') || c == QLatin1Char(':') || c == QLatin1Char('#'))
+    {
+      if (!copying)
+      {
+        escaped.reserve(part.size() + 4);
+        escaped += part.leftRef(i);
+        copying = true;
+      }
+      escaped += QLatin1Char('\\');
+    }
+    if (copying)
+    {
+      escaped += c;
+    }
+  }
+  return copying ? escaped : part;
+}
+
+}
+
+QString GraphEdge::edgeId(const QString& tail, const QString& head, bool directed, const QString& key, int ordinal)
+{
+  QString id = escapedEdgeIdPart(tail) + QLatin1String(directed ? "->" : "--") + escapedEdgeIdPart(head);
+  if (!key.isEmpty())
+  {
+    id += QLatin1Char(':') + escapedEdgeIdPart(key);
+  }
+  else if (ordinal > 0)
+  {
+    id += QLatin1Char('#') + QString::number(ordinal);
+  }
+  return id;
+}
+
 void GraphEdge::updateWithEdge(const GraphEdge& edge)
 {
   qCDebug(KGRAPHVIEWERLIB_LOG) << id() << edge.id();
-  m_arrowheads = edge.arrowheads();
+  m_arrowheads = edge.m_arrowheads;
   m_colors = edge.colors();
   m_dir = edge.dir();
   GraphElement::updateWithElement(edge);
@@ -105,49 +154,15 @@ void GraphEdge::updateWithEdge(const GraphEdge& edge)
   }
 }
 
-void GraphEdge::updateWithEdge(edge_t* edge)
+void GraphEdge::updateWithEdge(edge_t* edge, DotRenderOpCollector& collector)
 {
   qCDebug(KGRAPHVIEWERLIB_LOG);
-  DotRenderOpVec ops;
-  // decrease mem peak
-  setRenderOperations(ops);
-
-  if (agget(edge, (char*)"_draw_"))
-  {
-    parse_renderop(agget(edge, (char*)"_draw_"), ops);
-    qCDebug(KGRAPHVIEWERLIB_LOG) << "element renderOperations size is now " << ops.size();
-  }
-  if (agget(edge, (char*)"_ldraw_"))
-  {
-    parse_renderop(agget(edge, (char*)"_ldraw_"), ops);
-    qCDebug(KGRAPHVIEWERLIB_LOG) << "element renderOperations size is now " << ops.size();
-  }
-  if (agget(edge, (char*)"_hdraw_"))
-  {
-    parse_renderop(agget(edge, (char*)"_hdraw_"), ops);
-    qCDebug(KGRAPHVIEWERLIB_LOG) << "element renderOperations size is now " << ops.size();
-  }
-  if (agget(edge, (char*)"_tdraw_"))
-  {
-    parse_renderop(agget(edge, (char*)"_tdraw_"), ops);
-    qCDebug(KGRAPHVIEWERLIB_LOG) << "element renderOperations size is now " << ops.size();
-  }
-  if (agget(edge, (char*)"_hldraw_"))
-  {
-    parse_renderop(agget(edge, (char*)"_hldraw_"), ops);
-    qCDebug(KGRAPHVIEWERLIB_LOG) << "element renderOperations size is now " << ops.size();
-  }
-  if (agget(edge, (char*)"_tldraw_"))
-  {
-    parse_renderop(agget(edge, (char*)"_tldraw_"), ops);
-    qCDebug(KGRAPHVIEWERLIB_LOG) << "element renderOperations size is now " << ops.size();
-  }
-  setRenderOperations(ops);
+  collector.add(this, edge, {"_draw_", "_ldraw_", "_hdraw_", "_tdraw_", "_hldraw_", "_tldraw_"});
   Agsym_t *attr = agnxtattr(agraphof(agtail(edge)), AGEDGE, nullptr);
   while(attr)
   {
     qCDebug(KGRAPHVIEWERLIB_LOG) /*<< edge->name*/ << ":" << attr->name << agxget(edge,attr);
-    m_attributes[attr->name] = agxget(edge,attr);
+    m_attributes[attr->name] = collector.attributeValues().intern(agxget(edge,attr));
     attr = agnxtattr(agraphof(agtail(edge)), AGEDGE, attr);
   }
   
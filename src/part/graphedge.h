@@ -36,6 +36,7 @@
 #include "graphelement.h"
 #include "dotgrammar.h"
 #include "dotrenderop.h"
+#include "dotrenderopcollector.h"
 
 #include <graphviz/gvc.h>
 
@@ -89,11 +90,26 @@ public:
   inline const QString& dir() const {return m_dir;}
   inline void dir(const QString& dir) {m_dir = dir;}
 
-  inline QList< DotRenderOp >&  arrowheads() {return m_arrowheads;}
-  inline const QList< DotRenderOp >&  arrowheads() const {return m_arrowheads;}
+  /** The arrowheads drawing operations, decoded on first use */
+  inline DotRenderOpVec&  arrowheads() {m_arrowheads.decode(); return m_arrowheads;}
+  inline const DotRenderOpVec&  arrowheads() const {m_arrowheads.decode(); return m_arrowheads;}
+
+  /**
+   * The deterministic id of an edge without explicit id: "tail->head", or
+   * "tail--head" in an undirected graph, followed by ":key" for a keyed
+   * edge or by "#ordinal" for the second and next unkeyed parallel edges.
+   * Loading the same graph twice thus gives the same ids.
+   *
+   * The '-', ':', '#' and '\\' characters of the names and of the key are
+   * escaped by a backslash, so that two different (tail, head, key or
+   * ordinal) never give the same id: the second parallel edge a -> b is
+   * "a->b#1" while a -> "b#1" is "a->b\\#1".
+   */
+  static QString edgeId(const QString& tail, const QString& head, bool directed, const QString& key, int ordinal);
 
   void updateWithEdge(const GraphEdge& edge);
-  void updateWithEdge(edge_t* edge);
+  /** Updates from a laid out edge, giving its xdot attributes to collector, to be decoded on first use */
+  void updateWithEdge(edge_t* edge, DotRenderOpCollector& collector);
 
 private:
   // we have a _ce *and* _from/_to because for collapsed edges,
@@ -105,7 +121,7 @@ private:
 //   QVector< QPair< float, float > > m_edgePoints;
 //   float m_labelX, m_labelY;
   
-  QList< DotRenderOp > m_arrowheads;
+  mutable DotRenderOpVec m_arrowheads;
 };
 
 
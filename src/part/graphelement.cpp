@@ -24,26 +24,16 @@
 #include <math.h>
 
 #include <QDebug>
-
+#include <QPair>
 #include <QRegExp>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
 #include <graphviz/gvc.h>
 
 namespace KGraphViewer
 {
 
-const QString GraphElement::KEY_ID = QLatin1String("id");
-const QString GraphElement::KEY_STYLE = QLatin1String("style");
-const QString GraphElement::KEY_LABEL = QLatin1String("label");
-const QString GraphElement::KEY_SHAPE = QLatin1String("shape");
-const QString GraphElement::KEY_SHAPEFILE = QLatin1String("shapefile");
-const QString GraphElement::KEY_COLOR = QLatin1String("color");
-const QString GraphElement::KEY_BGCOLOR = QLatin1String("bgcolor");
-const QString GraphElement::KEY_URL = QLatin1String("URL");
-const QString GraphElement::KEY_FONTSIZE = QLatin1String("fontsize");
-const QString GraphElement::KEY_FONTNAME = QLatin1String("fontname");
-const QString GraphElement::KEY_FONTCOLOR = QLatin1String("fontcolor");
-const QString GraphElement::KEY_FILLCOLOR = QLatin1String("fillcolor");
-
 GraphElement::GraphElement() :
     QObject(),
     m_attributes(),
@@ -85,6 +75,64 @@ void GraphElement::setRenderOperations(const DotRenderOpVec& drov)
     ++m_renderOperationsRevision;
 }
 
+namespace
+{
+
+/**
+ * The elements are handed to the pool threads in ranges small enough for an
+ * idle thread to take over the work left by a busy one, but large enough
+ * to amortize the scheduling cost and to share strings in each arena.
+ */
+const int minimumElementsPerRange = 64;
+const int rangesPerThread = 8;
+
+}
+
+void GraphElement::decodeRenderOperations(const QVector<GraphElement*>& elements)
+{
+  QVector<GraphElement*> pending;
+  for (GraphElement* element : elements)
+  {
+    if (element->hasPendingRenderOperations())
+    {
+      pending.append(element);
+    }
+  }
+  const int threads = qMax(1, QThreadPool::globalInstance()->maxThreadCount());
+  const int rangeSize = qMax(minimumElementsPerRange, pending.size() / (threads * rangesPerThread));
+  if (threads == 1 || pending.size() <= rangeSize)
+  {
+    for (GraphElement* element : pending)
+    {
+      element->m_renderOperations.decode();
+    }
+    return;
+  }
+
+  QVector< QPair<int, int> > ranges;
+  for (int first = 0; first < pending.size(); first += rangeSize)
+  {
+    ranges.append(qMakePair(first, qMin(first + rangeSize, pending.size())));
+  }
+  qCDebug(KGRAPHVIEWERLIB_LOG) << "decoding" << pending.size() << "elements in" << ranges.size() << "ranges";
+  // the pool threads only read the elements and write distinct results
+  QVector<DotRenderOpVec> decoded(pending.size());
+  DotRenderOpVec* results = decoded.data();
+  GraphElement* const* sources = pending.constData();
+  QtConcurrent::blockingMap(ranges, [results, sources](const QPair<int, int>& range) {
+    const QSharedPointer<DotRenderOpArena> arena = QSharedPointer<DotRenderOpArena>::create();
+    for (int i = range.first; i < range.second; i++)
+    {
+      results[i] = sources[i]->m_renderOperations.decoded(arena);
+    }
+  });
+  // the same operations, decoded: the revision does not change
+  for (int i = 0; i < pending.size(); i++)
+  {
+    pending[i]->m_renderOperations = decoded[i];
+  }
+}
+
 void GraphElement::updateWithElement(const GraphElement& element)
 {
   qCDebug(KGRAPHVIEWERLIB_LOG) << element.id();
@@ -94,14 +142,14 @@ void GraphElement::updateWithElement(const GraphElement& element)
     m_z = element.z();
     modified = true;
   }
-  QMap <QString, QString >::const_iterator it = element.attributes().constBegin();
+  DotAttributes::const_iterator it = element.attributes().constBegin();
   for (;it != element.attributes().constEnd(); it++)
   {
-    const QString &attrib = it.key();
+    const int attrib = it.symbol();
     if ( (!m_attributes.contains(attrib)) || (m_attributes[attrib] != it.value()) )
     {
       m_attributes[attrib] = it.value();
-      if (attrib == "z")
+      if (attrib == DotAttributeSymbols::Z)
       {
         bool ok;
         setZ(m_attributes[attrib].toDouble(&ok));
@@ -113,17 +161,9 @@ void GraphElement::updateWithElement(const GraphElement& element)
   {
     qCDebug(KGRAPHVIEWERLIB_LOG) << "modified: update render operations";
     setRenderOperations(element.m_renderOperations);
-/*    foreach (DotRenderOp op, m_renderOperations)
+/*    for (const DotRenderOp& op : m_renderOperations)
     {
-      QString msg;
-      QTextStream dd(&msg);
-      dd << "an op: " << op.renderop << " ";
-      foreach (int i, op.integers)
-      {
-        dd << i << " ";
-      }
-      dd << op.str;
-      qCDebug(KGRAPHVIEWERLIB_LOG) << msg;
+      qCDebug(KGRAPHVIEWERLIB_LOG) << "an op: " << op.name();
     }
     g() << "modified: emiting changed";*/
     emit changed();
@@ -134,11 +174,11 @@ void GraphElement::updateWithElement(const GraphElement& element)
 
 QString GraphElement::backColor() const
 {
-  if (m_attributes.find(KEY_FILLCOLOR) != m_attributes.end())
+  if (m_attributes.contains(KEY_FILLCOLOR))
   {
     return m_attributes[KEY_FILLCOLOR];
   }
-  else if ( (m_attributes.find(KEY_COLOR) != m_attributes.end())
+  else if ( m_attributes.contains(KEY_COLOR)
     && (m_attributes[KEY_STYLE] == QLatin1String("filled")) )
   {
     return m_attributes[KEY_COLOR];
@@ -158,8 +198,10 @@ void GraphElement::removeAttribute(const QString& attribName)
 
 void GraphElement::exportToGraphviz(void* element) const
 {
-  QMap<QString,QString>::const_iterator it, it_end;
-  it = attributes().begin(); it_end = attributes().end();
+  // sorted by name, so that the export does not depend on the reading order
+  const QMap<QString,QString> sortedAttributes = attributes().toMap();
+  QMap<QString,QString>::const_iterator it = sortedAttributes.constBegin();
+  const QMap<QString,QString>::const_iterator it_end = sortedAttributes.constEnd();
   for (;it != it_end; it++)
   {
     if (!it.value().isEmpty())
@@ -189,9 +231,11 @@ void GraphElement::exportToGraphviz(void* element) const
 
 QTextStream& operator<<(QTextStream& s, const GraphElement& n)
 {
-  QMap<QString,QString>::const_iterator it, it_end;
+  // sorted by name, so that the written files do not depend on the reading order
+  const QMap<QString,QString> sortedAttributes = n.attributes().toMap();
+  QMap<QString,QString>::const_iterator it = sortedAttributes.constBegin();
+  const QMap<QString,QString>::const_iterator it_end = sortedAttributes.constEnd();
   bool firstAttr = true;
-  it = n.attributes().begin(); it_end = n.attributes().end();
   for (;it != it_end; it++)
   {
     if (!it.value().isEmpty())
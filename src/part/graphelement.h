@@ -19,6 +19,7 @@
 #ifndef GRAPH_ELEMENT_H
 #define GRAPH_ELEMENT_H
 
+#include "dotattributes.h"
 #include "dotrenderop.h"
 
 #include <QVector>
@@ -68,8 +69,20 @@ public:
   inline QString fontColor() const {return m_attributes[KEY_FONTCOLOR];}
   inline void setFontColor(const QString& fc) {m_attributes[KEY_FONTCOLOR] = fc;}
 
-  inline const DotRenderOpVec& renderOperations() const {return m_renderOperations;};
+  /**
+   * The drawing operations. Those given as xdot strings are decoded on the
+   * first call, typically when the element is first painted.
+   */
+  inline const DotRenderOpVec& renderOperations() const {m_renderOperations.decode(); return m_renderOperations;};
   void setRenderOperations(const DotRenderOpVec& drov);
+  /** Whether some drawing operations have not been decoded yet */
+  inline bool hasPendingRenderOperations() const {return m_renderOperations.hasPending();}
+  /**
+   * Decodes the pending drawing operations of elements on the global thread
+   * pool, before they are painted together, each range of elements into
+   * its own arena. Few elements are decoded in the calling thread.
+   */
+  static void decodeRenderOperations(const QVector<GraphElement*>& elements);
   /**
    * indicates the version of the render operations, gets increased every time
    * @c setRenderOperations gets called.
@@ -87,8 +100,8 @@ public:
 
   virtual void updateWithElement(const GraphElement& element);
 
-  inline QMap<QString,QString>& attributes() {return m_attributes;}
-  inline const QMap<QString,QString>& attributes() const {return m_attributes;}
+  inline DotAttributes& attributes() {return m_attributes;}
+  inline const DotAttributes& attributes() const {return m_attributes;}
 
   inline QList<QString>& originalAttributes() {return m_originalAttributes;}
   inline const QList<QString>& originalAttributes() const {return m_originalAttributes;}
@@ -113,29 +126,29 @@ Q_SIGNALS:
   void changed();
 
 protected:
-  QMap<QString,QString> m_attributes;
+  DotAttributes m_attributes;
   QList<QString> m_originalAttributes;
   
   CanvasElement* m_ce;
 
-  static const QString KEY_ID;
-  static const QString KEY_STYLE;
-  static const QString KEY_LABEL;
-  static const QString KEY_SHAPE;
-  static const QString KEY_SHAPEFILE;
-  static const QString KEY_COLOR;
-  static const QString KEY_BGCOLOR;
-  static const QString KEY_URL;
-  static const QString KEY_FONTSIZE;
-  static const QString KEY_FONTNAME;
-  static const QString KEY_FONTCOLOR;
-  static const QString KEY_FILLCOLOR;
+  static const int KEY_ID = DotAttributeSymbols::Id;
+  static const int KEY_STYLE = DotAttributeSymbols::Style;
+  static const int KEY_LABEL = DotAttributeSymbols::Label;
+  static const int KEY_SHAPE = DotAttributeSymbols::Shape;
+  static const int KEY_SHAPEFILE = DotAttributeSymbols::ShapeFile;
+  static const int KEY_COLOR = DotAttributeSymbols::Color;
+  static const int KEY_BGCOLOR = DotAttributeSymbols::BgColor;
+  static const int KEY_URL = DotAttributeSymbols::Url;
+  static const int KEY_FONTSIZE = DotAttributeSymbols::FontSize;
+  static const int KEY_FONTNAME = DotAttributeSymbols::FontName;
+  static const int KEY_FONTCOLOR = DotAttributeSymbols::FontColor;
+  static const int KEY_FILLCOLOR = DotAttributeSymbols::FillColor;
 
 private:
   double m_z;
   bool m_visible;
 
-  DotRenderOpVec m_renderOperations;
+  mutable DotRenderOpVec m_renderOperations;
   quint32 m_renderOperationsRevision;
 
   bool m_selected;
@@ -59,9 +59,9 @@ GraphElement(gn)
   //   qCDebug(KGRAPHVIEWERLIB_LOG) ;
 }
 
-GraphNode::GraphNode(node_t* gn) : GraphElement()
+GraphNode::GraphNode(node_t* gn, DotRenderOpCollector& collector) : GraphElement()
 {
-  updateWithNode(gn);
+  updateWithNode(gn, collector);
 }
 
 void GraphNode::updateWithNode(const GraphNode& node)
@@ -76,34 +76,19 @@ void GraphNode::updateWithNode(const GraphNode& node)
 //   qCDebug(KGRAPHVIEWERLIB_LOG) << "done";
 }
 
-void GraphNode::updateWithNode(node_t* node)
+void GraphNode::updateWithNode(node_t* node, DotRenderOpCollector& collector)
 {
   qCDebug(KGRAPHVIEWERLIB_LOG) << agnameof(node);
   m_attributes["id"] = agnameof(node);
   m_attributes["label"] = ND_label(node)->text;
 
-  DotRenderOpVec ops;
-  // decrease mem peak
-  setRenderOperations(ops);
-
-  if (agget(node, (char*)"_draw_"))
-  {
-    parse_renderop(agget(node, (char*)"_draw_"), ops);
-    qCDebug(KGRAPHVIEWERLIB_LOG) << "_draw_: element renderOperations size is now " << ops.size();
-  }
-  if (agget(node, (char*)"_ldraw_"))
-  {
-    parse_renderop(agget(node, (char*)"_ldraw_"), ops);
-    qCDebug(KGRAPHVIEWERLIB_LOG) << "_ldraw_: element renderOperations size is now " << ops.size();
-  }
-
-  setRenderOperations(ops);
+  collector.add(this, node, {"_draw_", "_ldraw_"});
 
   Agsym_t *attr = agnxtattr(agraphof(node), AGNODE, nullptr);
   while(attr)
   {
     qCDebug(KGRAPHVIEWERLIB_LOG) << agnameof(node) << ":" << attr->name << agxget(node,attr);
-    m_attributes[attr->name] = agxget(node,attr);
+    m_attributes[attr->name] = collector.attributeValues().intern(agxget(node,attr));
     attr = agnxtattr(agraphof(node), AGNODE, attr);
   }
 }
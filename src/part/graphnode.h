@@ -40,6 +40,7 @@
 #include <graphviz/gvc.h>
 
 #include "dotrenderop.h"
+#include "dotrenderopcollector.h"
 #include "dotgrammar.h"
 #include "graphelement.h"
 #include "canvaselement.h"
@@ -59,7 +60,7 @@ class GraphNode : public GraphElement
 public:
   GraphNode();
   explicit GraphNode(const GraphNode& gn);
-  explicit GraphNode(node_t* gn);
+  GraphNode(node_t* gn, DotRenderOpCollector& collector);
 
   ~GraphNode() override {}
 
@@ -68,7 +69,8 @@ public:
   inline void setCanvasNode(CanvasNode* cn) { setCanvasElement((CanvasElement*)cn); }
 
   void updateWithNode(const GraphNode& node);
-  void updateWithNode(node_t* node);
+  /** Updates from a laid out node, giving its xdot attributes to collector, to be decoded on first use */
+  void updateWithNode(node_t* node, DotRenderOpCollector& collector);
 
   
 private:
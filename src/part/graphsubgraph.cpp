@@ -40,10 +40,10 @@ GraphSubgraph::GraphSubgraph() :
 {
 }
 
-GraphSubgraph::GraphSubgraph(graph_t* sg) :
+GraphSubgraph::GraphSubgraph(graph_t* sg, DotRenderOpCollector& collector) :
   GraphElement(), m_content()
 {
-  updateWithSubgraph(sg);
+  updateWithSubgraph(sg, collector);
 }
 
 void GraphSubgraph::updateWithSubgraph(const GraphSubgraph& subgraph)
@@ -101,35 +101,20 @@ void GraphSubgraph::updateWithSubgraph(const GraphSubgraph& subgraph)
 //   qCDebug(KGRAPHVIEWERLIB_LOG) << "done";
 }
 
-void GraphSubgraph::updateWithSubgraph(graph_t* subgraph)
+void GraphSubgraph::updateWithSubgraph(graph_t* subgraph, DotRenderOpCollector& collector)
 {
   qCDebug(KGRAPHVIEWERLIB_LOG) << agnameof(subgraph);
   m_attributes["id"] = agnameof(subgraph);
   if (GD_label(subgraph))
     m_attributes["label"] = GD_label(subgraph)->text;
   
-  DotRenderOpVec ops;
-  // decrease mem peak
-  setRenderOperations(ops);
-
-  if (agget(subgraph, (char*)"_draw_"))
-  {
-    parse_renderop(agget(subgraph, (char*)"_draw_"), ops);
-    qCDebug(KGRAPHVIEWERLIB_LOG) << "_draw_: element renderOperations size is now " << ops.size();
-  }
-  if (agget(subgraph, (char*)"_ldraw_"))
-  {
-    parse_renderop(agget(subgraph, (char*)"_ldraw_"), ops);
-    qCDebug(KGRAPHVIEWERLIB_LOG) << "_ldraw_: element renderOperations size is now " << ops.size();
-  }
-
-  setRenderOperations(ops);
+  collector.add(this, subgraph, {"_draw_", "_ldraw_"});
 
   Agsym_t *attr = agnxtattr(subgraph, AGRAPH, nullptr);
   while(attr)
   {
     qCDebug(KGRAPHVIEWERLIB_LOG) << agnameof(subgraph) << ":" << attr->name << agxget(subgraph,attr);
-    m_attributes[attr->name] = agxget(subgraph,attr);
+    m_attributes[attr->name] = collector.attributeValues().intern(agxget(subgraph,attr));
     attr = agnxtattr(subgraph, AGRAPH, attr);
   }
 
@@ -142,7 +127,7 @@ void GraphSubgraph::updateWithSubgraph(graph_t* subgraph)
       qCDebug(KGRAPHVIEWERLIB_LOG) << "known subsubgraph";
       // ???
       //       nodes()[ngn->name]->setZ(ngn->z());
-      subgraphs()[agnameof(sg)]->updateWithSubgraph(sg);
+      subgraphs()[agnameof(sg)]->updateWithSubgraph(sg, collector);
       if (subgraphs()[agnameof(sg)]->canvasElement())
       {
         //         nodes()[ngn->id()]->canvasElement()->setGh(m_height);
@@ -151,7 +136,7 @@ void GraphSubgraph::updateWithSubgraph(graph_t* subgraph)
     else
     {
       qCDebug(KGRAPHVIEWERLIB_LOG) << "new subsubgraph";
-      GraphSubgraph* newsg = new GraphSubgraph(sg);
+      GraphSubgraph* newsg = new GraphSubgraph(sg, collector);
       //       qCDebug(KGRAPHVIEWERLIB_LOG) << "new created";
       subgraphs().insert(agnameof(sg), newsg);
       //       qCDebug(KGRAPHVIEWERLIB_LOG) << "new inserted";
@@ -163,19 +148,19 @@ void GraphSubgraph::updateWithSubgraph(graph_t* subgraph)
 
 QString GraphSubgraph::backColor() const
 {
-  if (m_attributes.find("bgcolor") != m_attributes.end())
+  if (m_attributes.contains("bgcolor"))
   {
     return m_attributes["bgcolor"];
   }
-  else if ( (m_attributes.find("style") != m_attributes.end())
+  else if ( m_attributes.contains("style")
     && (m_attributes["style"] == "filled")
-    && (m_attributes.find("color") != m_attributes.end()) )
+    && m_attributes.contains("color") )
   {
     return m_attributes["color"];
   }
-  else if ((m_attributes.find("style") != m_attributes.end())
+  else if (m_attributes.contains("style")
     && (m_attributes["style"] == "filled")
-    && (m_attributes.find("fillcolor") != m_attributes.end()))
+    && m_attributes.contains("fillcolor"))
   {
     return m_attributes["fillcolor"];
   }
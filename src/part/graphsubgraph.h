@@ -29,6 +29,7 @@
 #include "dotgrammar.h"
 #include "graphelement.h"
 #include "dotrenderop.h"
+#include "dotrenderopcollector.h"
 
 #include <graphviz/gvc.h>
 
@@ -50,7 +51,7 @@ class GraphSubgraph : public GraphElement
   Q_OBJECT
 public:
   GraphSubgraph();
-  explicit GraphSubgraph(graph_t* sg);
+  GraphSubgraph(graph_t* sg, DotRenderOpCollector& collector);
 
   ~GraphSubgraph() override {}
 
@@ -58,7 +59,8 @@ public:
   inline GraphSubgraphMap& subgraphs() {return m_subgraphsMap;}
   
   void updateWithSubgraph(const GraphSubgraph& subgraph);
-  void updateWithSubgraph(graph_t* subgraph);
+  /** Updates from a laid out subgraph, giving its xdot attributes to collector, to be decoded on first use */
+  void updateWithSubgraph(graph_t* subgraph, DotRenderOpCollector& collector);
   
   CanvasSubgraph* canvasSubgraph() { return (CanvasSubgraph*)canvasElement();  }
   void setCanvasSubgraph(CanvasSubgraph* cs) { setCanvasElement((CanvasElement*)cs); }
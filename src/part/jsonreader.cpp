@@ -0,0 +1,361 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+#include "jsonreader.h"
+#include "kgraphviewerlib_debug.h"
+
+#include <QByteArray>
+#include <QDebug>
+
+#include <cstring>
+
+namespace KGraphViewer
+{
+
+namespace
+{
+
+inline bool isJsonSpace(char c)
+{
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+inline bool isNumberChar(char c)
+{
+  return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+bool readHex4(const char* p, unsigned int& value)
+{
+  value = 0;
+  for (int i = 0; i < 4; i++)
+  {
+    const char c = p[i];
+    value <<= 4;
+    if (c >= '0' && c <= '9')
+    {
+      value |= c - '0';
+    }
+    else if (c >= 'a' && c <= 'f')
+    {
+      value |= c - 'a' + 10;
+    }
+    else if (c >= 'A' && c <= 'F')
+    {
+      value |= c - 'A' + 10;
+    }
+    else
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+void appendUtf8(std::string& str, unsigned int c)
+{
+  if (c < 0x80)
+  {
+    str += char(c);
+  }
+  else if (c < 0x800)
+  {
+    str += char(0xC0 | (c >> 6));
+    str += char(0x80 | (c & 0x3F));
+  }
+  else if (c < 0x10000)
+  {
+    str += char(0xE0 | (c >> 12));
+    str += char(0x80 | ((c >> 6) & 0x3F));
+    str += char(0x80 | (c & 0x3F));
+  }
+  else
+  {
+    str += char(0xF0 | (c >> 18));
+    str += char(0x80 | ((c >> 12) & 0x3F));
+    str += char(0x80 | ((c >> 6) & 0x3F));
+    str += char(0x80 | (c & 0x3F));
+  }
+}
+
+}
+
+JsonReader::JsonReader(JsonHandler& handler) :
+    m_handler(handler),
+    m_state(ExpectValue),
+    m_containers(),
+    m_unescaped()
+{
+}
+
+const char* JsonReader::error(const char* position, const char* last, const char* expected)
+{
+  qCWarning(KGRAPHVIEWERLIB_LOG) << "JSON syntax error:" << expected << "expected but got"
+                                 << (position == last ? QString("end of input") : QString::fromUtf8(position, int(qMin<std::ptrdiff_t>(last - position, 16))));
+  m_state = Failed;
+  return nullptr;
+}
+
+const char* JsonReader::expected() const
+{
+  switch (m_state)
+  {
+    case ExpectKey: return "a key";
+    case ExpectKeyOrEnd: return "a key or }";
+    case ExpectColon: return ":";
+    case ExpectCommaOrEnd: return (m_containers.back() == '{') ? ", or }" : ", or ]";
+    case Finished: return "end of input";
+    default: return "a value";
+  }
+}
+
+void JsonReader::valueRead()
+{
+  m_state = m_containers.empty() ? Finished : ExpectCommaOrEnd;
+}
+
+const char* JsonReader::readString(const char* first, const char* last, DotStringRef& value)
+{
+  const char* p = first + 1;
+  for (;;)
+  {
+    p = static_cast<const char*>(memchr(p, '"', last - p));
+    if (p == nullptr)
+    {
+      return nullptr;
+    }
+    // a quote preceded by an odd number of backslashes is escaped
+    const char* q = p;
+    while (q[-1] == '\\' && q - 1 > first)
+    {
+      --q;
+    }
+    if ((p - q) % 2 == 0)
+    {
+      break;
+    }
+    ++p;
+  }
+
+  const char* begin = first + 1;
+  if (memchr(begin, '\\', p - begin) == nullptr)
+  {
+    value = DotStringRef(begin, p);
+    return p + 1;
+  }
+  m_unescaped.clear();
+  for (const char* c = begin; c != p; ++c)
+  {
+    if (*c != '\\')
+    {
+      m_unescaped += *c;
+      continue;
+    }
+    // the closing quote is not escaped: there is a character after the backslash
+    ++c;
+    unsigned int code;
+    switch (*c)
+    {
+      case 'b': m_unescaped += '\b'; break;
+      case 'f': m_unescaped += '\f'; break;
+      case 'n': m_unescaped += '\n'; break;
+      case 'r': m_unescaped += '\r'; break;
+      case 't': m_unescaped += '\t'; break;
+      case 'u':
+        if (p - c > 4 && readHex4(c + 1, code))
+        {
+          c += 4;
+          unsigned int low;
+          if (code >= 0xD800 && code < 0xDC00 && p - c > 6 && c[1] == '\\' && c[2] == 'u'
+              && readHex4(c + 3, low) && low >= 0xDC00 && low < 0xE000)
+          {
+            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+            c += 6;
+          }
+          appendUtf8(m_unescaped, code);
+        }
+        else
+        {
+          m_unescaped += *c;
+        }
+        break;
+      default:
+        // quote, backslash and slash
+        m_unescaped += *c;
+    }
+  }
+  value = DotStringRef(m_unescaped.data(), m_unescaped.data() + m_unescaped.size());
+  return p + 1;
+}
+
+const char* JsonReader::read(const char* first, const char* last, bool atEnd)
+{
+  const char* p = first;
+  while (m_state != Failed)
+  {
+    while (p != last && isJsonSpace(*p))
+    {
+      ++p;
+    }
+    if (p == last)
+    {
+      break;
+    }
+
+    bool accepted = true;
+    switch (*p)
+    {
+      case '{':
+      case '[':
+        if (!expectsValue())
+        {
+          return error(p, last, expected());
+        }
+        m_containers.push_back(*p);
+        if (*p == '{')
+        {
+          accepted = m_handler.startObject();
+          m_state = ExpectKeyOrEnd;
+        }
+        else
+        {
+          accepted = m_handler.startArray();
+          m_state = ExpectValueOrEnd;
+        }
+        ++p;
+        break;
+
+      case '}':
+      case ']':
+      {
+        const char open = (*p == '}') ? '{' : '[';
+        const State empty = (open == '{') ? ExpectKeyOrEnd : ExpectValueOrEnd;
+        if ((m_state != ExpectCommaOrEnd && m_state != empty) || m_containers.empty() || m_containers.back() != open)
+        {
+          return error(p, last, expected());
+        }
+        m_containers.pop_back();
+        accepted = (open == '{') ? m_handler.endObject() : m_handler.endArray();
+        valueRead();
+        ++p;
+        break;
+      }
+
+      case ',':
+        if (m_state != ExpectCommaOrEnd)
+        {
+          return error(p, last, expected());
+        }
+        m_state = (m_containers.back() == '{') ? ExpectKey : ExpectValue;
+        ++p;
+        break;
+
+      case ':':
+        if (m_state != ExpectColon)
+        {
+          return error(p, last, expected());
+        }
+        m_state = ExpectValue;
+        ++p;
+        break;
+
+      case '"':
+      {
+        DotStringRef value;
+        const char* end = readString(p, last, value);
+        if (end == nullptr)
+        {
+          return atEnd ? error(p, last, "a complete string") : p;
+        }
+        if (m_state == ExpectKey || m_state == ExpectKeyOrEnd)
+        {
+          accepted = m_handler.key(value);
+          m_state = ExpectColon;
+        }
+        else if (expectsValue())
+        {
+          accepted = m_handler.stringValue(value);
+          valueRead();
+        }
+        else
+        {
+          return error(p, last, expected());
+        }
+        p = end;
+        break;
+      }
+
+      case 't':
+      case 'f':
+      case 'n':
+      {
+        const char* word = (*p == 't') ? "true" : (*p == 'f') ? "false" : "null";
+        const std::ptrdiff_t size = std::ptrdiff_t(strlen(word));
+        if (last - p < size)
+        {
+          if (!atEnd && memcmp(p, word, last - p) == 0)
+          {
+            return p;
+          }
+          return error(p, last, word);
+        }
+        if (memcmp(p, word, size) != 0 || !expectsValue())
+        {
+          return error(p, last, expected());
+        }
+        accepted = (*p == 'n') ? m_handler.nullValue() : m_handler.boolValue(*p == 't');
+        valueRead();
+        p += size;
+        break;
+      }
+
+      default:
+      {
+        if (*p != '-' && (*p < '0' || *p > '9'))
+        {
+          return error(p, last, expected());
+        }
+        const char* end = p;
+        while (end != last && isNumberChar(*end))
+        {
+          ++end;
+        }
+        if (end == last && !atEnd)
+        {
+          return p;
+        }
+        bool ok = false;
+        const double value = QByteArray::fromRawData(p, int(end - p)).toDouble(&ok);
+        if (!ok || !expectsValue())
+        {
+          return error(p, last, expected());
+        }
+        accepted = m_handler.numberValue(value);
+        valueRead();
+        p = end;
+      }
+    }
+    if (!accepted)
+    {
+      m_state = Failed;
+    }
+  }
+  return (m_state == Failed) ? nullptr : p;
+}
+
+}
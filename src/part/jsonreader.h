@@ -0,0 +1,118 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+/*
+ * Streaming event based JSON reader
+ */
+
+#ifndef JSON_READER_H
+#define JSON_READER_H
+
+#include "dotlexer.h"
+
+#include <string>
+#include <vector>
+
+namespace KGraphViewer
+{
+
+/**
+ * Receives the content of a JSON document as it is read. Each method
+ * returns false to stop the reading with an error.
+ *
+ * The strings given reference either the buffer being read or a buffer of
+ * the reader: they are only valid during the call.
+ */
+class JsonHandler
+{
+public:
+  virtual ~JsonHandler() {}
+
+  virtual bool startObject() = 0;
+  virtual bool endObject() = 0;
+  virtual bool startArray() = 0;
+  virtual bool endArray() = 0;
+  /** The key of the next member of the current object */
+  virtual bool key(const DotStringRef& name) = 0;
+  virtual bool stringValue(const DotStringRef& value) = 0;
+  virtual bool numberValue(double value) = 0;
+  virtual bool boolValue(bool value) = 0;
+  virtual bool nullValue() = 0;
+};
+
+/**
+ * A JSON reader giving the document to a JsonHandler without building it
+ * in memory, so that a document can be handled while it is still being
+ * produced: the input can be given in several buffers.
+ */
+class JsonReader
+{
+public:
+  explicit JsonReader(JsonHandler& handler);
+
+  /**
+   * Reads the complete tokens of [first, last). When atEnd is false, a
+   * token which could continue after last is left for the next call.
+   * @return the first byte not read, or nullptr on error
+   */
+  const char* read(const char* first, const char* last, bool atEnd);
+
+  /** true once a whole document has been read */
+  inline bool isFinished() const {return m_state == Finished;}
+
+private:
+  enum State
+  {
+    ExpectValue,
+    /** After [ */
+    ExpectValueOrEnd,
+    /** After , in an object */
+    ExpectKey,
+    /** After { */
+    ExpectKeyOrEnd,
+    ExpectColon,
+    ExpectCommaOrEnd,
+    Finished,
+    Failed
+  };
+
+  /** @return nullptr, after having reported the error */
+  const char* error(const char* position, const char* last, const char* expected);
+  /** What the current state accepts, for error messages */
+  const char* expected() const;
+  inline bool expectsValue() const {return m_state == ExpectValue || m_state == ExpectValueOrEnd;}
+  void valueRead();
+  /**
+   * Finds the end of the string starting at first, a quote, and decodes it
+   * in value.
+   * @return the byte following the closing quote or nullptr if the string
+   * is not complete
+   */
+  const char* readString(const char* first, const char* last, DotStringRef& value);
+
+  JsonHandler& m_handler;
+  State m_state;
+  /** The open containers, the innermost last: '{' or '[' */
+  std::vector<char> m_containers;
+  /** The value of the last string read, if it contained escapes */
+  std::string m_unescaped;
+};
+
+}
+
+#endif
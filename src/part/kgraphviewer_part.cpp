@@ -21,6 +21,9 @@
 #include "kgraphviewerlib_debug.h"
 #include "dotgraphview.h"
 #include "dotgraph.h"
+#include "dotinput.h"
+#include "dotlayoutpreset.h"
+#include "dotnativelayout.h"
 #include "config-kgraphviewer.h"
 
 #include <KDirWatch>
@@ -33,6 +36,7 @@
 #include <QDebug>
 #include <KPluginFactory>
 #include <QIcon>
+#include <QLocale>
 #include <QStandardPaths>
 #include <KAboutData>
 #include <klocalizedstring.h>
@@ -112,6 +116,8 @@ KGraphViewerPart::KGraphViewerPart( QWidget *parentWidget, QObject *parent, cons
           this, &KGraphViewerPart::hoverEnter);
   connect(d->m_widget, &DotGraphView::hoverLeave,
           this, &KGraphViewerPart::hoverLeave);
+  connect(d->m_widget, &DotGraphView::graphLaidOut,
+          this, &KGraphViewerPart::slotGraphLaidOut);
                    
 
           
@@ -206,8 +212,12 @@ bool KGraphViewerPart::openFile()
   d->m_watch = new KDirWatch();
   
   //   qCDebug(KGRAPHVIEWERLIB_LOG) << "Watching file " << localFilePath();
-  d->m_watch->addFile(localFilePath());
-  connect(d->m_watch, &KDirWatch::dirty, d->m_widget, &DotGraphView::dirty);
+  // the standard input and pipes cannot be reloaded
+  if (!DotInput::isStreamFile(localFilePath()))
+  {
+    d->m_watch->addFile(localFilePath());
+    connect(d->m_watch, &KDirWatch::dirty, d->m_widget, &DotGraphView::dirty);
+  }
   QString label = localFilePath().section('/',-1,-1);
   
   d->m_widget->show();
@@ -414,6 +424,24 @@ void KGraphViewerPart::slotRenameNode(const QString& oldNodeName, const QString&
   d->m_widget->graph()->renameNode(oldNodeName,newNodeName);
 }
 
+void KGraphViewerPart::slotGraphLaidOut(const QString& layoutCommand, qint64 milliseconds)
+{
+  if (milliseconds < 0)
+  {
+    // read from the cache or already laid out: nothing was timed
+    emit setStatusBarText(QString());
+  }
+  else if (DotNativeLayout::isNative(layoutCommand))
+  {
+    emit setStatusBarText(i18n("Laid out by %1 in %2 ms", layoutCommand, QLocale().toString(milliseconds)));
+  }
+  else
+  {
+    emit setStatusBarText(i18n("Laid out by %1 in %2 ms with the %3 preset", layoutCommand,
+                               QLocale().toString(milliseconds), DotLayoutPreset::name()));
+  }
+}
+
 }
 
 #include "kgraphviewer_part.moc"
@@ -141,6 +141,10 @@ public Q_SLOTS:
      */
     bool openFile() override;
 
+private Q_SLOTS:
+  /** Shows how long the layout of the graph displayed took in the status bar */
+  void slotGraphLaidOut(const QString& layoutCommand, qint64 milliseconds);
+
 private:
   KGraphViewerPartPrivate * const d;
 };
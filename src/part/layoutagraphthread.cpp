@@ -19,8 +19,19 @@
 
 #include "kgraphviewerlib_debug.h"
 #include "layoutagraphthread.h"
+#include "dotlayoutcache.h"
+#include "dotlayoutpreset.h"
+#include "dotlayoutworkerpool.h"
+#include "dotcontextpool.h"
+#include "dotcomponentlayout.h"
+#include "dotgraph.h"
+#include "dotnativelayout.h"
+#include "DotGraphParsingHelper.h"
+#include "dotparser.h"
 
+#include <QElapsedTimer>
 #include <QMutex>
+#include <QFile>
 
 #include <QDebug>
 
@@ -41,32 +52,217 @@ int threadsafe_wrap_gvRender(GVC_t *gvc, graph_t *g, const char *format, FILE *o
   return gvRender(gvc, g, format, out);
 }
 
-LayoutAGraphThread::LayoutAGraphThread() : sem(1)
+LayoutAGraphThread::LayoutAGraphThread() :
+    m_g(nullptr),
+    m_laidOutGraph(nullptr),
+    m_layoutTime(0),
+    m_cancelled(0),
+    m_runs(0),
+    m_handledRuns(0),
+    m_hasPending(false),
+    m_pending{nullptr, QString(), QString(), QByteArray()}
 {
-  m_gvc = gvContext();
 }
 
 LayoutAGraphThread::~LayoutAGraphThread()
 {
-  gvFreeContext(m_gvc);
+  cancel();
+  wait();
+  delete m_laidOutGraph;
+  if (m_g)
+  {
+    agclose(m_g);
+  }
+}
+
+KGraphViewer::DotGraph* LayoutAGraphThread::takeLaidOutGraph()
+{
+  KGraphViewer::DotGraph* graph = m_laidOutGraph;
+  m_laidOutGraph = nullptr;
+  return graph;
+}
+
+bool LayoutAGraphThread::layoutInProcess(QByteArray& output)
+{
+  KGraphViewer::DotContext gvc;
+  QMutexLocker locker(&gv_mutex);
+  char* data = nullptr;
+  unsigned int length = 0;
+  const bool result = gvLayout(gvc, m_g, m_layoutCommand.toUtf8().data()) == 0
+      && gvRenderData(gvc, m_g, "xdot", &data, &length) == 0;
+  if (result)
+  {
+    output = QByteArray(data, int(length));
+  }
+  gvFreeRenderData(data);
+  gvFreeLayout(gvc, m_g);
+  return result;
 }
 
 void LayoutAGraphThread::run()
+{
+  QElapsedTimer timer;
+  timer.start();
+  layout();
+  m_layoutTime = timer.elapsed();
+}
+
+void LayoutAGraphThread::layout()
 {
   if (!m_g)
   {
     qCWarning(KGRAPHVIEWERLIB_LOG) << "No graph loaded, skipping layout";
     return;
   }
-  threadsafe_wrap_gvLayout(m_gvc, m_g, m_layoutCommand.toUtf8().data());
-  threadsafe_wrap_gvRender(m_gvc, m_g, "xdot", nullptr);
+  if (KGraphViewer::DotNativeLayout::isNative(m_layoutCommand))
+  {
+    // built in this thread, without xdot output to cache
+    m_laidOutGraph = KGraphViewer::DotNativeLayout::layout(m_g, m_layoutCommand, m_dotFileName, &m_cancelled);
+    return;
+  }
+  KGraphViewer::DotLayoutPreset::apply(m_g);
+  KGraphViewer::DotLayoutWorkerPool& workers = KGraphViewer::DotLayoutWorkerPool::instance();
+  if (KGraphViewer::DotComponentLayout::isEnabled() && workers.isAvailable())
+  {
+    // the packed drawing is not the output of a layout: it is not cached
+    const QString& layoutCommand = m_layoutCommand;
+    const QAtomicInt* cancelled = &m_cancelled;
+    m_laidOutGraph = KGraphViewer::DotComponentLayout::layout(m_g, m_layoutCommand, m_dotFileName,
+        [&workers, &layoutCommand, cancelled](graph_t* part, QByteArray& output)
+        {
+          return workers.layout(part, layoutCommand, output, cancelled);
+        },
+        &m_cancelled);
+    if (!m_laidOutGraph && !m_cancelled.load())
+    {
+      qCWarning(KGRAPHVIEWERLIB_LOG) << "Layout of the components with" << m_layoutCommand << "failed";
+    }
+    return;
+  }
+
+  QByteArray output;
+  const bool laidOut = workers.isAvailable() ? workers.layout(m_g, m_layoutCommand, output, &m_cancelled) : layoutInProcess(output);
+  if (!laidOut)
+  {
+    if (!m_cancelled.load())
+    {
+      qCWarning(KGRAPHVIEWERLIB_LOG) << "Layout with" << m_layoutCommand << "failed";
+    }
+    return;
+  }
+
+  // kept even if cancelled: the layout is valid
+  if (!m_cacheKey.isEmpty())
+  {
+    const QString path = KGraphViewer::DotLayoutCache::newEntryPath(m_cacheKey);
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly) && file.write(output) == output.size() && file.flush())
+    {
+      m_cacheEntryPath = path;
+    }
+    else
+    {
+      qCWarning(KGRAPHVIEWERLIB_LOG) << "Cannot write the layout cache entry" << path;
+      file.close();
+      KGraphViewer::DotLayoutCache::discard(path);
+    }
+  }
+  if (m_cancelled.load())
+  {
+    return;
+  }
+
+  KGraphViewer::DotGraph* graph = new KGraphViewer::DotGraph(m_layoutCommand, m_dotFileName);
+  KGraphViewer::DotGraphParsingHelper helper;
+  helper.graph = graph;
+  helper.z = 1;
+  helper.maxZ = 1;
+  helper.uniq = 0;
+  KGraphViewer::DotParser parser(helper);
+  if (!parser.parseInParallel(output.constData(), output.constData() + output.size()) || !parser.isFinished())
+  {
+    qCWarning(KGRAPHVIEWERLIB_LOG) << "Cannot parse the output of the layout with" << m_layoutCommand;
+    delete graph;
+    return;
+  }
+  m_laidOutGraph = graph;
 }
 
-void LayoutAGraphThread::layoutGraph(graph_t* graph, const QString& layoutCommand)
+void LayoutAGraphThread::layoutGraph(graph_t* graph, const QString& dotFileName, const QString& layoutCommand, const QByteArray& cacheKey)
 {
-  sem.acquire();
-  m_g = graph;
-  m_layoutCommand = layoutCommand;
+  const Request request = {graph, dotFileName, layoutCommand, graph ? cacheKey : QByteArray()};
+  if (isRunning())
+  {
+    qCDebug(KGRAPHVIEWERLIB_LOG) << "superseding the layout of" << m_dotFileName << "by the one of" << dotFileName;
+    cancel();
+    m_hasPending = true;
+    m_pending = request;
+    return;
+  }
+  begin(request);
+}
+
+void LayoutAGraphThread::begin(const Request& request)
+{
+  // the previous result was not handled if it was superseded
+  if (m_g)
+  {
+    agclose(m_g);
+  }
+  delete m_laidOutGraph;
+  m_laidOutGraph = nullptr;
+  m_layoutTime = 0;
+  if (!m_cacheEntryPath.isEmpty() && m_handledRuns != m_runs)
+  {
+    KGraphViewer::DotLayoutCache::store(m_cacheKey, m_cacheEntryPath);
+  }
+  m_cacheEntryPath.clear();
+
+  m_g = request.graph;
+  m_dotFileName = request.dotFileName;
+  m_layoutCommand = request.layoutCommand;
+  m_cacheKey = request.cacheKey;
+  m_cancelled.store(0);
+  ++m_runs;
   start();
 }
 
+void LayoutAGraphThread::cancel()
+{
+  m_cancelled.store(1);
+  if (m_pending.graph)
+  {
+    agclose(m_pending.graph);
+  }
+  m_hasPending = false;
+  m_pending = Request{nullptr, QString(), QString(), QByteArray()};
+}
+
+bool LayoutAGraphThread::discardStale()
+{
+  // the end of a run superseded before its end was handled
+  if (isRunning() || m_handledRuns == m_runs)
+  {
+    return true;
+  }
+  m_handledRuns = m_runs;
+  if (!m_cancelled.load())
+  {
+    return false;
+  }
+  delete m_laidOutGraph;
+  m_laidOutGraph = nullptr;
+  if (!m_cacheEntryPath.isEmpty())
+  {
+    KGraphViewer::DotLayoutCache::store(m_cacheKey, m_cacheEntryPath);
+    m_cacheEntryPath.clear();
+  }
+  if (m_hasPending)
+  {
+    const Request request = m_pending;
+    m_hasPending = false;
+    m_pending = Request{nullptr, QString(), QString(), QByteArray()};
+    begin(request);
+  }
+  return true;
+}
@@ -20,34 +20,96 @@
 #ifndef LAYOUTAGRAPHTHREAD_H
 #define LAYOUTAGRAPHTHREAD_H
 
+#include <QAtomicInt>
+#include <QByteArray>
 #include <QThread>
-#include <QSemaphore>
 
 #include <graphviz/gvc.h>
 
+namespace KGraphViewer
+{
+class DotGraph;
+}
+
 int threadsafe_wrap_gvLayout(GVC_t *gvc, graph_t *g, const char *engine);
 int threadsafe_wrap_gvRender(GVC_t *gvc, graph_t *g, const char *format, FILE *out);
 
+/**
+ * Lays out graphs read by LoadAGraphThread. Like it, it never blocks the
+ * calling thread: a new request cancels the layout in progress, killing its
+ * worker process, and is run once it ends. Only the last of several such
+ * requests is kept.
+ */
 class LayoutAGraphThread : public QThread
 {
   Q_OBJECT
 public:
   LayoutAGraphThread();
   ~LayoutAGraphThread() override;
-  void layoutGraph(graph_t* graph, const QString& layoutCommand);
-  inline graph_t* g() {return m_g;}
-  inline GVC_t* gvc() {return m_gvc;}
+  /**
+   * Lays out graph, read from dotFileName, in the thread, in a worker
+   * process if possible, and builds the laid out model. If cacheKey is not
+   * empty, the laid out graph is also written to a new layout cache entry,
+   * to be stored once the thread is finished. The thread takes the
+   * ownership of graph.
+   */
+  void layoutGraph(graph_t* graph, const QString& dotFileName, const QString& layoutCommand, const QByteArray& cacheKey = QByteArray());
+  /** Drops the layout in progress and the pending request, if any */
+  void cancel();
+  /**
+   * To be called first when the thread has finished: if its run was
+   * superseded or cancelled, drops its result and starts the pending
+   * request if any.
+   * @return true if the result was dropped
+   */
+  bool discardStale();
+  /**
+   * The model of the laid out graph, to be deleted by the caller, once the
+   * thread is finished.
+   * @return nullptr if the layout failed
+   */
+  KGraphViewer::DotGraph* takeLaidOutGraph();
+  inline const QString& dotFileName() const {return m_dotFileName;}
   inline const QString& layoutCommand() const {return m_layoutCommand;}
-  void processed_finished() { sem.release(); }
-  
+  inline const QByteArray& cacheKey() const {return m_cacheKey;}
+  /** The layout cache entry written, empty if none */
+  inline const QString& cacheEntryPath() const {return m_cacheEntryPath;}
+  /** How long the last run took, in ms, once the thread is finished */
+  inline qint64 layoutTime() const {return m_layoutTime;}
+
 protected:
   void run() override;
 
 private:
-  QSemaphore sem;
+  /** A layout request */
+  struct Request
+  {
+    graph_t* graph;
+    QString dotFileName;
+    QString layoutCommand;
+    QByteArray cacheKey;
+  };
+
+  void begin(const Request& request);
+  /** Lays out m_g and builds m_laidOutGraph */
+  void layout();
+  /** Lays out m_g in this process, when no worker can be started */
+  bool layoutInProcess(QByteArray& output);
+
+  QString m_dotFileName;
   QString m_layoutCommand;
+  QByteArray m_cacheKey;
+  QString m_cacheEntryPath;
   graph_t* m_g;
-  GVC_t *m_gvc;
+  KGraphViewer::DotGraph* m_laidOutGraph;
+  qint64 m_layoutTime;
+  QAtomicInt m_cancelled;
+  /** The number of runs started and the one of those whose end was handled */
+  int m_runs;
+  int m_handledRuns;
+  /** The request to run once the current run is over */
+  bool m_hasPending;
+  Request m_pending;
 };
 
 #endif // LAYOUTAGRAPHTHREAD_H
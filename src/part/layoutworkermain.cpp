@@ -0,0 +1,66 @@
+/* This file is part of KGraphViewer.
+   Copyright (C) 2026 agent <agent@local>
+
+   KGraphViewer is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation, version 2.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA
+*/
+
+/*
+ * Layout worker process: lays out one graph with the Graphviz library
+ */
+
+#include <graphviz/gvc.h>
+
+#include <cstdio>
+#include <cstring>
+
+// The worker is started before it is needed, so that the context and its
+// plugins are ready when a graph arrives. Its standard input then receives
+// the layout engine on a line followed by the graph, and the laid out graph
+// is written in the xdot format on its standard output. A worker serves a
+// single graph: a crash in Graphviz only loses the layout it was running.
+int main()
+{
+  GVC_t* gvc = gvContext();
+
+  char engine[64];
+  if (fgets(engine, sizeof(engine), stdin) == nullptr)
+  {
+    // the pool is closed without having used this worker
+    gvFreeContext(gvc);
+    return 0;
+  }
+  engine[strcspn(engine, "\r\n")] = '\0';
+
+  graph_t* graph = agread(stdin, nullptr);
+  if (graph == nullptr)
+  {
+    fprintf(stderr, "kgraphviewer-layout-worker: invalid graph\n");
+    gvFreeContext(gvc);
+    return 2;
+  }
+  if (gvLayout(gvc, graph, engine) != 0)
+  {
+    fprintf(stderr, "kgraphviewer-layout-worker: layout with %s failed\n", engine);
+    agclose(graph);
+    gvFreeContext(gvc);
+    return 3;
+  }
+  const int result = gvRender(gvc, graph, "xdot", stdout);
+  fflush(stdout);
+  gvFreeLayout(gvc, graph);
+  agclose(graph);
+  gvFreeContext(gvc);
+  return (result != 0 || ferror(stdout)) ? 4 : 0;
+}
@@ -16,50 +16,110 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 */
-
 #include "loadagraphthread.h"
+#include "dotinput.h"
 #include "kgraphviewerlib_debug.h"
 
 #include <QDebug>
 
+LoadAGraphThread::LoadAGraphThread() :
+    m_g(nullptr),
+    m_cancelled(0),
+    m_runs(0),
+    m_handledRuns(0)
+{
+}
+
+LoadAGraphThread::~LoadAGraphThread()
+{
+  cancel();
+  wait();
+  if (m_g)
+  {
+    agclose(m_g);
+  }
+}
+
 void LoadAGraphThread::run()
 {
   qCDebug(KGRAPHVIEWERLIB_LOG) << m_dotFileName;
-  FILE* fp = fopen(m_dotFileName.toUtf8().data(), "r");
-  if (!fp)
+  KGraphViewer::DotInput input(m_dotFileName);
+  if (!input.open())
   {
-      qCWarning(KGRAPHVIEWERLIB_LOG) << "Failed to open file " << m_dotFileName;
       return;
   }
-  m_g = agread(fp, nullptr);
-  if (!m_g)
+  m_layoutCommand = input.layoutCommand();
+  m_g = input.read();
+  if (m_cancelled.load())
   {
-      qCWarning(KGRAPHVIEWERLIB_LOG) << "Failed to read file, retrying to work around graphviz bug(?)";
-      rewind(fp);
-      m_g = agread(fp, nullptr);
+    return;
   }
-  if (m_g == nullptr)
+  m_contentHash = input.hash();
+}
+
+void LoadAGraphThread::loadFile(const QString& dotFileName)
+{
+  if (isRunning())
   {
-      qCWarning(KGRAPHVIEWERLIB_LOG) << "Failed to read file " << m_dotFileName;
+    // a reading cannot be interrupted: its result is dropped when it ends
+    qCDebug(KGRAPHVIEWERLIB_LOG) << "superseding the reading of" << m_dotFileName << "by" << dotFileName;
+    m_cancelled.store(1);
+    m_pendingFileName = dotFileName;
+    return;
   }
-  fclose(fp);
+  begin(dotFileName);
 }
 
-void LoadAGraphThread::loadFile(const QString& dotFileName)
+void LoadAGraphThread::begin(const QString& dotFileName)
 {
-  // FIXME: deadlock possible
-  // if thread is still running or queued finished signal of the thread has not
-  // yet been delivered so its handler who would release the semaphore,
-  // then the semaphore can not be acquired and this will block the (main) thread
-  // which called LoadAGraphThread::loadFile().
-  // That one though very much might have also been the one which before invoked this
-  // method and thus the still running thread or yet-to-be delivered finished signal.
-  // But being blocked now, it will not reach its event loop where the queued finished
-  // signal of the thread would be processed and delivered, so in the further processing
-  // by the signal handler this semaphore would be released
-  // -> blocked ourselves without any escape
-  sem.acquire();
+  if (m_g)
+  {
+    agclose(m_g);
+  }
   m_dotFileName = dotFileName;
+  m_layoutCommand.clear();
+  m_contentHash.clear();
   m_g = nullptr;
+  m_cancelled.store(0);
+  ++m_runs;
   start();
 }
+
+void LoadAGraphThread::cancel()
+{
+  m_cancelled.store(1);
+  m_pendingFileName.clear();
+}
+
+bool LoadAGraphThread::discardStale()
+{
+  // the end of a run superseded before its end was handled
+  if (isRunning() || m_handledRuns == m_runs)
+  {
+    return true;
+  }
+  m_handledRuns = m_runs;
+  if (!m_cancelled.load())
+  {
+    return false;
+  }
+  if (m_g)
+  {
+    agclose(m_g);
+    m_g = nullptr;
+  }
+  if (!m_pendingFileName.isEmpty())
+  {
+    const QString dotFileName = m_pendingFileName;
+    m_pendingFileName.clear();
+    begin(dotFileName);
+  }
+  return true;
+}
+
+graph_t* LoadAGraphThread::takeGraph()
+{
+  graph_t* graph = m_g;
+  m_g = nullptr;
+  return graph;
+}
@@ -16,37 +16,62 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 */
-
 #ifndef LOADAGRAPHTHREAD_H
 #define LOADAGRAPHTHREAD_H
 
-#include <QSemaphore>
+#include <QAtomicInt>
+#include <QByteArray>
 #include <QThread>
 
 #include <graphviz/gvc.h>
 
 
+/**
+ * Reads a graph file with cgraph. The requests are never waited for on the
+ * calling thread: a request made while a file is being read supersedes it,
+ * the result of the reading in progress being dropped once it ends. Only
+ * the last of several such requests is kept.
+ */
 class LoadAGraphThread : public QThread
 {
   Q_OBJECT
 public:
-  LoadAGraphThread() : sem(1) {}
+  LoadAGraphThread();
+  ~LoadAGraphThread() override;
   void loadFile(const QString& dotFileName);
-  inline graph_t* g() {return m_g;}
+  /** Drops the reading in progress and the pending request, if any */
+  void cancel();
+  /**
+   * To be called first when the thread has finished: if its run was
+   * superseded or cancelled, drops its result and starts the pending
+   * request if any.
+   * @return true if the result was dropped
+   */
+  bool discardStale();
+  /** The graph read, to be closed by the caller */
+  graph_t* takeGraph();
   inline const QString& dotFileName() {return m_dotFileName;}
-  void processed_finished() { sem.release(); }
-
-  // helper method only for DotGraphView::loadLibrarySync()
-  // see notes next to the call there
-  void setDotFileName(const QString& dotFileName) { m_dotFileName = dotFileName; }
+  /** The layout program suited to the graph read, detected from its header */
+  inline const QString& layoutCommand() {return m_layoutCommand;}
+  /** The hash of the content of the file read */
+  inline const QByteArray& contentHash() {return m_contentHash;}
 
 protected:
   void run() override;
 
 private:
-  QSemaphore sem;
+  void begin(const QString& dotFileName);
+
   QString m_dotFileName;
+  QString m_layoutCommand;
+  QByteArray m_contentHash;
   graph_t *m_g;
+  QAtomicInt m_cancelled;
+  /** The number of runs started and the one of those whose end was handled */
+  int m_runs;
+  int m_handledRuns;
+  /** The file to read once the current run is over, if not empty */
+  QString m_pendingFileName;
 };
 
 #endif // LOADAGRAPHTHREAD_H
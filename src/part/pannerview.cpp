@@ -40,6 +40,7 @@
 #include <QGraphicsScene>
 #include <QPainter>
 #include <QMouseEvent>
+#include <QPaintEvent>
 #include <QDebug>
 
 #include <klocalizedstring.h>
@@ -123,6 +124,12 @@ void PannerView::moveZoomRectTo(const QPointF& newPos, bool notify)
   }
 }
 
+void PannerView::paintEvent(QPaintEvent* event)
+{
+  m_parent->decodeRenderOperations(mapToScene(event->rect()).boundingRect());
+  QGraphicsView::paintEvent(event);
+}
+
 void PannerView::drawForeground(QPainter * p, const QRectF & rect )
 {
   if (m_zoomRect.isValid() && rect.intersects(m_zoomRect))
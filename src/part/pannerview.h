@@ -67,6 +67,8 @@ protected:
   void mouseMoveEvent(QMouseEvent*) override;
   void mouseReleaseEvent(QMouseEvent*) override;
   void drawForeground(QPainter* p, const QRectF& rect) override;
+  /** Decodes the drawing operations of the elements shown before painting them, all of them when zoomed out */
+  void paintEvent(QPaintEvent* event) override;
   void contextMenuEvent(QContextMenuEvent* event) override;
 
   QRectF m_zoomRect;